@@ -0,0 +1,310 @@
+// Grid's tile counts and crop index vs scanning the grid.
+//
+// Random grids take setTile / TileRef writes, ticks in both growth modes (serial and over a
+// pool), mode switches, resets, loadTiles and indexing turned off and on. After every step
+// the counts, nearest-crop and rectangle queries have to match a brute-force scan, and
+// verifyIndexes has to agree. Timed: the queries against scans, and what the index adds to a
+// tick.
+//
+// usage: crop_index_bench [--seeds N] [--size S] [--queries N] [--verify-only]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Grid.hpp"
+#include "WorkerPool.hpp"
+
+namespace {
+
+int roll(std::mt19937& rng, int lo, int hi)
+{
+    return std::uniform_int_distribution<int>(lo, hi)(rng);
+}
+
+Tile randomTile(std::mt19937& rng)
+{
+    Tile t;
+    t.type = static_cast<TileType>(roll(rng, 0, 2));
+    t.cropstate = static_cast<CropState>(roll(rng, 0, 2));
+    t.growthTimer = roll(rng, -5, Tile::GROWTH_TIME);
+    return t;
+}
+
+bool isCrop(const Grid& grid, int i, CropState state)
+{
+    return grid.types()[i] == TileType::CROP && grid.cropStates()[i] == state;
+}
+
+int bruteNearest(const Grid& grid, CropState state, int x, int y)
+{
+    int best = -1;
+    int bestDistance = 0;
+    for (int i = 0; i < grid.tileCount(); i++) {
+        if (!isCrop(grid, i, state)) continue;
+        const int d = std::abs(i % grid.getGridWidth() - x) + std::abs(i / grid.getGridWidth() - y);
+        if (best < 0 || d < bestDistance) {
+            best = i;
+            bestDistance = d;
+        }
+    }
+    return best;
+}
+
+std::vector<int> bruteRect(const Grid& grid, CropState state, int x0, int y0, int x1, int y1)
+{
+    std::vector<int> out;
+    for (int y = std::max(0, y0); y < std::min(grid.getGridHeight(), y1); y++) {
+        for (int x = std::max(0, x0); x < std::min(grid.getGridWidth(), x1); x++) {
+            if (isCrop(grid, grid.index(x, y), state)) out.push_back(grid.index(x, y));
+        }
+    }
+    return out;
+}
+
+// everything the grid answers against a scan, false with a message on the first difference
+bool check(std::mt19937& rng, const Grid& grid, std::string& why)
+{
+    int counts[3][3] = {};
+    for (int i = 0; i < grid.tileCount(); i++)
+        counts[static_cast<int>(grid.types()[i])][static_cast<int>(grid.cropStates()[i])]++;
+    for (int t = 0; t < 3; t++) {
+        int typeTotal = 0;
+        for (int s = 0; s < 3; s++) {
+            typeTotal += counts[t][s];
+            if (grid.countTiles(static_cast<TileType>(t), static_cast<CropState>(s)) != counts[t][s]) {
+                why = "countTiles(type " + std::to_string(t) + ", state " + std::to_string(s) + ")";
+                return false;
+            }
+        }
+        if (grid.countTiles(static_cast<TileType>(t)) != typeTotal
+            || grid.countTiles(static_cast<CropState>(t)) != counts[0][t] + counts[1][t] + counts[2][t]) {
+            why = "countTiles by type or state alone";
+            return false;
+        }
+    }
+    if (!grid.verifyIndexes(&why)) {
+        why = "verifyIndexes: " + why;
+        return false;
+    }
+    if (!grid.isIndexingCrops()) return true;
+
+    const int w = grid.getGridWidth();
+    const int h = grid.getGridHeight();
+    for (int q = 0; q < 4; q++) {
+        const CropState state = q % 2 ? CropState::GROWN : CropState::PLANTED;
+        // a little off the grid too, the queries clip
+        const int x = roll(rng, -3, w + 2);
+        const int y = roll(rng, -3, h + 2);
+        int nx = -1, ny = -1;
+        const int expect = bruteNearest(grid, state, x, y);
+        const bool found = grid.nearestCrop(state, x, y, nx, ny);
+        if (found != (expect >= 0) || (found && grid.index(nx, ny) != expect)) {
+            why = "nearestCrop from " + std::to_string(x) + "," + std::to_string(y);
+            return false;
+        }
+
+        const int x0 = roll(rng, -3, w + 2), x1 = roll(rng, -3, w + 2);
+        const int y0 = roll(rng, -3, h + 2), y1 = roll(rng, -3, h + 2);
+        const std::vector<int> inRect = bruteRect(grid, state, x0, y0, x1, y1);
+        if (grid.countCrops(state, x0, y0, x1, y1) != static_cast<int>(inRect.size())) {
+            why = "countCrops";
+            return false;
+        }
+        std::vector<int> listed;
+        grid.cropsIn(state, x0, y0, x1, y1, listed);
+        std::sort(listed.begin(), listed.end());
+        if (listed != inRect) {
+            why = "cropsIn";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool verify(int seeds)
+{
+    WorkerPool pool(3);
+    for (int seed = 1; seed <= seeds; seed++) {
+        std::mt19937 rng(seed);
+        // mostly small, some past a couple of pyramid levels and not multiples of a block
+        const int big = seed % 5 == 0 ? 150 : 40;
+        int w = roll(rng, 1, big), h = roll(rng, 1, big);
+        Grid grid(w, h, seed % 2 ? GrowthMode::Scan : GrowthMode::Scheduled);
+        grid.setChangeTracking(seed % 3 == 0);
+        grid.setIndexVerification(seed % 7 == 0);
+        // some start indexed, the rest turn it on over a grid that's already full
+        grid.setCropIndexing(seed % 4 != 0);
+
+        for (int step = 0; step < 300; step++) {
+            const int r = roll(rng, 0, 99);
+            const int x = roll(rng, 0, w - 1), y = roll(rng, 0, h - 1);
+            if (r < 35) {
+                grid.setTile(x, y, randomTile(rng));
+            } else if (r < 45) {
+                // a batch of writes through TileRef between checks
+                for (int k = roll(rng, 1, 20); k > 0; k--) {
+                    const Tile t = randomTile(rng);
+                    auto ref = grid.getTile(roll(rng, 0, w - 1), roll(rng, 0, h - 1));
+                    if (k % 2) ref.type = t.type;
+                    ref.cropstate = t.cropstate;
+                }
+            } else if (r < 70) {
+                for (int k = roll(rng, 1, 5); k > 0; k--) {
+                    if (seed % 3 == 1) grid.tickParallel(pool);
+                    else grid.tick();
+                }
+            } else if (r < 75) {
+                grid.setGrowthMode(grid.getGrowthMode() == GrowthMode::Scan ? GrowthMode::Scheduled : GrowthMode::Scan);
+            } else if (r < 78) {
+                w = roll(rng, 1, big);
+                h = roll(rng, 1, big);
+                grid.reset(w, h);
+            } else if (r < 81) {
+                w = roll(rng, 1, big);
+                h = roll(rng, 1, big);
+                const std::size_t n = static_cast<std::size_t>(w) * h;
+                std::vector<TileType> types(n);
+                std::vector<CropState> states(n);
+                std::vector<std::int32_t> timers(n);
+                for (std::size_t i = 0; i < n; i++) {
+                    const Tile t = randomTile(rng);
+                    types[i] = t.type;
+                    states[i] = t.cropstate;
+                    timers[i] = t.growthTimer;
+                }
+                grid.loadTiles(w, h, types.data(), states.data(), timers.data(), nullptr);
+            } else if (r < 83) {
+                grid.setCropIndexing(!grid.isIndexingCrops());
+            } else if (r < 84) {
+                grid.setTickCount(roll(rng, 0, 1000));
+            } else if (grid.isTrackingChanges()) {
+                grid.clearChangedTiles();
+            }
+
+            std::string why;
+            if (!check(rng, grid, why)) {
+                std::cerr << "seed " << seed << " step " << step << ": " << why << " doesn't match a scan\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// density percent of tiles are crops, grownShare of those percent GROWN
+void seedFarm(Grid& grid, int density, int grownShare)
+{
+    std::mt19937 rng(99);
+    const int n = grid.tileCount();
+    std::vector<TileType> types(n, TileType::SOIL);
+    std::vector<CropState> states(n, CropState::EMPTY);
+    std::vector<std::int32_t> timers(n, 0);
+    for (int i = 0; i < n; i++) {
+        if (roll(rng, 0, 9999) >= density * 100) continue;
+        types[i] = TileType::CROP;
+        const bool grown = roll(rng, 0, 99) < grownShare;
+        states[i] = grown ? CropState::GROWN : CropState::PLANTED;
+        timers[i] = grown ? Tile::GROWTH_TIME : roll(rng, -1000, Tile::GROWTH_TIME - 1);
+    }
+    grid.loadTiles(grid.getGridWidth(), grid.getGridHeight(), types.data(), states.data(), timers.data(), nullptr);
+}
+
+template <typename Fn>
+double nsPer(int repeats, Fn&& fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; i++) fn(i);
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / repeats;
+}
+
+volatile long long sink = 0;
+
+void timeQueries(int size, int density, int queries)
+{
+    Grid grid(size, size);
+    grid.setCropIndexing(true);
+    seedFarm(grid, density, 50);
+    std::mt19937 rng(7);
+    std::vector<int> xs(queries), ys(queries);
+    for (int i = 0; i < queries; i++) {
+        xs[i] = roll(rng, 0, size - 1);
+        ys[i] = roll(rng, 0, size - 1);
+    }
+    // scans are slow, fewer of them
+    const int scans = std::max(1, queries / 100);
+    const int rect = 32;
+
+    const double countScan = nsPer(scans, [&](int) {
+        long long n = 0;
+        for (int i = 0; i < grid.tileCount(); i++) n += isCrop(grid, i, CropState::GROWN);
+        sink = sink + n;
+    });
+    const double countIndex = nsPer(queries, [&](int) { sink = sink + grid.countTiles(TileType::CROP, CropState::GROWN); });
+
+    const double nearestScan = nsPer(scans, [&](int q) { sink = sink + bruteNearest(grid, CropState::GROWN, xs[q], ys[q]); });
+    const double nearestIndex = nsPer(queries, [&](int q) {
+        int x = 0, y = 0;
+        sink = sink + grid.nearestCrop(CropState::GROWN, xs[q], ys[q], x, y) + x;
+    });
+
+    const double rectScan = nsPer(queries, [&](int q) {
+        sink = sink + static_cast<long long>(bruteRect(grid, CropState::GROWN, xs[q], ys[q], xs[q] + rect, ys[q] + rect).size());
+    });
+    const double rectIndex = nsPer(queries, [&](int q) {
+        sink = sink + grid.countCrops(CropState::GROWN, xs[q], ys[q], xs[q] + rect, ys[q] + rect);
+    });
+
+    std::cout << size << "x" << size << ", " << density << "% crops, half grown\n";
+    std::cout << "  count grown        scan " << countScan / 1e3 << " us   counter " << countIndex << " ns\n";
+    std::cout << "  nearest grown      scan " << nearestScan / 1e3 << " us   index " << nearestIndex << " ns  ("
+              << nearestScan / nearestIndex << "x)\n";
+    std::cout << "  grown in " << rect << "x" << rect << "    scan " << rectScan << " ns   index " << rectIndex << " ns  ("
+              << rectScan / rectIndex << "x)\n";
+}
+
+void timeTicks(int size, GrowthMode mode)
+{
+    double ms[2];
+    for (int indexed = 0; indexed < 2; indexed++) {
+        Grid grid(size, size, mode);
+        grid.setCropIndexing(indexed != 0);
+        seedFarm(grid, 10, 0);
+        const int ticks = 50;
+        ms[indexed] = nsPer(ticks, [&](int) { grid.tick(); }) / 1e6;
+    }
+    std::cout << "  tick (" << (mode == GrowthMode::Scan ? "scan" : "scheduled") << ")   " << ms[0]
+              << " ms   with index " << ms[1] << " ms\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int seeds = 200;
+    int size = 1024;
+    int queries = 20000;
+    bool verifyOnly = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seeds" && i + 1 < argc) seeds = std::atoi(argv[++i]);
+        else if (arg == "--size" && i + 1 < argc) size = std::max(8, std::atoi(argv[++i]));
+        else if (arg == "--queries" && i + 1 < argc) queries = std::max(100, std::atoi(argv[++i]));
+        else if (arg == "--verify-only") verifyOnly = true;
+    }
+
+    if (!verify(seeds)) return 1;
+    std::cout << "differential check passed (" << seeds << " random edit/tick sequences)\n";
+    if (verifyOnly) return 0;
+
+    timeQueries(size, 10, queries);
+    timeQueries(size, 1, queries);
+    std::cout << size << "x" << size << ", 10% crops growing\n";
+    timeTicks(size, GrowthMode::Scan);
+    timeTicks(size, GrowthMode::Scheduled);
+    return 0;
+}
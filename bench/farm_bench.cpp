@@ -0,0 +1,545 @@
+// Benchmark suite for the engine's core paths, with machine-readable results to catch
+// regressions: Grid construction, Grid::tick() in both growth modes, getTile access patterns,
+// Farmer::move streams and buildMeshesFromGrid, each at several grid sizes.
+//
+// Every benchmark is calibrated to a batch of operations that takes at least --min-sample-ms,
+// warmed up, then timed over --repeats batches. Reported per operation: median, p99 and
+// min time across the batches, and heap allocations (counted by replacing operator new in
+// this executable).
+//
+// usage: farm_bench [--sizes 64,256,1024] [--filter TEXT] [--repeats N] [--warmup N]
+//                   [--min-sample-ms MS] [--mesh-cap-mb MB]
+//                   [--json FILE|-] [--baseline FILE [--threshold PCT]]
+//   --json       write the results as JSON (see writeJson for the format), - for stdout
+//   --baseline   compare against a JSON file from an earlier --json run: a median more than
+//                --threshold percent (default 10) slower, or more allocations per operation,
+//                is a regression and the exit code is 1
+//   --filter     only benchmarks whose name contains TEXT
+//   the mesh benchmark needs ~600 bytes per tile, sizes over --mesh-cap-mb (256) skip it
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Farmer.hpp"
+#include "Grid.hpp"
+#include "GridMesh.hpp"
+
+// every heap allocation in the process goes through these, only the count is added
+static std::atomic<std::uint64_t> allocationCount{ 0 };
+
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr int RESULT_FORMAT_VERSION = 1;
+
+struct Result
+{
+    std::string name;
+    int size = 0;
+    std::int64_t itemsPerOp = 1; // tiles, accesses or moves one operation covers
+    std::int64_t opsPerSample = 0;
+    int samples = 0;
+    double medianNs = 0.0;
+    double p99Ns = 0.0;
+    double minNs = 0.0;
+    double allocsPerOp = 0.0;
+};
+
+struct Options
+{
+    std::vector<int> sizes = { 64, 256, 1024 };
+    std::string filter;
+    int repeats = 21;
+    int warmup = 3;
+    double minSampleMs = 5.0;
+    double meshCapMb = 256.0;
+    std::string jsonPath;
+    std::string baselinePath;
+    double thresholdPct = 10.0;
+};
+
+double nowNs()
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// nearest rank, samples sorted
+double percentile(const std::vector<double>& sorted, double p)
+{
+    const std::size_t rank = static_cast<std::size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::min(sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+}
+
+// op() is one operation; it's called in batches big enough to time reliably
+Result measure(const Options& opt, const std::string& name, int size, std::int64_t itemsPerOp,
+               const std::function<void()>& op)
+{
+    // double the batch until one takes long enough
+    std::int64_t batch = 1;
+    for (;;) {
+        const double start = nowNs();
+        for (std::int64_t i = 0; i < batch; i++) op();
+        if (nowNs() - start >= opt.minSampleMs * 1e6 || batch >= (std::int64_t(1) << 40)) break;
+        batch *= 2;
+    }
+    for (int w = 0; w < opt.warmup; w++)
+        for (std::int64_t i = 0; i < batch; i++) op();
+
+    std::vector<double> perOp;
+    perOp.reserve(static_cast<std::size_t>(opt.repeats)); // not counted against the benchmark
+    const std::uint64_t allocsBefore = allocationCount.load(std::memory_order_relaxed);
+    for (int r = 0; r < opt.repeats; r++) {
+        const double start = nowNs();
+        for (std::int64_t i = 0; i < batch; i++) op();
+        perOp.push_back((nowNs() - start) / static_cast<double>(batch));
+    }
+    const std::uint64_t allocs = allocationCount.load(std::memory_order_relaxed) - allocsBefore;
+    std::sort(perOp.begin(), perOp.end());
+
+    Result r;
+    r.name = name;
+    r.size = size;
+    r.itemsPerOp = itemsPerOp;
+    r.opsPerSample = batch;
+    r.samples = opt.repeats;
+    r.medianNs = percentile(perOp, 0.5);
+    r.p99Ns = percentile(perOp, 0.99);
+    r.minNs = perOp.front();
+    r.allocsPerOp = static_cast<double>(allocs) / (static_cast<double>(batch) * opt.repeats);
+    return r;
+}
+
+// a third of the tiles planted at staggered times so the scheduled mode always has crops due
+void plantFarm(Grid& grid, std::mt19937& rng)
+{
+    const int w = grid.getGridWidth();
+    const int h = grid.getGridHeight();
+    std::uniform_int_distribution<int> pick(0, 2);
+    std::uniform_int_distribution<int> age(0, Tile::GROWTH_TIME - 1);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (pick(rng) != 0) continue;
+            Tile t;
+            t.type = TileType::CROP;
+            t.cropstate = CropState::PLANTED;
+            t.growthTimer = age(rng);
+            grid.setTile(x, y, t);
+        }
+    }
+}
+
+void runSuite(const Options& opt, std::vector<Result>& results)
+{
+    auto wanted = [&](const std::string& name) { return opt.filter.empty() || name.find(opt.filter) != std::string::npos; };
+    auto run = [&](const std::string& name, int size, std::int64_t items, const std::function<void()>& op) {
+        if (!wanted(name)) return;
+        results.push_back(measure(opt, name, size, items, op));
+        const Result& r = results.back();
+        std::fprintf(stderr, "%-24s %6d  median %12.1f ns  p99 %12.1f ns  allocs/op %.2f\n", r.name.c_str(), r.size,
+                     r.medianNs, r.p99Ns, r.allocsPerOp);
+    };
+
+    for (int size : opt.sizes) {
+        const std::int64_t tiles = static_cast<std::int64_t>(size) * size;
+        std::mt19937 rng(static_cast<unsigned>(size));
+
+        run("grid_construct", size, tiles, [&] {
+            Grid grid(size, size);
+            if (grid.tileCount() != tiles) std::abort();
+        });
+
+        // ticks keep going forever: every crop that grows gets harvested and replanted by a
+        // sweep over a slice of rows each tick, so the farm never settles
+        for (GrowthMode mode : { GrowthMode::Scan, GrowthMode::Scheduled }) {
+            const std::string name = mode == GrowthMode::Scan ? "grid_tick/scan" : "grid_tick/scheduled";
+            if (!wanted(name)) continue;
+            Grid grid(size, size, mode);
+            plantFarm(grid, rng);
+            const int rowsPerTick = std::max(1, size / Tile::GROWTH_TIME);
+            int nextRow = 0;
+            run(name, size, tiles, [&] {
+                grid.tick();
+                for (int k = 0; k < rowsPerTick; k++, nextRow = (nextRow + 1) % size) {
+                    const GridSpan<CropState> states = grid.cropStateRow(nextRow);
+                    for (int x = 0; x < size; x++) {
+                        if (states[static_cast<std::size_t>(x)] != CropState::GROWN) continue;
+                        Tile t;
+                        t.type = TileType::CROP;
+                        t.cropstate = CropState::PLANTED;
+                        grid.setTile(x, nextRow, t);
+                    }
+                }
+            });
+        }
+
+        {
+            Grid grid(size, size);
+            plantFarm(grid, rng);
+            const Grid& view = grid;
+            std::vector<std::pair<int, int>> randomOrder;
+            randomOrder.reserve(static_cast<std::size_t>(std::min<std::int64_t>(tiles, 1 << 16)));
+            std::uniform_int_distribution<int> coord(0, size - 1);
+            for (std::size_t i = 0; i < randomOrder.capacity(); i++) randomOrder.emplace_back(coord(rng), coord(rng));
+            std::int64_t sink = 0;
+
+            run("get_tile/row_major", size, tiles, [&] {
+                for (int y = 0; y < size; y++)
+                    for (int x = 0; x < size; x++) sink += view.getTile(x, y).growthTimer;
+            });
+            run("get_tile/column_major", size, tiles, [&] {
+                for (int x = 0; x < size; x++)
+                    for (int y = 0; y < size; y++) sink += view.getTile(x, y).growthTimer;
+            });
+            run("get_tile/random", size, static_cast<std::int64_t>(randomOrder.size()), [&] {
+                for (const auto& [x, y] : randomOrder) sink += view.getTile(x, y).growthTimer;
+            });
+            // the old write path, a TileRef per tile
+            run("get_tile/write_row_major", size, tiles, [&] {
+                for (int y = 0; y < size; y++)
+                    for (int x = 0; x < size; x++) grid.getTile(x, y).type = TileType::SOIL;
+            });
+            if (sink == 42) std::fprintf(stderr, " ");
+        }
+
+        {
+            // a random walk with walls on 1 tile in 8, bumping into them and the edges included
+            Grid grid(size, size);
+            std::uniform_int_distribution<int> wall(0, 7);
+            for (int y = 0; y < size; y++)
+                for (int x = 0; x < size; x++)
+                    if (wall(rng) == 0 && (x | y) != 0) grid.setWalkable(x, y, false);
+            Farmer farmer(grid);
+            std::vector<direction> moves(4096);
+            std::uniform_int_distribution<int> dir(0, 3);
+            for (direction& d : moves) d = static_cast<direction>(dir(rng));
+            run("farmer_move", size, static_cast<std::int64_t>(moves.size()), [&] {
+                for (direction d : moves) farmer.move(d);
+            });
+        }
+
+        if (tiles * 600.0 / (1024.0 * 1024.0) <= opt.meshCapMb && wanted("build_meshes")) {
+            Grid grid(size, size);
+            plantFarm(grid, rng);
+            std::vector<float> tileVerts, borderVerts, farmerVerts;
+            run("build_meshes", size, tiles, [&] {
+                buildMeshesFromGrid(grid, 0, 0, tileVerts, borderVerts, farmerVerts);
+            });
+        }
+    }
+}
+
+std::string jsonEscape(const std::string& s)
+{
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+// {"format": 1, "build": {...}, "results": [{"name", "size", "items_per_op", "ops_per_sample",
+//  "samples", "median_ns", "p99_ns", "min_ns", "allocs_per_op"}, ...]}
+void writeJson(std::ostream& out, const std::vector<Result>& results, const Options& opt)
+{
+    out << "{\n  \"format\": " << RESULT_FORMAT_VERSION << ",\n";
+#if defined(__clang__)
+    const std::string compiler = std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    const std::string compiler = std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+    const std::string compiler = "msvc " + std::to_string(_MSC_VER);
+#else
+    const std::string compiler = "unknown";
+#endif
+#if defined(NDEBUG)
+    const char* asserts = "off";
+#else
+    const char* asserts = "on";
+#endif
+    out << "  \"build\": {\"compiler\": \"" << jsonEscape(compiler) << "\", \"asserts\": \"" << asserts
+        << "\", \"min_sample_ms\": " << opt.minSampleMs << ", \"repeats\": " << opt.repeats << "},\n";
+    out << "  \"results\": [\n";
+    char line[512];
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        std::snprintf(line, sizeof(line),
+                      "    {\"name\": \"%s\", \"size\": %d, \"items_per_op\": %lld, \"ops_per_sample\": %lld, "
+                      "\"samples\": %d, \"median_ns\": %.3f, \"p99_ns\": %.3f, \"min_ns\": %.3f, \"allocs_per_op\": %.4f}%s\n",
+                      jsonEscape(r.name).c_str(), r.size, (long long)r.itemsPerOp, (long long)r.opsPerSample, r.samples,
+                      r.medianNs, r.p99Ns, r.minNs, r.allocsPerOp, i + 1 < results.size() ? "," : "");
+        out << line;
+    }
+    out << "  ]\n}\n";
+}
+
+// Just enough JSON to read a results file back: objects, arrays, strings, numbers, true/false/null.
+// Result objects are picked out of the "results" array, everything else is skipped.
+class JsonReader
+{
+    public:
+    explicit JsonReader(const std::string& text) : s(text) {}
+
+    std::vector<Result> readResults()
+    {
+        std::vector<Result> out;
+        expect('{');
+        if (peek() == '}') return out;
+        for (;;) {
+            const std::string key = readString();
+            expect(':');
+            if (key == "format") {
+                const double format = readNumber();
+                if (format != RESULT_FORMAT_VERSION)
+                    fail("results format " + std::to_string(static_cast<int>(format)) + ", this build reads " + std::to_string(RESULT_FORMAT_VERSION));
+            } else if (key == "results") {
+                expect('[');
+                if (peek() != ']') {
+                    for (;;) {
+                        out.push_back(readResult());
+                        if (peek() != ',') break;
+                        pos++;
+                    }
+                }
+                expect(']');
+            } else {
+                skipValue();
+            }
+            if (peek() != ',') break;
+            pos++;
+        }
+        expect('}');
+        return out;
+    }
+
+    private:
+    Result readResult()
+    {
+        Result r;
+        expect('{');
+        if (peek() == '}') fail("empty result");
+        for (;;) {
+            const std::string key = readString();
+            expect(':');
+            if (key == "name") r.name = readString();
+            else if (key == "size") r.size = static_cast<int>(readNumber());
+            else if (key == "items_per_op") r.itemsPerOp = static_cast<std::int64_t>(readNumber());
+            else if (key == "ops_per_sample") r.opsPerSample = static_cast<std::int64_t>(readNumber());
+            else if (key == "samples") r.samples = static_cast<int>(readNumber());
+            else if (key == "median_ns") r.medianNs = readNumber();
+            else if (key == "p99_ns") r.p99Ns = readNumber();
+            else if (key == "min_ns") r.minNs = readNumber();
+            else if (key == "allocs_per_op") r.allocsPerOp = readNumber();
+            else skipValue();
+            if (peek() != ',') break;
+            pos++;
+        }
+        expect('}');
+        return r;
+    }
+
+    [[noreturn]] void fail(const std::string& what)
+    {
+        throw std::runtime_error("bad results JSON at byte " + std::to_string(pos) + ": " + what);
+    }
+
+    char peek()
+    {
+        while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos]))) pos++;
+        return pos < s.size() ? s[pos] : '\0';
+    }
+
+    void expect(char c)
+    {
+        if (peek() != c) fail(std::string("expected '") + c + "'");
+        pos++;
+    }
+
+    std::string readString()
+    {
+        expect('"');
+        std::string out;
+        while (pos < s.size() && s[pos] != '"') {
+            if (s[pos] == '\\' && pos + 1 < s.size()) pos++;
+            out += s[pos++];
+        }
+        if (pos >= s.size()) fail("unterminated string");
+        pos++;
+        return out;
+    }
+
+    double readNumber()
+    {
+        peek();
+        const char* start = s.c_str() + pos;
+        char* end = nullptr;
+        const double v = std::strtod(start, &end);
+        if (end == start) fail("expected a number");
+        pos += static_cast<std::size_t>(end - start);
+        return v;
+    }
+
+    void skipValue()
+    {
+        const char c = peek();
+        if (c == '"') {
+            readString();
+        } else if (c == '{' || c == '[') {
+            const char close = c == '{' ? '}' : ']';
+            pos++;
+            if (peek() == close) {
+                pos++;
+                return;
+            }
+            for (;;) {
+                if (c == '{') {
+                    readString();
+                    expect(':');
+                }
+                skipValue();
+                if (peek() != ',') break;
+                pos++;
+            }
+            expect(close);
+        } else if (s.compare(pos, 4, "true") == 0 || s.compare(pos, 4, "null") == 0) {
+            pos += 4;
+        } else if (s.compare(pos, 5, "false") == 0) {
+            pos += 5;
+        } else {
+            readNumber();
+        }
+    }
+
+    const std::string& s;
+    std::size_t pos = 0;
+};
+
+// prints one line per benchmark in both runs, returns how many regressed
+int compare(const std::vector<Result>& baseline, const std::vector<Result>& current, double thresholdPct)
+{
+    std::map<std::pair<std::string, int>, const Result*> base;
+    for (const Result& r : baseline) base[{ r.name, r.size }] = &r;
+
+    int regressions = 0;
+    std::printf("%-24s %6s %14s %14s %9s %11s  %s\n", "benchmark", "size", "base ns", "now ns", "change", "allocs/op", "");
+    for (const Result& r : current) {
+        auto it = base.find({ r.name, r.size });
+        if (it == base.end()) {
+            std::printf("%-24s %6d %14s %14.1f %9s %11.2f  new\n", r.name.c_str(), r.size, "-", r.medianNs, "-", r.allocsPerOp);
+            continue;
+        }
+        const Result& b = *it->second;
+        const double change = b.medianNs > 0.0 ? (r.medianNs / b.medianNs - 1.0) * 100.0 : 0.0;
+        // allocation counts don't jitter, any real increase is a change in the code
+        const bool moreAllocs = r.allocsPerOp > b.allocsPerOp + 0.01;
+        const char* status = "";
+        if (change > thresholdPct || moreAllocs) {
+            status = moreAllocs ? "REGRESSION (allocations)" : "REGRESSION";
+            regressions++;
+        } else if (change < -thresholdPct) {
+            status = "faster";
+        }
+        std::printf("%-24s %6d %14.1f %14.1f %+8.1f%% %11.2f  %s\n", r.name.c_str(), r.size, b.medianNs, r.medianNs,
+                    change, r.allocsPerOp, status);
+    }
+    return regressions;
+}
+
+std::vector<int> parseSizes(const std::string& list)
+{
+    std::vector<int> sizes;
+    std::stringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        const int v = std::atoi(item.c_str());
+        if (v <= 0) throw std::invalid_argument("--sizes wants positive numbers, e.g. 64,256,1024");
+        sizes.push_back(v);
+    }
+    return sizes;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument(arg + " needs a value");
+                return argv[++i];
+            };
+            if (arg == "--sizes") opt.sizes = parseSizes(next());
+            else if (arg == "--filter") opt.filter = next();
+            else if (arg == "--repeats") opt.repeats = std::max(1, std::atoi(next().c_str()));
+            else if (arg == "--warmup") opt.warmup = std::max(0, std::atoi(next().c_str()));
+            else if (arg == "--min-sample-ms") opt.minSampleMs = std::max(0.0, std::atof(next().c_str()));
+            else if (arg == "--mesh-cap-mb") opt.meshCapMb = std::atof(next().c_str());
+            else if (arg == "--json") opt.jsonPath = next();
+            else if (arg == "--baseline") opt.baselinePath = next();
+            else if (arg == "--threshold") opt.thresholdPct = std::max(0.0, std::atof(next().c_str()));
+            else throw std::invalid_argument("unknown option " + arg);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 2;
+    }
+
+    try {
+        // read the baseline first so a bad path fails before minutes of benchmarking
+        std::vector<Result> baseline;
+        if (!opt.baselinePath.empty()) {
+            std::ifstream in(opt.baselinePath);
+            if (!in) throw std::runtime_error("can't open baseline " + opt.baselinePath);
+            std::stringstream text;
+            text << in.rdbuf();
+            baseline = JsonReader(text.str()).readResults();
+        }
+
+        std::vector<Result> results;
+        runSuite(opt, results);
+
+        if (opt.jsonPath == "-") {
+            writeJson(std::cout, results, opt);
+        } else if (!opt.jsonPath.empty()) {
+            std::ofstream out(opt.jsonPath);
+            if (!out) throw std::runtime_error("can't write " + opt.jsonPath);
+            writeJson(out, results, opt);
+        }
+
+        if (!opt.baselinePath.empty()) {
+            const int regressions = compare(baseline, results, opt.thresholdPct);
+            std::printf("%d regression%s against %s (threshold %g%%)\n", regressions, regressions == 1 ? "" : "s",
+                        opt.baselinePath.c_str(), opt.thresholdPct);
+            return regressions == 0 ? 0 : 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,236 @@
+// Compares the old nested-vector tile storage against the flat per-field Grid
+// for Grid::tick() and buildMeshesFromGrid, plus what a full upload costs on the instanced
+// renderer path (one byte per tile).
+//
+// usage: grid_storage_bench [size ...] [--reps N] [--mesh-cap-mb MB]
+//   default sizes are 1000 and 4000 (square grids)
+//   the mesh step needs ~600 bytes per tile, sizes over the cap skip it
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Grid.hpp"
+#include "GridMesh.hpp"
+
+namespace {
+
+// the Tile/Grid layout from before the switch to per-field arrays, kept here as the baseline:
+// int-sized enums, 12 bytes per tile, one heap row per y
+enum class LegacyTileType { EMPTY, SOIL, CROP };
+enum class LegacyCropState { EMPTY, PLANTED, GROWN };
+
+struct LegacyTile
+{
+    LegacyTileType type = LegacyTileType::EMPTY;
+    LegacyCropState cropstate = LegacyCropState::EMPTY;
+    int growthTimer = 0;
+};
+
+class LegacyGrid
+{
+    public:
+    LegacyGrid(int w, int h) : grid_width(w), grid_height(h)
+    {
+        TileVector.resize(h);
+        for (int y = 0; y < h; y++) TileVector[y].resize(w);
+    }
+    int getGridWidth() const { return grid_width; }
+    int getGridHeight() const { return grid_height; }
+    LegacyTile& getTile(int x, int y)
+    {
+        if (x < 0 || x >= grid_width || y < 0 || y >= grid_height)
+            throw std::out_of_range("getTile out of range");
+        return TileVector[y][x];
+    }
+    const LegacyTile& getTile(int x, int y) const
+    {
+        if (x < 0 || x >= grid_width || y < 0 || y >= grid_height)
+            throw std::out_of_range("getTile out of range");
+        return TileVector[y][x];
+    }
+    void tick()
+    {
+        for (int y = 0; y < grid_height; y++) {
+            for (int x = 0; x < grid_width; x++) {
+                LegacyTile& t = TileVector[y][x];
+                if (t.type == LegacyTileType::CROP && t.cropstate == LegacyCropState::PLANTED) {
+                    t.growthTimer++;
+                    if (t.growthTimer >= Tile::GROWTH_TIME) t.cropstate = LegacyCropState::GROWN;
+                }
+            }
+        }
+    }
+
+    private:
+    std::vector<std::vector<LegacyTile>> TileVector;
+    int grid_width;
+    int grid_height;
+};
+
+Tile toTile(const LegacyTile& lt)
+{
+    Tile t;
+    t.type = static_cast<TileType>(lt.type);
+    t.cropstate = static_cast<CropState>(lt.cropstate);
+    t.growthTimer = lt.growthTimer;
+    return t;
+}
+
+// the old mesh helpers, one vector insert per vertex
+void legacyPushTri(std::vector<float>& v,
+                   float x0, float y0, float x1, float y1, float x2, float y2,
+                   float r, float g, float b)
+{
+    v.insert(v.end(), { x0, y0, r, g, b });
+    v.insert(v.end(), { x1, y1, r, g, b });
+    v.insert(v.end(), { x2, y2, r, g, b });
+}
+
+void legacyPushQuad(std::vector<float>& v, float left, float top, float right, float bottom, RGB c)
+{
+    legacyPushTri(v, left, top, right, top, right, bottom, c.r, c.g, c.b);
+    legacyPushTri(v, left, top, right, bottom, left, bottom, c.r, c.g, c.b);
+}
+
+// the old mesh loop: a checked getTile per tile through the nested vectors
+void legacyBuildMeshes(const LegacyGrid& grid, std::vector<float>& tiles, std::vector<float>& borders)
+{
+    tiles.clear();
+    borders.clear();
+    const int W = grid.getGridWidth();
+    const int H = grid.getGridHeight();
+    const float gridSize = 1.4f;
+    const float cellSize = gridSize / W;
+    const float startX = -gridSize / 2.0f;
+    const float startY = gridSize / 2.0f;
+    const float borderT = 0.01f;
+    const RGB borderC{ 0.05f, 0.05f, 0.05f };
+    tiles.reserve(static_cast<size_t>(W) * H * 6 * 5);
+    borders.reserve(static_cast<size_t>(W) * H * 4 * 6 * 5);
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            float left = startX + x * cellSize;
+            float top = startY - y * cellSize;
+            float right = left + cellSize;
+            float bottom = top - cellSize;
+            RGB c = colorForTile(toTile(grid.getTile(x, y)));
+            if ((x + y) % 2 == 0) { c.r += 0.02f; c.g += 0.02f; c.b += 0.02f; }
+            legacyPushQuad(tiles, left, top, right, bottom, c);
+            legacyPushQuad(borders, left, top, right, top - borderT, borderC);
+            legacyPushQuad(borders, left, bottom + borderT, right, bottom, borderC);
+            legacyPushQuad(borders, left, top, left + borderT, bottom, borderC);
+            legacyPushQuad(borders, right - borderT, top, right, bottom, borderC);
+        }
+    }
+}
+
+// same pseudo-random farm for both layouts: mostly empty/soil with ~10% crops at mixed timers
+Tile farmTileAt(std::mt19937& rng)
+{
+    std::uniform_int_distribution<int> roll(0, 99);
+    std::uniform_int_distribution<int> timer(0, Tile::GROWTH_TIME - 1);
+    Tile t;
+    int r = roll(rng);
+    if (r < 10) {
+        t.type = TileType::CROP;
+        t.cropstate = CropState::PLANTED;
+        t.growthTimer = timer(rng);
+    } else if (r < 40) {
+        t.type = TileType::SOIL;
+    }
+    return t;
+}
+
+void seedFarm(LegacyGrid& legacy, Grid& flat)
+{
+    std::mt19937 rng(1234);
+    for (int y = 0; y < flat.getGridHeight(); y++) {
+        for (int x = 0; x < flat.getGridWidth(); x++) {
+            Tile t = farmTileAt(rng);
+            flat.getTileUnchecked(x, y) = t;
+            LegacyTile& lt = legacy.getTile(x, y);
+            lt.type = static_cast<LegacyTileType>(t.type);
+            lt.cropstate = static_cast<LegacyCropState>(t.cropstate);
+            lt.growthTimer = t.growthTimer;
+        }
+    }
+}
+
+template <typename Fn>
+double medianMs(int reps, Fn&& fn)
+{
+    std::vector<double> samples;
+    for (int i = 0; i < reps; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+void report(const char* what, int size, double legacyMs, double flatMs)
+{
+    std::cout << what << " " << size << "x" << size
+              << "  legacy " << legacyMs << " ms"
+              << "  flat " << flatMs << " ms"
+              << "  speedup " << (flatMs > 0.0 ? legacyMs / flatMs : 0.0) << "x\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<int> sizes;
+    int reps = 5;
+    double meshCapMb = 3000.0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--reps" && i + 1 < argc) reps = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--mesh-cap-mb" && i + 1 < argc) meshCapMb = std::atof(argv[++i]);
+        else sizes.push_back(std::atoi(arg.c_str()));
+    }
+    if (sizes.empty()) sizes = { 1000, 4000 };
+
+    for (int size : sizes) {
+        if (size <= 0) continue;
+
+        LegacyGrid legacy(size, size);
+        Grid flat(size, size, GrowthMode::Scan);
+        seedFarm(legacy, flat);
+
+        double legacyTick = medianMs(reps, [&] { legacy.tick(); });
+        double flatTick = medianMs(reps, [&] { flat.tick(); });
+        report("tick", size, legacyTick, flatTick);
+
+        const double meshMb = static_cast<double>(size) * size * 150 * sizeof(float) / (1024.0 * 1024.0);
+
+        std::vector<std::uint8_t> codes;
+        double codesMs = medianMs(reps, [&] { buildTileCodes(flat, codes); });
+        std::cout << "instances " << size << "x" << size << "  " << codesMs << " ms  "
+                  << codes.size() / (1024.0 * 1024.0) << " MB per full upload vs "
+                  << meshMb << " MB of vertices\n";
+        if (meshMb > meshCapMb) {
+            std::cout << "mesh " << size << "x" << size << "  skipped (" << meshMb
+                      << " MB of vertices, raise --mesh-cap-mb to run)\n";
+            continue;
+        }
+
+        std::vector<float> tiles, borders, farmer;
+        double legacyMesh = medianMs(reps, [&] { legacyBuildMeshes(legacy, tiles, borders); });
+        tiles.clear(); tiles.shrink_to_fit();
+        borders.clear(); borders.shrink_to_fit();
+        double flatMesh = medianMs(reps, [&] { buildMeshesFromGrid(flat, 0, 0, tiles, borders, farmer); });
+        report("mesh", size, legacyMesh, flatMesh);
+    }
+    return 0;
+}
@@ -0,0 +1,197 @@
+// Event-driven growth vs the full-grid scan.
+//
+// Random plant / harvest / edit schedules go to a scalar Scan grid, a Scheduled grid, one
+// that flips modes mid-run and a Scan grid per SIMD growth kernel the CPU has. Every tile,
+// timer included, has to match after every tick. Timed: tick() for each on a big, sparsely
+// planted farm.
+//
+// usage: growth_bench [--seeds N] [--size S] [--density PERCENT] [--ticks N] [--verify-only]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Grid.hpp"
+
+namespace {
+
+std::vector<GrowthKernel> supportedKernels()
+{
+    std::vector<GrowthKernel> out;
+    for (GrowthKernel k : { GrowthKernel::Scalar, GrowthKernel::Sse2, GrowthKernel::Avx2 })
+        if (growthKernelSupported(k)) out.push_back(k);
+    return out;
+}
+
+bool sameTile(const Tile& a, const Tile& b)
+{
+    return a.type == b.type && a.cropstate == b.cropstate && a.growthTimer == b.growthTimer;
+}
+
+bool compareGrids(const Grid& expected, const Grid& actual, int seed, int tick, const char* label)
+{
+    const GridSpan<int> timers = actual.growthTimers();
+    for (int y = 0; y < expected.getGridHeight(); y++) {
+        for (int x = 0; x < expected.getGridWidth(); x++) {
+            const Tile e = expected.getTile(x, y);
+            const Tile a = actual.getTile(x, y);
+            if (!sameTile(e, a) || timers[actual.index(x, y)] != e.growthTimer) {
+                std::cerr << "MISMATCH (" << label << ") seed " << seed << " tick " << tick
+                          << " tile " << x << "," << y
+                          << " expected type " << int(e.type) << " state " << int(e.cropstate)
+                          << " timer " << e.growthTimer
+                          << " got type " << int(a.type) << " state " << int(a.cropstate)
+                          << " timer " << a.growthTimer << " (span " << timers[actual.index(x, y)] << ")\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// one random edit, mostly the plant/harvest pattern the game produces plus odd hand edits
+void randomEdit(std::mt19937& rng, int w, int h, std::vector<Grid*>& grids)
+{
+    const int x = std::uniform_int_distribution<int>(0, w - 1)(rng);
+    const int y = std::uniform_int_distribution<int>(0, h - 1)(rng);
+    const int kind = std::uniform_int_distribution<int>(0, 9)(rng);
+
+    Tile t;
+    switch (kind) {
+    case 0: case 1: case 2: case 3: // plant
+        t.type = TileType::CROP;
+        t.cropstate = CropState::PLANTED;
+        t.growthTimer = 0;
+        break;
+    case 4: case 5: // harvest back to soil
+        t.type = TileType::SOIL;
+        break;
+    case 6: { // poke just the timer through the old field-write API
+        const int timer = std::uniform_int_distribution<int>(-40, Tile::GROWTH_TIME + 10)(rng);
+        for (Grid* g : grids) g->getTile(x, y).growthTimer = timer;
+        return;
+    }
+    case 7: { // poke just the state
+        const CropState s = static_cast<CropState>(std::uniform_int_distribution<int>(0, 2)(rng));
+        for (Grid* g : grids) g->getTile(x, y).cropstate = s;
+        return;
+    }
+    default: // anything at all
+        t.type = static_cast<TileType>(std::uniform_int_distribution<int>(0, 2)(rng));
+        t.cropstate = static_cast<CropState>(std::uniform_int_distribution<int>(0, 2)(rng));
+        t.growthTimer = std::uniform_int_distribution<int>(-40, Tile::GROWTH_TIME + 10)(rng);
+        break;
+    }
+    for (Grid* g : grids) g->setTile(x, y, t);
+}
+
+bool verify(int seeds)
+{
+    for (int seed = 1; seed <= seeds; seed++) {
+        std::mt19937 rng(seed);
+        const int w = std::uniform_int_distribution<int>(1, 24)(rng);
+        const int h = std::uniform_int_distribution<int>(1, 24)(rng);
+        const int ticks = std::uniform_int_distribution<int>(20, 200)(rng);
+        const int editsPerTick = std::uniform_int_distribution<int>(0, 6)(rng);
+
+        Grid scan(w, h, GrowthMode::Scan);
+        scan.setGrowthKernel(GrowthKernel::Scalar);
+        Grid scheduled(w, h, GrowthMode::Scheduled);
+        Grid flipping(w, h, GrowthMode::Scheduled);
+        std::vector<Grid*> grids = { &scan, &scheduled, &flipping };
+        // the SIMD scans, widths that leave a tail most of the time
+        std::vector<Grid> simd;
+        for (GrowthKernel k : supportedKernels()) {
+            if (k == GrowthKernel::Scalar) continue;
+            simd.emplace_back(w, h, GrowthMode::Scan);
+            simd.back().setGrowthKernel(k);
+        }
+        for (Grid& g : simd) grids.push_back(&g);
+
+        for (int tick = 0; tick < ticks; tick++) {
+            for (int e = 0; e < editsPerTick; e++) randomEdit(rng, w, h, grids);
+            if (std::uniform_int_distribution<int>(0, 15)(rng) == 0) {
+                flipping.setGrowthMode(flipping.getGrowthMode() == GrowthMode::Scan
+                    ? GrowthMode::Scheduled : GrowthMode::Scan);
+            }
+            for (Grid* g : grids) g->tick();
+
+            if (!compareGrids(scan, scheduled, seed, tick, "scheduled")) return false;
+            if (!compareGrids(scan, flipping, seed, tick, "mode switch")) return false;
+            for (const Grid& g : simd)
+                if (!compareGrids(scan, g, seed, tick, growthKernelName(g.getGrowthKernel()))) return false;
+        }
+    }
+    return true;
+}
+
+double timeTicks(Grid& grid, int ticks)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; i++) grid.tick();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / ticks;
+}
+
+// plants `density` percent of the farm, spread over the growth window so crops ripen every tick
+void plantFarm(Grid& grid, int density)
+{
+    std::mt19937 rng(99);
+    std::uniform_int_distribution<int> roll(0, 999);
+    std::uniform_int_distribution<int> timer(0, Tile::GROWTH_TIME - 1);
+    Tile crop;
+    crop.type = TileType::CROP;
+    crop.cropstate = CropState::PLANTED;
+    for (int y = 0; y < grid.getGridHeight(); y++) {
+        for (int x = 0; x < grid.getGridWidth(); x++) {
+            if (roll(rng) < density * 10) {
+                crop.growthTimer = timer(rng);
+                grid.setTile(x, y, crop);
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int seeds = 300;
+    int size = 2000;
+    int density = 1;
+    int ticks = 60;
+    bool verifyOnly = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seeds" && i + 1 < argc) seeds = std::atoi(argv[++i]);
+        else if (arg == "--size" && i + 1 < argc) size = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--density" && i + 1 < argc) density = std::clamp(std::atoi(argv[++i]), 0, 100);
+        else if (arg == "--ticks" && i + 1 < argc) ticks = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--verify-only") verifyOnly = true;
+    }
+
+    if (!verify(seeds)) return 1;
+    std::cout << "differential check passed (" << seeds << " random schedules)\n";
+    if (verifyOnly) return 0;
+
+    Grid scheduled(size, size, GrowthMode::Scheduled);
+    plantFarm(scheduled, density);
+
+    // crops ripen within GROWTH_TIME ticks, time the window where they are still growing
+    const int window = std::min(ticks, Tile::GROWTH_TIME);
+    const double schedMs = timeTicks(scheduled, window);
+    std::cout << "tick " << size << "x" << size << " at " << density << "% planted, scheduled " << schedMs << " ms\n";
+    for (GrowthKernel k : supportedKernels()) {
+        Grid scan(size, size, GrowthMode::Scan);
+        scan.setGrowthKernel(k);
+        plantFarm(scan, density);
+        const double scanMs = timeTicks(scan, window);
+        std::cout << "  scan (" << growthKernelName(k) << ") " << scanMs << " ms, scheduled is "
+                  << (schedMs > 0.0 ? scanMs / schedMs : 0.0) << "x faster\n";
+    }
+    return 0;
+}
@@ -0,0 +1,241 @@
+// Level packs: mapping a precompiled pack vs parsing ASCII layouts on every load.
+//
+// Random level sets (every layout character, walls, objectives) go through a pack file and
+// back. Every level loaded into a reused grid has to hash the same as its layout parsed and
+// applied, with the same crops, objective and commands, and flipped bytes and truncated files
+// have to be refused. Timed: opening a pack of thousands of levels and switching between them,
+// against parsing their layouts.
+//
+// usage: level_pack_bench [--seeds N] [--levels N] [--verify-only]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Farmer.hpp"
+#include "Grid.hpp"
+#include "LevelPack.hpp"
+#include "Simulation.hpp"
+
+namespace {
+
+LevelSource randomLevel(std::mt19937& rng, int number, int maxSize)
+{
+    static const std::string chars = "....XSPGWCTR";
+    const int w = std::uniform_int_distribution<int>(1, maxSize)(rng);
+    const int h = std::uniform_int_distribution<int>(1, maxSize)(rng);
+    std::ostringstream text;
+    const int fx = std::uniform_int_distribution<int>(0, w - 1)(rng);
+    const int fy = std::uniform_int_distribution<int>(0, h - 1)(rng);
+    const bool hasFarmer = std::uniform_int_distribution<int>(0, 9)(rng) > 0;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (hasFarmer && x == fx && y == fy) text << 'F';
+            else text << chars[std::uniform_int_distribution<std::size_t>(0, chars.size() - 1)(rng)];
+        }
+        text << "\n";
+    }
+
+    LevelSource level;
+    level.number = number;
+    level.name = "Level " + std::to_string(number);
+    level.hint = std::uniform_int_distribution<int>(0, 1)(rng) ? "" : "hint for " + std::to_string(number);
+    std::istringstream in(text.str());
+    level.layout = parseLayout(in);
+    level.harvestsRequired = std::uniform_int_distribution<int>(1, 60)(rng);
+    for (int k = 1; k < CROP_KIND_COUNT; k++)
+        if (std::uniform_int_distribution<int>(0, 2)(rng) == 0)
+            level.cropRequirements.emplace_back(static_cast<CropKind>(k), std::uniform_int_distribution<int>(1, 15)(rng));
+    level.timeLimitSeconds = std::uniform_int_distribution<int>(0, 1)(rng) ? -1.0 : std::uniform_int_distribution<int>(1, 900)(rng) / 10.0;
+    for (const std::string& command : levelPackCommandNames())
+        if (std::uniform_int_distribution<int>(0, 1)(rng)) level.allowed.push_back(command);
+    return level;
+}
+
+bool sameLevel(const LevelSource& src, const LevelPack& pack, int index, Grid& grid, Farmer& farmer)
+{
+    Grid expected(src.layout.width, src.layout.height);
+    applyLayout(src.layout, expected);
+    Farmer expectedFarmer(expected, src.layout.startX, src.layout.startY);
+
+    pack.loadLevel(index, grid, farmer);
+    if (hashState(grid, farmer) != hashState(expected, expectedFarmer) || grid.getTickCount() != 0)
+        return false;
+
+    // the growth schedule has to come out the same too, not just the fields
+    for (int t = 0; t < Tile::GROWTH_TIME + 1; t++) {
+        grid.tick();
+        expected.tick();
+    }
+    if (hashState(grid, farmer) != hashState(expected, expectedFarmer)) return false;
+
+    const PackedLevel l = pack.level(index);
+    const std::vector<CropKind> crops = layoutCrops(src.layout);
+    if (!std::equal(crops.begin(), crops.end(), l.crops)) return false;
+    if (l.number != src.number || l.name != src.name || l.hint != src.hint || l.harvestsRequired != src.harvestsRequired)
+        return false;
+    if ((src.timeLimitSeconds < 0) != (l.timeLimitSeconds < 0)
+        || (src.timeLimitSeconds >= 0 && std::abs(l.timeLimitSeconds - src.timeLimitSeconds) > 1e-3))
+        return false;
+    if (l.objective().cropRequirements != src.cropRequirements || l.allowedCommands() != src.allowed) return false;
+    return true;
+}
+
+bool expectThrow(std::vector<std::uint8_t> bytes, LevelPackCheck check)
+{
+    try {
+        LevelPack::fromBytes(std::move(bytes), check);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+bool verify(int seeds, const std::string& path)
+{
+    for (int seed = 1; seed <= seeds; seed++) {
+        std::mt19937 rng(seed);
+        std::vector<LevelSource> levels;
+        const int count = std::uniform_int_distribution<int>(1, 12)(rng);
+        for (int i = 0; i < count; i++) levels.push_back(randomLevel(rng, i + 1, seed % 5 == 0 ? 70 : 12));
+
+        saveLevelPack(levels, path);
+        const LevelPack pack = LevelPack::open(path);
+        const LevelPack indexOnly = LevelPack::open(path, LevelPackCheck::Index);
+        // one grid for every level, like switching levels in the game
+        Grid grid(1, 1);
+        Farmer farmer(grid);
+        for (int i = 0; i < count; i++) {
+            const int pick = std::uniform_int_distribution<int>(0, count - 1)(rng);
+            if (!sameLevel(levels[pick], pack, pick, grid, farmer) || !sameLevel(levels[pick], indexOnly, pick, grid, farmer)
+                || !indexOnly.verifyLevel(pick) || pack.indexOfNumber(levels[pick].number) != pick) {
+                std::cerr << "MISMATCH seed " << seed << ": level " << levels[pick].number << " differs from its layout\n";
+                return false;
+            }
+        }
+
+        const std::vector<std::uint8_t> bytes = buildLevelPack(levels);
+        for (int flip = 0; flip < 8; flip++) {
+            std::vector<std::uint8_t> bad = bytes;
+            const std::size_t at = std::uniform_int_distribution<std::size_t>(0, bad.size() - 1)(rng);
+            bad[at] ^= static_cast<std::uint8_t>(std::uniform_int_distribution<int>(1, 255)(rng));
+            if (!expectThrow(bad, LevelPackCheck::Full)) {
+                std::cerr << "MISMATCH seed " << seed << ": a flipped byte at " << at << " was accepted\n";
+                return false;
+            }
+        }
+        const std::size_t cut = std::uniform_int_distribution<std::size_t>(0, bytes.size() - 1)(rng);
+        if (!expectThrow(std::vector<std::uint8_t>(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(cut)), LevelPackCheck::Index)) {
+            std::cerr << "MISMATCH seed " << seed << ": a pack cut at " << cut << " bytes was accepted\n";
+            return false;
+        }
+        // a damaged tile block gets past an index-only open but not verifyLevel
+        std::vector<std::uint8_t> damaged = bytes;
+        const int victim = std::uniform_int_distribution<int>(0, count - 1)(rng);
+        damaged[damaged.size() - 1 - std::uniform_int_distribution<std::size_t>(0, 3)(rng)] ^= 1;
+        const LevelPack partial = LevelPack::fromBytes(damaged, LevelPackCheck::Index);
+        if (partial.verifyLevel(count - 1) || (victim != count - 1 && !partial.verifyLevel(victim))) {
+            std::cerr << "MISMATCH seed " << seed << ": verifyLevel missed a damaged tile block\n";
+            return false;
+        }
+        // and loadLevel won't copy it into a grid
+        try {
+            Grid grid(1, 1);
+            Farmer farmer(grid);
+            partial.loadLevel(count - 1, grid, farmer);
+            std::cerr << "MISMATCH seed " << seed << ": loadLevel took a damaged tile block\n";
+            return false;
+        } catch (const std::runtime_error&) {
+        }
+    }
+    return true;
+}
+
+template <typename Fn>
+double timeMs(Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int seeds = 200;
+    int levelCount = 5000;
+    bool verifyOnly = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seeds" && i + 1 < argc) seeds = std::atoi(argv[++i]);
+        else if (arg == "--levels" && i + 1 < argc) levelCount = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--verify-only") verifyOnly = true;
+    }
+
+    const std::string path = (std::filesystem::temp_directory_path() / "level_pack_bench.pack").string();
+    const bool ok = verify(seeds, path);
+    if (ok) std::cout << "differential check passed (" << seeds << " random level sets)\n";
+    if (!ok || verifyOnly) {
+        std::remove(path.c_str());
+        return ok ? 0 : 1;
+    }
+
+    std::mt19937 rng(3);
+    std::vector<LevelSource> levels;
+    std::vector<std::string> texts;
+    for (int i = 0; i < levelCount; i++) {
+        levels.push_back(randomLevel(rng, i + 1, 40));
+        std::string text;
+        for (const std::string& row : levels.back().layout.rows) text += row + "\n";
+        texts.push_back(text);
+    }
+    saveLevelPack(levels, path);
+
+    LevelPack pack = LevelPack::open(path, LevelPackCheck::Index);
+    const double openIndexMs = timeMs([&] { pack = LevelPack::open(path, LevelPackCheck::Index); });
+    const double openFullMs = timeMs([&] { pack = LevelPack::open(path, LevelPackCheck::Full); });
+    std::cout << levelCount << " levels up to 40x40, " << pack.sizeBytes() / 1024 << " KB pack"
+              << (pack.isMapped() ? " (mapped)" : "") << "\n";
+    std::cout << "  open, index check  " << openIndexMs << " ms\n";
+    std::cout << "  open, full check   " << openFullMs << " ms\n";
+
+    Grid grid(1, 1);
+    Farmer farmer(grid);
+    std::vector<int> order(static_cast<std::size_t>(levelCount));
+    for (int i = 0; i < levelCount; i++) order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::uint64_t sink = 0;
+    const double parseMs = timeMs([&] {
+        for (int i : order) {
+            std::istringstream in(texts[i]);
+            const Layout layout = parseLayout(in);
+            grid.reset(layout.width, layout.height);
+            applyLayout(layout, grid);
+            farmer.reset(layout.startX, layout.startY);
+            sink += static_cast<std::uint64_t>(grid.tileCount());
+        }
+    });
+    const double packMs = timeMs([&] {
+        for (int i : order) {
+            pack.loadLevel(i, grid, farmer);
+            sink += static_cast<std::uint64_t>(grid.tileCount());
+        }
+    });
+    std::cout << "  parse + apply      " << parseMs * 1e3 / levelCount << " us a level\n";
+    std::cout << "  pack load          " << packMs * 1e3 / levelCount << " us a level (" << parseMs / std::max(packMs, 1e-9)
+              << "x)\n";
+    std::remove(path.c_str());
+    return sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,221 @@
+// 16-bit packed tiles with the SIMD growth step vs the Grid scan.
+//
+// Random plant / harvest / edit schedules go to a Scan Grid and to a PackedGrid per
+// supported growth kernel, at odd sizes so the SIMD tails run. Every tile, timer included,
+// has to match after every tick. Timed: tick() for the Grid scan and each kernel on a big
+// farm.
+//
+// usage: packed_grid_bench [--seeds N] [--size S] [--ticks N] [--threads N] [--packed-only]
+//                          [--verify-only]
+//   --packed-only  skip the Grid, for sizes it won't fit in memory for (--size 10000 is 100M tiles)
+//   --threads      also time tickParallel over N threads
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Grid.hpp"
+#include "PackedGrid.hpp"
+#include "WorkerPool.hpp"
+
+namespace {
+
+std::vector<GrowthKernel> supportedKernels()
+{
+    std::vector<GrowthKernel> out;
+    for (GrowthKernel k : { GrowthKernel::Scalar, GrowthKernel::Sse2, GrowthKernel::Avx2 })
+        if (growthKernelSupported(k)) out.push_back(k);
+    return out;
+}
+
+bool compareGrids(const Grid& expected, const PackedGrid& actual, int seed, int tick)
+{
+    for (int y = 0; y < expected.getGridHeight(); y++) {
+        for (int x = 0; x < expected.getGridWidth(); x++) {
+            const Tile e = expected.getTile(x, y);
+            const Tile a = actual.getTile(x, y);
+            if (e.type != a.type || e.cropstate != a.cropstate || e.growthTimer != a.growthTimer) {
+                std::cerr << "MISMATCH (" << growthKernelName(actual.getKernel()) << ") seed " << seed
+                          << " tick " << tick << " tile " << x << "," << y
+                          << " expected type " << int(e.type) << " state " << int(e.cropstate)
+                          << " timer " << e.growthTimer
+                          << " got type " << int(a.type) << " state " << int(a.cropstate)
+                          << " timer " << a.growthTimer << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// one random edit: the plant/harvest pattern the game produces plus odd timers, including
+// the ends of the packed timer range
+void randomEdit(std::mt19937& rng, Grid& grid, std::vector<PackedGrid>& packed)
+{
+    const int x = std::uniform_int_distribution<int>(0, grid.getGridWidth() - 1)(rng);
+    const int y = std::uniform_int_distribution<int>(0, grid.getGridHeight() - 1)(rng);
+    const int kind = std::uniform_int_distribution<int>(0, 9)(rng);
+
+    Tile t;
+    switch (kind) {
+    case 0: case 1: case 2: case 3: // plant
+        t.type = TileType::CROP;
+        t.cropstate = CropState::PLANTED;
+        break;
+    case 4: case 5: // harvest back to soil
+        t.type = TileType::SOIL;
+        break;
+    case 6: // a planted crop at the edge of what fits
+        t.type = TileType::CROP;
+        t.cropstate = CropState::PLANTED;
+        t.growthTimer = std::uniform_int_distribution<int>(0, 1)(rng) ? PackedTile::MAX_GROWING_TIMER : PackedTile::MIN_TIMER;
+        break;
+    default: // anything at all
+        t.type = static_cast<TileType>(std::uniform_int_distribution<int>(0, 2)(rng));
+        t.cropstate = static_cast<CropState>(std::uniform_int_distribution<int>(0, 2)(rng));
+        t.growthTimer = std::uniform_int_distribution<int>(-40, Tile::GROWTH_TIME + 10)(rng);
+        break;
+    }
+    grid.setTile(x, y, t);
+    for (PackedGrid& p : packed) p.setTile(x, y, t);
+}
+
+bool verify(int seeds)
+{
+    const std::vector<GrowthKernel> kernels = supportedKernels();
+    WorkerPool pool(3);
+    for (int seed = 1; seed <= seeds; seed++) {
+        std::mt19937 rng(seed);
+        const int w = std::uniform_int_distribution<int>(1, 70)(rng);
+        const int h = std::uniform_int_distribution<int>(1, 40)(rng);
+        const int ticks = std::uniform_int_distribution<int>(20, 120)(rng);
+        const int editsPerTick = std::uniform_int_distribution<int>(0, 12)(rng);
+
+        Grid grid(w, h, GrowthMode::Scan);
+        std::vector<PackedGrid> packed;
+        for (GrowthKernel k : kernels) {
+            packed.emplace_back(w, h);
+            packed.back().setKernel(k);
+        }
+
+        for (int tick = 0; tick < ticks; tick++) {
+            for (int e = 0; e < editsPerTick; e++) randomEdit(rng, grid, packed);
+            grid.tick();
+            for (PackedGrid& p : packed) {
+                p.tick();
+                if (!compareGrids(grid, p, seed, tick)) return false;
+            }
+        }
+
+        // and the conversions both ways land on the same farm
+        PackedGrid copied(grid);
+        Grid back(1, 1, GrowthMode::Scan);
+        copied.copyTo(back);
+        back.tick();
+        copied.tickParallel(pool);
+        if (!compareGrids(back, copied, seed, ticks)) return false;
+    }
+    return true;
+}
+
+// a tenth planted at timers spread over the growth window, a third soil
+template <typename G>
+void seedFarm(G& grid)
+{
+    std::mt19937 rng(4321);
+    std::uniform_int_distribution<int> roll(0, 99);
+    std::uniform_int_distribution<int> timer(-200, Tile::GROWTH_TIME - 1);
+    Tile t;
+    for (int y = 0; y < grid.getGridHeight(); y++) {
+        for (int x = 0; x < grid.getGridWidth(); x++) {
+            const int r = roll(rng);
+            if (r < 10) {
+                t.type = TileType::CROP;
+                t.cropstate = CropState::PLANTED;
+                t.growthTimer = timer(rng);
+            } else if (r < 40) {
+                t.type = TileType::SOIL;
+                t.cropstate = CropState::EMPTY;
+                t.growthTimer = 0;
+            } else {
+                continue;
+            }
+            grid.setTile(x, y, t);
+        }
+    }
+}
+
+template <typename Tick>
+double timeTicks(int ticks, Tick&& tick)
+{
+    tick(); // warm up, first touch of the pages
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; i++) tick();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / ticks;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int seeds = 200;
+    int size = 4000;
+    int ticks = 20;
+    int threads = 0;
+    bool packedOnly = false;
+    bool verifyOnly = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seeds" && i + 1 < argc) seeds = std::atoi(argv[++i]);
+        else if (arg == "--size" && i + 1 < argc) size = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--ticks" && i + 1 < argc) ticks = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--packed-only") packedOnly = true;
+        else if (arg == "--verify-only") verifyOnly = true;
+    }
+
+    std::cout << "growth kernels on this CPU:";
+    for (GrowthKernel k : supportedKernels()) std::cout << " " << growthKernelName(k);
+    std::cout << " (default " << growthKernelName(bestGrowthKernel()) << ")\n";
+
+    if (!verify(seeds)) return 1;
+    std::cout << "differential check passed (" << seeds << " random schedules)\n";
+    if (verifyOnly) return 0;
+
+    const double tiles = static_cast<double>(size) * size;
+    std::cout << "tick " << size << "x" << size << "\n";
+
+    double gridMs = 0.0;
+    if (!packedOnly) {
+        Grid grid(size, size, GrowthMode::Scan);
+        seedFarm(grid);
+        gridMs = timeTicks(ticks, [&] { grid.tick(); });
+        std::cout << "  grid scan      " << gridMs << " ms  ("
+                  << (sizeof(TileType) + sizeof(CropState) + sizeof(int)) * tiles / 1e6 << " MB)\n";
+    }
+
+    PackedGrid packed(size, size);
+    seedFarm(packed);
+    for (GrowthKernel k : supportedKernels()) {
+        packed.setKernel(k);
+        const double ms = timeTicks(ticks, [&] { packed.tick(); });
+        std::cout << "  packed " << growthKernelName(k) << std::string(8 - std::string(growthKernelName(k)).size(), ' ')
+                  << ms << " ms  (" << sizeof(std::uint16_t) * tiles / 1e6 << " MB)";
+        if (gridMs > 0.0) std::cout << "  " << gridMs / ms << "x";
+        std::cout << "\n";
+    }
+
+    if (threads > 0) {
+        WorkerPool pool(threads);
+        packed.setKernel(bestGrowthKernel());
+        const double ms = timeTicks(ticks, [&] { packed.tickParallel(pool); });
+        std::cout << "  packed " << growthKernelName(bestGrowthKernel()) << " x" << pool.getThreadCount()
+                  << " threads  " << ms << " ms\n";
+    }
+    return 0;
+}
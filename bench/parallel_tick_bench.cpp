@@ -0,0 +1,123 @@
+// Scaling of Grid::tickParallel over thread counts, checked bit for bit against serial tick().
+//
+// usage: parallel_tick_bench [--size S] [--ticks N] [--threads 1,2,4,8,...]
+//   default size 6000 (36M tiles), threads 1,2,4,8 and the machine's hardware thread count
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Grid.hpp"
+#include "WorkerPool.hpp"
+
+namespace {
+
+void seedFarm(Grid& grid)
+{
+    std::mt19937 rng(4321);
+    std::uniform_int_distribution<int> roll(0, 99);
+    std::uniform_int_distribution<int> timer(-200, Tile::GROWTH_TIME - 1);
+    Tile t;
+    for (int y = 0; y < grid.getGridHeight(); y++) {
+        for (int x = 0; x < grid.getGridWidth(); x++) {
+            const int r = roll(rng);
+            if (r < 10) {
+                t.type = TileType::CROP;
+                t.cropstate = CropState::PLANTED;
+                t.growthTimer = timer(rng);
+            } else if (r < 40) {
+                t.type = TileType::SOIL;
+                t.cropstate = CropState::EMPTY;
+                t.growthTimer = 0;
+            } else {
+                continue;
+            }
+            grid.setTile(x, y, t);
+        }
+    }
+}
+
+template <typename T>
+bool sameSpan(GridSpan<T> a, GridSpan<T> b)
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+bool identical(const Grid& a, const Grid& b)
+{
+    return a.getTickCount() == b.getTickCount()
+        && sameSpan(a.types(), b.types())
+        && sameSpan(a.cropStates(), b.cropStates())
+        && sameSpan(a.growthTimers(), b.growthTimers());
+}
+
+std::vector<int> parseThreads(const std::string& list)
+{
+    std::vector<int> out;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        const int n = std::atoi(item.c_str());
+        if (n > 0) out.push_back(n);
+    }
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int size = 6000;
+    int ticks = 20;
+    const int hardware = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> threadCounts = { 1, 2, 4, 8, hardware };
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc) size = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--ticks" && i + 1 < argc) ticks = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threadCounts = parseThreads(argv[++i]);
+    }
+    std::sort(threadCounts.begin(), threadCounts.end());
+    threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+
+    Grid base(size, size, GrowthMode::Scan);
+    seedFarm(base);
+
+    Grid reference = base;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < ticks; t++) reference.tick();
+    auto end = std::chrono::steady_clock::now();
+    const double serialMs = std::chrono::duration<double, std::milli>(end - start).count() / ticks;
+
+    const double tiles = static_cast<double>(size) * size;
+    std::cout << size << "x" << size << " (" << tiles / 1e6 << "M tiles), " << ticks << " ticks, "
+              << hardware << " hardware threads\n";
+    std::cout << "serial tick()   " << serialMs << " ms/tick  "
+              << tiles / (serialMs * 1e3) << " Mtiles/s\n";
+
+    bool allMatch = true;
+    for (int threads : threadCounts) {
+        WorkerPool pool(threads);
+        Grid grid = base;
+
+        start = std::chrono::steady_clock::now();
+        for (int t = 0; t < ticks; t++) grid.tickParallel(pool);
+        end = std::chrono::steady_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>(end - start).count() / ticks;
+
+        const bool match = identical(reference, grid);
+        allMatch = allMatch && match;
+        std::cout << "threads " << threads << "\t" << ms << " ms/tick  "
+                  << tiles / (ms * 1e3) << " Mtiles/s  speedup " << serialMs / ms
+                  << "x  efficiency " << 100.0 * serialMs / ms / threads << "%"
+                  << (match ? "" : "  MISMATCH vs serial") << "\n";
+    }
+    return allMatch ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+// Path planning over walls: cached distance fields vs searching from scratch.
+//
+// Random walled grids get wall edits between queries. Every cached field, patched or rebuilt,
+// has to match a fresh BFS, BFS and A* have to agree on route lengths, routes have to walk,
+// and the batched distance matrix has to match the single queries. Timed: single queries,
+// cached route steps and the all-pairs matrix.
+//
+// usage: path_bench [--seeds N] [--size S] [--targets N] [--threads N] [--verify-only]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Grid.hpp"
+#include "PathPlanner.hpp"
+#include "WorkerPool.hpp"
+
+namespace {
+
+GridPoint randomPoint(std::mt19937& rng, const Grid& grid)
+{
+    return { std::uniform_int_distribution<int>(0, grid.getGridWidth() - 1)(rng),
+             std::uniform_int_distribution<int>(0, grid.getGridHeight() - 1)(rng) };
+}
+
+void randomWalls(std::mt19937& rng, Grid& grid, int percent)
+{
+    std::uniform_int_distribution<int> roll(0, 99);
+    for (int y = 0; y < grid.getGridHeight(); y++)
+        for (int x = 0; x < grid.getGridWidth(); x++)
+            grid.setWalkable(x, y, roll(rng) >= percent);
+}
+
+// the farmer actually gets from a to b with these moves, through walkable tiles only
+bool walks(Grid& grid, GridPoint a, GridPoint b, const std::vector<direction>& moves)
+{
+    Farmer farmer(grid, a.x, a.y);
+    for (direction d : moves)
+        if (!farmer.move(d)) return false;
+    return farmer.getX() == b.x && farmer.getY() == b.y;
+}
+
+bool verify(int seeds)
+{
+    WorkerPool pool(3);
+    for (int seed = 1; seed <= seeds; seed++) {
+        std::mt19937 rng(seed);
+        const int w = std::uniform_int_distribution<int>(1, 40)(rng);
+        const int h = std::uniform_int_distribution<int>(1, 30)(rng);
+        Grid grid(w, h);
+        randomWalls(rng, grid, std::uniform_int_distribution<int>(0, 45)(rng));
+        PathPlanner planner(grid, std::uniform_int_distribution<int>(1, 8)(rng));
+
+        std::vector<GridPoint> targets;
+        for (int i = 0; i < 6; i++) targets.push_back(randomPoint(rng, grid));
+
+        for (int round = 0; round < 30; round++) {
+            // a few wall edits, occasionally more than the grid's edit log keeps
+            const int edits = std::uniform_int_distribution<int>(0, 6)(rng);
+            for (int e = 0; e < edits; e++) {
+                const GridPoint p = randomPoint(rng, grid);
+                grid.setWalkable(p.x, p.y, !grid.isWalkable(p.x, p.y));
+            }
+            if (round == 20 && seed % 10 == 0)
+                for (int e = 0; e < 5000; e++) grid.setWalkable(0, 0, e % 2 == 0);
+
+            for (const GridPoint& t : targets) {
+                const DistanceField& cached = planner.field(t);
+                PathPlanner reference(grid, 1);
+                const std::vector<int>& expected = reference.field(t).distance;
+                if (cached.distance != expected) {
+                    std::cerr << "MISMATCH seed " << seed << " round " << round << ": cached field to "
+                              << t.x << "," << t.y << " differs from a fresh BFS\n";
+                    return false;
+                }
+            }
+
+            const GridPoint a = randomPoint(rng, grid);
+            const GridPoint b = targets[std::uniform_int_distribution<int>(0, 5)(rng)];
+            const PathResult bfs = planner.findPath(a, b, PathSearch::Bfs);
+            const PathResult astar = planner.findPath(a, b, PathSearch::AStar);
+            const int d = planner.distance(a, b);
+            const std::vector<direction> route = planner.route(a, b);
+            const bool reachable = d != DistanceField::UNREACHABLE;
+            if (bfs.found != reachable || astar.found != reachable
+                || (reachable && (static_cast<int>(bfs.moves.size()) != d || static_cast<int>(astar.moves.size()) != d
+                                  || static_cast<int>(route.size()) != d))) {
+                std::cerr << "MISMATCH seed " << seed << " round " << round << ": route lengths disagree ("
+                          << d << " field, " << bfs.moves.size() << " bfs, " << astar.moves.size() << " a*, "
+                          << route.size() << " route)\n";
+                return false;
+            }
+            if (reachable && (!walks(grid, a, b, bfs.moves) || !walks(grid, a, b, astar.moves) || !walks(grid, a, b, route))) {
+                std::cerr << "MISMATCH seed " << seed << " round " << round << ": a route doesn't walk\n";
+                return false;
+            }
+
+            std::vector<GridPoint> points = targets;
+            points.push_back(a);
+            const std::vector<int> matrix = planner.distanceMatrix(points, pool);
+            for (std::size_t i = 0; i < points.size(); i++) {
+                for (std::size_t j = 0; j < points.size(); j++) {
+                    PathPlanner reference(grid, 1);
+                    if (matrix[i * points.size() + j] != reference.distance(points[j], points[i])) {
+                        std::cerr << "MISMATCH seed " << seed << " round " << round << ": distance matrix\n";
+                        return false;
+                    }
+                }
+            }
+            if (round % 7 == 0) planner.prepare(targets, pool);
+        }
+    }
+    return true;
+}
+
+template <typename Fn>
+double timeMs(Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int seeds = 100;
+    int size = 512;
+    int targets = 256;
+    int threads = 0;
+    bool verifyOnly = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seeds" && i + 1 < argc) seeds = std::atoi(argv[++i]);
+        else if (arg == "--size" && i + 1 < argc) size = std::max(2, std::atoi(argv[++i]));
+        else if (arg == "--targets" && i + 1 < argc) targets = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) threads = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--verify-only") verifyOnly = true;
+    }
+
+    if (!verify(seeds)) return 1;
+    std::cout << "differential check passed (" << seeds << " random walled grids)\n";
+    if (verifyOnly) return 0;
+
+    std::mt19937 rng(99);
+    Grid grid(size, size);
+    randomWalls(rng, grid, 25);
+    PathPlanner planner(grid, 64);
+    std::vector<GridPoint> points;
+    for (int i = 0; i < targets; i++) {
+        GridPoint p = randomPoint(rng, grid);
+        grid.setWalkable(p.x, p.y, true);
+        points.push_back(p);
+    }
+    std::cout << size << "x" << size << ", 25% walls\n";
+
+    const int queries = 200;
+    long long expandedBfs = 0, expandedAStar = 0;
+    const double bfsMs = timeMs([&] {
+        for (int q = 0; q < queries; q++)
+            expandedBfs += planner.findPath(points[q % targets], points[(q * 7 + 1) % targets], PathSearch::Bfs).expanded;
+    });
+    const double astarMs = timeMs([&] {
+        for (int q = 0; q < queries; q++)
+            expandedAStar += planner.findPath(points[q % targets], points[(q * 7 + 1) % targets], PathSearch::AStar).expanded;
+    });
+    std::cout << "  bfs query          " << bfsMs * 1e3 / queries << " us  (" << expandedBfs / queries << " tiles expanded)\n";
+    std::cout << "  a* query           " << astarMs * 1e3 / queries << " us  (" << expandedAStar / queries << " tiles expanded)\n";
+
+    const GridPoint target = points[0];
+    const double buildMs = timeMs([&] { planner.field(target); });
+    long long steps = 0;
+    const double stepMs = timeMs([&] {
+        for (int q = 0; q < queries; q++) {
+            GridPoint at = points[q % targets];
+            direction d;
+            while (planner.nextStep(at, target, d)) {
+                at.x += d == LEFT ? -1 : d == RIGHT ? 1 : 0;
+                at.y += d == UP ? -1 : d == DOWN ? 1 : 0;
+                steps++;
+            }
+        }
+    });
+    std::cout << "  field build        " << buildMs * 1e3 << " us\n";
+    std::cout << "  cached step        " << (steps ? stepMs * 1e6 / steps : 0.0) << " ns  (" << steps << " steps)\n";
+
+    // a wall appearing and disappearing somewhere the field reaches
+    const GridPoint edit = points[1];
+    const double editMs = timeMs([&] {
+        for (int q = 0; q < queries; q++) {
+            grid.setWalkable(edit.x, edit.y, q % 2 == 1);
+            planner.field(target);
+        }
+    });
+    std::cout << "  wall toggle + sync " << editMs * 1e3 / queries << " us  (" << planner.getStats().patched
+              << " patched, " << planner.getStats().invalidated << " rebuilt)\n";
+
+    // serial, then across the pool (--threads 0 is one per hardware thread)
+    WorkerPool serial(1);
+    WorkerPool parallel(threads);
+    for (WorkerPool* pool : { &serial, &parallel }) {
+        if (pool == &parallel && parallel.getThreadCount() == 1) break;
+        planner.clearCache();
+        const double ms = timeMs([&] { planner.distanceMatrix(points, *pool); });
+        std::cout << "  " << targets << "x" << targets << " matrix x" << pool->getThreadCount() << " threads  " << ms << " ms\n";
+    }
+    return 0;
+}
@@ -0,0 +1,288 @@
+// Replay logs: seeking through checkpoints vs re-simulating from the start.
+//
+// Random farms (walls, crops mid-growth, timers out past the growth wheel) are recorded under
+// random command streams, keeping the state hash of every tick. After a file round trip,
+// random seeks, rewinds and steps have to land on those hashes. verify() has to pass the real
+// replay and catch a wrong final hash and a doctored checkpoint. Truncated files and misplaced
+// checkpoints have to be refused. Timed: recording, seeking and verifying a long run on a big
+// farm.
+//
+// usage: replay_bench [--seeds N] [--size S] [--ticks N] [--interval N] [--verify-only]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Grid.hpp"
+#include "Farmer.hpp"
+#include "Replay.hpp"
+#include "Simulation.hpp"
+
+namespace {
+
+Command randomCommand(std::mt19937& rng)
+{
+    Command cmd;
+    const int roll = std::uniform_int_distribution<int>(0, 99)(rng);
+    if (roll < 50) {
+        cmd.type = CommandType::Move;
+        cmd.dir = static_cast<direction>(std::uniform_int_distribution<int>(0, 3)(rng));
+    } else if (roll < 70) {
+        cmd.type = CommandType::Plant;
+    } else if (roll < 90) {
+        cmd.type = CommandType::Harvest;
+    } else if (roll < 93) {
+        cmd.type = CommandType::Remove;
+    } else {
+        cmd.type = CommandType::Wait;
+        cmd.count = std::uniform_int_distribution<int>(1, 10)(rng);
+    }
+    return cmd;
+}
+
+void randomFarm(std::mt19937& rng, Grid& grid)
+{
+    std::uniform_int_distribution<int> roll(0, 99);
+    for (int y = 0; y < grid.getGridHeight(); y++) {
+        for (int x = 0; x < grid.getGridWidth(); x++) {
+            const int r = roll(rng);
+            Tile t;
+            if (r < 10) {
+                t.type = TileType::SOIL;
+            } else if (r < 25) {
+                t.type = TileType::CROP;
+                t.cropstate = CropState::PLANTED;
+                // now and then far enough back to sit in the scheduler's overflow heap
+                t.growthTimer = r < 12 ? -std::uniform_int_distribution<int>(20, 80)(rng)
+                                       : std::uniform_int_distribution<int>(0, Tile::GROWTH_TIME - 1)(rng);
+            } else if (r < 30) {
+                t.type = TileType::CROP;
+                t.cropstate = CropState::GROWN;
+                t.growthTimer = Tile::GROWTH_TIME;
+            }
+            grid.setTile(x, y, t);
+            if (r >= 95) grid.setWalkable(x, y, false);
+        }
+    }
+}
+
+bool expectThrow(const std::string& bytes)
+{
+    std::istringstream in(bytes);
+    try {
+        readReplay(in);
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+bool verify(int seeds)
+{
+    for (int seed = 1; seed <= seeds; seed++) {
+        std::mt19937 rng(seed);
+        // past a chunk now and then so there's more than one
+        const bool big = seed % 4 == 0;
+        const int w = std::uniform_int_distribution<int>(1, big ? 90 : 30)(rng);
+        const int h = std::uniform_int_distribution<int>(1, big ? 60 : 20)(rng);
+        const GrowthMode mode = seed % 3 == 0 ? GrowthMode::Scan : GrowthMode::Scheduled;
+        Grid grid(w, h, mode);
+        randomFarm(rng, grid);
+        Farmer farmer(grid, std::uniform_int_distribution<int>(0, w - 1)(rng), std::uniform_int_distribution<int>(0, h - 1)(rng));
+        grid.setWalkable(farmer.getX(), farmer.getY(), true);
+        // recording doesn't have to start at tick 0
+        const int warmup = std::uniform_int_distribution<int>(0, 40)(rng);
+        for (int t = 0; t < warmup; t++) grid.tick();
+
+        const int interval = std::uniform_int_distribution<int>(1, 24)(rng);
+        const int ticks = std::uniform_int_distribution<int>(0, 400)(rng);
+        ReplayRecorder recorder(grid, farmer, interval);
+        std::vector<std::uint64_t> hashes{ hashState(grid, farmer) };
+        while (static_cast<int>(hashes.size()) <= ticks) {
+            const Command cmd = randomCommand(rng);
+            for (int r = 0; r < cmd.count && static_cast<int>(hashes.size()) <= ticks; r++) {
+                recorder.act(cmd.type, cmd.dir);
+                hashes.push_back(hashState(grid, farmer));
+            }
+        }
+        const Replay recorded = recorder.finish();
+        if (recorded.finalHash != hashes.back() || recorded.endTick - recorded.startTick != ticks) {
+            std::cerr << "MISMATCH seed " << seed << ": final hash or tick count wrong\n";
+            return false;
+        }
+
+        // everything below runs off the copy that went through a file
+        std::ostringstream out;
+        writeReplay(recorded, out);
+        const std::string file = out.str();
+        std::istringstream in(file);
+        const Replay replay = readReplay(in);
+        std::ostringstream again;
+        writeReplay(replay, again);
+        if (again.str() != file) {
+            std::cerr << "MISMATCH seed " << seed << ": file round trip changed the replay\n";
+            return false;
+        }
+        for (int cut = 0; cut < 8; cut++) {
+            const std::size_t length = std::uniform_int_distribution<std::size_t>(0, file.size() - 1)(rng);
+            if (!expectThrow(file.substr(0, length))) {
+                std::cerr << "MISMATCH seed " << seed << ": a file cut at " << length << " bytes was accepted\n";
+                return false;
+            }
+        }
+
+        // checkpoints that aren't exactly one interval apart, or one too many
+        Replay skewed = replay;
+        skewed.endTick += interval;
+        std::ostringstream skewedFile;
+        writeReplay(skewed, skewedFile);
+        bool rejected = expectThrow(skewedFile.str());
+        if (replay.checkpoints.size() > 1 && interval > 1) {
+            skewed = replay;
+            skewed.checkpoints.back().tick--;
+            skewedFile.str("");
+            writeReplay(skewed, skewedFile);
+            rejected = rejected && expectThrow(skewedFile.str());
+        }
+        if (!rejected) {
+            std::cerr << "MISMATCH seed " << seed << ": a file with misplaced checkpoints was accepted\n";
+            return false;
+        }
+
+        ReplayPlayer player(replay);
+        for (int q = 0; q < 120; q++) {
+            const int roll = std::uniform_int_distribution<int>(0, 9)(rng);
+            if (roll < 4) player.seek(replay.startTick + std::uniform_int_distribution<int>(-5, ticks + 5)(rng));
+            else if (roll < 7) player.stepBack();
+            else player.stepForward();
+
+            const std::int64_t at = player.getTick() - replay.startTick;
+            if (hashState(player.getGrid(), player.getFarmer()) != hashes[at]) {
+                std::cerr << "MISMATCH seed " << seed << " query " << q << ": tick " << player.getTick()
+                          << " doesn't match the recording\n";
+                return false;
+            }
+            if (player.lastReplayedTicks() > interval) {
+                std::cerr << "MISMATCH seed " << seed << ": a seek replayed " << player.lastReplayedTicks()
+                          << " ticks, interval is " << interval << "\n";
+                return false;
+            }
+        }
+
+        if (!player.verify().ok || player.getTick() != replay.endTick) {
+            std::cerr << "MISMATCH seed " << seed << ": verify failed on a good replay\n";
+            return false;
+        }
+        if (verifyReplay(replay, replay.finalHash ^ 1).ok) {
+            std::cerr << "MISMATCH seed " << seed << ": verify passed a wrong final hash\n";
+            return false;
+        }
+        if (replay.checkpoints.size() > 1) {
+            Replay doctored = replay;
+            const std::size_t k = std::uniform_int_distribution<std::size_t>(1, doctored.checkpoints.size() - 1)(rng);
+            doctored.checkpoints[k].harvests++;
+            if (verifyReplay(doctored, doctored.finalHash).divergedAt != doctored.checkpoints[k].tick) {
+                std::cerr << "MISMATCH seed " << seed << ": verify missed a doctored checkpoint\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename Fn>
+double timeMs(Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int seeds = 200;
+    int size = 512;
+    int ticks = 100000;
+    int interval = 256;
+    bool verifyOnly = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seeds" && i + 1 < argc) seeds = std::atoi(argv[++i]);
+        else if (arg == "--size" && i + 1 < argc) size = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--ticks" && i + 1 < argc) ticks = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--interval" && i + 1 < argc) interval = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--verify-only") verifyOnly = true;
+    }
+
+    if (!verify(seeds)) return 1;
+    std::cout << "differential check passed (" << seeds << " recorded runs)\n";
+    if (verifyOnly) return 0;
+
+    std::mt19937 rng(7);
+    std::vector<Command> commands;
+    for (int t = 0; t < ticks;) {
+        Command cmd = randomCommand(rng);
+        cmd.count = std::min(cmd.count, ticks - t);
+        t += cmd.count;
+        commands.push_back(cmd);
+    }
+
+    Grid plainGrid(size, size);
+    Farmer plainFarmer(plainGrid, size / 2, size / 2);
+    const double plainMs = timeMs([&] { runCommands(plainGrid, plainFarmer, commands); });
+
+    Grid grid(size, size);
+    Farmer farmer(grid, size / 2, size / 2);
+    Replay replay;
+    const double recordMs = timeMs([&] {
+        ReplayRecorder recorder(grid, farmer, interval);
+        recorder.run(commands);
+        replay = recorder.finish();
+    });
+    std::ostringstream file;
+    writeReplay(replay, file);
+
+    std::cout << size << "x" << size << ", " << ticks << " ticks, " << replay.actionCount << " actions, checkpoint every "
+              << interval << "\n";
+    std::cout << "  run                " << plainMs << " ms\n";
+    std::cout << "  run + record       " << recordMs << " ms\n";
+    std::cout << "  action log         " << replay.log.size() << " bytes (" << double(replay.log.size()) / replay.actionCount
+              << " per action)\n";
+    std::cout << "  in memory          " << replay.storageBytes() / 1024 << " KB, " << replay.checkpoints.size()
+              << " checkpoints\n";
+    std::cout << "  file               " << file.str().size() / 1024 << " KB\n";
+
+    ReplayPlayer player(replay);
+    const int seeks = 200;
+    const double seekMs = timeMs([&] {
+        for (int q = 0; q < seeks; q++)
+            player.seek(std::uniform_int_distribution<std::int64_t>(replay.startTick, replay.endTick)(rng));
+    });
+    player.seek(replay.endTick);
+    const int steps = 200;
+    const double backMs = timeMs([&] {
+        for (int q = 0; q < steps; q++) player.stepBack();
+    });
+    std::cout << "  random seek        " << seekMs * 1e3 / seeks << " us\n";
+    std::cout << "  step back          " << backMs * 1e3 / steps << " us\n";
+
+    // what a seek to the end cost before: re-simulating from the first tick
+    Grid fresh(size, size);
+    Farmer freshFarmer(fresh, size / 2, size / 2);
+    const double resimMs = timeMs([&] { runCommands(fresh, freshFarmer, commands); });
+    std::cout << "  re-sim to the end  " << resimMs << " ms\n";
+
+    ReplayVerifyResult result;
+    const double verifyMs = timeMs([&] { result = player.verify(); });
+    std::cout << "  verify             " << verifyMs << " ms (" << (result.ok ? "ok" : "FAILED") << ")\n";
+    return result.ok ? 0 : 1;
+}
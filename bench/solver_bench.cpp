@@ -0,0 +1,331 @@
+// Par solver: branch-and-bound against an exhaustive search, then thread scaling.
+//
+// Small random levels (walls, crops planted or ripe, tiles still in a replant cooldown, with
+// and without crop requirements, plant locked now and then) have to solve in the tick count a
+// plain breadth-first search over the real Grid and Farmer finds, trying every action, crop
+// kind and wait. Each schedule has to win in exactly that many ticks as a farm script through
+// ScriptVM. Timed: a few larger levels at 1, 2, 4... threads with the same node budget.
+//
+// usage: solver_bench [--seeds N] [--max-nodes N] [--threads N] [--verify-only]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "FarmScript.hpp"
+#include "Farmer.hpp"
+#include "Grid.hpp"
+#include "ScriptVM.hpp"
+#include "Simulation.hpp"
+#include "Solver.hpp"
+
+namespace {
+
+struct Case
+{
+    Layout layout;
+    ScriptObjective objective;
+    std::vector<std::string> allowed;
+    std::vector<int> cooldowns; // per tile, left over from harvests before the level starts
+};
+
+Layout makeLayout(const std::vector<std::string>& rows)
+{
+    std::string text;
+    for (const std::string& r : rows) text += r + "\n";
+    std::istringstream in(text);
+    return parseLayout(in);
+}
+
+void load(const Case& c, Grid& grid, Farmer& farmer, std::vector<CropKind>& crops)
+{
+    grid.reset(c.layout.width, c.layout.height);
+    applyLayout(c.layout, grid);
+    for (std::size_t i = 0; i < c.cooldowns.size(); i++) {
+        if (!c.cooldowns[i]) continue;
+        Tile t = grid.getTile(static_cast<int>(i) % grid.getGridWidth(), static_cast<int>(i) / grid.getGridWidth());
+        t.replantCooldown = c.cooldowns[i];
+        grid.setTile(static_cast<int>(i) % grid.getGridWidth(), static_cast<int>(i) / grid.getGridWidth(), t);
+    }
+    farmer.reset(c.layout.startX, c.layout.startY);
+    crops = layoutCrops(c.layout);
+}
+
+bool won(const ScriptObjective& objective, int total, const int* byKind)
+{
+    if (total == 0) return false;
+    if (objective.cropRequirements.empty()) return total >= objective.harvestsRequired;
+    for (const auto& r : objective.cropRequirements)
+        if (byKind[static_cast<int>(r.first)] < r.second) return false;
+    return true;
+}
+
+// Every action on every tick, no pruning beyond identical states. Returns the fewest ticks,
+// -1 for no way to win, -2 when there are too many states to finish.
+int exhaustive(const Case& c, std::size_t stateCap)
+{
+    struct Node
+    {
+        Grid grid;
+        int x, y;
+        std::vector<CropKind> crops;
+        int total;
+        int byKind[CROP_KIND_COUNT];
+    };
+    const bool canPlant = c.allowed.empty() || std::find(c.allowed.begin(), c.allowed.end(), "plant") != c.allowed.end();
+    std::vector<CropKind> kinds;
+    if (c.objective.cropRequirements.empty()) kinds.push_back(CropKind::Wheat);
+    for (const auto& r : c.objective.cropRequirements) kinds.push_back(r.first);
+
+    auto key = [](const Node& n) {
+        std::string k;
+        k.push_back(static_cast<char>(n.x));
+        k.push_back(static_cast<char>(n.y));
+        // counts past what could matter don't make a different state
+        k.push_back(static_cast<char>(std::min(n.total, 64)));
+        for (int v : n.byKind) k.push_back(static_cast<char>(std::min(v, 64)));
+        for (int y = 0; y < n.grid.getGridHeight(); y++) {
+            for (int x = 0; x < n.grid.getGridWidth(); x++) {
+                const Tile t = n.grid.getTile(x, y);
+                k.push_back(static_cast<char>(t.type));
+                k.push_back(static_cast<char>(t.cropstate));
+                k.push_back(static_cast<char>(t.type == TileType::CROP && t.cropstate == CropState::PLANTED ? t.growthTimer : 0));
+                k.push_back(static_cast<char>(t.replantCooldown));
+                k.push_back(static_cast<char>(n.crops[static_cast<std::size_t>(y * n.grid.getGridWidth() + x)]));
+            }
+        }
+        return k;
+    };
+
+    Grid grid(1, 1);
+    Farmer farmer(grid);
+    std::vector<CropKind> crops;
+    load(c, grid, farmer, crops);
+    std::deque<Node> layer;
+    layer.push_back({ grid, farmer.getX(), farmer.getY(), crops, 0, {} });
+    std::unordered_set<std::string> seen{ key(layer.front()) };
+
+    for (int depth = 1; !layer.empty(); depth++) {
+        std::deque<Node> next;
+        for (Node& n : layer) {
+            // 0-3 moves, 4 harvest, 5 remove, 6 wait, 7+ plant kinds[i]
+            const int actionCount = 7 + (canPlant ? static_cast<int>(kinds.size()) : 0);
+            for (int a = 0; a < actionCount; a++) {
+                Node m = n;
+                Farmer f(m.grid, m.x, m.y);
+                f.setHarvestCount(0);
+                const std::size_t tile = static_cast<std::size_t>(m.y * m.grid.getGridWidth() + m.x);
+                bool ok = true;
+                if (a < 4) {
+                    ok = f.move(static_cast<direction>(a));
+                } else if (a == 4) {
+                    const CropKind kind = m.crops[tile];
+                    ok = f.harvest();
+                    if (ok) {
+                        m.total++;
+                        m.byKind[static_cast<int>(kind)]++;
+                        m.crops[tile] = CropKind::Unknown;
+                    }
+                } else if (a == 5) {
+                    ok = f.remove();
+                    if (ok) m.crops[tile] = CropKind::Unknown;
+                } else if (a >= 7) {
+                    ok = f.plant();
+                    if (ok) m.crops[tile] = kinds[static_cast<std::size_t>(a - 7)];
+                }
+                if (!ok && a != 6) continue; // a failed action is the same as waiting
+                m.grid.tick();
+                m.x = f.getX();
+                m.y = f.getY();
+                if (a == 4 && won(c.objective, m.total, m.byKind)) return depth;
+                if (!seen.insert(key(m)).second) continue;
+                if (seen.size() > stateCap) return -2;
+                next.push_back(std::move(m));
+            }
+        }
+        layer.swap(next);
+    }
+    return -1;
+}
+
+bool checkSchedule(const Case& c, const SolverResult& result, std::string& why)
+{
+    Grid grid(1, 1);
+    Farmer farmer(grid);
+    std::vector<CropKind> crops;
+    load(c, grid, farmer, crops);
+    ScriptOptions options;
+    options.allowed = c.allowed;
+    ScriptVM vm;
+    const ScriptResult run = vm.run(compileScript(scheduleScript(result), options), grid, farmer, crops, c.objective, c.allowed);
+    if (run.outcome == ScriptOutcome::Won && run.ticks == result.ticks) return true;
+    why = std::string(scriptOutcomeName(run.outcome)) + " after " + std::to_string(run.ticks) + " ticks";
+    return false;
+}
+
+Case randomCase(std::mt19937& rng)
+{
+    auto roll = [&](int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); };
+    Case c;
+    const int w = roll(1, 4);
+    const int h = roll(1, std::max(1, 6 / w));
+    const char cropChars[] = { 'G', 'W', 'C', 'T', 'R', 'P' };
+    std::vector<std::string> rows(static_cast<std::size_t>(h), std::string(static_cast<std::size_t>(w), '.'));
+    for (std::string& r : rows) {
+        for (char& ch : r) {
+            const int t = roll(0, 99);
+            if (t < 15) ch = 'X';
+            else if (t < 30) ch = cropChars[roll(0, 5)];
+            else if (t < 35) ch = 'S';
+        }
+    }
+    rows[static_cast<std::size_t>(roll(0, h - 1))][static_cast<std::size_t>(roll(0, w - 1))] = 'F';
+    c.layout = makeLayout(rows);
+    c.cooldowns.assign(static_cast<std::size_t>(w * h), 0);
+    for (int i = 0; i < w * h; i++) {
+        const char ch = rows[static_cast<std::size_t>(i / w)][static_cast<std::size_t>(i % w)];
+        if ((ch == '.' || ch == 'S' || ch == 'F') && roll(0, 9) == 0) c.cooldowns[static_cast<std::size_t>(i)] = roll(1, Tile::REPLANT_COOLDOWN + 1);
+    }
+
+    if (roll(0, 1) == 0) {
+        c.objective.harvestsRequired = roll(1, 3);
+    } else {
+        const CropKind a = static_cast<CropKind>(roll(1, 4));
+        c.objective.cropRequirements.push_back({ a, roll(1, 2) });
+        if (roll(0, 2) == 0) {
+            const CropKind b = static_cast<CropKind>(static_cast<int>(a) % 4 + 1);
+            c.objective.cropRequirements.push_back({ b, 1 });
+        }
+    }
+    c.allowed = { "move", "harvest" };
+    if (roll(0, 5) != 0) c.allowed.push_back("plant");
+    return c;
+}
+
+bool verify(int seeds)
+{
+    int compared = 0, skipped = 0, unsolvable = 0;
+    for (int seed = 1; seed <= seeds; seed++) {
+        std::mt19937 rng(seed);
+        const Case c = randomCase(rng);
+        const int expected = exhaustive(c, 200'000);
+        if (expected == -2) {
+            skipped++;
+            continue;
+        }
+
+        Grid grid(1, 1);
+        Farmer farmer(grid);
+        std::vector<CropKind> crops;
+        load(c, grid, farmer, crops);
+        SolverOptions options;
+        options.threads = 1 + seed % 3;
+        options.beamWidth = 1 + seed % 64; // narrow beams, so branch-and-bound has work to do
+        options.memoryBytes = 8u << 20;
+        options.maxTicks = 200;
+        const SolverResult result = solveLevel(makeSolverProblem(grid, farmer, crops, c.objective, c.allowed), options);
+
+        if (expected == -1) {
+            unsolvable++;
+            if (result.status != SolveStatus::NoSolution) {
+                std::cerr << "MISMATCH seed " << seed << ": exhaustive search finds no win, solver says "
+                          << result.ticks << " ticks\n";
+                return false;
+            }
+            continue;
+        }
+        if (result.status != SolveStatus::Optimal || result.ticks != expected) {
+            std::cerr << "MISMATCH seed " << seed << ": " << solveStatusName(result.status) << " " << result.ticks
+                      << " ticks, exhaustive search says " << expected << "\n";
+            for (const std::string& r : c.layout.rows) std::cerr << "  " << r << "\n";
+            return false;
+        }
+        std::string why;
+        if (!checkSchedule(c, result, why)) {
+            std::cerr << "MISMATCH seed " << seed << ": the " << result.ticks << " tick schedule " << why << "\n";
+            return false;
+        }
+        compared++;
+    }
+    std::cout << "  " << compared << " compared, " << unsolvable << " unsolvable, " << skipped
+              << " too big to search exhaustively\n";
+    return true;
+}
+
+template <typename Fn>
+double timeMs(Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int seeds = 150;
+    std::int64_t maxNodes = 2'000'000;
+    int maxThreads = 0;
+    bool verifyOnly = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--seeds" && i + 1 < argc) seeds = std::atoi(argv[++i]);
+        else if (arg == "--max-nodes" && i + 1 < argc) maxNodes = std::max(1LL, std::atoll(argv[++i]));
+        else if (arg == "--threads" && i + 1 < argc) maxThreads = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--verify-only") verifyOnly = true;
+    }
+
+    if (!verify(seeds)) return 1;
+    std::cout << "differential check passed (" << seeds << " random levels)\n";
+    if (verifyOnly) return 0;
+
+    // the maze (level 7), a pillar field, and the snake (level 10)
+    std::vector<std::pair<std::string, Case>> levels;
+    {
+        Case c;
+        c.layout = makeLayout({ "F.X..", "..X..", "..X..", ".....", "XX.XX" });
+        c.objective.cropRequirements = { { CropKind::Wheat, 2 }, { CropKind::Corn, 2 }, { CropKind::Tomato, 2 }, { CropKind::Carrot, 2 } };
+        levels.push_back({ "maze 5x5, 8 crops", c });
+        c.layout = makeLayout({ "F......", ".X...X.", "...X...", ".X...X.", "...X...", ".X...X.", "......." });
+        c.objective.cropRequirements = { { CropKind::Wheat, 3 }, { CropKind::Corn, 3 }, { CropKind::Tomato, 3 }, { CropKind::Carrot, 3 } };
+        levels.push_back({ "pillars 7x7, 12 crops", c });
+        c.layout = makeLayout({ "F.......", "XXXXXXX.", "........", ".XXXXXXX", "........", "XXXXXXX.", "........", "........" });
+        c.objective.cropRequirements = { { CropKind::Wheat, 4 }, { CropKind::Corn, 4 }, { CropKind::Tomato, 4 }, { CropKind::Carrot, 4 } };
+        levels.push_back({ "snake 8x8, 16 crops", c });
+    }
+
+    const int hardware = maxThreads > 0 ? maxThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    std::cout << "node budget " << maxNodes << " per solve\n";
+    for (const auto& level : levels) {
+        std::cout << level.first << "\n";
+        double serialMs = 0.0;
+        for (int threads = 1; threads <= hardware; threads *= 2) {
+            Grid grid(1, 1);
+            Farmer farmer(grid);
+            std::vector<CropKind> crops;
+            load(level.second, grid, farmer, crops);
+            const SolverProblem problem = makeSolverProblem(grid, farmer, crops, level.second.objective, level.second.allowed);
+            SolverOptions options;
+            options.threads = threads;
+            options.maxNodes = maxNodes;
+            SolverResult result;
+            const double ms = timeMs([&] { result = solveLevel(problem, options); });
+            if (threads == 1) serialMs = ms;
+            std::cout << "  " << threads << " thread" << (threads == 1 ? " " : "s") << "  " << ms << " ms  "
+                      << solveStatusName(result.status) << " " << result.ticks << " ticks (bound " << result.lowerBound
+                      << ", beam " << result.beamTicks << ")  " << result.nodes << " nodes, " << result.tableHits
+                      << " table cuts  " << serialMs / ms << "x\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,262 @@
+from __future__ import annotations
+import ctypes
+import os
+import sys
+
+#ctypes binding for the c++ simulation core (scripts/FarmApi.h, built as the farm_api shared library)
+#actions go over in batches so the cost of calling into c++ is paid once per batch not once per move,
+#and tile state is read straight out of the grid's memory through memoryviews, nothing is copied
+
+API_VERSION = 1
+
+#action bytes, same numbers as FarmAction in FarmApi.h
+MOVE_LEFT  = 0
+MOVE_UP    = 1
+MOVE_DOWN  = 2
+MOVE_RIGHT = 3
+PLANT      = 4
+HARVEST    = 5
+REMOVE     = 6
+WAIT       = 7
+
+_MOVES = {"left": MOVE_LEFT, "up": MOVE_UP, "down": MOVE_DOWN, "right": MOVE_RIGHT}
+
+#crop states, for count_crops / nearest_crop
+PLANTED = 1
+GROWN   = 2
+
+#result bits
+RESULT_OK          = 1
+RESULT_ALL_CHANGED = 2
+
+
+class FarmNativeError(RuntimeError):
+    pass
+
+
+class _TileView(ctypes.Structure):
+    _fields_ = [
+        ("types",  ctypes.POINTER(ctypes.c_uint8)),
+        ("states", ctypes.POINTER(ctypes.c_uint8)),
+        ("timers", ctypes.POINTER(ctypes.c_int32)),
+        ("width",  ctypes.c_int32),
+        ("height", ctypes.c_int32),
+    ]
+
+
+def _library_names() -> list[str]:
+    if sys.platform == "win32":
+        return ["farm_api.dll", "libfarm_api.dll"]
+    if sys.platform == "darwin":
+        return ["libfarm_api.dylib"]
+    return ["libfarm_api.so"]
+
+
+#looks in FARM_NATIVE_LIB first, then the usual cmake build folders next to the repo
+def _find_library() -> str | None:
+    override = os.environ.get("FARM_NATIVE_LIB")
+    if override:
+        return override
+    repo = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    for folder in ("build", os.path.join("build", "Release"), os.path.join("build", "Debug")):
+        for name in _library_names():
+            path = os.path.join(repo, folder, name)
+            if os.path.exists(path):
+                return path
+    return None
+
+
+_lib = None
+
+
+def _load():
+    global _lib
+    if _lib is not None:
+        return _lib
+    path = _find_library()
+    if path is None:
+        raise FarmNativeError("farm_api library not found, build it with cmake --build build --target farm_api")
+    lib = ctypes.CDLL(path)
+
+    world_p = ctypes.c_void_p
+    lib.farm_api_version.restype = ctypes.c_int
+    lib.farm_last_error.restype = ctypes.c_char_p
+    lib.farm_world_create.argtypes = [ctypes.c_int, ctypes.c_int]
+    lib.farm_world_create.restype = world_p
+    lib.farm_world_create_from_layout.argtypes = [ctypes.c_char_p]
+    lib.farm_world_create_from_layout.restype = world_p
+    lib.farm_world_destroy.argtypes = [world_p]
+    lib.farm_world_destroy.restype = None
+    lib.farm_world_tiles.argtypes = [world_p, ctypes.POINTER(_TileView)]
+    lib.farm_world_set_tile.argtypes = [world_p] + [ctypes.c_int] * 5
+    lib.farm_world_walkability.argtypes = [world_p, ctypes.POINTER(ctypes.POINTER(ctypes.c_uint8))]
+    lib.farm_world_set_walkable.argtypes = [world_p, ctypes.c_int, ctypes.c_int, ctypes.c_int]
+    lib.farm_world_farmer.argtypes = [world_p, ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
+    lib.farm_world_set_farmer.argtypes = [world_p, ctypes.c_int, ctypes.c_int]
+    lib.farm_world_harvests.argtypes = [world_p, ctypes.POINTER(ctypes.c_int64)]
+    lib.farm_world_tick_count.argtypes = [world_p, ctypes.POINTER(ctypes.c_int64)]
+    lib.farm_world_tick.argtypes = [world_p, ctypes.c_int]
+    lib.farm_world_count_crops.argtypes = [world_p] + [ctypes.c_int] * 5 + [ctypes.POINTER(ctypes.c_int64)]
+    lib.farm_world_nearest_crop.argtypes = [
+        world_p, ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int),
+    ]
+    lib.farm_world_submit.argtypes = [
+        world_p, ctypes.POINTER(ctypes.c_uint8), ctypes.c_int, ctypes.POINTER(ctypes.c_uint8),
+        ctypes.POINTER(ctypes.c_int32), ctypes.POINTER(ctypes.c_int32), ctypes.c_int,
+    ]
+
+    version = lib.farm_api_version()
+    if version != API_VERSION:
+        raise FarmNativeError(f"farm_api version {version}, this binding wants {API_VERSION}")
+    _lib = lib
+    return lib
+
+
+def available() -> bool:
+    try:
+        _load()
+        return True
+    except (FarmNativeError, OSError):
+        return False
+
+
+def _check(status: int) -> None:
+    if status != 0:
+        raise FarmNativeError(_lib.farm_last_error().decode("utf-8", "replace"))
+
+
+def action_for(command: str, arg: str | None = None) -> int:
+    #"move", "up" -> MOVE_UP etc, for building batches from script commands
+    if command == "move":
+        return _MOVES[(arg or "").lower()]
+    return {"plant": PLANT, "harvest": HARVEST, "remove": REMOVE, "wait": WAIT}[command]
+
+
+class NativeFarm:
+    #one c++ world, either an empty width x height farm or an ascii layout (see Simulation.hpp)
+    def __init__(self, width: int = 0, height: int = 0, layout: str | None = None):
+        lib = _load()
+        if layout is not None:
+            self._world = lib.farm_world_create_from_layout(layout.encode("utf-8"))
+        else:
+            self._world = lib.farm_world_create(width, height)
+        if not self._world:
+            raise FarmNativeError(lib.farm_last_error().decode("utf-8", "replace"))
+
+        #the tile arrays never move for the life of the world so the views are made once
+        view = _TileView()
+        _check(lib.farm_world_tiles(self._world, ctypes.byref(view)))
+        self.width = view.width
+        self.height = view.height
+        n = self.width * self.height
+        shape = [self.height, self.width]
+        self.types = memoryview(ctypes.cast(view.types, ctypes.POINTER(ctypes.c_uint8 * n)).contents).cast("B", shape)
+        self.states = memoryview(ctypes.cast(view.states, ctypes.POINTER(ctypes.c_uint8 * n)).contents).cast("B", shape)
+        self.timers = (memoryview(ctypes.cast(view.timers, ctypes.POINTER(ctypes.c_int32 * n)).contents)
+                       .cast("B").cast("i", shape))
+        walkable = ctypes.POINTER(ctypes.c_uint8)()
+        _check(lib.farm_world_walkability(self._world, ctypes.byref(walkable)))
+        self.walkable = memoryview(ctypes.cast(walkable, ctypes.POINTER(ctypes.c_uint8 * n)).contents).cast("B", shape)
+
+        #batch buffers, grown as needed and reused between submits
+        self._capacity = 0
+        self._changed_capacity = 0
+
+    def close(self) -> None:
+        if self._world:
+            #drop the views first, they point into memory that is about to be freed
+            self.types = self.states = self.timers = self.walkable = None
+            _lib.farm_world_destroy(self._world)
+            self._world = None
+
+    def __enter__(self) -> NativeFarm:
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+    def __del__(self) -> None:
+        try:
+            self.close()
+        except Exception:
+            pass
+
+    #farmer position, kept by the c++ farmer so this is O(1) whatever the grid size
+    @property
+    def farmer(self) -> tuple[int, int]:
+        x = ctypes.c_int()
+        y = ctypes.c_int()
+        _check(_lib.farm_world_farmer(self._world, ctypes.byref(x), ctypes.byref(y)))
+        return x.value, y.value
+
+    def set_farmer(self, x: int, y: int) -> None:
+        _check(_lib.farm_world_set_farmer(self._world, x, y))
+
+    @property
+    def harvests(self) -> int:
+        out = ctypes.c_int64()
+        _check(_lib.farm_world_harvests(self._world, ctypes.byref(out)))
+        return out.value
+
+    @property
+    def tick_count(self) -> int:
+        out = ctypes.c_int64()
+        _check(_lib.farm_world_tick_count(self._world, ctypes.byref(out)))
+        return out.value
+
+    #crops in that state (PLANTED / GROWN) in x0 <= x < x1, y0 <= y < y1, whole grid by default.
+    #answered from the c++ crop index, no scan
+    def count_crops(self, state: int, x0: int = 0, y0: int = 0, x1: int | None = None, y1: int | None = None) -> int:
+        if x1 is None: x1 = self.width
+        if y1 is None: y1 = self.height
+        out = ctypes.c_int64()
+        _check(_lib.farm_world_count_crops(self._world, state, x0, y0, x1, y1, ctypes.byref(out)))
+        return out.value
+
+    #closest crop in that state to x, y (the farmer by default) counting moves, walls ignored. None if there's none
+    def nearest_crop(self, state: int, x: int | None = None, y: int | None = None) -> tuple[int, int] | None:
+        if x is None or y is None:
+            x, y = self.farmer
+        cx = ctypes.c_int()
+        cy = ctypes.c_int()
+        _check(_lib.farm_world_nearest_crop(self._world, state, x, y, ctypes.byref(cx), ctypes.byref(cy)))
+        return None if cx.value < 0 else (cx.value, cy.value)
+
+    def set_tile(self, x: int, y: int, type_: int, state: int = 0, timer: int = 0) -> None:
+        _check(_lib.farm_world_set_tile(self._world, x, y, type_, state, timer))
+
+    def set_walkable(self, x: int, y: int, walkable: bool) -> None:
+        _check(_lib.farm_world_set_walkable(self._world, x, y, 1 if walkable else 0))
+
+    def tick(self, ticks: int = 1) -> None:
+        _check(_lib.farm_world_tick(self._world, ticks))
+
+    def _reserve(self, count: int) -> None:
+        if count > self._capacity:
+            self._capacity = max(count, self._capacity * 2, 64)
+            self._results = (ctypes.c_uint8 * self._capacity)()
+            self._offsets = (ctypes.c_int32 * (self._capacity + 1))()
+            #a move or plant changes one tile, ripening crops add a few more
+            self._changed_capacity = self._capacity * 4
+            self._changed = (ctypes.c_int32 * self._changed_capacity)()
+
+    def submit(self, actions) -> tuple[bytes, list[list[int] | None]]:
+        #runs every action (each one a tick) in a single call
+        #returns one result byte per action and per action the flat tile indices that changed,
+        #or None for an action that changed too much to list (re-read the tile views)
+        actions = bytes(actions)
+        count = len(actions)
+        self._reserve(max(count, 1))
+        buffer = (ctypes.c_uint8 * count).from_buffer_copy(actions) if count else None
+        _check(_lib.farm_world_submit(self._world, buffer, count, self._results, self._offsets,
+                                      self._changed, self._changed_capacity))
+        results = bytes(memoryview(self._results)[:count])
+        offsets = self._offsets
+        changed = self._changed
+        per_action: list[list[int] | None] = []
+        for i in range(count):
+            if results[i] & RESULT_ALL_CHANGED:
+                per_action.append(None)
+            else:
+                per_action.append(changed[offsets[i]:offsets[i + 1]])
+        return results, per_action
@@ -382,7 +382,7 @@ LEVEL_18 = {
         "..........",
         "XXXXXXXXX.",
         "..........",
-        "..XXXXXXXXX",
+        "..XXXXXXXX",
         "..........",
         "XXXXXXXXX.",
         "..........",
@@ -743,6 +743,7 @@ class Level:
         self.rows: int = len(self.grid_data)
         self.cols: int = len(self.grid_data[0])
         self.tiles: list[list[Tile]] = [] #holds the data until build runs
+        self._positions: dict[int, tuple[int, int]] = {} #id(tile) -> (row, col) so find_tile doesnt scan
         self.start_tile: Tile | None = None
  
         self._build()
@@ -750,6 +751,7 @@ class Level:
     #this function converts the character strings into tiles
     def _build(self) -> None:
         self.tiles = []
+        self._positions = {}
         for r, row_str in enumerate(self.grid_data):
             row: list[Tile] = []
             for c, ch in enumerate(row_str):
@@ -765,6 +767,7 @@ class Level:
                 if ch == "F":
                     self.start_tile = tile
  
+                self._positions[id(tile)] = (r, c)
                 row.append(tile)
             self.tiles.append(row)
  
@@ -792,12 +795,14 @@ class Level:
             return self.tiles[row][col]
         return None
  
+    #called on every move() so this is a dict lookup instead of a scan over every tile
     def find_tile(self, tile: Tile) -> tuple[int, int] | None:
-        for r, row in enumerate(self.tiles):
-            for c, t in enumerate(row):
-                if t is tile:
-                    return r, c
-        return None
+        pos = self._positions.get(id(tile))
+        if pos is None:
+            return None
+        r, c = pos
+        #the is check guards against a foreign tile that happens to reuse a freed id
+        return pos if self.tiles[r][c] is tile else None
  
     #functions for updating and drawing the tiles
     def update(self, dt: float, mouse_pos: tuple[int, int]) -> None:
@@ -0,0 +1,263 @@
+from __future__ import annotations
+import argparse
+import ast
+import os
+import random
+import struct
+import sys
+import zlib
+
+#level compiler: turns the LEVEL_N dicts in level.py into one binary pack (scripts/LevelPack.hpp)
+#that the c++ engine maps into memory and copies straight into a Grid, no per character parsing
+#level.py is read with ast instead of imported so this runs without pygame installed
+#
+#  python3 pygame/level_pack.py -o build/levels.pack
+#  python3 pygame/level_pack.py -o stress.pack --generate 5000 --seed 1
+#  python3 pygame/level_pack.py --list build/levels.pack
+
+PACK_VERSION = 1  #LEVEL_PACK_VERSION in LevelPack.hpp, bump both together
+MAGIC = b"FLVP"
+
+#bit i of the allowed mask, same order as levelPackCommandNames() in LevelPack.cpp, append only
+COMMANDS = ["move", "plant", "harvest", "remove", "for", "while", "if", "elif", "else", "print"]
+#CropKind order, cropRequired[0] is wheat
+CROPS = ["wheat", "corn", "tomato", "carrot"]
+
+HEADER = struct.Struct("<4sIIIQQQQIIQ")
+ENTRY = struct.Struct("<IIIIIHHHHIiI4HQII")
+assert HEADER.size == 64 and ENTRY.size == 64
+
+#tile values, the same numbers as TileType / CropState / CropKind on the c++ side
+EMPTY, SOIL, CROP = 0, 1, 2
+PLANTED, GROWN = 1, 2
+GROWTH_TIME = 15  #Tile::GROWTH_TIME
+_CROP_CHARS = {"W": 1, "C": 2, "T": 3, "R": 4}
+_LAYOUT_CHARS = set(".XFSPGWCTR")
+
+
+class LevelPackError(ValueError):
+    pass
+
+
+def _value(node: ast.AST):
+    #literal values, plus Objective(...) calls which come back as a dict of their keywords
+    if isinstance(node, ast.Call) and isinstance(node.func, ast.Name) and node.func.id == "Objective":
+        return {kw.arg: _value(kw.value) for kw in node.keywords}
+    if isinstance(node, ast.Dict):
+        return {_value(k): _value(v) for k, v in zip(node.keys, node.values)}
+    if isinstance(node, ast.List):
+        return [_value(v) for v in node.elts]
+    return ast.literal_eval(node)
+
+
+def load_levels(path: str) -> list[dict]:
+    #every level in _ALL_LEVELS order, as plain dicts with the objective as a dict
+    with open(path, encoding="utf-8") as f:
+        tree = ast.parse(f.read(), path)
+    defs: dict[str, dict] = {}
+    order: list[str] = []
+    for node in tree.body:
+        if not isinstance(node, ast.Assign) or len(node.targets) != 1 or not isinstance(node.targets[0], ast.Name):
+            continue
+        name = node.targets[0].id
+        if name.startswith("LEVEL_") and isinstance(node.value, ast.Dict):
+            defs[name] = _value(node.value)
+        elif name == "_ALL_LEVELS" and isinstance(node.value, ast.List):
+            order = [elt.id for elt in node.value.elts if isinstance(elt, ast.Name)]
+    if not order:
+        raise LevelPackError(f"{path}: no _ALL_LEVELS list")
+    missing = [name for name in order if name not in defs]
+    if missing:
+        raise LevelPackError(f"{path}: _ALL_LEVELS names undefined levels {missing}")
+    return [defs[name] for name in order]
+
+
+def generate_levels(count: int, seed: int, first_number: int) -> list[dict]:
+    #random levels for stress testing level switching, same shape as the level.py dicts
+    rng = random.Random(seed)
+    levels = []
+    for i in range(count):
+        w = rng.randint(3, 40)
+        h = rng.randint(3, 30)
+        rows = [["X" if rng.random() < 0.15 else rng.choice("......SW") for _ in range(w)] for _ in range(h)]
+        rows[rng.randrange(h)][rng.randrange(w)] = "F"
+        requirements = {crop: rng.randint(1, 5) for crop in rng.sample(CROPS, rng.randint(0, 4))}
+        levels.append({
+            "name": f"Generated {i + 1}",
+            "number": first_number + i,
+            "grid": ["".join(r) for r in rows],
+            "objective": {
+                "harvests_required": max(1, sum(requirements.values())),
+                "time_limit": rng.choice([None, 30.0, 60.0]),
+                "allowed_commands": ["move", "plant", "harvest", "for", "while"],
+                "crop_requirements": requirements,
+            },
+            "hint": "",
+        })
+    return levels
+
+
+def _tiles(level: dict) -> tuple[int, int, int, int, bytes]:
+    #width, height, start x, start y and the level's tile block, the same tiles applyLayout makes
+    rows = level["grid"]
+    number = level["number"]
+    if not rows or any(len(r) != len(rows[0]) for r in rows) or not rows[0]:
+        raise LevelPackError(f"level {number}: grid rows must be non-empty and the same width")
+    h, w = len(rows), len(rows[0])
+    if w > 0xFFFF or h > 0xFFFF:
+        raise LevelPackError(f"level {number}: grid too big")
+    timers, types, states, walkable, crops = [], bytearray(), bytearray(), bytearray(), bytearray()
+    start = (0, 0)
+    for y, row in enumerate(rows):
+        for x, ch in enumerate(row):
+            if ch not in _LAYOUT_CHARS:
+                raise LevelPackError(f"level {number}: unknown tile {ch!r} at {x},{y}")
+            t, s, timer = EMPTY, EMPTY, 0
+            if ch == "S":
+                t = SOIL
+            elif ch == "P":
+                t, s = CROP, PLANTED
+            elif ch in "GWCTR":
+                #pre-placed crops start fully grown like they do in level.py
+                t, s, timer = CROP, GROWN, GROWTH_TIME
+            if ch == "F":
+                start = (x, y)
+            timers.append(timer)
+            types.append(t)
+            states.append(s)
+            walkable.append(0 if ch == "X" else 1)
+            crops.append(_CROP_CHARS.get(ch, 0))
+    block = struct.pack(f"<{w * h}i", *timers) + bytes(types) + bytes(states) + bytes(walkable) + bytes(crops)
+    return w, h, start[0], start[1], block
+
+
+def _pad(data: bytearray) -> None:
+    data.extend(b"\0" * (-len(data) % 8))
+
+
+def compile_pack(levels: list[dict]) -> bytes:
+    strings = bytearray()
+    blocks = bytearray()
+    entries = []
+    #offsets are only known once the strings are in, so entries are packed at the end
+    pending = []
+    for level in levels:
+        number = level["number"]
+        objective = level.get("objective") or {}
+        name = level.get("name", "").encode("utf-8")
+        hint = (level.get("hint") or "").encode("utf-8")
+        name_at = len(strings)
+        strings += name
+        hint_at = len(strings)
+        strings += hint
+
+        mask = 0
+        for command in objective.get("allowed_commands", ["move", "plant", "harvest"]):
+            if command not in COMMANDS:
+                raise LevelPackError(f"level {number}: unknown command {command!r}")
+            mask |= 1 << COMMANDS.index(command)
+        required = [0, 0, 0, 0]
+        for crop, n in (objective.get("crop_requirements") or {}).items():
+            if crop.lower() not in CROPS or not 0 <= n <= 0xFFFF:
+                raise LevelPackError(f"level {number}: bad crop requirement {crop}={n}")
+            required[CROPS.index(crop.lower())] = n
+        limit = objective.get("time_limit")
+        limit_ms = -1 if limit is None else int(round(limit * 1000))
+
+        w, h, sx, sy, block = _tiles(level)
+        block_at = len(blocks)
+        crc = zlib.crc32(block)
+        blocks += block
+        _pad(blocks)
+        pending.append((number, name_at, len(name), hint_at, len(hint), w, h, sx, sy,
+                        objective.get("harvests_required", 1), limit_ms, mask, required, block_at, crc))
+
+    index_size = ENTRY.size * len(levels)
+    strings_at = HEADER.size + index_size
+    blocks_at = strings_at + len(strings) + (-(strings_at + len(strings)) % 8)
+    for (number, name_at, name_len, hint_at, hint_len, w, h, sx, sy, harvests, limit_ms, mask, required,
+         block_at, crc) in pending:
+        entries.append(ENTRY.pack(number, name_at, name_len, hint_at, hint_len, w, h, sx, sy, harvests,
+                                  limit_ms, mask, *required, blocks_at + block_at, crc, 0))
+
+    body = bytearray(b"".join(entries))
+    body += strings
+    index_crc = zlib.crc32(body)
+    body.extend(b"\0" * (blocks_at - HEADER.size - len(body)))
+    body += blocks
+    size = HEADER.size + len(body)
+    header = HEADER.pack(MAGIC, PACK_VERSION, len(levels), HEADER.size, size, HEADER.size, strings_at,
+                         len(strings), index_crc, zlib.crc32(body), 0)
+    return header + bytes(body)
+
+
+def read_pack(data: bytes) -> list[dict]:
+    #checks a pack the same way LevelPackCheck::Full does and lists what's in it
+    if len(data) < HEADER.size:
+        raise LevelPackError("too short")
+    (magic, version, count, header_size, size, index_at, strings_at, strings_size, index_crc, data_crc,
+     _) = HEADER.unpack_from(data)
+    if magic != MAGIC or version != PACK_VERSION or header_size != HEADER.size or size != len(data):
+        raise LevelPackError("not a version %d level pack" % PACK_VERSION)
+    if zlib.crc32(data[index_at:strings_at + strings_size]) != index_crc or zlib.crc32(data[HEADER.size:]) != data_crc:
+        raise LevelPackError("checksum mismatch")
+    strings = data[strings_at:strings_at + strings_size]
+    levels = []
+    for i in range(count):
+        (number, name_at, name_len, hint_at, hint_len, w, h, sx, sy, harvests, limit_ms, mask, r0, r1, r2, r3,
+         tiles_at, crc, _) = ENTRY.unpack_from(data, index_at + i * ENTRY.size)
+        if zlib.crc32(data[tiles_at:tiles_at + w * h * 8]) != crc:
+            raise LevelPackError(f"level {number}: tile checksum mismatch")
+        levels.append({
+            "number": number,
+            "name": strings[name_at:name_at + name_len].decode("utf-8"),
+            "size": (w, h),
+            "start": (sx, sy),
+            "harvests_required": harvests,
+            "crop_requirements": {c: n for c, n in zip(CROPS, (r0, r1, r2, r3)) if n},
+            "time_limit": None if limit_ms < 0 else limit_ms / 1000.0,
+            "allowed_commands": [c for b, c in enumerate(COMMANDS) if mask & (1 << b)],
+        })
+    return levels
+
+
+def main(argv: list[str] | None = None) -> int:
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="compile level.py into a binary level pack")
+    parser.add_argument("-o", "--output", help="pack file to write")
+    parser.add_argument("--source", default=os.path.join(here, "level.py"), help="level definitions (default level.py)")
+    parser.add_argument("--generate", type=int, default=0, help="append N random levels after the real ones")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--list", metavar="PACK", help="check a pack and print its levels")
+    args = parser.parse_args(argv)
+
+    try:
+        if args.list:
+            with open(args.list, "rb") as f:
+                levels = read_pack(f.read())
+            for level in levels:
+                w, h = level["size"]
+                print(f'{level["number"]:5d}  {w}x{h:<4} {level["name"]}')
+            print(f"{len(levels)} levels, checksums ok")
+            return 0
+        if not args.output:
+            parser.error("give -o PACK or --list PACK")
+
+        levels = load_levels(args.source)
+        if args.generate:
+            levels += generate_levels(args.generate, args.seed, max(l["number"] for l in levels) + 1)
+        data = compile_pack(levels)
+        #write then rename so a running game never maps half a file
+        tmp = args.output + ".tmp"
+        with open(tmp, "wb") as f:
+            f.write(data)
+        os.replace(tmp, args.output)
+        print(f"{args.output}: {len(levels)} levels, {len(data)} bytes")
+        return 0
+    except (OSError, LevelPackError, SyntaxError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
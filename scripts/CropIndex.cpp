@@ -0,0 +1,250 @@
+#include "CropIndex.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <stdexcept>
+
+// level 0 cells are 8x8 tiles, each level up groups 4x4 cells of the one below: a 1024x1024
+// grid is 5 levels, and nearest() opens at most 16 cells or 64 tiles per cell it looks in
+static constexpr int LEAF_SHIFT = 3;
+static constexpr int BRANCH_SHIFT = 2;
+
+static const char* slotName(int slot)
+{
+    return slot == 0 ? "no crop" : slot == 1 ? "planted" : "grown";
+}
+
+// moves from p to the nearest of [lo, hi) along one axis
+static int axisDistance(int p, int lo, int hi)
+{
+    return p < lo ? lo - p : p >= hi ? p - hi + 1 : 0;
+}
+
+int CropIndex::slotFor(CropState state)
+{
+    if (state != CropState::PLANTED && state != CropState::GROWN)
+        throw std::invalid_argument("only PLANTED and GROWN crops are indexed");
+    return static_cast<int>(state);
+}
+
+void CropIndex::reset(int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        throw std::invalid_argument("CropIndex dimensions must be positive");
+
+    this->width = width;
+    this->height = height;
+    slots.assign(static_cast<std::size_t>(width) * height, 0);
+
+    // assign() on the levels already there, so a pooled grid's reset doesn't allocate
+    std::size_t used = 0;
+    for (int shift = LEAF_SHIFT;; shift += BRANCH_SHIFT) {
+        if (levels.size() <= used) levels.emplace_back();
+        Level& level = levels[used++];
+        level.shift = shift;
+        level.cellsWide = ((width - 1) >> shift) + 1;
+        level.cellsHigh = ((height - 1) >> shift) + 1;
+        level.counts.assign(static_cast<std::size_t>(level.cellsWide) * level.cellsHigh * 2, 0);
+        if (level.cellsWide == 1 && level.cellsHigh == 1) break;
+    }
+    levels.resize(used);
+}
+
+void CropIndex::build(int width, int height, const TileType* types, const CropState* states)
+{
+    reset(width, height);
+    const int count = width * height;
+    for (int i = 0; i < count; i++) {
+        const std::uint8_t slot = slotOf(types[i], states[i]);
+        if (slot != 0) move(i, slot);
+    }
+}
+
+void CropIndex::move(int i, std::uint8_t slot)
+{
+    const int x = i % width;
+    const int y = i / width;
+    const int old = slots[i];
+    for (Level& level : levels) {
+        const std::size_t cell = static_cast<std::size_t>((y >> level.shift) * level.cellsWide + (x >> level.shift)) * 2;
+        if (old != 0) level.counts[cell + old - 1]--;
+        if (slot != 0) level.counts[cell + slot - 1]++;
+    }
+    slots[i] = slot;
+}
+
+int CropIndex::count(CropState state) const
+{
+    return levels.back().counts[slotFor(state) - 1];
+}
+
+int CropIndex::countIn(CropState state, int x0, int y0, int x1, int y1) const
+{
+    const int slot = slotFor(state);
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, width);
+    y1 = std::min(y1, height);
+    if (x0 >= x1 || y0 >= y1) return 0;
+    return countCell(slot, static_cast<int>(levels.size()) - 1, 0, 0, x0, y0, x1, y1);
+}
+
+int CropIndex::countCell(int slot, int level, int cx, int cy, int x0, int y0, int x1, int y1) const
+{
+    const Level& l = levels[level];
+    const int n = l.counts[static_cast<std::size_t>(cy * l.cellsWide + cx) * 2 + slot - 1];
+    if (n == 0) return 0;
+
+    // the caller only hands down cells that overlap the rectangle
+    const int left = cx << l.shift;
+    const int top = cy << l.shift;
+    const int right = std::min(width, left + (1 << l.shift));
+    const int bottom = std::min(height, top + (1 << l.shift));
+    if (x0 <= left && right <= x1 && y0 <= top && bottom <= y1) return n;
+
+    int total = 0;
+    if (level == 0) {
+        for (int y = std::max(top, y0); y < std::min(bottom, y1); y++) {
+            for (int x = std::max(left, x0); x < std::min(right, x1); x++)
+                total += slots[static_cast<std::size_t>(y) * width + x] == slot;
+        }
+        return total;
+    }
+
+    const Level& below = levels[level - 1];
+    const int firstX = std::max(cx << BRANCH_SHIFT, x0 >> below.shift);
+    const int lastX = std::min((cx + 1) << BRANCH_SHIFT, ((x1 - 1) >> below.shift) + 1);
+    const int firstY = std::max(cy << BRANCH_SHIFT, y0 >> below.shift);
+    const int lastY = std::min((cy + 1) << BRANCH_SHIFT, ((y1 - 1) >> below.shift) + 1);
+    for (int by = firstY; by < lastY; by++) {
+        for (int bx = firstX; bx < lastX; bx++)
+            total += countCell(slot, level - 1, bx, by, x0, y0, x1, y1);
+    }
+    return total;
+}
+
+void CropIndex::collect(CropState state, int x0, int y0, int x1, int y1, std::vector<int>& out) const
+{
+    const int slot = slotFor(state);
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, width);
+    y1 = std::min(y1, height);
+    if (x0 >= x1 || y0 >= y1) return;
+    collectCell(slot, static_cast<int>(levels.size()) - 1, 0, 0, x0, y0, x1, y1, out);
+}
+
+void CropIndex::collectCell(int slot, int level, int cx, int cy, int x0, int y0, int x1, int y1,
+                            std::vector<int>& out) const
+{
+    const Level& l = levels[level];
+    if (l.counts[static_cast<std::size_t>(cy * l.cellsWide + cx) * 2 + slot - 1] == 0) return;
+
+    if (level == 0) {
+        const int left = cx << l.shift;
+        const int top = cy << l.shift;
+        const int right = std::min({ width, left + (1 << l.shift), x1 });
+        const int bottom = std::min({ height, top + (1 << l.shift), y1 });
+        for (int y = std::max(top, y0); y < bottom; y++) {
+            for (int x = std::max(left, x0); x < right; x++) {
+                const int i = y * width + x;
+                if (slots[i] == slot) out.push_back(i);
+            }
+        }
+        return;
+    }
+
+    const Level& below = levels[level - 1];
+    const int firstX = std::max(cx << BRANCH_SHIFT, x0 >> below.shift);
+    const int lastX = std::min((cx + 1) << BRANCH_SHIFT, ((x1 - 1) >> below.shift) + 1);
+    const int firstY = std::max(cy << BRANCH_SHIFT, y0 >> below.shift);
+    const int lastY = std::min((cy + 1) << BRANCH_SHIFT, ((y1 - 1) >> below.shift) + 1);
+    for (int by = firstY; by < lastY; by++) {
+        for (int bx = firstX; bx < lastX; bx++)
+            collectCell(slot, level - 1, bx, by, x0, y0, x1, y1, out);
+    }
+}
+
+int CropIndex::nearest(CropState state, int x, int y) const
+{
+    const int slot = slotFor(state);
+    if (levels.back().counts[slot - 1] == 0) return -1;
+
+    // best-first over cells by their closest tile: the first tile off the heap is the answer
+    // since every cell still on it is at least as far. The open list is per thread rather
+    // than per index so concurrent queries don't share it, and kept so they don't allocate.
+    thread_local std::vector<Entry> heap;
+    heap.clear();
+    auto push = [](const Entry& e) {
+        heap.push_back(e);
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    };
+    push({ 0, static_cast<int>(levels.size()) - 1, 0 });
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        const Entry e = heap.back();
+        heap.pop_back();
+        if (e.level < 0) return e.id;
+
+        const Level& l = levels[e.level];
+        const int cx = e.id % l.cellsWide;
+        const int cy = e.id / l.cellsWide;
+        if (e.level == 0) {
+            const int left = cx << l.shift;
+            const int top = cy << l.shift;
+            const int right = std::min(width, left + (1 << l.shift));
+            const int bottom = std::min(height, top + (1 << l.shift));
+            for (int ty = top; ty < bottom; ty++) {
+                for (int tx = left; tx < right; tx++) {
+                    const int i = ty * width + tx;
+                    if (slots[i] == slot) push({ std::abs(tx - x) + std::abs(ty - y), -1, i });
+                }
+            }
+            continue;
+        }
+
+        const Level& below = levels[e.level - 1];
+        const int lastX = std::min((cx + 1) << BRANCH_SHIFT, below.cellsWide);
+        const int lastY = std::min((cy + 1) << BRANCH_SHIFT, below.cellsHigh);
+        for (int by = cy << BRANCH_SHIFT; by < lastY; by++) {
+            for (int bx = cx << BRANCH_SHIFT; bx < lastX; bx++) {
+                const int cell = by * below.cellsWide + bx;
+                if (below.counts[static_cast<std::size_t>(cell) * 2 + slot - 1] == 0) continue;
+                const int left = bx << below.shift;
+                const int top = by << below.shift;
+                const int distance = axisDistance(x, left, std::min(width, left + (1 << below.shift)))
+                                     + axisDistance(y, top, std::min(height, top + (1 << below.shift)));
+                push({ distance, e.level - 1, cell });
+            }
+        }
+    }
+    return -1;
+}
+
+bool CropIndex::matches(const TileType* types, const CropState* states, std::string& why) const
+{
+    CropIndex fresh;
+    fresh.build(width, height, types, states);
+
+    for (std::size_t i = 0; i < slots.size(); i++) {
+        if (slots[i] != fresh.slots[i]) {
+            why = "tile (" + std::to_string(i % width) + ", " + std::to_string(i / width) + ") is indexed as "
+                  + slotName(slots[i]) + " but is " + slotName(fresh.slots[i]);
+            return false;
+        }
+    }
+    for (std::size_t l = 0; l < levels.size(); l++) {
+        const Level& level = levels[l];
+        for (std::size_t k = 0; k < level.counts.size(); k++) {
+            if (level.counts[k] != fresh.levels[l].counts[k]) {
+                const int cell = static_cast<int>(k / 2);
+                why = "level " + std::to_string(l) + " cell (" + std::to_string(cell % level.cellsWide) + ", "
+                      + std::to_string(cell / level.cellsWide) + ") counts " + std::to_string(level.counts[k]) + " "
+                      + slotName(static_cast<int>(k % 2) + 1) + ", should be " + std::to_string(fresh.levels[l].counts[k]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Tile.hpp"
+
+// Where the PLANTED and GROWN crops are, for "nearest ripe crop to the farmer" and "crops in
+// this area" without scanning the grid. Used by Grid (setCropIndexing), which keeps it in step
+// with every tile write and every crop that ripens.
+//
+// A count pyramid over the tiles: level 0 counts each state per 8x8 block of tiles, every
+// level above counts per 4x4 block of the cells below it, up to one cell for the whole grid.
+// Changing a tile is one count per level. Queries only go down into cells that have a crop of
+// the state asked for and, for rectangles, aren't wholly inside or outside the rectangle.
+// A byte per tile remembers which state the index has it under, so a change never needs
+// the old tile.
+class CropIndex
+{
+    public:
+    // all tiles crop-free
+    void reset(int width, int height);
+    // from row-major field arrays, width * height each
+    void build(int width, int height, const TileType* types, const CropState* states);
+
+    // tile i is now this
+    void set(int i, TileType type, CropState state)
+    {
+        const std::uint8_t slot = slotOf(type, state);
+        if (slot != slots[i]) move(i, slot);
+    }
+
+    // Queries. state is PLANTED or GROWN, anything else throws std::invalid_argument. They
+    // don't write anything, so any number of threads can run them at once as long as nothing
+    // changes the index meanwhile.
+    // crops in that state, O(1)
+    int count(CropState state) const;
+    // ... inside x0 <= x < x1, y0 <= y < y1 (clipped to the grid)
+    int countIn(CropState state, int x0, int y0, int x1, int y1) const;
+    // appends their tile indices, block by block rather than row-major
+    void collect(CropState state, int x0, int y0, int x1, int y1, std::vector<int>& out) const;
+    // tile index of the crop in that state closest to (x, y) in moves ignoring walls
+    // (Manhattan), the lowest index on a tie, -1 if there's none
+    int nearest(CropState state, int x, int y) const;
+
+    // compares everything against an index built from scratch off these fields, false with
+    // the first difference in why if they don't agree
+    bool matches(const TileType* types, const CropState* states, std::string& why) const;
+
+    private:
+    // 0 not a crop, 1 PLANTED, 2 GROWN
+    static std::uint8_t slotOf(TileType type, CropState state)
+    {
+        return type == TileType::CROP ? static_cast<std::uint8_t>(state) : 0;
+    }
+    static int slotFor(CropState state);
+
+    struct Level
+    {
+        int shift = 0;                     // log2 of the tiles a cell spans each way
+        int cellsWide = 0;
+        int cellsHigh = 0;
+        std::vector<std::int32_t> counts;  // [cell * 2 + slot - 1]
+    };
+
+    // best-first entry: a cell of some level, or a tile (level -1)
+    struct Entry
+    {
+        int distance;
+        int level;
+        int id;
+        bool operator>(const Entry& o) const
+        {
+            // cells before tiles at the same distance, so a tile only comes out once nothing
+            // at that distance is left unopened and the lowest index wins
+            if (distance != o.distance) return distance > o.distance;
+            if ((level < 0) != (o.level < 0)) return level < 0;
+            return id > o.id;
+        }
+    };
+
+    void move(int i, std::uint8_t slot);
+    int countCell(int slot, int level, int cx, int cy, int x0, int y0, int x1, int y1) const;
+    void collectCell(int slot, int level, int cx, int cy, int x0, int y0, int x1, int y1,
+                     std::vector<int>& out) const;
+
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint8_t> slots;
+    std::vector<Level> levels;         // levels.back() is the single whole-grid cell
+};
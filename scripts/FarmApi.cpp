@@ -0,0 +1,266 @@
+#include "FarmApi.h"
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "Farmer.hpp"
+#include "Grid.hpp"
+#include "Simulation.hpp"
+
+// the opaque handle, a farm and the farmer on it (Farmer keeps a Grid&, so this never moves)
+struct FarmWorld
+{
+    FarmWorld(int width, int height) : grid(width, height), farmer(grid)
+    {
+        // submit reports changed tiles per action
+        grid.setChangeTracking(true);
+        // count_crops / nearest_crop
+        grid.setCropIndexing(true);
+    }
+
+    Grid grid;
+    Farmer farmer;
+};
+
+namespace {
+
+thread_local std::string lastError;
+
+// runs fn, turning exceptions into a status code and a message for farm_last_error
+template <typename Fn>
+int guarded(Fn&& fn)
+{
+    try {
+        lastError.clear();
+        fn();
+        return FARM_OK;
+    } catch (const std::out_of_range& e) {
+        lastError = e.what();
+        return FARM_ERR_RANGE;
+    } catch (const std::invalid_argument& e) {
+        lastError = e.what();
+        return FARM_ERR_ARGUMENT;
+    } catch (const std::exception& e) {
+        lastError = e.what();
+        return FARM_ERR_INTERNAL;
+    } catch (...) {
+        lastError = "unknown error";
+        return FARM_ERR_INTERNAL;
+    }
+}
+
+void requireWorld(const FarmWorld* world)
+{
+    if (!world) throw std::invalid_argument("world is NULL");
+}
+
+bool applyFarmAction(std::uint8_t action, Farmer& farmer)
+{
+    switch (action) {
+    case FARM_ACTION_MOVE_LEFT: return farmer.move(LEFT);
+    case FARM_ACTION_MOVE_UP: return farmer.move(UP);
+    case FARM_ACTION_MOVE_DOWN: return farmer.move(DOWN);
+    case FARM_ACTION_MOVE_RIGHT: return farmer.move(RIGHT);
+    case FARM_ACTION_PLANT: return farmer.plant();
+    case FARM_ACTION_HARVEST: return farmer.harvest();
+    case FARM_ACTION_REMOVE: return farmer.remove();
+    default: return true; // wait
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+int farm_api_version(void)
+{
+    return FARM_API_VERSION;
+}
+
+const char* farm_last_error(void)
+{
+    return lastError.c_str();
+}
+
+FarmWorld* farm_world_create(int width, int height)
+{
+    FarmWorld* world = nullptr;
+    guarded([&] { world = new FarmWorld(width, height); });
+    return world;
+}
+
+FarmWorld* farm_world_create_from_layout(const char* layout)
+{
+    FarmWorld* world = nullptr;
+    const int status = guarded([&] {
+        if (!layout) throw std::invalid_argument("layout is NULL");
+        std::istringstream in(layout);
+        const Layout parsed = parseLayout(in);
+        world = new FarmWorld(parsed.width, parsed.height);
+        applyLayout(parsed, world->grid);
+        world->grid.clearChangedTiles();
+        world->farmer.reset(parsed.startX, parsed.startY);
+    });
+    if (status != FARM_OK && world) {
+        delete world;
+        world = nullptr;
+    }
+    return world;
+}
+
+void farm_world_destroy(FarmWorld* world)
+{
+    delete world;
+}
+
+int farm_world_tiles(FarmWorld* world, FarmTileView* out)
+{
+    return guarded([&] {
+        requireWorld(world);
+        if (!out) throw std::invalid_argument("out is NULL");
+        static_assert(sizeof(TileType) == 1 && sizeof(CropState) == 1 && sizeof(int) == sizeof(std::int32_t),
+                      "FarmTileView expects byte enums and 32-bit timers");
+        const Grid& grid = world->grid;
+        // growthTimers() brings the scheduled crops' timers up to date
+        out->timers = reinterpret_cast<const std::int32_t*>(grid.growthTimers().data());
+        out->types = reinterpret_cast<const std::uint8_t*>(grid.types().data());
+        out->states = reinterpret_cast<const std::uint8_t*>(grid.cropStates().data());
+        out->width = grid.getGridWidth();
+        out->height = grid.getGridHeight();
+    });
+}
+
+int farm_world_set_tile(FarmWorld* world, int x, int y, int type, int state, int timer)
+{
+    return guarded([&] {
+        requireWorld(world);
+        if (type < 0 || type > static_cast<int>(TileType::CROP) || state < 0 || state > static_cast<int>(CropState::GROWN))
+            throw std::invalid_argument("bad tile type or crop state");
+        Tile t;
+        t.type = static_cast<TileType>(type);
+        t.cropstate = static_cast<CropState>(state);
+        t.growthTimer = timer;
+        world->grid.setTile(x, y, t);
+        world->grid.growthTimers(); // keep the tile view's timers current
+    });
+}
+
+int farm_world_walkability(FarmWorld* world, const uint8_t** out)
+{
+    return guarded([&] {
+        requireWorld(world);
+        if (!out) throw std::invalid_argument("out is NULL");
+        *out = world->grid.walkability().data();
+    });
+}
+
+int farm_world_set_walkable(FarmWorld* world, int x, int y, int walkable)
+{
+    return guarded([&] {
+        requireWorld(world);
+        world->grid.setWalkable(x, y, walkable != 0);
+    });
+}
+
+int farm_world_farmer(const FarmWorld* world, int* x, int* y)
+{
+    return guarded([&] {
+        requireWorld(world);
+        if (x) *x = world->farmer.getX();
+        if (y) *y = world->farmer.getY();
+    });
+}
+
+int farm_world_set_farmer(FarmWorld* world, int x, int y)
+{
+    return guarded([&] {
+        requireWorld(world);
+        if (x < 0 || y < 0 || x >= world->grid.getGridWidth() || y >= world->grid.getGridHeight())
+            throw std::out_of_range("farmer position off the grid");
+        world->farmer.setPosition(x, y);
+    });
+}
+
+int farm_world_harvests(const FarmWorld* world, int64_t* out)
+{
+    return guarded([&] {
+        requireWorld(world);
+        if (out) *out = world->farmer.getHarvestCount();
+    });
+}
+
+int farm_world_tick_count(const FarmWorld* world, int64_t* out)
+{
+    return guarded([&] {
+        requireWorld(world);
+        if (out) *out = world->grid.getTickCount();
+    });
+}
+
+int farm_world_count_crops(const FarmWorld* world, int state, int x0, int y0, int x1, int y1, int64_t* out)
+{
+    return guarded([&] {
+        requireWorld(world);
+        const int n = world->grid.countCrops(static_cast<CropState>(state), x0, y0, x1, y1);
+        if (out) *out = n;
+    });
+}
+
+int farm_world_nearest_crop(const FarmWorld* world, int state, int x, int y, int* out_x, int* out_y)
+{
+    return guarded([&] {
+        requireWorld(world);
+        int cx = -1, cy = -1;
+        if (!world->grid.nearestCrop(static_cast<CropState>(state), x, y, cx, cy)) cx = cy = -1;
+        if (out_x) *out_x = cx;
+        if (out_y) *out_y = cy;
+    });
+}
+
+int farm_world_tick(FarmWorld* world, int ticks)
+{
+    return guarded([&] {
+        requireWorld(world);
+        if (ticks < 0) throw std::invalid_argument("ticks can't be negative");
+        for (int i = 0; i < ticks; i++) world->grid.tick();
+        world->grid.clearChangedTiles();
+        world->grid.growthTimers();
+    });
+}
+
+int farm_world_submit(FarmWorld* world, const uint8_t* actions, int count, uint8_t* results,
+                      int32_t* changed_offsets, int32_t* changed, int changed_capacity)
+{
+    return guarded([&] {
+        requireWorld(world);
+        if (count < 0 || (count > 0 && !actions)) throw std::invalid_argument("bad action array");
+        if (!changed) changed_capacity = 0;
+        // check the whole batch first so a bad byte doesn't leave it half run
+        for (int i = 0; i < count; i++)
+            if (actions[i] > FARM_ACTION_WAIT)
+                throw std::invalid_argument("unknown action " + std::to_string(actions[i]) + " at " + std::to_string(i));
+
+        Grid& grid = world->grid;
+        grid.clearChangedTiles();
+        int written = 0;
+        for (int i = 0; i < count; i++) {
+            const bool ok = applyFarmAction(actions[i], world->farmer);
+            grid.tick();
+
+            std::uint8_t flags = ok ? FARM_RESULT_OK : 0;
+            if (changed_offsets) changed_offsets[i] = written;
+            const std::vector<int>& tiles = grid.getChangedTiles();
+            if (grid.allTilesChanged() || static_cast<std::size_t>(changed_capacity - written) < tiles.size()) {
+                flags |= FARM_RESULT_ALL_CHANGED;
+            } else if (changed) {
+                for (int t : tiles) changed[written++] = t;
+            }
+            grid.clearChangedTiles();
+            if (results) results[i] = flags;
+        }
+        if (changed_offsets) changed_offsets[count] = written;
+        grid.growthTimers();
+    });
+}
+
+} // extern "C"
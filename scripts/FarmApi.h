@@ -0,0 +1,128 @@
+#ifndef FARM_API_H
+#define FARM_API_H
+/*
+ * Plain C interface to the simulation (Grid + Farmer), built as the farm_api shared library
+ * so the Python client can load it with ctypes (pygame/farm_native.py).
+ *
+ * - Actions go in as batches: one farm_world_submit call runs N actions, each followed by a
+ *   tick, and hands back N results plus the tiles each one changed. Crossing into the
+ *   library costs the same for 1 action or 10000.
+ * - Tile state is read in place: farm_world_tiles gives pointers straight into the grid's
+ *   arrays, nothing gets copied.
+ * - Every function returning int returns FARM_OK (0) or a negative FARM_ERR_*, the message
+ *   for the last error on the calling thread is farm_last_error(). Nothing throws across
+ *   the boundary.
+ *
+ * Bump FARM_API_VERSION when an existing signature or struct changes, adding functions
+ * doesn't need it.
+ */
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  if defined(FARM_API_BUILD)
+#    define FARM_API __declspec(dllexport)
+#  else
+#    define FARM_API __declspec(dllimport)
+#  endif
+#else
+#  define FARM_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FARM_API_VERSION 1
+
+typedef struct FarmWorld FarmWorld;
+
+enum FarmStatus
+{
+    FARM_OK = 0,
+    FARM_ERR_ARGUMENT = -1, /* null world, bad size, bad layout, unknown action */
+    FARM_ERR_RANGE = -2,    /* tile or farmer position off the grid */
+    FARM_ERR_INTERNAL = -3, /* anything else, see farm_last_error */
+};
+
+/* one byte per action in a batch, the moves line up with Farmer's direction enum */
+enum FarmAction
+{
+    FARM_ACTION_MOVE_LEFT = 0,
+    FARM_ACTION_MOVE_UP = 1,
+    FARM_ACTION_MOVE_DOWN = 2,
+    FARM_ACTION_MOVE_RIGHT = 3,
+    FARM_ACTION_PLANT = 4,
+    FARM_ACTION_HARVEST = 5,
+    FARM_ACTION_REMOVE = 6,
+    FARM_ACTION_WAIT = 7,
+};
+
+/* bits of each per-action result byte */
+enum FarmResultFlags
+{
+    FARM_RESULT_OK = 1,          /* the action did something (not blocked by an edge or wall, ...) */
+    FARM_RESULT_ALL_CHANGED = 2, /* too many tiles changed to list, or the list buffer was full:
+                                    re-read the whole grid */
+};
+
+/* pointers into the grid's own arrays, row-major (y * width + x). Valid until the world is
+   destroyed; contents change with every submit / tick / set_tile. */
+typedef struct FarmTileView
+{
+    const uint8_t* types;   /* TileType: 0 empty, 1 soil, 2 crop */
+    const uint8_t* states;  /* CropState: 0 empty, 1 planted, 2 grown */
+    const int32_t* timers;  /* ticks since planted */
+    int32_t width;
+    int32_t height;
+} FarmTileView;
+
+FARM_API int farm_api_version(void);
+/* message for the last failed call on this thread, "" if none */
+FARM_API const char* farm_last_error(void);
+
+/* an all-empty width x height farm with the farmer at 0,0, NULL on error */
+FARM_API FarmWorld* farm_world_create(int width, int height);
+/* a farm from an ASCII layout (same format as farm_headless --layout), NULL on error */
+FARM_API FarmWorld* farm_world_create_from_layout(const char* layout);
+FARM_API void farm_world_destroy(FarmWorld* world);
+
+FARM_API int farm_world_tiles(FarmWorld* world, FarmTileView* out);
+FARM_API int farm_world_set_tile(FarmWorld* world, int x, int y, int type, int state, int timer);
+/* 1 walkable / 0 wall per tile, row-major, a pointer into the grid like FarmTileView */
+FARM_API int farm_world_walkability(FarmWorld* world, const uint8_t** out);
+FARM_API int farm_world_set_walkable(FarmWorld* world, int x, int y, int walkable);
+
+FARM_API int farm_world_farmer(const FarmWorld* world, int* x, int* y);
+FARM_API int farm_world_set_farmer(FarmWorld* world, int x, int y);
+FARM_API int farm_world_harvests(const FarmWorld* world, int64_t* out);
+FARM_API int farm_world_tick_count(const FarmWorld* world, int64_t* out);
+
+/* crops in state (1 planted, 2 grown) inside x0 <= x < x1, y0 <= y < y1, clipped to the grid,
+   without scanning it */
+FARM_API int farm_world_count_crops(const FarmWorld* world, int state, int x0, int y0, int x1, int y1,
+                                    int64_t* out);
+/* the crop in state closest to x, y in moves ignoring walls (lowest y * width + x on a tie),
+   -1, -1 if there's none */
+FARM_API int farm_world_nearest_crop(const FarmWorld* world, int state, int x, int y, int* out_x, int* out_y);
+
+/* runs ticks ticks with no actions, changed tiles aren't reported: re-read the tile view */
+FARM_API int farm_world_tick(FarmWorld* world, int ticks);
+
+/*
+ * Runs count actions in order, each one followed by a tick.
+ *   results         count bytes of FarmResultFlags, may be NULL
+ *   changed_offsets count + 1 entries, action i changed tiles
+ *                   changed[changed_offsets[i] .. changed_offsets[i + 1]), may be NULL
+ *   changed         flat tile indices (y * width + x) whose type or crop state changed,
+ *                   changed_capacity entries, may be NULL. An action whose list doesn't fit
+ *                   gets FARM_RESULT_ALL_CHANGED and an empty range instead.
+ * Every action runs even if the change list fills up.
+ */
+FARM_API int farm_world_submit(FarmWorld* world, const uint8_t* actions, int count, uint8_t* results,
+                               int32_t* changed_offsets, int32_t* changed, int changed_capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
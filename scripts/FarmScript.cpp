@@ -0,0 +1,799 @@
+#include "FarmScript.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+enum class TokenKind { Name, Int, Str, Op, Newline, Indent, Dedent, End };
+
+struct Token
+{
+    TokenKind kind;
+    std::string text; // name, operator or string contents
+    std::int64_t value = 0;
+    int line = 0;
+};
+
+bool isNameStart(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// the parser recurses once per nested bracket, unary operator or block, so these keep a
+// crafted script from running it out of stack (CPython stops at about the same depths)
+constexpr int MAX_EXPRESSION_NESTING = 200;
+constexpr int MAX_BLOCK_NESTING = 100;
+
+// longest first so "//=" wins over "//" over "/"
+const char* const OPERATORS[] = {
+    "//=", "**", "==", "!=", "<=", ">=", "+=", "-=", "*=", "%=", "//", "->",
+    "(", ")", "[", "]", "{", "}", ",", ":", ";", "=", "<", ">", "+", "-", "*", "/", "%", ".", "@", "&", "|", "^", "~",
+};
+
+// Python's tokenizer, cut down: INDENT/DEDENT from leading whitespace, newlines inside
+// brackets don't end the line, comments and blank lines are skipped
+std::vector<Token> tokenize(const std::string& source)
+{
+    std::vector<Token> out;
+    std::vector<int> indents = { 0 };
+    int depth = 0; // open brackets
+    int lineNo = 0;
+    std::size_t pos = 0;
+
+    while (pos <= source.size()) {
+        std::size_t end = source.find('\n', pos);
+        if (end == std::string::npos) end = source.size();
+        std::string line = source.substr(pos, end - pos);
+        pos = end + 1;
+        lineNo++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        std::size_t i = 0;
+        if (depth == 0) {
+            int column = 0;
+            for (; i < line.size() && (line[i] == ' ' || line[i] == '\t'); i++)
+                column = line[i] == '\t' ? (column / 8 + 1) * 8 : column + 1;
+            if (i == line.size() || line[i] == '#') continue; // blank or comment only
+
+            if (column > indents.back()) {
+                indents.push_back(column);
+                out.push_back({ TokenKind::Indent, "", 0, lineNo });
+            }
+            while (column < indents.back()) {
+                indents.pop_back();
+                out.push_back({ TokenKind::Dedent, "", 0, lineNo });
+            }
+            if (column != indents.back())
+                throw ScriptError("unindent does not match any outer indentation level", lineNo);
+        }
+
+        bool continued = false;
+        while (i < line.size()) {
+            const char c = line[i];
+            if (c == ' ' || c == '\t') { i++; continue; }
+            if (c == '#') break;
+            if (c == '\\' && i + 1 == line.size()) { continued = true; break; }
+
+            if (isDigit(c)) {
+                std::size_t j = i;
+                while (j < line.size() && (isDigit(line[j]) || line[j] == '_')) j++;
+                if (j < line.size() && (line[j] == '.' || line[j] == 'e' || line[j] == 'E'))
+                    throw ScriptError("only whole numbers are supported", lineNo);
+                if (j < line.size() && isNameStart(line[j]))
+                    throw ScriptError("invalid number literal", lineNo);
+                std::int64_t v = 0;
+                for (std::size_t k = i; k < j; k++) {
+                    if (line[k] == '_') continue;
+                    if (v > (std::numeric_limits<std::int32_t>::max() - (line[k] - '0')) / 10)
+                        throw ScriptError("number too big", lineNo);
+                    v = v * 10 + (line[k] - '0');
+                }
+                out.push_back({ TokenKind::Int, line.substr(i, j - i), v, lineNo });
+                i = j;
+                continue;
+            }
+
+            if (isNameStart(c)) {
+                std::size_t j = i;
+                while (j < line.size() && (isNameStart(line[j]) || isDigit(line[j]))) j++;
+                // f"..." b"..." and friends
+                if (j < line.size() && (line[j] == '"' || line[j] == '\''))
+                    throw ScriptError("string prefixes aren't supported", lineNo);
+                out.push_back({ TokenKind::Name, line.substr(i, j - i), 0, lineNo });
+                i = j;
+                continue;
+            }
+
+            if (c == '"' || c == '\'') {
+                if (line.compare(i, 3, std::string(3, c)) == 0)
+                    throw ScriptError("triple-quoted strings aren't supported, use # comments", lineNo);
+                std::string text;
+                std::size_t j = i + 1;
+                for (;; j++) {
+                    if (j >= line.size()) throw ScriptError("unterminated string", lineNo);
+                    if (line[j] == c) break;
+                    if (line[j] == '\\' && j + 1 < line.size()) {
+                        const char e = line[++j];
+                        text += e == 'n' ? '\n' : e == 't' ? '\t' : e;
+                    } else {
+                        text += line[j];
+                    }
+                }
+                out.push_back({ TokenKind::Str, text, 0, lineNo });
+                i = j + 1;
+                continue;
+            }
+
+            const char* op = nullptr;
+            for (const char* candidate : OPERATORS) {
+                if (line.compare(i, std::strlen(candidate), candidate) == 0) {
+                    op = candidate;
+                    break;
+                }
+            }
+            if (!op) throw ScriptError(std::string("unexpected character '") + c + "'", lineNo);
+            if (op[0] == '(' || op[0] == '[' || op[0] == '{') depth++;
+            if (op[0] == ')' || op[0] == ']' || op[0] == '}') depth = std::max(0, depth - 1);
+            out.push_back({ TokenKind::Op, op, 0, lineNo });
+            i += std::strlen(op);
+        }
+
+        // a logical line ends here unless a bracket is still open
+        if (depth == 0 && !continued && !out.empty() && out.back().kind != TokenKind::Newline
+            && out.back().kind != TokenKind::Indent && out.back().kind != TokenKind::Dedent)
+            out.push_back({ TokenKind::Newline, "", 0, lineNo });
+        if (end == source.size()) break;
+    }
+    if (depth > 0) throw ScriptError("unclosed bracket at end of script", lineNo);
+
+    while (indents.size() > 1) {
+        indents.pop_back();
+        out.push_back({ TokenKind::Dedent, "", 0, lineNo });
+    }
+    out.push_back({ TokenKind::End, "", 0, lineNo });
+    return out;
+}
+
+const char* const ACTIONS[] = { "move", "plant", "harvest", "remove", "print", "range" };
+const char* const UNSUPPORTED_STATEMENTS[] = {
+    "def", "class", "import", "from", "return", "try", "except", "finally", "with", "lambda",
+    "global", "nonlocal", "del", "assert", "raise", "yield", "async", "await",
+};
+
+bool isOneOf(const std::string& s, std::initializer_list<const char*> list)
+{
+    for (const char* l : list)
+        if (s == l) return true;
+    return false;
+}
+
+class Compiler
+{
+    public:
+    Compiler(const std::vector<Token>& tokens, const ScriptOptions& options) : tokens(tokens), options(options) {}
+
+    ScriptProgram compile()
+    {
+        while (peek().kind != TokenKind::End) {
+            if (peek().kind == TokenKind::Indent) throw error("unexpected indent");
+            statement();
+        }
+        markLine(peek().line);
+        emit(ScriptOp::Halt);
+        return std::move(program);
+    }
+
+    private:
+    struct Loop
+    {
+        std::size_t continueTarget;
+        std::vector<std::size_t> breaks; // operand offsets to patch with the loop's exit
+    };
+
+    const Token& peek(int ahead = 0) const { return tokens[std::min(pos + ahead, tokens.size() - 1)]; }
+    const Token& advance() { return tokens[std::min(pos++, tokens.size() - 1)]; }
+    bool isOp(const char* op, int ahead = 0) const { return peek(ahead).kind == TokenKind::Op && peek(ahead).text == op; }
+    bool isName(const char* name) const { return peek().kind == TokenKind::Name && peek().text == name; }
+
+    ScriptError error(const std::string& message) const { return ScriptError(message, peek().line); }
+
+    // one level deeper for as long as it lives, throws past the limit
+    struct Nested
+    {
+        Nested(const Compiler& compiler, int& depth, int limit, const char* message) : depth(depth)
+        {
+            if (++depth > limit) throw compiler.error(message);
+        }
+        ~Nested() { depth--; }
+        Nested(const Nested&) = delete;
+        Nested& operator=(const Nested&) = delete;
+        int& depth;
+    };
+
+    void expectOp(const char* op)
+    {
+        if (!isOp(op)) throw error(std::string("expected '") + op + "'");
+        advance();
+    }
+
+    void expectNewline()
+    {
+        if (peek().kind != TokenKind::Newline && peek().kind != TokenKind::End) throw error("invalid syntax");
+        if (peek().kind == TokenKind::Newline) advance();
+    }
+
+    bool allowed(const char* construct) const
+    {
+        return options.allowed.empty()
+            || std::find(options.allowed.begin(), options.allowed.end(), construct) != options.allowed.end();
+    }
+
+    void requireAllowed(const char* construct)
+    {
+        if (!allowed(construct))
+            throw error(std::string(construct) + " isn't allowed on this level");
+    }
+
+    // --- emitting ---
+
+    void emit(ScriptOp op) { program.code.push_back(static_cast<std::uint8_t>(op)); }
+
+    std::size_t emitOperand(std::int32_t v)
+    {
+        const std::size_t at = program.code.size();
+        std::uint8_t bytes[4];
+        for (int b = 0; b < 4; b++) bytes[b] = static_cast<std::uint8_t>(static_cast<std::uint32_t>(v) >> (8 * b));
+        program.code.insert(program.code.end(), bytes, bytes + 4);
+        return at;
+    }
+
+    void patch(std::size_t operandAt, std::size_t target)
+    {
+        for (int b = 0; b < 4; b++)
+            program.code[operandAt + b] = static_cast<std::uint8_t>(static_cast<std::uint32_t>(target) >> (8 * b));
+    }
+
+    std::size_t here() const { return program.code.size(); }
+
+    std::size_t emitJump(ScriptOp op, std::size_t target = 0)
+    {
+        emit(op);
+        return emitOperand(static_cast<std::int32_t>(target));
+    }
+
+    void markLine(int line)
+    {
+        if (program.lines.empty() || program.lines.back().second != line) {
+            if (!program.lines.empty() && program.lines.back().first == here())
+                program.lines.back().second = line;
+            else
+                program.lines.push_back({ static_cast<std::uint32_t>(here()), line });
+        }
+    }
+
+    int slotFor(const std::string& name)
+    {
+        auto it = slots.find(name);
+        if (it != slots.end()) return it->second;
+        const int slot = static_cast<int>(program.variables.size());
+        program.variables.push_back(name);
+        slots[name] = slot;
+        return slot;
+    }
+
+    int hiddenSlots(int count)
+    {
+        const int first = static_cast<int>(program.variables.size());
+        for (int k = 0; k < count; k++) program.variables.push_back("");
+        return first;
+    }
+
+    int stringConstant(const std::string& s)
+    {
+        auto it = std::find(program.strings.begin(), program.strings.end(), s);
+        if (it != program.strings.end()) return static_cast<int>(it - program.strings.begin());
+        program.strings.push_back(s);
+        return static_cast<int>(program.strings.size() - 1);
+    }
+
+    // --- statements ---
+
+    void statement()
+    {
+        const Token& t = peek();
+        markLine(t.line);
+        if (t.kind == TokenKind::Name) {
+            if (t.text == "if") return ifStatement();
+            if (t.text == "while") return whileStatement();
+            if (t.text == "for") return forStatement();
+            for (const char* word : UNSUPPORTED_STATEMENTS)
+                if (t.text == word) throw error("'" + t.text + "' isn't supported in farm scripts");
+            if (t.text == "elif" || t.text == "else") throw error("'" + t.text + "' without a matching if");
+        }
+        simpleStatements();
+    }
+
+    // one or more simple statements separated by ';' up to the end of the line
+    void simpleStatements()
+    {
+        for (;;) {
+            markLine(peek().line);
+            simpleStatement();
+            if (!isOp(";")) break;
+            advance();
+            if (peek().kind == TokenKind::Newline || peek().kind == TokenKind::End) break;
+        }
+        expectNewline();
+    }
+
+    void simpleStatement()
+    {
+        const Token& t = peek();
+        if (t.kind == TokenKind::Name && t.text == "pass") {
+            advance();
+            return;
+        }
+        if (t.kind == TokenKind::Name && (t.text == "break" || t.text == "continue")) {
+            if (loops.empty()) throw error("'" + t.text + "' outside loop");
+            advance();
+            if (t.text == "break") {
+                loops.back().breaks.push_back(emitJump(ScriptOp::Jump));
+            } else {
+                emitJump(ScriptOp::Jump, loops.back().continueTarget);
+            }
+            return;
+        }
+
+        if (t.kind == TokenKind::Name && peek(1).kind == TokenKind::Op) {
+            const std::string& op = peek(1).text;
+            if (op == "=" || op == "+=" || op == "-=" || op == "*=" || op == "//=" || op == "%=") {
+                assignment();
+                return;
+            }
+        }
+
+        // an expression on its own, normally a command call. Commands push None for when
+        // they're used as a value, which a statement doesn't need.
+        expression();
+        if (lastCommandEnd == here() && !program.code.empty()
+            && program.code.back() == static_cast<std::uint8_t>(ScriptOp::PushNone))
+            program.code.pop_back();
+        else
+            emit(ScriptOp::Pop);
+    }
+
+    void assignment()
+    {
+        const Token name = advance();
+        if (isOneOf(name.text, { "move", "plant", "harvest", "remove", "print", "range", "True", "False", "None" }))
+            throw ScriptError("can't assign to '" + name.text + "'", name.line);
+        const std::string op = advance().text;
+        const int slot = slotFor(name.text);
+        if (op != "=") {
+            emit(ScriptOp::Load);
+            emitOperand(slot);
+        }
+        expression();
+        if (isOp("=")) throw error("chained assignment isn't supported");
+        if (isOp(",")) throw error("tuple assignment isn't supported");
+        if (op == "+=") emit(ScriptOp::Add);
+        else if (op == "-=") emit(ScriptOp::Sub);
+        else if (op == "*=") emit(ScriptOp::Mul);
+        else if (op == "//=") emit(ScriptOp::FloorDiv);
+        else if (op == "%=") emit(ScriptOp::Mod);
+        emit(ScriptOp::Store);
+        emitOperand(slot);
+    }
+
+    // ':' then an indented block, or simple statements on the same line
+    void block()
+    {
+        const Nested nested(*this, blockDepth, MAX_BLOCK_NESTING, "too many levels of indentation");
+        expectOp(":");
+        if (peek().kind != TokenKind::Newline) {
+            simpleStatements();
+            return;
+        }
+        advance();
+        if (peek().kind != TokenKind::Indent) throw error("expected an indented block");
+        advance();
+        while (peek().kind != TokenKind::Dedent && peek().kind != TokenKind::End) statement();
+        if (peek().kind == TokenKind::Dedent) advance();
+    }
+
+    void ifStatement()
+    {
+        requireAllowed("if");
+        advance();
+        std::vector<std::size_t> toEnd;
+        for (;;) {
+            expression();
+            const std::size_t skip = emitJump(ScriptOp::JumpIfFalse);
+            block();
+            if (isName("elif")) {
+                markLine(peek().line);
+                toEnd.push_back(emitJump(ScriptOp::Jump));
+                patch(skip, here());
+                advance();
+                continue;
+            }
+            if (isName("else")) {
+                markLine(peek().line);
+                toEnd.push_back(emitJump(ScriptOp::Jump));
+                patch(skip, here());
+                advance();
+                block();
+            } else {
+                patch(skip, here());
+            }
+            break;
+        }
+        for (std::size_t at : toEnd) patch(at, here());
+    }
+
+    void whileStatement()
+    {
+        requireAllowed("while");
+        advance();
+        const std::size_t start = here();
+        expression();
+        const std::size_t exit = emitJump(ScriptOp::JumpIfFalse);
+        loops.push_back({ start, {} });
+        block();
+        emitJump(ScriptOp::Jump, start);
+        finishLoop(exit);
+    }
+
+    void forStatement()
+    {
+        requireAllowed("for");
+        advance();
+        if (peek().kind != TokenKind::Name) throw error("expected a loop variable");
+        const Token var = advance();
+        if (isOp(",")) throw error("only one loop variable is supported");
+        if (!isName("in")) throw error("expected 'in'");
+        advance();
+        if (!isName("range") || !isOp("(", 1)) throw error("for loops only go over range(...)");
+        advance();
+        advance();
+
+        // range(stop) / range(start, stop) / range(start, stop, step)
+        int args = 0;
+        while (!isOp(")")) {
+            if (args == 3) throw error("range expected at most 3 arguments");
+            if (args > 0) expectOp(",");
+            if (isOp(")")) break;
+            expression();
+            args++;
+        }
+        advance();
+        if (args == 0) throw error("range expected at least 1 argument");
+        if (args == 1) {
+            // start goes under stop
+            const int stop = hiddenSlots(1);
+            emit(ScriptOp::Store);
+            emitOperand(stop);
+            emit(ScriptOp::PushInt);
+            emitOperand(0);
+            emit(ScriptOp::Load);
+            emitOperand(stop);
+        }
+        if (args < 3) {
+            emit(ScriptOp::PushInt);
+            emitOperand(1);
+        }
+
+        const int base = hiddenSlots(3);
+        const int varSlot = slotFor(var.text);
+        emit(ScriptOp::RangeInit);
+        emitOperand(base);
+        const std::size_t start = here();
+        emit(ScriptOp::RangeNext);
+        emitOperand(base);
+        emitOperand(varSlot);
+        const std::size_t exit = emitOperand(0);
+        loops.push_back({ start, {} });
+        block();
+        emitJump(ScriptOp::Jump, start);
+        finishLoop(exit);
+    }
+
+    void finishLoop(std::size_t exitOperand)
+    {
+        if (isName("else")) throw error("else on a loop isn't supported");
+        patch(exitOperand, here());
+        for (std::size_t at : loops.back().breaks) patch(at, here());
+        loops.pop_back();
+    }
+
+    // --- expressions, lowest precedence first ---
+
+    void expression()
+    {
+        const Nested nested(*this, expressionDepth, MAX_EXPRESSION_NESTING, "too many nested parentheses");
+        orExpression();
+    }
+
+    void orExpression()
+    {
+        andExpression();
+        std::vector<std::size_t> toEnd;
+        while (isName("or")) {
+            advance();
+            toEnd.push_back(emitJump(ScriptOp::JumpIfTrueOrPop));
+            andExpression();
+        }
+        for (std::size_t at : toEnd) patch(at, here());
+    }
+
+    void andExpression()
+    {
+        notExpression();
+        std::vector<std::size_t> toEnd;
+        while (isName("and")) {
+            advance();
+            toEnd.push_back(emitJump(ScriptOp::JumpIfFalseOrPop));
+            notExpression();
+        }
+        for (std::size_t at : toEnd) patch(at, here());
+    }
+
+    void notExpression()
+    {
+        if (isName("not")) {
+            advance();
+            const Nested nested(*this, expressionDepth, MAX_EXPRESSION_NESTING, "expression nested too deeply");
+            notExpression();
+            emit(ScriptOp::Not);
+            return;
+        }
+        comparison();
+    }
+
+    void comparison()
+    {
+        sum();
+        static const std::pair<const char*, ScriptOp> OPS[] = {
+            { "==", ScriptOp::Eq }, { "!=", ScriptOp::Ne }, { "<", ScriptOp::Lt },
+            { "<=", ScriptOp::Le }, { ">", ScriptOp::Gt }, { ">=", ScriptOp::Ge },
+        };
+        for (const auto& op : OPS) {
+            if (!isOp(op.first)) continue;
+            advance();
+            sum();
+            emit(op.second);
+            for (const auto& again : OPS)
+                if (isOp(again.first)) throw error("chained comparisons aren't supported");
+            break;
+        }
+        if (isName("in") || isName("is")) throw error("'" + peek().text + "' isn't supported in farm scripts");
+    }
+
+    void sum()
+    {
+        term();
+        for (;;) {
+            if (isOp("+")) { advance(); term(); emit(ScriptOp::Add); }
+            else if (isOp("-")) { advance(); term(); emit(ScriptOp::Sub); }
+            else break;
+        }
+    }
+
+    void term()
+    {
+        unary();
+        for (;;) {
+            if (isOp("*")) { advance(); unary(); emit(ScriptOp::Mul); }
+            else if (isOp("//")) { advance(); unary(); emit(ScriptOp::FloorDiv); }
+            else if (isOp("%")) { advance(); unary(); emit(ScriptOp::Mod); }
+            else if (isOp("/")) throw error("only whole numbers are supported, use // to divide");
+            else if (isOp("**")) throw error("'**' isn't supported in farm scripts");
+            else break;
+        }
+    }
+
+    void unary()
+    {
+        if (isOp("-") || isOp("+")) {
+            const bool negate = isOp("-");
+            advance();
+            const Nested nested(*this, expressionDepth, MAX_EXPRESSION_NESTING, "expression nested too deeply");
+            unary();
+            if (negate) emit(ScriptOp::Neg);
+            return;
+        }
+        primary();
+    }
+
+    void primary()
+    {
+        const Token t = peek();
+        if (t.kind == TokenKind::Int) {
+            advance();
+            emit(ScriptOp::PushInt);
+            emitOperand(static_cast<std::int32_t>(t.value));
+            return;
+        }
+        if (t.kind == TokenKind::Str) {
+            advance();
+            // "a" "b" is one string in Python
+            std::string s = t.text;
+            while (peek().kind == TokenKind::Str) s += advance().text;
+            emit(ScriptOp::PushStr);
+            emitOperand(stringConstant(s));
+            return;
+        }
+        if (isOp("(")) {
+            advance();
+            expression();
+            if (isOp(",")) throw error("tuples aren't supported");
+            expectOp(")");
+            return;
+        }
+        if (t.kind == TokenKind::Name) {
+            advance();
+            if (t.text == "True" || t.text == "False") {
+                emit(ScriptOp::PushInt);
+                emitOperand(t.text == "True" ? 1 : 0);
+                return;
+            }
+            if (t.text == "None") {
+                emit(ScriptOp::PushNone);
+                return;
+            }
+            if (isOp("(")) {
+                call(t);
+                return;
+            }
+            if (isOp("[") || isOp(".")) throw error("indexing and attributes aren't supported");
+            if (isOneOf(t.text, { "move", "plant", "harvest", "remove", "print", "range" }))
+                throw ScriptError("'" + t.text + "' has to be called", t.line);
+            auto it = slots.find(t.text);
+            // a name never assigned anywhere above is still a NameError at runtime in Python,
+            // it might get assigned further down before this line runs again
+            emit(ScriptOp::Load);
+            emitOperand(it != slots.end() ? it->second : slotFor(t.text));
+            return;
+        }
+        if (t.kind == TokenKind::Op && (t.text == "[" || t.text == "{"))
+            throw error("lists and dicts aren't supported");
+        throw error("invalid syntax");
+    }
+
+    void call(const Token& name)
+    {
+        advance(); // (
+        int args = 0;
+        while (!isOp(")")) {
+            if (args > 0) expectOp(",");
+            if (isOp(")")) break;
+            if (peek().kind == TokenKind::Name && isOp("=", 1)) throw error("keyword arguments aren't supported");
+            expression();
+            args++;
+        }
+        advance();
+
+        auto wantArgs = [&](int n) {
+            if (args != n)
+                throw ScriptError(name.text + "() takes " + std::to_string(n) + " argument" + (n == 1 ? "" : "s")
+                                  + " (" + std::to_string(args) + " given)", name.line);
+        };
+        if (name.text == "move") { wantArgs(1); emit(ScriptOp::Move); }
+        else if (name.text == "plant") { wantArgs(1); emit(ScriptOp::Plant); }
+        else if (name.text == "harvest") { wantArgs(0); emit(ScriptOp::Harvest); }
+        else if (name.text == "remove") { wantArgs(0); emit(ScriptOp::Remove); }
+        else if (name.text == "print") { emit(ScriptOp::Print); emitOperand(args); }
+        else if (name.text == "range") throw ScriptError("range() only works in a for loop", name.line);
+        else throw ScriptError(name.text + "() isn't available in farm scripts", name.line);
+        emit(ScriptOp::PushNone);
+        lastCommandEnd = here();
+    }
+
+    const std::vector<Token>& tokens;
+    const ScriptOptions& options;
+    std::size_t pos = 0;
+    ScriptProgram program;
+    std::unordered_map<std::string, int> slots;
+    std::vector<Loop> loops;
+    int expressionDepth = 0;
+    int blockDepth = 0;
+    std::size_t lastCommandEnd = static_cast<std::size_t>(-1);
+};
+
+const char* opName(ScriptOp op)
+{
+    switch (op) {
+    case ScriptOp::PushInt: return "PUSH_INT";
+    case ScriptOp::PushStr: return "PUSH_STR";
+    case ScriptOp::PushNone: return "PUSH_NONE";
+    case ScriptOp::Load: return "LOAD";
+    case ScriptOp::Store: return "STORE";
+    case ScriptOp::Pop: return "POP";
+    case ScriptOp::Add: return "ADD";
+    case ScriptOp::Sub: return "SUB";
+    case ScriptOp::Mul: return "MUL";
+    case ScriptOp::FloorDiv: return "FLOOR_DIV";
+    case ScriptOp::Mod: return "MOD";
+    case ScriptOp::Neg: return "NEG";
+    case ScriptOp::Not: return "NOT";
+    case ScriptOp::Eq: return "EQ";
+    case ScriptOp::Ne: return "NE";
+    case ScriptOp::Lt: return "LT";
+    case ScriptOp::Le: return "LE";
+    case ScriptOp::Gt: return "GT";
+    case ScriptOp::Ge: return "GE";
+    case ScriptOp::Jump: return "JUMP";
+    case ScriptOp::JumpIfFalse: return "JUMP_IF_FALSE";
+    case ScriptOp::JumpIfFalseOrPop: return "JUMP_IF_FALSE_OR_POP";
+    case ScriptOp::JumpIfTrueOrPop: return "JUMP_IF_TRUE_OR_POP";
+    case ScriptOp::RangeInit: return "RANGE_INIT";
+    case ScriptOp::RangeNext: return "RANGE_NEXT";
+    case ScriptOp::Move: return "MOVE";
+    case ScriptOp::Plant: return "PLANT";
+    case ScriptOp::Harvest: return "HARVEST";
+    case ScriptOp::Remove: return "REMOVE";
+    case ScriptOp::Print: return "PRINT";
+    case ScriptOp::Halt: return "HALT";
+    }
+    return "?";
+}
+
+int operandCount(ScriptOp op)
+{
+    switch (op) {
+    case ScriptOp::PushInt: case ScriptOp::PushStr: case ScriptOp::Load: case ScriptOp::Store:
+    case ScriptOp::Jump: case ScriptOp::JumpIfFalse: case ScriptOp::JumpIfFalseOrPop:
+    case ScriptOp::JumpIfTrueOrPop: case ScriptOp::RangeInit: case ScriptOp::Print:
+        return 1;
+    case ScriptOp::RangeNext:
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+} // namespace
+
+int ScriptProgram::lineAt(std::size_t pc) const
+{
+    auto it = std::upper_bound(lines.begin(), lines.end(), pc,
+                               [](std::size_t at, const std::pair<std::uint32_t, int>& l) { return at < l.first; });
+    return it == lines.begin() ? 0 : std::prev(it)->second;
+}
+
+std::string ScriptProgram::disassemble() const
+{
+    std::ostringstream out;
+    std::size_t pc = 0;
+    int lastLine = -1;
+    while (pc < code.size()) {
+        const ScriptOp op = static_cast<ScriptOp>(code[pc]);
+        const int line = lineAt(pc);
+        if (line != lastLine) {
+            out << "line " << line << ":\n";
+            lastLine = line;
+        }
+        out << "  " << pc << "\t" << opName(op);
+        std::size_t at = pc + 1;
+        for (int k = 0; k < operandCount(op); k++, at += 4) {
+            std::uint32_t v = 0;
+            for (int b = 0; b < 4; b++) v |= static_cast<std::uint32_t>(code[at + b]) << (8 * b);
+            out << (k == 0 ? " " : ", ") << static_cast<std::int32_t>(v);
+            if (op == ScriptOp::PushStr && v < strings.size()) out << " \"" << strings[v] << "\"";
+            if ((op == ScriptOp::Load || op == ScriptOp::Store) && v < variables.size()) out << " (" << variables[v] << ")";
+        }
+        out << "\n";
+        pc = at;
+    }
+    return out.str();
+}
+
+ScriptProgram compileScript(const std::string& source, const ScriptOptions& options)
+{
+    if (source.size() > options.maxSourceBytes)
+        throw ScriptError("script is longer than " + std::to_string(options.maxSourceBytes) + " bytes", 0);
+    const std::vector<Token> tokens = tokenize(source);
+    Compiler compiler(tokens, options);
+    return compiler.compile();
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Compiler for the player scripts the in-game IDE runs, the part of Python the levels use:
+//   move("up") plant("wheat") harvest() remove() print(...)
+//   for NAME in range(...):   while cond:   if / elif / else   break continue pass
+//   NAME = expr   NAME += -= *= //= %= expr
+//   ints, strings, True/False/None, + - * // % unary -, == != < <= > >=, and or not
+// Anything else (def, lists, floats, imports, ...) is a compile error with the line it's on.
+// The output is bytecode for ScriptVM (ScriptVM.hpp), which runs it straight against Grid
+// and Farmer.
+
+// a compile error or a runtime fault, line is 1-based in the script source (0 if unknown)
+class ScriptError : public std::runtime_error
+{
+    public:
+    ScriptError(const std::string& message, int line)
+        : std::runtime_error(line > 0 ? "line " + std::to_string(line) + ": " + message : message), line(line)
+    {
+    }
+    int getLine() const { return line; }
+
+    private:
+    int line;
+};
+
+// one byte per opcode, operands follow as 4-byte little-endian ints
+enum class ScriptOp : std::uint8_t
+{
+    PushInt,    // i32 value
+    PushStr,    // i32 string constant
+    PushNone,
+    Load,       // i32 variable slot
+    Store,      // i32 variable slot, pops
+    Pop,
+    Add, Sub, Mul, FloorDiv, Mod, Neg, Not,
+    Eq, Ne, Lt, Le, Gt, Ge,
+    Jump,              // i32 target
+    JumpIfFalse,       // i32 target, pops
+    JumpIfFalseOrPop,  // i32 target, keeps the value if it jumps (and)
+    JumpIfTrueOrPop,   // i32 target, keeps the value if it jumps (or)
+    RangeInit,  // i32 hidden slot base: pops start, stop, step into slot, slot+1, slot+2
+    RangeNext,  // i32 hidden slot base, i32 loop variable, i32 exit target
+    Move,       // pops the direction
+    Plant,      // pops the crop name
+    Harvest,
+    Remove,
+    Print,      // i32 argument count, pops them
+    Halt,
+};
+
+struct ScriptProgram
+{
+    std::vector<std::uint8_t> code;
+    std::vector<std::string> strings;   // string constants, by PushStr index
+    std::vector<std::string> variables; // user variables first, then hidden loop slots ("" names)
+    std::vector<std::pair<std::uint32_t, int>> lines; // (code offset, source line) where a line starts
+
+    // source line of the instruction at pc, for runtime errors
+    int lineAt(std::size_t pc) const;
+    // one instruction per line, for farm_script --disasm
+    std::string disassemble() const;
+};
+
+struct ScriptOptions
+{
+    // the level's allowed list (Objective.allowed_commands). When it isn't empty, for / while
+    // / if not in it are compile errors, the same constructs the game gates. Empty allows all.
+    std::vector<std::string> allowed;
+    // longest script accepted, keeps a pasted novel from eating the compiler
+    std::size_t maxSourceBytes = 64 * 1024;
+};
+
+// throws ScriptError
+ScriptProgram compileScript(const std::string& source, const ScriptOptions& options = ScriptOptions());
@@ -4,6 +4,12 @@ Farmer::Farmer(Grid& grid) : grid(grid), positionX(0), positionY(0) {}
 
 Farmer::Farmer(Grid& grid, int startX, int startY) : grid(grid), positionX(startX), positionY(startY) {}
 
+void Farmer::reset(int startX, int startY) {
+    positionX = startX;
+    positionY = startY;
+    harvestCount = 0;
+}
+
 bool Farmer::move(direction GivenDirection) {
     int oldX = positionX;
     int oldY = positionY;
@@ -46,6 +52,54 @@ bool Farmer::move(direction GivenDirection) {
         positionX++;
     }
 
+    // walls block like the edge does
+    if (!grid.isWalkable(positionX, positionY)) {
+        positionX = oldX;
+        positionY = oldY;
+    }
+
     //Return false if movement was blocked
     return (positionX != oldX || positionY != oldY);
 }
+
+bool Farmer::plant() {
+    Tile t = grid.getTile(positionX, positionY);
+    if (t.type == TileType::CROP || t.replantCooldown > 0) {
+        return false;
+    }
+
+    t.type = TileType::CROP;
+    t.cropstate = CropState::PLANTED;
+    t.growthTimer = 0;
+    grid.setTile(positionX, positionY, t);
+    return true;
+}
+
+bool Farmer::harvest() {
+    Tile t = grid.getTile(positionX, positionY);
+    if (t.type != TileType::CROP || t.cropstate != CropState::GROWN) {
+        return false;
+    }
+
+    t.type = TileType::SOIL;
+    t.cropstate = CropState::EMPTY;
+    t.growthTimer = 0;
+    t.replantCooldown = Tile::REPLANT_COOLDOWN + 1;
+    grid.setTile(positionX, positionY, t);
+    harvestCount++;
+    return true;
+}
+
+bool Farmer::remove() {
+    Tile t = grid.getTile(positionX, positionY);
+    if (t.type != TileType::CROP) {
+        return false;
+    }
+
+    t.type = TileType::SOIL;
+    t.cropstate = CropState::EMPTY;
+    t.growthTimer = 0;
+    t.replantCooldown = Tile::REPLANT_COOLDOWN + 1;
+    grid.setTile(positionX, positionY, t);
+    return true;
+}
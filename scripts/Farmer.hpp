@@ -10,15 +10,33 @@ class Farmer
         Farmer(Grid& grid);
         Farmer(Grid& grid, int startX, int startY);
 
+        // one tile over, false (and no move) if the edge of the grid or a wall is in the way
         bool move(direction GivenDirection);
 
+        // put the farmer back at a start tile with no harvests, for reusing a world
+        void reset(int startX, int startY);
+        // place the farmer without touching the harvest count (no bounds check, callers do it)
+        void setPosition(int x, int y) {positionX = x; positionY = y;}
+        // for restoring a saved state
+        void setHarvestCount(int count) {harvestCount = count;}
+
+        // work the tile the farmer is standing on, false if there was nothing to do
+        // plant: any non-crop tile out of its replant cooldown becomes a freshly PLANTED crop
+        // harvest: a GROWN crop is picked and the tile goes back to SOIL
+        // remove: any crop is dug up back to SOIL, not counted as a harvest
+        // both of the last two start the tile's cooldown (Tile::REPLANT_COOLDOWN)
+        bool plant();
+        bool harvest();
+        bool remove();
+
         int getX() const {return positionX;}
         int getY() const {return positionY;}
+        int getHarvestCount() const {return harvestCount;}
 
     private: 
         Grid& grid;
         int positionX = 0;
         int positionY = 0;
+        int harvestCount = 0;
 
 };
-
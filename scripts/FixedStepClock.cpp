@@ -0,0 +1,68 @@
+#include "FixedStepClock.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+double steadySeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FixedStepClock::FixedStepClock(double ticksPerSecond)
+{
+    setTicksPerSecond(ticksPerSecond);
+}
+
+void FixedStepClock::setTicksPerSecond(double rate)
+{
+    if (!(rate > 0.0) || !std::isfinite(rate))
+        throw std::invalid_argument("ticks per second must be > 0");
+    ticksPerSecond = rate;
+}
+
+void FixedStepClock::advance(double realSeconds)
+{
+    if (realSeconds <= 0.0) return;
+    accumulator += realSeconds * ticksPerSecond;
+
+    const double maxBacklog = std::max(1.0, maxBacklogSeconds * ticksPerSecond);
+    if (accumulator > maxBacklog) {
+        const double over = std::floor(accumulator - maxBacklog);
+        droppedTicks += static_cast<std::int64_t>(over);
+        accumulator -= over;
+    }
+}
+
+std::int64_t FixedStepClock::ticksDue() const
+{
+    return static_cast<std::int64_t>(std::floor(accumulator));
+}
+
+void FixedStepClock::consumeTicks(std::int64_t ticks)
+{
+    accumulator = std::max(0.0, accumulator - static_cast<double>(ticks));
+}
+
+double FixedStepClock::alpha() const
+{
+    return accumulator - std::floor(accumulator);
+}
+
+double FixedStepClock::secondsUntilNextTick() const
+{
+    if (accumulator >= 1.0) return 0.0;
+    return (1.0 - accumulator) / ticksPerSecond;
+}
+
+void RateCounter::add(std::int64_t events, double now)
+{
+    if (windowStart < 0.0) windowStart = now;
+    count += events;
+    const double elapsed = now - windowStart;
+    if (elapsed >= window) {
+        rate = count / elapsed;
+        count = 0;
+        windowStart = now;
+    }
+}
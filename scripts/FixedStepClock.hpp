@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+
+// seconds on the steady clock, the shared time base between the simulation and render threads
+double steadySeconds();
+
+// Turns real time into whole fixed-length simulation ticks, so growth runs at the same
+// speed whatever the frame rate is. Time accumulates with advance(), ticksDue() says how
+// many ticks it covers and consumeTicks() takes them off once they've actually run.
+class FixedStepClock
+{
+    public:
+    explicit FixedStepClock(double ticksPerSecond = 4.0);
+
+    // any rate > 0, thousands per second is fine for fast-forward
+    void setTicksPerSecond(double ticksPerSecond);
+    double getTicksPerSecond() const { return ticksPerSecond; }
+    double getTickSeconds() const { return 1.0 / ticksPerSecond; }
+
+    // adds real time. If more than maxBacklogSeconds worth of ticks are owed (a stall, a
+    // debugger break) the rest is dropped rather than fast-forwarded through.
+    void advance(double realSeconds);
+    std::int64_t ticksDue() const;
+    void consumeTicks(std::int64_t ticks);
+
+    // how far into the next tick we are, 0..1
+    double alpha() const;
+    double secondsUntilNextTick() const;
+
+    void setMaxBacklogSeconds(double seconds) { maxBacklogSeconds = seconds; }
+    std::int64_t getDroppedTicks() const { return droppedTicks; }
+
+    private:
+    double ticksPerSecond;
+    double accumulator = 0.0; // in ticks, not seconds, so a rate change keeps the tick phase
+    double maxBacklogSeconds = 0.25;
+    std::int64_t droppedTicks = 0;
+};
+
+// events per second over roughly the last `window` seconds, for tick rate and FPS readouts
+class RateCounter
+{
+    public:
+    explicit RateCounter(double window = 0.5) : window(window) {}
+
+    void add(std::int64_t events, double now);
+    double getRate() const { return rate; }
+
+    private:
+    double window;
+    double windowStart = -1.0;
+    std::int64_t count = 0;
+    double rate = 0.0;
+};
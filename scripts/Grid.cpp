@@ -1,45 +1,461 @@
 #include "Grid.hpp"
+#include <algorithm>
 #include <stdexcept>
+#include "Profiler.hpp"
+#include "WorkerPool.hpp"
 
-Grid::Grid(int grid_width, int grid_height)
-    : grid_width(grid_width), grid_height(grid_height)
+// tiles per parallel tick block: ~6 bytes of fields per tile keeps a block around 192KB,
+// comfortably inside a per-core L2
+static constexpr int TICK_BLOCK_TILES = 32 * 1024;
+
+// walkability edits remembered for walkabilityChangesSince, older ones fall off the front
+static constexpr std::size_t WALKABILITY_LOG_SIZE = 4096;
+
+TileRef::TileRef(Grid& grid, int x, int y, const Tile& t)
+    : grid(grid), x(x), y(y), original(t), value(t)
+{
+}
+
+TileRef::~TileRef()
+{
+    const bool typeChanged = value.type != original.type;
+    const bool stateChanged = value.cropstate != original.cropstate;
+    const bool timerChanged = value.growthTimer != original.growthTimer;
+    const bool cooldownChanged = value.replantCooldown != original.replantCooldown;
+    if (!typeChanged && !stateChanged && !timerChanged && !cooldownChanged)
+        return;
+
+    // only the fields that were written win, the rest are re-read so we don't stomp on
+    // anything that moved since this handle was taken
+    Tile current = grid.getTileUnchecked(x, y);
+    if (typeChanged) current.type = value.type;
+    if (stateChanged) current.cropstate = value.cropstate;
+    if (timerChanged) current.growthTimer = value.growthTimer;
+    if (cooldownChanged) current.replantCooldown = value.replantCooldown;
+    grid.setTile(x, y, current);
+}
+
+Grid::Grid(int grid_width, int grid_height, GrowthMode mode)
+    : growthMode(mode)
+{
+    reset(grid_width, grid_height);
+}
+
+void Grid::reset(int grid_width, int grid_height)
 {
     if (grid_width <= 0 || grid_height <= 0)
         throw std::invalid_argument("Grid dimensions must be positive");
 
-    TileVector.resize(this->grid_height);
-    for (int y = 0; y < this->grid_height; y++) {
-        TileVector[y].resize(this->grid_width);
+    this->grid_width = grid_width;
+    this->grid_height = grid_height;
+
+    // assign() reuses the existing capacity when the new grid fits
+    const std::size_t count = static_cast<std::size_t>(grid_width) * grid_height;
+    typeField.assign(count, TileType::EMPTY);
+    cropStateField.assign(count, CropState::EMPTY);
+    growthTimerField.assign(count, 0);
+    walkableField.assign(count, 1);
+    cooldownField.assign(count, 0);
+    coolingTiles.clear();
+    timersSyncedAt = -1;
+    // nothing from before a reset carries over, walkabilityChangesSince says so
+    walkabilityVersion++;
+    walkabilityLog.clear();
+    walkabilityLogStart = walkabilityVersion;
+    tickCount = 0;
+
+    if (growthMode == GrowthMode::Scheduled)
+        scheduler.reset(tileCount());
+
+    if (trackChanges) {
+        changedFlags.assign(count, 0);
+        markAllChanged();
+    }
+
+    std::fill(&tileCounts[0][0], &tileCounts[0][0] + 9, 0);
+    tileCounts[static_cast<int>(TileType::EMPTY)][static_cast<int>(CropState::EMPTY)] = tileCount();
+    if (indexCrops)
+        cropIndex.reset(grid_width, grid_height);
+}
+
+void Grid::setChangeTracking(bool enabled)
+{
+    trackChanges = enabled;
+    changedTiles.clear();
+    if (enabled) {
+        // whoever turned it on hasn't seen anything yet
+        changedFlags.assign(static_cast<std::size_t>(tileCount()), 0);
+        everythingChanged = true;
+    } else {
+        changedFlags = std::vector<std::uint8_t>();
+        everythingChanged = false;
+    }
+}
+
+void Grid::setCropIndexing(bool enabled)
+{
+    indexCrops = enabled;
+    if (enabled)
+        cropIndex.build(grid_width, grid_height, typeField.data(), cropStateField.data());
+    else
+        cropIndex = CropIndex();
+}
+
+void Grid::rebuildIndexes()
+{
+    std::fill(&tileCounts[0][0], &tileCounts[0][0] + 9, 0);
+    for (int i = 0; i < tileCount(); i++)
+        tileCounts[static_cast<int>(typeField[i])][static_cast<int>(cropStateField[i])]++;
+    if (indexCrops)
+        cropIndex.build(grid_width, grid_height, typeField.data(), cropStateField.data());
+}
+
+int Grid::countTiles(TileType type) const
+{
+    const int* row = tileCounts[static_cast<int>(type)];
+    return row[0] + row[1] + row[2];
+}
+
+int Grid::countTiles(CropState state) const
+{
+    const int s = static_cast<int>(state);
+    return tileCounts[0][s] + tileCounts[1][s] + tileCounts[2][s];
+}
+
+void Grid::requireCropIndex() const
+{
+    if (!indexCrops)
+        throw std::logic_error("crop queries need setCropIndexing(true)");
+}
+
+bool Grid::nearestCrop(CropState state, int x, int y, int& outX, int& outY) const
+{
+    requireCropIndex();
+    const int i = cropIndex.nearest(state, x, y);
+    if (i < 0) return false;
+    outX = i % grid_width;
+    outY = i / grid_width;
+    return true;
+}
+
+int Grid::countCrops(CropState state, int x0, int y0, int x1, int y1) const
+{
+    requireCropIndex();
+    return cropIndex.countIn(state, x0, y0, x1, y1);
+}
+
+void Grid::cropsIn(CropState state, int x0, int y0, int x1, int y1, std::vector<int>& out) const
+{
+    requireCropIndex();
+    cropIndex.collect(state, x0, y0, x1, y1, out);
+}
+
+bool Grid::verifyIndexes(std::string* why) const
+{
+    int counts[3][3] = {};
+    for (int i = 0; i < tileCount(); i++)
+        counts[static_cast<int>(typeField[i])][static_cast<int>(cropStateField[i])]++;
+    for (int t = 0; t < 3; t++) {
+        for (int s = 0; s < 3; s++) {
+            if (counts[t][s] != tileCounts[t][s]) {
+                if (why)
+                    *why = "type " + std::to_string(t) + " state " + std::to_string(s) + " counted "
+                           + std::to_string(tileCounts[t][s]) + ", the grid has " + std::to_string(counts[t][s]);
+                return false;
+            }
+        }
+    }
+
+    std::string mismatch;
+    if (indexCrops && !cropIndex.matches(typeField.data(), cropStateField.data(), mismatch)) {
+        if (why) *why = "crop index: " + mismatch;
+        return false;
     }
+    return true;
+}
+
+void Grid::clearChangedTiles()
+{
+    if (everythingChanged)
+        std::fill(changedFlags.begin(), changedFlags.end(), 0);
+    else
+        for (int i : changedTiles) changedFlags[i] = 0;
+    changedTiles.clear();
+    everythingChanged = false;
+}
+
+void Grid::markAllChanged()
+{
+    everythingChanged = true;
+    changedTiles.clear();
 }
 
 int Grid::getGridWidth() const { return grid_width; }
 int Grid::getGridHeight() const { return grid_height; }
 
-Tile& Grid::getTile(int x, int y)
+TileRef Grid::getTile(int x, int y)
 {
     if (x < 0 || x >= grid_width || y < 0 || y >= grid_height)
         throw std::out_of_range("getTile out of range");
-    return TileVector[y][x];
+    return getTileUnchecked(x, y);
 }
 
-const Tile& Grid::getTile(int x, int y) const
+Tile Grid::getTile(int x, int y) const
 {
     if (x < 0 || x >= grid_width || y < 0 || y >= grid_height)
         throw std::out_of_range("getTile out of range");
-    return TileVector[y][x];
+    return getTileUnchecked(x, y);
+}
+
+void Grid::setTile(int x, int y, const Tile& t)
+{
+    if (x < 0 || x >= grid_width || y < 0 || y >= grid_height)
+        throw std::out_of_range("setTile out of range");
+    if (t.replantCooldown < 0 || t.replantCooldown > Tile::MAX_REPLANT_COOLDOWN)
+        throw std::invalid_argument("replant cooldown out of range");
+
+    const int i = index(x, y);
+    if (typeField[i] != t.type || cropStateField[i] != t.cropstate) {
+        markChanged(i);
+        recount(i, t.type, t.cropstate);
+    }
+    typeField[i] = t.type;
+    cropStateField[i] = t.cropstate;
+    growthTimerField[i] = t.growthTimer;
+    setCooldown(i, t.replantCooldown);
+
+    if (growthMode == GrowthMode::Scheduled) {
+        if (isGrowing(t.type, t.cropstate))
+            scheduler.schedule(i, t.growthTimer, tickCount);
+        else
+            scheduler.cancel(i);
+    }
+}
+
+void Grid::loadTiles(int grid_width, int grid_height, const TileType* types, const CropState* states,
+                     const std::int32_t* timers, const std::uint8_t* walkable)
+{
+    // reset() covers the size check, the tick, change tracking and telling walkability readers
+    // that everything moved
+    reset(grid_width, grid_height);
+    const std::size_t count = typeField.size();
+    std::copy_n(types, count, typeField.begin());
+    std::copy_n(states, count, cropStateField.begin());
+    if (timers) std::copy_n(timers, count, growthTimerField.begin());
+    if (walkable) std::copy_n(walkable, count, walkableField.begin());
+    rebuildIndexes();
+
+    if (growthMode == GrowthMode::Scheduled) {
+        for (int i = 0; i < tileCount(); i++) {
+            if (isGrowing(typeField[i], cropStateField[i]))
+                scheduler.schedule(i, growthTimerField[i], tickCount);
+        }
+    }
+}
+
+void Grid::setWalkable(int x, int y, bool walkable)
+{
+    if (x < 0 || x >= grid_width || y < 0 || y >= grid_height)
+        throw std::out_of_range("setWalkable out of range");
+
+    const int i = index(x, y);
+    if ((walkableField[i] != 0) == walkable)
+        return;
+    walkableField[i] = walkable ? 1 : 0;
+    markChanged(i);
+
+    if (walkabilityLog.size() == WALKABILITY_LOG_SIZE) {
+        const std::size_t drop = WALKABILITY_LOG_SIZE / 2;
+        walkabilityLog.erase(walkabilityLog.begin(), walkabilityLog.begin() + drop);
+        walkabilityLogStart += drop;
+    }
+    walkabilityLog.push_back(i);
+    walkabilityVersion++;
+}
+
+bool Grid::walkabilityChangesSince(std::uint64_t since, std::vector<int>& out) const
+{
+    if (since < walkabilityLogStart || since > walkabilityVersion)
+        return false;
+    out.insert(out.end(), walkabilityLog.begin() + static_cast<std::ptrdiff_t>(since - walkabilityLogStart),
+               walkabilityLog.end());
+    return true;
+}
+
+GridSpan<int> Grid::growthTimers() const
+{
+    syncGrowthTimers();
+    return spanOf(growthTimerField, 0, growthTimerField.size());
+}
+
+GridSpan<int> Grid::growthTimerRow(int y) const
+{
+    syncGrowthTimers();
+    return spanOf(growthTimerField, rowStart(y), grid_width);
+}
+
+void Grid::syncGrowthTimers() const
+{
+    if (growthMode != GrowthMode::Scheduled || timersSyncedAt == tickCount)
+        return;
+
+    // only crops still in the schedule have a timer that moved since it was last written
+    scheduler.forEachScheduled([this](int i) {
+        growthTimerField[i] = scheduler.timerAt(i, tickCount);
+    });
+    timersSyncedAt = tickCount;
+}
+
+void Grid::setTickCount(std::int64_t tick)
+{
+    if (tick < 0)
+        throw std::invalid_argument("tick count can't be negative");
+    if (growthMode == GrowthMode::Scheduled)
+        scheduler.rebase(tickCount, tick);
+    tickCount = tick;
+    timersSyncedAt = -1;
+}
+
+void Grid::setGrowthMode(GrowthMode mode)
+{
+    if (mode == growthMode)
+        return;
+
+    if (mode == GrowthMode::Scan) {
+        // bake the derived timers in, the scan reads them straight from the array
+        syncGrowthTimers();
+        scheduler = GrowthScheduler();
+        growthMode = mode;
+        return;
+    }
+
+    growthMode = mode;
+    timersSyncedAt = -1;
+    scheduler.reset(tileCount());
+    for (int i = 0; i < tileCount(); i++) {
+        if (isGrowing(typeField[i], cropStateField[i]))
+            scheduler.schedule(i, growthTimerField[i], tickCount);
+    }
+}
+
+void Grid::setGrowthKernel(GrowthKernel kernel)
+{
+    if (!growthKernelSupported(kernel))
+        throw std::invalid_argument(std::string("growth kernel not supported on this CPU: ") + growthKernelName(kernel));
+    growthKernel = kernel;
 }
 
 void Grid::tick() {
-    for (int y = 0; y < grid_height; y++) {
-        for (int x = 0; x < grid_width; x++) {
-            Tile& t = TileVector[y][x];
-            if (t.type == TileType::CROP && t.cropstate == CropState::PLANTED) {
-                t.growthTimer++;
-                if(t.growthTimer >= Tile::GROWTH_TIME) {
-                    t.cropstate = CropState::GROWN;
-                }
-            }
+    tickCount++;
+    if (growthMode == GrowthMode::Scheduled)
+        tickScheduled();
+    else
+        tickScan();
+    tickCooldowns();
+    if (verifyEveryTick) checkIndexes();
+}
+
+void Grid::setCooldown(int i, int ticks)
+{
+    if (ticks > 0 && cooldownField[i] == 0)
+        coolingTiles.push_back(i);
+    else if (ticks == 0 && cooldownField[i] > 0)
+        // a handful of tiles at most, the ones harvested or cleared in the last few ticks
+        coolingTiles.erase(std::find(coolingTiles.begin(), coolingTiles.end(), i));
+    cooldownField[i] = static_cast<std::uint8_t>(ticks);
+}
+
+void Grid::tickCooldowns()
+{
+    for (std::size_t k = 0; k < coolingTiles.size();) {
+        const int i = coolingTiles[k];
+        if (--cooldownField[i] == 0) {
+            coolingTiles[k] = coolingTiles.back();
+            coolingTiles.pop_back();
+        } else {
+            k++;
+        }
+    }
+}
+
+void Grid::checkIndexes() const
+{
+    std::string why;
+    if (!verifyIndexes(&why))
+        throw std::logic_error("index out of step after tick " + std::to_string(tickCount) + ": " + why);
+}
+
+void Grid::tickScheduled()
+{
+    // only the crops whose ripening tick is now, the rest of the grid is never looked at
+    std::int64_t visited = 0;
+    scheduler.collectDue(tickCount, [this, &visited](int i) {
+        cropStateField[i] = CropState::GROWN;
+        growthTimerField[i] = scheduler.timerAt(i, tickCount);
+        noteRipened(i);
+        visited++;
+    });
+    countRipened(static_cast<int>(visited));
+    FARM_PROFILE_COUNT(ProfileCounter::TilesVisited, visited);
+    (void)visited;
+}
+
+void Grid::tickParallel(WorkerPool& pool)
+{
+    if (growthMode == GrowthMode::Scheduled || pool.getThreadCount() == 1) {
+        tick();
+        return;
+    }
+
+    tickCount++;
+    FARM_PROFILE_COUNT(ProfileCounter::TilesVisited, tileCount());
+
+    // whole rows per block so neighbouring threads never share a row, tiles are independent
+    // so the result can't depend on how the blocks get split up
+    const int rowsPerBlock = std::max(1, TICK_BLOCK_TILES / grid_width);
+    const int blocks = (grid_height + rowsPerBlock - 1) / rowsPerBlock;
+    // the lists are only needed for tiles that something else has to hear about
+    const bool collect = (trackChanges && !everythingChanged) || indexCrops;
+    if (collect && static_cast<int>(blockRipened.size()) < blocks)
+        blockRipened.resize(blocks);
+    if (static_cast<int>(blockRipenCounts.size()) < blocks)
+        blockRipenCounts.resize(blocks);
+
+    pool.run(blocks, [this, rowsPerBlock, collect](int block) {
+        const int firstRow = block * rowsPerBlock;
+        const int lastRow = std::min(grid_height, firstRow + rowsPerBlock);
+        blockRipenCounts[block] =
+            growRange(rowStart(firstRow), rowStart(lastRow), collect ? &blockRipened[block] : nullptr);
+    });
+
+    // change lists, counts and the index are merged on this thread, blocks only wrote their own slot
+    for (int b = 0; b < blocks; b++) {
+        countRipened(blockRipenCounts[b]);
+        if (collect) {
+            for (int i : blockRipened[b]) noteRipened(i);
+            blockRipened[b].clear();
         }
     }
-}
\ No newline at end of file
+    tickCooldowns();
+    if (verifyEveryTick) checkIndexes();
+}
+
+void Grid::tickScan()
+{
+    FARM_PROFILE_COUNT(ProfileCounter::TilesVisited, tileCount());
+    if ((trackChanges && !everythingChanged) || indexCrops) {
+        if (blockRipened.empty()) blockRipened.resize(1);
+        countRipened(growRange(0, typeField.size(), &blockRipened[0]));
+        for (int i : blockRipened[0]) noteRipened(i);
+        blockRipened[0].clear();
+    } else {
+        countRipened(growRange(0, typeField.size(), nullptr));
+    }
+}
+
+int Grid::growRange(std::size_t begin, std::size_t end, std::vector<int>* ripened)
+{
+    // one pass over the flat arrays
+    return growTileFields(growthKernel, typeField.data(), cropStateField.data(), growthTimerField.data(), begin, end,
+                          ripened);
+}
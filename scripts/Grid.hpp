@@ -1,22 +1,310 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <vector>
 #include "Tile.hpp"
-class Grid 
+#include "CropIndex.hpp"
+#include "GrowthKernel.hpp"
+#include "GrowthScheduler.hpp"
+
+class Grid;
+class WorkerPool;
+
+// read-only view over a contiguous run of one tile field (one row, or the whole grid)
+// small stand-in for std::span since we are on C++17
+template <typename T>
+struct GridSpan
+{
+    const T* first = nullptr;
+    std::size_t count = 0;
+
+    const T* begin() const { return first; }
+    const T* end() const { return first + count; }
+    const T* data() const { return first; }
+    std::size_t size() const { return count; }
+    const T& operator[](std::size_t i) const { return first[i]; }
+};
+
+// mutable handle to one tile, returned by the non-const getTile so old callers
+// can keep writing grid.getTile(x, y).type = TileType::SOIL
+// it buffers a copy of the tile and writes whatever fields changed back through Grid::setTile
+// when it goes out of scope, so don't keep one alive across a tick()
+struct TileRef
+{
+    TileRef(Grid& grid, int x, int y, const Tile& t);
+    TileRef(const TileRef&) = delete;
+    TileRef& operator=(const TileRef&) = delete;
+    ~TileRef();
+
+    private:
+    Grid& grid;
+    int x;
+    int y;
+    Tile original;
+    Tile value;
+
+    public:
+    // references into the buffered copy, so field writes work on the temporary getTile returns
+    TileType& type = value.type;
+    CropState& cropstate = value.cropstate;
+    int& growthTimer = value.growthTimer;
+    int& replantCooldown = value.replantCooldown;
+
+    TileRef& operator=(const Tile& t)
+    {
+        value.type = t.type;
+        value.cropstate = t.cropstate;
+        value.growthTimer = t.growthTimer;
+        value.replantCooldown = t.replantCooldown;
+        return *this;
+    }
+
+    operator Tile() const { return value; }
+};
+
+// how tick() advances crops
+// Scan visits every tile like the original loop (16 or 32 at a time where the CPU can, see
+// setGrowthKernel), Scheduled only touches crops that are due
+enum class GrowthMode { Scan, Scheduled };
+
+class Grid
 {
     public:
-    Grid(int grid_width, int grid_height);
+    Grid(int grid_width, int grid_height, GrowthMode mode = GrowthMode::Scheduled);
     int getGridWidth() const;
     int getGridHeight() const;
 
+    // back to an all-EMPTY grid at tick 0, possibly a different size, keeping the
+    // allocations around so pooled grids don't go back to the heap
+    void reset(int grid_width, int grid_height);
+
     // added for rendering tiles 2/14/26
-    Tile& getTile(int x, int y);
-    const Tile& getTile(int x, int y) const;
+    // tiles live in one array per field now, so these hand back a proxy / a copy
+    // instead of a Tile& into the storage
+    TileRef getTile(int x, int y);
+    Tile getTile(int x, int y) const;
+
+    // same as getTile without the bounds check, for loops that already know x/y are in range
+    TileRef getTileUnchecked(int x, int y) { return TileRef(*this, x, y, tileAt(index(x, y))); }
+    Tile getTileUnchecked(int x, int y) const { return tileAt(index(x, y)); }
+
+    // every tile write ends up here so the growth schedule stays in step with the grid.
+    // Throws std::invalid_argument for a replantCooldown outside 0..Tile::MAX_REPLANT_COOLDOWN.
+    void setTile(int x, int y, const Tile& t);
+
+    // the whole grid at once from row-major field arrays (a level pack), same as reset() then
+    // setTile and setWalkable on every tile but copied in bulk. timers and walkable may be
+    // null for all 0 / all walkable. No tile starts out in a replant cooldown.
+    void loadTiles(int grid_width, int grid_height, const TileType* types, const CropState* states,
+                   const std::int32_t* timers, const std::uint8_t* walkable);
+
+    // row-major flat index shared by every field array
+    int index(int x, int y) const { return y * grid_width + x; }
+    int tileCount() const { return grid_width * grid_height; }
+
+    // whole-grid field arrays, indexed by index(x, y)
+    GridSpan<TileType> types() const { return spanOf(typeField, 0, typeField.size()); }
+    GridSpan<CropState> cropStates() const { return spanOf(cropStateField, 0, cropStateField.size()); }
+    GridSpan<int> growthTimers() const;
+
+    // a single row of each field, indexed by x
+    GridSpan<TileType> typeRow(int y) const { return spanOf(typeField, rowStart(y), grid_width); }
+    GridSpan<CropState> cropStateRow(int y) const { return spanOf(cropStateField, rowStart(y), grid_width); }
+    GridSpan<int> growthTimerRow(int y) const;
+    // Tile::replantCooldown of every tile, 0 for all but the few harvested or cleared lately
+    GridSpan<std::uint8_t> replantCooldowns() const { return spanOf(cooldownField, 0, cooldownField.size()); }
 
     void tick();
-    
+
+    // same result as tick(), bit for bit, with the scan split into cache-sized row blocks
+    // spread over the pool. Scheduled mode only touches due crops so it just runs tick()
+    void tickParallel(WorkerPool& pool);
+
+    // ticks run so far
+    std::int64_t getTickCount() const { return tickCount; }
+    // jumps the tick counter, growing crops keep the timers they have now (restoring a saved
+    // state). O(growing crops) in Scheduled mode.
+    void setTickCount(std::int64_t tick);
+
+    // switching modes carries every crop over with its current timer
+    void setGrowthMode(GrowthMode mode);
+    GrowthMode getGrowthMode() const { return growthMode; }
+    // the Scan step's implementation, bestGrowthKernel() to start with. Every kernel ticks
+    // the same, this is for benchmarks and for ruling the SIMD out. Throws
+    // std::invalid_argument for one the CPU can't run.
+    void setGrowthKernel(GrowthKernel kernel);
+    GrowthKernel getGrowthKernel() const { return growthKernel; }
+
+    // walkability, the 'X' tiles of the levels. Separate from the tile fields: a wall is still
+    // an EMPTY tile, it just can't be walked onto. Everything starts out walkable.
+    bool isWalkable(int x, int y) const
+    {
+        return x >= 0 && x < grid_width && y >= 0 && y < grid_height && walkableField[index(x, y)] != 0;
+    }
+    void setWalkable(int x, int y, bool walkable);
+    // 1 walkable / 0 wall per tile, indexed by index(x, y)
+    GridSpan<std::uint8_t> walkability() const { return spanOf(walkableField, 0, walkableField.size()); }
+    GridSpan<std::uint8_t> walkabilityRow(int y) const { return spanOf(walkableField, rowStart(y), grid_width); }
+    // goes up with every setWalkable that changes a tile and with every reset()
+    std::uint64_t getWalkabilityVersion() const { return walkabilityVersion; }
+    // appends the tiles whose walkability changed after version `since`, in order (a tile can
+    // show up more than once). False if that's further back than the log goes or across a
+    // reset(), then the caller has to assume every tile changed.
+    bool walkabilityChangesSince(std::uint64_t since, std::vector<int>& out) const;
+
+    // change tracking for renderers: which tiles had their type, crop state or walkability
+    // change since the last clearChangedTiles(). Timer and cooldown changes don't count, nothing draws them.
+    // Off by default since it costs a byte per tile.
+    void setChangeTracking(bool enabled);
+    bool isTrackingChanges() const { return trackChanges; }
+    const std::vector<int>& getChangedTiles() const { return changedTiles; }
+    // set after reset() or when so much changed that a list isn't worth it: treat every tile as changed
+    bool allTilesChanged() const { return everythingChanged; }
+    void clearChangedTiles();
+
+    // tiles of a type / crop state / both, kept up to date on every write and ripening so
+    // they're O(1). countTiles(CropState) counts every tile in that state whatever its type.
+    int countTiles(TileType type) const;
+    int countTiles(CropState state) const;
+    int countTiles(TileType type, CropState state) const
+    {
+        return tileCounts[static_cast<int>(type)][static_cast<int>(state)];
+    }
+
+    // spatial index of the PLANTED and GROWN crops (CropIndex.hpp) for harvest bots and
+    // objective checks, so they don't scan the grid. Off by default since it costs a byte per
+    // tile and a few count updates per change; turning it on builds it from the grid.
+    void setCropIndexing(bool enabled);
+    bool isIndexingCrops() const { return indexCrops; }
+    // the queries below throw std::logic_error with indexing off, and std::invalid_argument
+    // for a state other than PLANTED or GROWN
+    // crop in that state closest to (x, y) in moves ignoring walls, the lowest index on a tie.
+    // False if there's none. (x, y) can be off the grid.
+    bool nearestCrop(CropState state, int x, int y, int& outX, int& outY) const;
+    // crops in that state inside x0 <= x < x1, y0 <= y < y1, clipped to the grid
+    int countCrops(CropState state, int x0, int y0, int x1, int y1) const;
+    // appends their tile indices, in no particular order
+    void cropsIn(CropState state, int x0, int y0, int x1, int y1, std::vector<int>& out) const;
+
+    // checks the counts (and the crop index if it's on) against a scan of the whole grid,
+    // false with the first mismatch in why
+    bool verifyIndexes(std::string* why = nullptr) const;
+    // runs verifyIndexes after every tick and throws std::logic_error on a mismatch. O(tiles)
+    // a tick, for tests and chasing bugs.
+    void setIndexVerification(bool enabled) { verifyEveryTick = enabled; }
+    bool isVerifyingIndexes() const { return verifyEveryTick; }
+
     private:
-    std::vector<std::vector<Tile>> TileVector;
+    std::size_t rowStart(int y) const { return static_cast<std::size_t>(y) * grid_width; }
+
+    template <typename T>
+    static GridSpan<T> spanOf(const std::vector<T>& field, std::size_t start, std::size_t count)
+    {
+        return { field.data() + start, count };
+    }
+
+    static bool isGrowing(TileType type, CropState state)
+    {
+        return type == TileType::CROP && state == CropState::PLANTED;
+    }
+
+    Tile tileAt(int i) const
+    {
+        Tile t;
+        t.type = typeField[i];
+        t.cropstate = cropStateField[i];
+        t.growthTimer = growthMode == GrowthMode::Scheduled && scheduler.isScheduled(i)
+            ? scheduler.timerAt(i, tickCount)
+            : growthTimerField[i];
+        t.replantCooldown = cooldownField[i];
+        return t;
+    }
+
+    void tickScan();
+    void tickScheduled();
+    // one tick off every replant cooldown, O(tiles still cooling)
+    void tickCooldowns();
+    void setCooldown(int i, int ticks);
+
+    // the scan's per-tile growth step over tiles [begin, end), optionally collecting the
+    // indices that ripened. Returns how many did.
+    int growRange(std::size_t begin, std::size_t end, std::vector<int>* ripened);
+
+    // tile i is about to become type/state: counts and crop index, before the fields change
+    void recount(int i, TileType type, CropState state)
+    {
+        tileCounts[static_cast<int>(typeField[i])][static_cast<int>(cropStateField[i])]--;
+        tileCounts[static_cast<int>(type)][static_cast<int>(state)]++;
+        if (indexCrops) cropIndex.set(i, type, state);
+    }
+    // tile i just ripened, already GROWN in the fields
+    void noteRipened(int i)
+    {
+        if (indexCrops) cropIndex.set(i, TileType::CROP, CropState::GROWN);
+        markChanged(i);
+    }
+    void countRipened(int n)
+    {
+        tileCounts[static_cast<int>(TileType::CROP)][static_cast<int>(CropState::PLANTED)] -= n;
+        tileCounts[static_cast<int>(TileType::CROP)][static_cast<int>(CropState::GROWN)] += n;
+    }
+    // every count from scratch, and the index if it's on
+    void rebuildIndexes();
+    void requireCropIndex() const;
+    // verifyIndexes or throw, for setIndexVerification
+    void checkIndexes() const;
+
+    void markChanged(int i)
+    {
+        if (!trackChanges || everythingChanged || changedFlags[i]) return;
+        changedFlags[i] = 1;
+        changedTiles.push_back(i);
+        if (changedTiles.size() > static_cast<std::size_t>(tileCount()) / 4)
+            markAllChanged();
+    }
+    void markAllChanged();
+
+    // writes the derived timers of scheduled crops into growthTimerField
+    void syncGrowthTimers() const;
+
     int grid_width = 10;
     int grid_height = 10;
 
-};
\ No newline at end of file
+    // structure of arrays: one contiguous block per Tile field, y * grid_width + x
+    std::vector<TileType> typeField;
+    std::vector<CropState> cropStateField;
+    // in Scheduled mode the entries for growing crops are only refreshed on request
+    mutable std::vector<int> growthTimerField;
+    mutable std::int64_t timersSyncedAt = -1;
+
+    GrowthMode growthMode = GrowthMode::Scheduled;
+    GrowthKernel growthKernel = bestGrowthKernel();
+    GrowthScheduler scheduler;
+    std::int64_t tickCount = 0;
+
+    bool trackChanges = false;
+    bool everythingChanged = false;
+    std::vector<std::uint8_t> changedFlags;
+    std::vector<int> changedTiles;
+    std::vector<std::uint8_t> walkableField;
+    std::vector<std::uint8_t> cooldownField;
+    // the tiles with a cooldownField entry above 0, in no particular order
+    std::vector<int> coolingTiles;
+    std::uint64_t walkabilityVersion = 0;
+    // the last few walkability edits, walkabilityLog[k] is the tile of version walkabilityLogStart + k + 1
+    std::vector<int> walkabilityLog;
+    std::uint64_t walkabilityLogStart = 0;
+
+    // per-block ripen lists for the scan ticks, kept to avoid reallocating every tick
+    std::vector<std::vector<int>> blockRipened;
+    // per-block ripen counts for parallel ticks that don't need the lists
+    std::vector<int> blockRipenCounts;
+
+    // [type][state], 3 of each
+    int tileCounts[3][3] = {};
+    bool indexCrops = false;
+    bool verifyEveryTick = false;
+    CropIndex cropIndex;
+
+};
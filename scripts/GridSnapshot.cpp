@@ -0,0 +1,114 @@
+#include "GridSnapshot.hpp"
+#include <algorithm>
+
+// past this many stale tiles a slot just gets copied whole
+static bool tooManyChanges(std::size_t changes, std::size_t tileCount)
+{
+    return changes > tileCount / 4;
+}
+
+bool SnapshotExchange::publish(const Grid& grid, const std::vector<int>& changed, bool allChanged,
+                               const SnapshotInfo& info)
+{
+    int back;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        back = latest == 0 ? 1 : 0;
+        if (reading == back) return false;
+    }
+
+    // the reader only ever touches `latest`, so the back slot is ours until the flip
+    GridSnapshot& s = slots[back];
+    const std::size_t count = static_cast<std::size_t>(grid.tileCount());
+    const GridSpan<TileType> types = grid.types();
+    const GridSpan<CropState> states = grid.cropStates();
+    const GridSpan<std::uint8_t> walkable = grid.walkability();
+
+    const bool resized = s.width != grid.getGridWidth() || s.height != grid.getGridHeight();
+    if (resized || allChanged || staleAll[back] || tooManyChanges(stale[back].size() + changed.size(), count)) {
+        s.width = grid.getGridWidth();
+        s.height = grid.getGridHeight();
+        s.types.assign(types.begin(), types.end());
+        s.states.assign(states.begin(), states.end());
+        s.walkable.assign(walkable.begin(), walkable.end());
+    } else {
+        for (int i : stale[back]) { s.types[i] = types[i]; s.states[i] = states[i]; s.walkable[i] = walkable[i]; }
+        for (int i : changed)     { s.types[i] = types[i]; s.states[i] = states[i]; s.walkable[i] = walkable[i]; }
+    }
+    s.info = info;
+    stale[back].clear();
+    staleAll[back] = false;
+
+    // the other slot now lags by this publish's changes
+    const int other = 1 - back;
+    if (!staleAll[other]) {
+        if (allChanged || resized || tooManyChanges(stale[other].size() + changed.size(), count)) {
+            staleAll[other] = true;
+            stale[other].clear();
+        } else {
+            stale[other].insert(stale[other].end(), changed.begin(), changed.end());
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    latest = back;
+    unread = true;
+    if (!pendingAll) {
+        if (allChanged || resized || tooManyChanges(pending.size() + changed.size(), count)) {
+            pendingAll = true;
+            pending.clear();
+        } else {
+            pending.insert(pending.end(), changed.begin(), changed.end());
+        }
+    }
+    return true;
+}
+
+const GridSnapshot* SnapshotExchange::acquire(std::vector<int>& changedOut, bool& allChangedOut)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    changedOut.clear();
+    allChangedOut = false;
+    if (!unread) return nullptr;
+
+    reading = latest;
+    unread = false;
+    changedOut.swap(pending);
+    allChangedOut = pendingAll;
+    pendingAll = false;
+    return &slots[reading];
+}
+
+void SnapshotExchange::release()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    reading = -1;
+}
+
+void applySnapshot(const GridSnapshot& snapshot, const std::vector<int>& changed, bool allChanged, Grid& display)
+{
+    const int w = snapshot.width;
+    if (allChanged || display.getGridWidth() != w || display.getGridHeight() != snapshot.height) {
+        // reset() leaves everything empty and walkable, only the rest needs writing
+        display.reset(w, snapshot.height);
+        for (std::size_t i = 0; i < snapshot.types.size(); i++) {
+            const int x = static_cast<int>(i) % w;
+            const int y = static_cast<int>(i) / w;
+            if (!snapshot.walkable[i]) display.setWalkable(x, y, false);
+            if (snapshot.types[i] == TileType::EMPTY && snapshot.states[i] == CropState::EMPTY) continue;
+            Tile t;
+            t.type = snapshot.types[i];
+            t.cropstate = snapshot.states[i];
+            display.setTile(x, y, t);
+        }
+        return;
+    }
+
+    for (int i : changed) {
+        Tile t;
+        t.type = snapshot.types[i];
+        t.cropstate = snapshot.states[i];
+        display.setTile(i % w, i / w, t);
+        display.setWalkable(i % w, i / w, snapshot.walkable[i] != 0);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "Grid.hpp"
+
+// everything the renderer wants besides the tiles
+struct SnapshotInfo
+{
+    std::int64_t tick = 0;
+    // farmer before and after the last tick, the renderer slides the marker between them
+    int farmerX = 0;
+    int farmerY = 0;
+    int prevFarmerX = 0;
+    int prevFarmerY = 0;
+    int harvests = 0;
+    double publishedAt = 0.0;       // steadySeconds() when it was published
+    double tickSeconds = 0.0;       // length of a tick at the rate it was running
+    double targetTicksPerSecond = 0.0;
+    double measuredTicksPerSecond = 0.0;
+};
+
+// read-only copy of the drawable part of a Grid (tile types, crop states and walls)
+struct GridSnapshot
+{
+    int width = 0;
+    int height = 0;
+    std::vector<TileType> types;
+    std::vector<CropState> states;
+    std::vector<std::uint8_t> walkable;
+    SnapshotInfo info;
+};
+
+// Double-buffered hand-off of the grid from the simulation thread to the render thread.
+// The writer fills whichever slot isn't the latest and flips `latest` under a lock held only
+// for the flip. Neither side ever waits for the other: if the reader is still on the slot the
+// writer wants, publish() just returns false and the writer tries again next time.
+// Slots are brought up to date incrementally from the Grid's change tracking, so a publish
+// costs about as much as the tiles that changed.
+class SnapshotExchange
+{
+    public:
+    // writer side. `changed`/`allChanged` are the Grid's change tracking since the last
+    // successful publish, the caller clears them only when this returns true.
+    bool publish(const Grid& grid, const std::vector<int>& changed, bool allChanged, const SnapshotInfo& info);
+
+    // reader side. The newest snapshot, or nullptr if nothing new was published since the last
+    // acquire. `changedOut` gets every tile changed since the previous acquire, or
+    // `allChangedOut` is set. Hold on to it until release().
+    const GridSnapshot* acquire(std::vector<int>& changedOut, bool& allChangedOut);
+    void release();
+
+    private:
+    std::mutex mutex;
+    GridSnapshot slots[2];
+    int latest = -1;
+    int reading = -1;
+    bool unread = false;
+
+    // writer only: tiles each slot is behind on
+    std::vector<int> stale[2];
+    bool staleAll[2] = { true, true };
+
+    // changes the reader hasn't picked up yet (guarded by mutex)
+    std::vector<int> pending;
+    bool pendingAll = true;
+};
+
+// brings a render-side copy of the grid up to date from a snapshot, through setTile so the
+// copy's own change tracking sees exactly what changed
+void applySnapshot(const GridSnapshot& snapshot, const std::vector<int>& changed, bool allChanged, Grid& display);
@@ -0,0 +1,297 @@
+// The growth step kernels (GrowthKernel.hpp), scalar and SIMD.
+//
+// Field arrays: types and states are a byte a tile, so a vector of them covers 16 or 32
+// tiles and the growing mask is two byte compares. Blocks with nothing growing (most of a
+// farm) stop there. Otherwise the mask is widened to the int timers, which step by
+// subtracting it (-1 in growing lanes), and the few tiles that ripen get their state written
+// one by one from a bit mask, the same pass that lists them.
+//
+// Packed words: adding 1 << TIMER_SHIFT to the word steps the timer, and with the type/state
+// bits fixed at GROWING_CODE "timer >= GROWTH_TIME" is a signed compare of the whole word.
+//
+// The SSE2/AVX2 versions are compiled with per-function target attributes, so the rest of the
+// build doesn't need -mavx2 and the binary still runs on CPUs without it.
+#include "GrowthKernel.hpp"
+#include "PackedGrid.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FARM_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#else
+#define FARM_X86 0
+#endif
+
+#if FARM_X86 && (defined(__GNUC__) || defined(__clang__))
+#define FARM_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FARM_TARGET(isa)
+#endif
+
+namespace {
+
+// word >= this (as int16) <=> timer >= GROWTH_TIME, for a word with GROWING_CODE in the low bits
+constexpr int RIPE_ABOVE = (Tile::GROWTH_TIME << PackedTile::TIMER_SHIFT) - 1;
+constexpr std::uint16_t TIMER_STEP = 1 << PackedTile::TIMER_SHIFT;
+
+int growFieldsScalar(const TileType* types, CropState* states, int* timers, std::size_t begin, std::size_t end,
+                     std::vector<int>* ripened)
+{
+    // written without branches so the mostly-empty random mix of tiles doesn't cost a
+    // mispredict per crop
+    int ripeCount = 0;
+    for (std::size_t i = begin; i < end; i++) {
+        const bool growing = (types[i] == TileType::CROP) & (states[i] == CropState::PLANTED);
+        timers[i] += growing;
+        const bool ripe = growing & (timers[i] >= Tile::GROWTH_TIME);
+        states[i] = ripe ? CropState::GROWN : states[i];
+        ripeCount += ripe;
+        if (ripened && ripe) ripened->push_back(static_cast<int>(i));
+    }
+    return ripeCount;
+}
+
+void growScalar(std::uint16_t* tiles, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++) {
+        std::uint16_t t = tiles[i];
+        const bool growing = (t & 0xF) == PackedTile::GROWING_CODE;
+        t = static_cast<std::uint16_t>(t + (growing ? TIMER_STEP : 0));
+        const bool ripe = growing & (static_cast<std::int16_t>(t) > RIPE_ABOVE);
+        tiles[i] = static_cast<std::uint16_t>(t ^ (ripe ? PackedTile::RIPEN_FLIP : 0));
+    }
+}
+
+#if FARM_X86
+
+int lowestBit(std::uint32_t mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return static_cast<int>(bit);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// bit k of mask set: tile base + k ripened
+int ripenMasked(std::uint32_t mask, std::size_t base, CropState* states, std::vector<int>* ripened)
+{
+    int count = 0;
+    for (; mask != 0; mask &= mask - 1, count++) {
+        const std::size_t i = base + lowestBit(mask);
+        states[i] = CropState::GROWN;
+        if (ripened) ripened->push_back(static_cast<int>(i));
+    }
+    return count;
+}
+
+FARM_TARGET("sse2")
+int growFieldsSse2(const TileType* types, CropState* states, int* timers, std::size_t begin, std::size_t end,
+                   std::vector<int>* ripened)
+{
+    const __m128i crop = _mm_set1_epi8(static_cast<char>(TileType::CROP));
+    const __m128i planted = _mm_set1_epi8(static_cast<char>(CropState::PLANTED));
+    const __m128i notRipe = _mm_set1_epi32(Tile::GROWTH_TIME - 1);
+
+    int ripeCount = 0;
+    std::size_t i = begin;
+    for (; i + 16 <= end; i += 16) {
+        const __m128i growing =
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(types + i)), crop),
+                          _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(states + i)), planted));
+        if (_mm_movemask_epi8(growing) == 0) continue;
+
+        // the byte mask doubled up to 16 and then 32 bits, four timers per quarter
+        const __m128i low = _mm_unpacklo_epi8(growing, growing);
+        const __m128i high = _mm_unpackhi_epi8(growing, growing);
+        const __m128i quarters[4] = { _mm_unpacklo_epi16(low, low), _mm_unpackhi_epi16(low, low),
+                                      _mm_unpacklo_epi16(high, high), _mm_unpackhi_epi16(high, high) };
+        std::uint32_t ripe = 0;
+        for (int q = 0; q < 4; q++) {
+            __m128i* p = reinterpret_cast<__m128i*>(timers + i + 4 * q);
+            const __m128i t = _mm_sub_epi32(_mm_loadu_si128(p), quarters[q]);
+            _mm_storeu_si128(p, t);
+            const __m128i r = _mm_and_si128(quarters[q], _mm_cmpgt_epi32(t, notRipe));
+            ripe |= static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(r))) << (4 * q);
+        }
+        ripeCount += ripenMasked(ripe, i, states, ripened);
+    }
+    return ripeCount + growFieldsScalar(types, states, timers, i, end, ripened);
+}
+
+FARM_TARGET("avx2")
+int growFieldsAvx2(const TileType* types, CropState* states, int* timers, std::size_t begin, std::size_t end,
+                   std::vector<int>* ripened)
+{
+    const __m256i crop = _mm256_set1_epi8(static_cast<char>(TileType::CROP));
+    const __m256i planted = _mm256_set1_epi8(static_cast<char>(CropState::PLANTED));
+    const __m256i notRipe = _mm256_set1_epi32(Tile::GROWTH_TIME - 1);
+
+    int ripeCount = 0;
+    std::size_t i = begin;
+    for (; i + 32 <= end; i += 32) {
+        const __m256i growing = _mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(types + i)), crop),
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(states + i)), planted));
+        if (_mm256_testz_si256(growing, growing)) continue;
+
+        // eight mask bytes at a time sign-extended to the timers' 32 bits
+        const __m128i low = _mm256_castsi256_si128(growing);
+        const __m128i high = _mm256_extracti128_si256(growing, 1);
+        const __m128i eighths[4] = { low, _mm_srli_si128(low, 8), high, _mm_srli_si128(high, 8) };
+        std::uint32_t ripe = 0;
+        for (int q = 0; q < 4; q++) {
+            const __m256i mask = _mm256_cvtepi8_epi32(eighths[q]);
+            __m256i* p = reinterpret_cast<__m256i*>(timers + i + 8 * q);
+            const __m256i t = _mm256_sub_epi32(_mm256_loadu_si256(p), mask);
+            _mm256_storeu_si256(p, t);
+            const __m256i r = _mm256_and_si256(mask, _mm256_cmpgt_epi32(t, notRipe));
+            ripe |= static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(r))) << (8 * q);
+        }
+        ripeCount += ripenMasked(ripe, i, states, ripened);
+    }
+    return ripeCount + growFieldsSse2(types, states, timers, i, end, ripened);
+}
+
+FARM_TARGET("sse2")
+void growSse2(std::uint16_t* tiles, std::size_t count)
+{
+    const __m128i low = _mm_set1_epi16(0xF);
+    const __m128i code = _mm_set1_epi16(PackedTile::GROWING_CODE);
+    const __m128i step = _mm_set1_epi16(TIMER_STEP);
+    const __m128i ripeAbove = _mm_set1_epi16(RIPE_ABOVE);
+    const __m128i flip = _mm_set1_epi16(PackedTile::RIPEN_FLIP);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tiles + i));
+        const __m128i growing = _mm_cmpeq_epi16(_mm_and_si128(t, low), code);
+        t = _mm_add_epi16(t, _mm_and_si128(growing, step));
+        const __m128i ripe = _mm_and_si128(growing, _mm_cmpgt_epi16(t, ripeAbove));
+        t = _mm_xor_si128(t, _mm_and_si128(ripe, flip));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(tiles + i), t);
+    }
+    growScalar(tiles + i, count - i);
+}
+
+FARM_TARGET("avx2")
+void growAvx2(std::uint16_t* tiles, std::size_t count)
+{
+    const __m256i low = _mm256_set1_epi16(0xF);
+    const __m256i code = _mm256_set1_epi16(PackedTile::GROWING_CODE);
+    const __m256i step = _mm256_set1_epi16(TIMER_STEP);
+    const __m256i ripeAbove = _mm256_set1_epi16(RIPE_ABOVE);
+    const __m256i flip = _mm256_set1_epi16(PackedTile::RIPEN_FLIP);
+
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tiles + i));
+        const __m256i growing = _mm256_cmpeq_epi16(_mm256_and_si256(t, low), code);
+        t = _mm256_add_epi16(t, _mm256_and_si256(growing, step));
+        const __m256i ripe = _mm256_and_si256(growing, _mm256_cmpgt_epi16(t, ripeAbove));
+        t = _mm256_xor_si256(t, _mm256_and_si256(ripe, flip));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(tiles + i), t);
+    }
+    growSse2(tiles + i, count - i);
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    // AVX2 bit, plus the OS has to save the ymm registers (OSXSAVE and XCR0 bits 1-2)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+    __cpuid(regs, 1);
+    if (!(regs[2] & (1 << 27)) || !(regs[2] & (1 << 28))) return false;
+    if ((_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    // checks the OS side as well
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool cpuHasSse2()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    return true; // part of x86-64
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 1);
+    return (regs[3] & (1 << 26)) != 0;
+#else
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+#endif // FARM_X86
+
+} // namespace
+
+const char* growthKernelName(GrowthKernel kernel)
+{
+    switch (kernel) {
+    case GrowthKernel::Scalar: return "scalar";
+    case GrowthKernel::Sse2: return "sse2";
+    case GrowthKernel::Avx2: return "avx2";
+    }
+    return "?";
+}
+
+bool growthKernelSupported(GrowthKernel kernel)
+{
+    switch (kernel) {
+    case GrowthKernel::Scalar: return true;
+#if FARM_X86
+    case GrowthKernel::Sse2: {
+        static const bool sse2 = cpuHasSse2();
+        return sse2;
+    }
+    case GrowthKernel::Avx2: {
+        static const bool avx2 = cpuHasAvx2();
+        return avx2;
+    }
+#else
+    case GrowthKernel::Sse2:
+    case GrowthKernel::Avx2:
+        return false;
+#endif
+    }
+    return false;
+}
+
+GrowthKernel bestGrowthKernel()
+{
+    if (growthKernelSupported(GrowthKernel::Avx2)) return GrowthKernel::Avx2;
+    if (growthKernelSupported(GrowthKernel::Sse2)) return GrowthKernel::Sse2;
+    return GrowthKernel::Scalar;
+}
+
+int growTileFields(GrowthKernel kernel, const TileType* types, CropState* states, int* timers, std::size_t begin,
+                   std::size_t end, std::vector<int>* ripened)
+{
+    switch (kernel) {
+#if FARM_X86
+    case GrowthKernel::Avx2: return growFieldsAvx2(types, states, timers, begin, end, ripened);
+    case GrowthKernel::Sse2: return growFieldsSse2(types, states, timers, begin, end, ripened);
+#endif
+    default: return growFieldsScalar(types, states, timers, begin, end, ripened);
+    }
+}
+
+void growPackedTiles(GrowthKernel kernel, std::uint16_t* tiles, std::size_t count)
+{
+    switch (kernel) {
+#if FARM_X86
+    case GrowthKernel::Avx2: growAvx2(tiles, count); return;
+    case GrowthKernel::Sse2: growSse2(tiles, count); return;
+#endif
+    default: growScalar(tiles, count); return;
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Tile.hpp"
+
+// The per-tile growth step of a full scan, scalar and SIMD. Every version does the same thing
+// per tile, so they all give the same result bit for bit:
+//   growing = CROP and PLANTED
+//   timer  += growing
+//   if growing and timer >= GROWTH_TIME: PLANTED -> GROWN
+// Grid runs it over its field arrays in Scan mode, PackedGrid over its 16-bit tiles.
+enum class GrowthKernel { Scalar, Sse2, Avx2 };
+
+const char* growthKernelName(GrowthKernel kernel);
+// whether this CPU (and build) can run it, checked at runtime
+bool growthKernelSupported(GrowthKernel kernel);
+// the widest supported one
+GrowthKernel bestGrowthKernel();
+
+// tiles [begin, end) of Grid-style field arrays, in place. Appends the tiles that ripened to
+// ripened (if given) in index order and returns how many did.
+int growTileFields(GrowthKernel kernel, const TileType* types, CropState* states, int* timers, std::size_t begin,
+                   std::size_t end, std::vector<int>* ripened);
+
+// count PackedTile words (PackedGrid.hpp), in place
+void growPackedTiles(GrowthKernel kernel, std::uint16_t* tiles, std::size_t count);
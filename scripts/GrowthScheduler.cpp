@@ -0,0 +1,72 @@
+#include "GrowthScheduler.hpp"
+
+void GrowthScheduler::reset(int tileCount)
+{
+    clear();
+    dueTick.assign(static_cast<std::size_t>(tileCount), -1);
+    zeroTick.assign(static_cast<std::size_t>(tileCount), 0);
+}
+
+void GrowthScheduler::clear()
+{
+    for (std::vector<Entry>& slot : wheel) slot.clear();
+    overflow.clear();
+    std::fill(dueTick.begin(), dueTick.end(), -1);
+    pending = 0;
+}
+
+void GrowthScheduler::schedule(int index, int timer, std::int64_t now)
+{
+    cancel(index);
+
+    // same rule as the scan: the timer goes up by one each tick and the crop is GROWN on the
+    // first tick it reaches GROWTH_TIME, always at least one tick after planting
+    const std::int64_t delay = std::max<std::int64_t>(1, static_cast<std::int64_t>(Tile::GROWTH_TIME) - timer);
+    const std::int64_t due = now + delay;
+
+    zeroTick[index] = now - timer;
+    dueTick[index] = due;
+    pending++;
+    enqueue(index, due, delay);
+}
+
+void GrowthScheduler::enqueue(int index, std::int64_t due, std::int64_t delay)
+{
+    if (delay < static_cast<std::int64_t>(WHEEL_SIZE)) {
+        wheel[static_cast<std::size_t>(due) & WHEEL_MASK].emplace_back(due, index);
+    } else {
+        overflow.emplace_back(due, index);
+        std::push_heap(overflow.begin(), overflow.end(), std::greater<Entry>());
+    }
+}
+
+void GrowthScheduler::cancel(int index)
+{
+    if (dueTick[index] >= 0) {
+        dueTick[index] = -1;
+        pending--;
+    }
+}
+
+void GrowthScheduler::rebase(std::int64_t now, std::int64_t newNow)
+{
+    const std::int64_t delta = newNow - now;
+    if (delta == 0)
+        return;
+
+    // the wheel slots depend on the absolute due tick, so everything gets queued again
+    std::vector<Entry> live;
+    live.reserve(pending);
+    forEachScheduled([this, &live](int i) { live.emplace_back(dueTick[i], i); });
+    for (std::vector<Entry>& slot : wheel) slot.clear();
+    overflow.clear();
+
+    for (const Entry& e : live) {
+        const int index = e.second;
+        // a duplicate of a tile that has already moved
+        if (dueTick[index] != e.first) continue;
+        dueTick[index] += delta;
+        zeroTick[index] += delta;
+        enqueue(index, dueTick[index], dueTick[index] - newNow);
+    }
+}
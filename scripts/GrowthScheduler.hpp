@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "Tile.hpp"
+
+// Event-driven crop growth used by Grid in GrowthMode::Scheduled.
+// Instead of bumping every PLANTED timer each tick, each planting records the absolute tick it
+// ripens on and tick() only touches the crops that are due. Timers are derived on request from
+// the tick the crop was (virtually) at zero, so readers see the same numbers the scan would give.
+//
+// Near-term ripenings (the normal case, at most GROWTH_TIME ticks out) go in a timing wheel,
+// anything further out (negative timers set by hand) waits in a min-heap.
+// Cancelled or rescheduled entries are left in place and skipped when their slot comes up.
+class GrowthScheduler
+{
+    public:
+    void reset(int tileCount);
+    void clear();
+
+    // tile index started (or restarted) growing with this timer value at tick `now`
+    void schedule(int index, int timer, std::int64_t now);
+    void cancel(int index);
+
+    // moves every scheduled crop from the clock at `now` to one at `newNow`, timers unchanged
+    void rebase(std::int64_t now, std::int64_t newNow);
+
+    bool isScheduled(int index) const { return dueTick[index] >= 0; }
+    std::int64_t ripensAt(int index) const { return dueTick[index]; }
+
+    // what growthTimer would read for a scheduled tile at tick `now`
+    int timerAt(int index, std::int64_t now) const
+    {
+        return static_cast<int>(now - zeroTick[index]);
+    }
+
+    // must be called once for every tick, in order; calls onRipe(index) for each crop due at `now`
+    template <typename OnRipe>
+    void collectDue(std::int64_t now, OnRipe&& onRipe)
+    {
+        std::vector<Entry>& slot = wheel[static_cast<std::size_t>(now) & WHEEL_MASK];
+        for (const Entry& e : slot) {
+            const int index = e.second;
+            if (dueTick[index] == now) {
+                dueTick[index] = -1;
+                pending--;
+                onRipe(index);
+            }
+        }
+        slot.clear();
+
+        while (!overflow.empty() && overflow.front().first <= now) {
+            std::pop_heap(overflow.begin(), overflow.end(), std::greater<Entry>());
+            const std::int64_t due = overflow.back().first;
+            const int index = overflow.back().second;
+            overflow.pop_back();
+            if (dueTick[index] == due) {
+                dueTick[index] = -1;
+                pending--;
+                onRipe(index);
+            }
+        }
+    }
+
+    // calls fn(index) for every crop still waiting to ripen, walking only the queued entries
+    // (a tile replanted onto the same due tick can come up twice, so fn should be idempotent)
+    template <typename Fn>
+    void forEachScheduled(Fn&& fn) const
+    {
+        for (const std::vector<Entry>& slot : wheel) {
+            for (const Entry& e : slot) {
+                if (dueTick[e.second] == e.first) fn(e.second);
+            }
+        }
+        for (const Entry& e : overflow) {
+            if (dueTick[e.second] == e.first) fn(e.second);
+        }
+    }
+
+    std::size_t pendingCount() const { return pending; }
+
+    private:
+    // power of two above GROWTH_TIME so a fresh planting always lands in the wheel
+    static constexpr std::size_t WHEEL_SIZE = 32;
+    static constexpr std::size_t WHEEL_MASK = WHEEL_SIZE - 1;
+    static_assert(Tile::GROWTH_TIME < static_cast<int>(WHEEL_SIZE), "growth wheel too small for GROWTH_TIME");
+
+    using Entry = std::pair<std::int64_t, int>; // due tick, tile index
+
+    // queues a tile due `delay` ticks from now
+    void enqueue(int index, std::int64_t due, std::int64_t delay);
+
+    std::vector<std::int64_t> dueTick;          // -1 when the tile is not growing
+    std::vector<std::int64_t> zeroTick;         // tick at which the tile's timer was 0
+    std::vector<Entry> wheel[WHEEL_SIZE];
+    std::vector<Entry> overflow;                // min-heap on due tick
+    std::size_t pending = 0;
+};
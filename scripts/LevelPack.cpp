@@ -0,0 +1,379 @@
+#include "LevelPack.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char PACK_MAGIC[4] = { 'F', 'L', 'V', 'P' };
+
+// per tile: int32 timer + type, state, walkable and crop kind bytes
+constexpr std::uint64_t BYTES_PER_TILE = 8;
+
+[[noreturn]] void fail(const std::string& what)
+{
+    throw std::runtime_error("bad level pack: " + what);
+}
+
+bool littleEndianHost()
+{
+    const std::uint16_t probe = 1;
+    std::uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+std::uint64_t alignUp(std::uint64_t v) { return (v + 7) & ~std::uint64_t(7); }
+
+template <typename T>
+void append(std::vector<std::uint8_t>& out, const T& value)
+{
+    const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+// type, state, walkable and crop kind bytes of a tile block all in range
+bool tilesInRange(const std::uint8_t* block, std::uint64_t tiles)
+{
+    const std::uint8_t* bytes = block + tiles * 4;
+    for (std::uint64_t t = 0; t < tiles; t++) {
+        if (bytes[t] > 2 || bytes[tiles + t] > 2 || bytes[2 * tiles + t] > 1 || bytes[3 * tiles + t] >= CROP_KIND_COUNT)
+            return false;
+    }
+    return true;
+}
+
+void pad(std::vector<std::uint8_t>& out) { out.resize(static_cast<std::size_t>(alignUp(out.size())), 0); }
+
+} // namespace
+
+std::uint32_t levelPackCrc32(const std::uint8_t* data, std::size_t size, std::uint32_t crc)
+{
+    static const std::vector<std::uint32_t> table = [] {
+        std::vector<std::uint32_t> t(256);
+        for (std::uint32_t i = 0; i < 256; i++) {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+const std::vector<std::string>& levelPackCommandNames()
+{
+    static const std::vector<std::string> names = {
+        "move", "plant", "harvest", "remove", "for", "while", "if", "elif", "else", "print",
+    };
+    return names;
+}
+
+ScriptObjective PackedLevel::objective() const
+{
+    ScriptObjective o;
+    o.harvestsRequired = harvestsRequired;
+    for (int k = 0; k < 4; k++) {
+        if (cropRequired[k] > 0) o.cropRequirements.emplace_back(static_cast<CropKind>(k + 1), cropRequired[k]);
+    }
+    return o;
+}
+
+std::vector<std::string> PackedLevel::allowedCommands() const
+{
+    std::vector<std::string> out;
+    const std::vector<std::string>& names = levelPackCommandNames();
+    for (std::size_t i = 0; i < names.size(); i++)
+        if (allowedMask & (1u << i)) out.push_back(names[i]);
+    return out;
+}
+
+LevelPack LevelPack::open(const std::string& path, LevelPackCheck check)
+{
+    LevelPack pack;
+#if defined(_WIN32)
+    // no mapping here yet, reading it in still skips all the parsing
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("can't open level pack: " + path);
+    pack.owned.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    pack.data = pack.owned.data();
+    pack.size = pack.owned.size();
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("can't open level pack: " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        fail("empty or unreadable file " + path);
+    }
+    void* region = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (region == MAP_FAILED) throw std::runtime_error("can't map level pack: " + path);
+    pack.mapping = region;
+    pack.data = static_cast<const std::uint8_t*>(region);
+    pack.size = static_cast<std::size_t>(st.st_size);
+#endif
+    pack.validate(check);
+    return pack;
+}
+
+LevelPack LevelPack::fromBytes(std::vector<std::uint8_t> bytes, LevelPackCheck check)
+{
+    LevelPack pack;
+    pack.owned = std::move(bytes);
+    pack.data = pack.owned.data();
+    pack.size = pack.owned.size();
+    pack.validate(check);
+    return pack;
+}
+
+LevelPack::LevelPack(LevelPack&& other) noexcept
+    : data(other.data), size(other.size), count(other.count), tilesChecked(other.tilesChecked), mapping(other.mapping),
+      owned(std::move(other.owned))
+{
+    other.data = nullptr;
+    other.size = 0;
+    other.count = 0;
+    other.mapping = nullptr;
+}
+
+LevelPack& LevelPack::operator=(LevelPack&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        data = std::exchange(other.data, nullptr);
+        size = std::exchange(other.size, 0);
+        count = std::exchange(other.count, 0);
+        tilesChecked = other.tilesChecked;
+        mapping = std::exchange(other.mapping, nullptr);
+        owned = std::move(other.owned);
+    }
+    return *this;
+}
+
+LevelPack::~LevelPack()
+{
+    release();
+}
+
+void LevelPack::release()
+{
+#if !defined(_WIN32)
+    if (mapping) ::munmap(mapping, size);
+#endif
+    mapping = nullptr;
+    data = nullptr;
+    size = 0;
+    count = 0;
+    tilesChecked = false;
+    owned.clear();
+}
+
+LevelPackEntry LevelPack::entry(int index) const
+{
+    LevelPackEntry e;
+    std::memcpy(&e, data + sizeof(LevelPackHeader) + static_cast<std::size_t>(index) * sizeof(LevelPackEntry), sizeof(e));
+    return e;
+}
+
+void LevelPack::validate(LevelPackCheck check)
+{
+    if (!littleEndianHost()) fail("packs are little-endian, this host isn't");
+    LevelPackHeader h;
+    if (size < sizeof(h)) fail("too short");
+    std::memcpy(&h, data, sizeof(h));
+    if (std::memcmp(h.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0) fail("not a level pack");
+    if (h.version != LEVEL_PACK_VERSION)
+        fail("version " + std::to_string(h.version) + ", this build reads " + std::to_string(LEVEL_PACK_VERSION));
+    if (h.headerSize != sizeof(h) || h.fileSize != size || h.indexOffset != sizeof(h) || h.reserved != 0) fail("bad header");
+    const std::uint64_t indexEnd = h.indexOffset + std::uint64_t(h.levelCount) * sizeof(LevelPackEntry);
+    if (indexEnd > size || h.stringsOffset != indexEnd || h.stringsSize > size - h.stringsOffset)
+        fail("index or strings out of bounds");
+    if (levelPackCrc32(data + h.indexOffset, static_cast<std::size_t>(h.stringsOffset + h.stringsSize - h.indexOffset)) != h.indexCrc)
+        fail("index checksum mismatch");
+    if (check == LevelPackCheck::Full && levelPackCrc32(data + sizeof(h), size - sizeof(h)) != h.dataCrc)
+        fail("checksum mismatch");
+
+    count = h.levelCount;
+    const std::uint32_t allMask = (1u << levelPackCommandNames().size()) - 1;
+    for (int i = 0; i < levelCount(); i++) {
+        const LevelPackEntry e = entry(i);
+        const std::uint64_t tiles = std::uint64_t(e.width) * e.height;
+        if (e.width == 0 || e.height == 0 || e.startX >= e.width || e.startY >= e.height)
+            fail("level " + std::to_string(e.number) + " has a bad size or start");
+        if (std::uint64_t(e.nameOffset) + e.nameLength > h.stringsSize || std::uint64_t(e.hintOffset) + e.hintLength > h.stringsSize)
+            fail("level " + std::to_string(e.number) + " strings out of bounds");
+        if (e.tilesOffset % 8 != 0 || e.tilesOffset < h.stringsOffset + h.stringsSize || e.tilesOffset > size
+            || tiles * BYTES_PER_TILE > size - e.tilesOffset)
+            fail("level " + std::to_string(e.number) + " tiles out of bounds");
+        if ((e.allowedMask & ~allMask) != 0 || e.timeLimitMs < -1 || e.reserved != 0)
+            fail("level " + std::to_string(e.number) + " has a bad objective");
+
+        if (check == LevelPackCheck::Full && !tilesInRange(data + e.tilesOffset, tiles))
+            fail("level " + std::to_string(e.number) + " has a bad tile");
+    }
+    tilesChecked = check == LevelPackCheck::Full;
+}
+
+PackedLevel LevelPack::level(int index) const
+{
+    if (index < 0 || index >= levelCount()) throw std::out_of_range("level pack index out of range");
+    const LevelPackEntry e = entry(index);
+    LevelPackHeader h;
+    std::memcpy(&h, data, sizeof(h));
+    const char* strings = reinterpret_cast<const char*>(data + h.stringsOffset);
+
+    PackedLevel l;
+    l.number = static_cast<int>(e.number);
+    l.name = std::string_view(strings + e.nameOffset, e.nameLength);
+    l.hint = std::string_view(strings + e.hintOffset, e.hintLength);
+    l.width = e.width;
+    l.height = e.height;
+    l.startX = e.startX;
+    l.startY = e.startY;
+    l.harvestsRequired = static_cast<int>(e.harvestsRequired);
+    for (int k = 0; k < 4; k++) l.cropRequired[k] = e.cropRequired[k];
+    l.timeLimitSeconds = e.timeLimitMs < 0 ? -1.0 : e.timeLimitMs / 1000.0;
+    l.allowedMask = e.allowedMask;
+
+    const std::size_t tiles = static_cast<std::size_t>(e.width) * e.height;
+    const std::uint8_t* block = data + e.tilesOffset;
+    l.timers = reinterpret_cast<const std::int32_t*>(block);
+    l.types = reinterpret_cast<const TileType*>(block + tiles * 4);
+    l.states = reinterpret_cast<const CropState*>(block + tiles * 5);
+    l.walkable = block + tiles * 6;
+    l.crops = reinterpret_cast<const CropKind*>(block + tiles * 7);
+    return l;
+}
+
+int LevelPack::indexOfNumber(int number) const
+{
+    for (int i = 0; i < levelCount(); i++)
+        if (static_cast<int>(entry(i).number) == number) return i;
+    return -1;
+}
+
+void LevelPack::loadLevel(int index, Grid& grid, Farmer& farmer) const
+{
+    const PackedLevel l = level(index);
+    // an index-only open hasn't looked at this block yet, and Grid counts tiles by their type
+    // and state bytes, so they can't go in unchecked
+    if (!tilesChecked && (!verifyLevel(index) || !tilesInRange(data + entry(index).tilesOffset, std::uint64_t(l.width) * l.height)))
+        fail("level " + std::to_string(l.number) + " has a bad tile block");
+    grid.loadTiles(l.width, l.height, l.types, l.states, l.timers, l.walkable);
+    farmer.reset(l.startX, l.startY);
+}
+
+bool LevelPack::verifyLevel(int index) const
+{
+    if (index < 0 || index >= levelCount()) throw std::out_of_range("level pack index out of range");
+    const LevelPackEntry e = entry(index);
+    const std::size_t bytes = static_cast<std::size_t>(std::uint64_t(e.width) * e.height * BYTES_PER_TILE);
+    return levelPackCrc32(data + e.tilesOffset, bytes) == e.tilesCrc;
+}
+
+std::vector<std::uint8_t> buildLevelPack(const std::vector<LevelSource>& levels)
+{
+    if (!littleEndianHost()) throw std::runtime_error("level packs can only be built on little-endian hosts");
+    const std::vector<std::string>& names = levelPackCommandNames();
+
+    std::vector<LevelPackEntry> entries(levels.size());
+    std::string strings;
+    for (std::size_t i = 0; i < levels.size(); i++) {
+        const LevelSource& src = levels[i];
+        LevelPackEntry& e = entries[i];
+        std::memset(&e, 0, sizeof(e));
+        if (src.layout.width <= 0 || src.layout.height <= 0 || src.layout.width > 0xffff || src.layout.height > 0xffff)
+            throw std::invalid_argument("level " + std::to_string(src.number) + ": bad size");
+        e.number = static_cast<std::uint32_t>(src.number);
+        e.nameOffset = static_cast<std::uint32_t>(strings.size());
+        e.nameLength = static_cast<std::uint32_t>(src.name.size());
+        strings += src.name;
+        e.hintOffset = static_cast<std::uint32_t>(strings.size());
+        e.hintLength = static_cast<std::uint32_t>(src.hint.size());
+        strings += src.hint;
+        e.width = static_cast<std::uint16_t>(src.layout.width);
+        e.height = static_cast<std::uint16_t>(src.layout.height);
+        e.startX = static_cast<std::uint16_t>(src.layout.startX);
+        e.startY = static_cast<std::uint16_t>(src.layout.startY);
+        e.harvestsRequired = static_cast<std::uint32_t>(src.harvestsRequired);
+        e.timeLimitMs = src.timeLimitSeconds < 0.0 ? -1 : static_cast<std::int32_t>(src.timeLimitSeconds * 1000.0 + 0.5);
+        for (const std::string& command : src.allowed) {
+            auto it = std::find(names.begin(), names.end(), command);
+            if (it == names.end())
+                throw std::invalid_argument("level " + std::to_string(src.number) + ": unknown command " + command);
+            e.allowedMask |= 1u << (it - names.begin());
+        }
+        for (const auto& req : src.cropRequirements) {
+            if (req.first == CropKind::Unknown || req.second < 0 || req.second > 0xffff)
+                throw std::invalid_argument("level " + std::to_string(src.number) + ": bad crop requirement");
+            e.cropRequired[static_cast<int>(req.first) - 1] = static_cast<std::uint16_t>(req.second);
+        }
+    }
+
+    LevelPackHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    h.version = LEVEL_PACK_VERSION;
+    h.levelCount = static_cast<std::uint32_t>(levels.size());
+    h.headerSize = sizeof(h);
+    h.indexOffset = sizeof(h);
+    h.stringsOffset = h.indexOffset + levels.size() * sizeof(LevelPackEntry);
+    h.stringsSize = strings.size();
+
+    // tile blocks go after the strings, built through applyLayout so they match a parsed layout
+    std::vector<std::uint8_t> blocks;
+    const std::uint64_t blocksStart = alignUp(h.stringsOffset + h.stringsSize);
+    for (std::size_t i = 0; i < levels.size(); i++) {
+        const Layout& layout = levels[i].layout;
+        Grid grid(layout.width, layout.height, GrowthMode::Scan);
+        applyLayout(layout, grid);
+        const std::vector<CropKind> crops = layoutCrops(layout);
+
+        const std::size_t start = blocks.size();
+        entries[i].tilesOffset = blocksStart + start;
+        for (int timer : grid.growthTimers()) append(blocks, static_cast<std::int32_t>(timer));
+        for (TileType t : grid.types()) blocks.push_back(static_cast<std::uint8_t>(t));
+        for (CropState s : grid.cropStates()) blocks.push_back(static_cast<std::uint8_t>(s));
+        for (std::uint8_t w : grid.walkability()) blocks.push_back(w);
+        for (CropKind k : crops) blocks.push_back(static_cast<std::uint8_t>(k));
+        entries[i].tilesCrc = levelPackCrc32(blocks.data() + start, blocks.size() - start);
+        pad(blocks);
+    }
+
+    std::vector<std::uint8_t> out;
+    out.reserve(static_cast<std::size_t>(blocksStart + blocks.size()));
+    append(out, h);
+    for (const LevelPackEntry& e : entries) append(out, e);
+    out.insert(out.end(), strings.begin(), strings.end());
+    pad(out);
+    out.insert(out.end(), blocks.begin(), blocks.end());
+
+    // checksums last, they cover everything above
+    h.fileSize = out.size();
+    h.indexCrc = levelPackCrc32(out.data() + h.indexOffset, static_cast<std::size_t>(h.stringsOffset + h.stringsSize - h.indexOffset));
+    h.dataCrc = levelPackCrc32(out.data() + sizeof(h), out.size() - sizeof(h));
+    std::memcpy(out.data(), &h, sizeof(h));
+    return out;
+}
+
+void saveLevelPack(const std::vector<LevelSource>& levels, const std::string& path)
+{
+    const std::vector<std::uint8_t> bytes = buildLevelPack(levels);
+    std::ofstream out(path, std::ios::binary);
+    if (!out) throw std::runtime_error("can't write level pack: " + path);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!out) throw std::runtime_error("failed writing level pack: " + path);
+}
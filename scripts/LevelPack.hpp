@@ -0,0 +1,165 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Farmer.hpp"
+#include "Grid.hpp"
+#include "ScriptVM.hpp"
+#include "Simulation.hpp"
+
+// Precompiled levels: pygame/level_pack.py turns the level.py definitions (grid, walls,
+// pre-placed crops, farmer start, objective) into one binary file, and the engine maps it
+// and copies a level's field arrays straight into a Grid, no character parsing on load.
+//
+// Layout, all little-endian, every block 8-byte aligned:
+//   header      64 bytes (LevelPackHeader)
+//   index       64 bytes per level (LevelPackEntry)
+//   strings     names and hints, UTF-8, not terminated
+//   tile blocks per level, n = width * height: int32 timers[n], then uint8 types[n],
+//               states[n], walkable[n] and crop kinds[n]
+// CRC-32 over index + strings (always checked) and over everything after the header (checked
+// with LevelPackCheck::Full), plus one per tile block.
+//
+// Bump LEVEL_PACK_VERSION with any change to the layout, and in level_pack.py with it.
+
+constexpr std::uint32_t LEVEL_PACK_VERSION = 1;
+
+// bit i of a level's allowed mask is levelPackCommandNames()[i], append only
+const std::vector<std::string>& levelPackCommandNames();
+
+struct LevelPackHeader
+{
+    char magic[4];              // "FLVP"
+    std::uint32_t version;
+    std::uint32_t levelCount;
+    std::uint32_t headerSize;   // sizeof(LevelPackHeader)
+    std::uint64_t fileSize;
+    std::uint64_t indexOffset;
+    std::uint64_t stringsOffset;
+    std::uint64_t stringsSize;
+    std::uint32_t indexCrc;     // index + strings
+    std::uint32_t dataCrc;      // everything after the header
+    std::uint64_t reserved;
+};
+static_assert(sizeof(LevelPackHeader) == 64, "level pack header layout changed");
+
+struct LevelPackEntry
+{
+    std::uint32_t number;
+    std::uint32_t nameOffset;   // into the strings block
+    std::uint32_t nameLength;
+    std::uint32_t hintOffset;
+    std::uint32_t hintLength;
+    std::uint16_t width;
+    std::uint16_t height;
+    std::uint16_t startX;
+    std::uint16_t startY;
+    std::uint32_t harvestsRequired;
+    std::int32_t timeLimitMs;   // -1 for none
+    std::uint32_t allowedMask;
+    std::uint16_t cropRequired[4]; // wheat, corn, tomato, carrot (CropKind order), 0 = not required
+    std::uint64_t tilesOffset;
+    std::uint32_t tilesCrc;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(LevelPackEntry) == 64, "level pack entry layout changed");
+
+// one level, pointing into the pack
+struct PackedLevel
+{
+    int number = 0;
+    std::string_view name;
+    std::string_view hint;
+    int width = 0;
+    int height = 0;
+    int startX = 0;
+    int startY = 0;
+    int harvestsRequired = 1;
+    int cropRequired[4] = {}; // per CropKind from Wheat on
+    double timeLimitSeconds = -1.0; // < 0 for none
+    std::uint32_t allowedMask = 0;
+
+    // row-major, width * height each
+    const std::int32_t* timers = nullptr;
+    const TileType* types = nullptr;
+    const CropState* states = nullptr;
+    const std::uint8_t* walkable = nullptr;
+    const CropKind* crops = nullptr;
+
+    // the time limit is in seconds, tickLimit is left for the caller to pick
+    ScriptObjective objective() const;
+    std::vector<std::string> allowedCommands() const;
+};
+
+enum class LevelPackCheck
+{
+    Index, // header, index and strings: opening is O(levels), tile blocks are trusted
+    Full,  // plus a CRC over the whole file and every tile checked, O(file size)
+};
+
+// A mapped pack file (or an in-memory one). Move-only, levels point into it so it has to
+// outlive them. Everything malformed throws std::runtime_error.
+class LevelPack
+{
+    public:
+    static LevelPack open(const std::string& path, LevelPackCheck check = LevelPackCheck::Full);
+    static LevelPack fromBytes(std::vector<std::uint8_t> bytes, LevelPackCheck check = LevelPackCheck::Full);
+
+    LevelPack(LevelPack&& other) noexcept;
+    LevelPack& operator=(LevelPack&& other) noexcept;
+    LevelPack(const LevelPack&) = delete;
+    LevelPack& operator=(const LevelPack&) = delete;
+    ~LevelPack();
+
+    int levelCount() const { return static_cast<int>(count); }
+    // throws std::out_of_range
+    PackedLevel level(int index) const;
+    // index of the level with this number, -1 if there's none
+    int indexOfNumber(int number) const;
+
+    // the level into grid (resized to fit, tick 0) and the farmer onto its start tile. On a pack
+    // opened with LevelPackCheck::Index the tile block is checked first (CRC and byte ranges),
+    // std::runtime_error if it's bad.
+    void loadLevel(int index, Grid& grid, Farmer& farmer) const;
+    // checks one tile block against its CRC, for packs opened with LevelPackCheck::Index
+    bool verifyLevel(int index) const;
+
+    std::size_t sizeBytes() const { return size; }
+    // true when the file is mapped rather than read into memory
+    bool isMapped() const { return mapping != nullptr; }
+
+    private:
+    LevelPack() = default;
+    void validate(LevelPackCheck check);
+    void release();
+    LevelPackEntry entry(int index) const;
+
+    const std::uint8_t* data = nullptr;
+    std::size_t size = 0;
+    std::uint32_t count = 0;
+    bool tilesChecked = false;        // every tile block range-checked by validate (Full)
+    void* mapping = nullptr;          // mmap'd region, null when owned holds the bytes
+    std::vector<std::uint8_t> owned;
+};
+
+// What goes into a pack, for building one from C++ (tools, benches); level_pack.py is the
+// one that compiles level.py.
+struct LevelSource
+{
+    int number = 0;
+    std::string name;
+    std::string hint;
+    Layout layout;
+    int harvestsRequired = 1;
+    std::vector<std::pair<CropKind, int>> cropRequirements;
+    double timeLimitSeconds = -1.0;
+    std::vector<std::string> allowed; // names from levelPackCommandNames()
+};
+
+std::vector<std::uint8_t> buildLevelPack(const std::vector<LevelSource>& levels);
+void saveLevelPack(const std::vector<LevelSource>& levels, const std::string& path);
+
+// CRC-32 (IEEE, same as zlib.crc32), chainable by passing the last result back in
+std::uint32_t levelPackCrc32(const std::uint8_t* data, std::size_t size, std::uint32_t crc = 0);
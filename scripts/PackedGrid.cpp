@@ -0,0 +1,107 @@
+#include "PackedGrid.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "Profiler.hpp"
+#include "WorkerPool.hpp"
+
+// tiles per parallel tick block, 2 bytes each so a block is 128KB, inside a per-core L2
+static constexpr int PACKED_BLOCK_TILES = 64 * 1024;
+
+PackedGrid::PackedGrid(int grid_width, int grid_height)
+    : grid_width(grid_width), grid_height(grid_height), kernel(bestGrowthKernel())
+{
+    if (grid_width <= 0 || grid_height <= 0)
+        throw std::invalid_argument("PackedGrid dimensions must be positive");
+    packed.assign(static_cast<std::size_t>(grid_width) * grid_height,
+                  PackedTile::pack(TileType::EMPTY, CropState::EMPTY, 0));
+}
+
+PackedGrid::PackedGrid(const Grid& grid) : PackedGrid(grid.getGridWidth(), grid.getGridHeight())
+{
+    const GridSpan<TileType> types = grid.types();
+    const GridSpan<CropState> states = grid.cropStates();
+    const GridSpan<int> timers = grid.growthTimers();
+    for (std::size_t i = 0; i < packed.size(); i++) {
+        Tile t;
+        t.type = types[i];
+        t.cropstate = states[i];
+        t.growthTimer = timers[i];
+        if (!PackedTile::fits(t))
+            throw std::out_of_range("growth timer doesn't fit a packed tile");
+        packed[i] = PackedTile::pack(t.type, t.cropstate, t.growthTimer);
+    }
+    tickCount = grid.getTickCount();
+}
+
+Tile PackedGrid::getTile(int x, int y) const
+{
+    if (x < 0 || x >= grid_width || y < 0 || y >= grid_height)
+        throw std::out_of_range("getTile out of range");
+    const std::uint16_t p = packed[index(x, y)];
+    Tile t;
+    t.type = PackedTile::type(p);
+    t.cropstate = PackedTile::state(p);
+    t.growthTimer = PackedTile::timer(p);
+    return t;
+}
+
+void PackedGrid::setTile(int x, int y, const Tile& t)
+{
+    if (x < 0 || x >= grid_width || y < 0 || y >= grid_height)
+        throw std::out_of_range("setTile out of range");
+    if (!PackedTile::fits(t))
+        throw std::out_of_range("growth timer doesn't fit a packed tile");
+    packed[index(x, y)] = PackedTile::pack(t.type, t.cropstate, t.growthTimer);
+}
+
+void PackedGrid::copyTo(Grid& grid) const
+{
+    grid.reset(grid_width, grid_height);
+    for (int y = 0; y < grid_height; y++) {
+        for (int x = 0; x < grid_width; x++) {
+            const std::uint16_t p = packed[index(x, y)];
+            if (p == 0) continue; // reset left it EMPTY already
+            Tile t;
+            t.type = PackedTile::type(p);
+            t.cropstate = PackedTile::state(p);
+            t.growthTimer = PackedTile::timer(p);
+            grid.setTile(x, y, t);
+        }
+    }
+}
+
+void PackedGrid::setKernel(GrowthKernel k)
+{
+    if (!growthKernelSupported(k))
+        throw std::invalid_argument(std::string("growth kernel not supported on this CPU: ") + growthKernelName(k));
+    kernel = k;
+}
+
+void PackedGrid::tick()
+{
+    tickCount++;
+    FARM_PROFILE_COUNT(ProfileCounter::TilesVisited, tileCount());
+    growPackedTiles(kernel, packed.data(), packed.size());
+}
+
+void PackedGrid::tickParallel(WorkerPool& pool)
+{
+    if (pool.getThreadCount() == 1 || packed.size() <= static_cast<std::size_t>(PACKED_BLOCK_TILES)) {
+        tick();
+        return;
+    }
+
+    tickCount++;
+    FARM_PROFILE_COUNT(ProfileCounter::TilesVisited, tileCount());
+
+    // every tile is independent, any split gives the same result. Blocks are a multiple of
+    // 16 tiles so only the last one runs a scalar tail.
+    const std::size_t total = packed.size();
+    const int blocks = static_cast<int>((total + PACKED_BLOCK_TILES - 1) / PACKED_BLOCK_TILES);
+    pool.run(blocks, [this, total](int block) {
+        const std::size_t begin = static_cast<std::size_t>(block) * PACKED_BLOCK_TILES;
+        const std::size_t end = std::min(total, begin + PACKED_BLOCK_TILES);
+        growPackedTiles(kernel, packed.data() + begin, end - begin);
+    });
+}
@@ -0,0 +1,390 @@
+#include "PathPlanner.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include "Profiler.hpp"
+#include "WorkerPool.hpp"
+
+namespace {
+
+// in direction enum order, so ties between equally short moves always break the same way
+constexpr direction DIRECTIONS[4] = { LEFT, UP, DOWN, RIGHT };
+constexpr int DX[4] = { -1, 0, 0, 1 };
+constexpr int DY[4] = { 0, -1, 1, 0 };
+
+// the four walkable neighbours of tile i
+template <typename Fn>
+void forEachNeighbour(const Grid& grid, int i, Fn&& fn)
+{
+    const int w = grid.getGridWidth();
+    const int h = grid.getGridHeight();
+    const GridSpan<std::uint8_t> walkable = grid.walkability();
+    const int x = i % w;
+    const int y = i / w;
+    for (int d = 0; d < 4; d++) {
+        const int nx = x + DX[d];
+        const int ny = y + DY[d];
+        if (nx < 0 || ny < 0 || nx >= w || ny >= h) continue;
+        const int n = ny * w + nx;
+        if (walkable[n]) fn(n, d);
+    }
+}
+
+// walks parent links back from goal and turns them into moves
+std::vector<direction> tracePath(const Grid& grid, const std::vector<int>& parent, int start, int goal)
+{
+    const int w = grid.getGridWidth();
+    std::vector<direction> moves;
+    for (int at = goal; at != start; at = parent[at]) {
+        const int from = parent[at];
+        const int dx = at % w - from % w;
+        const int dy = at / w - from / w;
+        for (int d = 0; d < 4; d++)
+            if (DX[d] == dx && DY[d] == dy) moves.push_back(DIRECTIONS[d]);
+    }
+    std::reverse(moves.begin(), moves.end());
+    return moves;
+}
+
+} // namespace
+
+PathPlanner::PathPlanner(const Grid& grid, std::size_t maxCachedFields)
+    : grid(grid), maxCachedFields(std::max<std::size_t>(1, maxCachedFields)), seenVersion(grid.getWalkabilityVersion())
+{
+}
+
+PathResult PathPlanner::findPath(GridPoint from, GridPoint to, PathSearch search) const
+{
+    FARM_PROFILE_SCOPE("PathPlanner::findPath");
+    PathResult result;
+    if (!inside(from) || !inside(to) || !grid.isWalkable(from.x, from.y) || !grid.isWalkable(to.x, to.y))
+        return result;
+
+    const int start = grid.index(from.x, from.y);
+    const int goal = grid.index(to.x, to.y);
+    if (start == goal) {
+        result.found = true;
+        return result;
+    }
+
+    std::vector<int> parent(static_cast<std::size_t>(grid.tileCount()), -1);
+    std::vector<int> cost(static_cast<std::size_t>(grid.tileCount()), -1);
+    cost[start] = 0;
+
+    if (search == PathSearch::Bfs) {
+        std::vector<int> open;
+        open.push_back(start);
+        for (std::size_t head = 0; head < open.size() && cost[goal] < 0; head++) {
+            const int u = open[head];
+            result.expanded++;
+            forEachNeighbour(grid, u, [&](int n, int) {
+                if (cost[n] >= 0) return;
+                cost[n] = cost[u] + 1;
+                parent[n] = u;
+                open.push_back(n);
+            });
+        }
+    } else {
+        // A* with the manhattan distance, exact on a 4-connected unit grid so the first time
+        // the goal comes off the heap its cost is final. Ties go to the deeper tile, which
+        // keeps the search hugging one route instead of flooding every equal one.
+        const int w = grid.getGridWidth();
+        auto heuristic = [&](int i) { return std::abs(i % w - to.x) + std::abs(i / w - to.y); };
+        using Entry = std::tuple<int, int, int>; // f, -g, tile
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+        open.emplace(heuristic(start), 0, start);
+        while (!open.empty()) {
+            const auto [f, negG, u] = open.top();
+            open.pop();
+            if (-negG != cost[u]) continue; // a stale entry, u was reached cheaper since
+            result.expanded++;
+            if (u == goal) break;
+            forEachNeighbour(grid, u, [&](int n, int) {
+                const int g = cost[u] + 1;
+                if (cost[n] >= 0 && cost[n] <= g) return;
+                cost[n] = g;
+                parent[n] = u;
+                open.emplace(g + heuristic(n), -g, n);
+            });
+        }
+    }
+
+    if (cost[goal] < 0) return result;
+    result.found = true;
+    result.moves = tracePath(grid, parent, start, goal);
+    return result;
+}
+
+void PathPlanner::buildField(int target, std::vector<int>& distance, std::vector<int>& open) const
+{
+    distance.assign(static_cast<std::size_t>(grid.tileCount()), DistanceField::UNREACHABLE);
+    if (!grid.walkability()[target]) return; // nothing reaches a wall
+
+    open.clear();
+    open.push_back(target);
+    distance[target] = 0;
+    for (std::size_t head = 0; head < open.size(); head++) {
+        const int u = open[head];
+        forEachNeighbour(grid, u, [&](int n, int) {
+            if (distance[n] != DistanceField::UNREACHABLE) return;
+            distance[n] = distance[u] + 1;
+            open.push_back(n);
+        });
+    }
+}
+
+void PathPlanner::sync()
+{
+    if (grid.getWalkabilityVersion() == seenVersion) return;
+
+    changes.clear();
+    if (!grid.walkabilityChangesSince(seenVersion, changes)) {
+        // too far behind or the grid was reset, nothing cached can be trusted
+        stats.invalidated += fields.size();
+        clearCache();
+        seenVersion = grid.getWalkabilityVersion();
+        return;
+    }
+    seenVersion = grid.getWalkabilityVersion();
+
+    // only the final state of each tile matters
+    std::sort(changes.begin(), changes.end());
+    changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+    const GridSpan<std::uint8_t> walkable = grid.walkability();
+
+    // walls first: a field that reached a tile now walled off may have routed through it, one
+    // that never reached it is unaffected. Every field left after this is exact for the grid
+    // minus the tiles that opened.
+    for (auto it = fields.begin(); it != fields.end();) {
+        bool stale = false;
+        for (int t : changes) {
+            if (!walkable[t] && (it->target == t || it->distance[t] != DistanceField::UNREACHABLE)) {
+                stale = true;
+                break;
+            }
+        }
+        if (stale) {
+            byTarget.erase(it->target);
+            it = fields.erase(it);
+            stats.invalidated++;
+        } else {
+            ++it;
+        }
+    }
+
+    // then openings, which can only make routes shorter, so they patch in place
+    for (auto it = fields.begin(); it != fields.end();) {
+        bool drop = false;
+        bool changed = false;
+        for (int t : changes) {
+            if (!walkable[t]) continue;
+            if (it->target == t) {
+                // the target was a wall, the field is empty, start over
+                drop = true;
+                break;
+            }
+            const int before = it->distance[t];
+            patchOpened(*it, t);
+            changed |= it->distance[t] != before;
+        }
+        if (drop) {
+            byTarget.erase(it->target);
+            it = fields.erase(it);
+            stats.invalidated++;
+            continue;
+        }
+        if (changed) stats.patched++;
+        ++it;
+    }
+}
+
+void PathPlanner::patchOpened(DistanceField& f, int tile)
+{
+    int best = DistanceField::UNREACHABLE;
+    forEachNeighbour(grid, tile, [&](int n, int) {
+        const int d = f.distance[n];
+        if (d != DistanceField::UNREACHABLE && (best == DistanceField::UNREACHABLE || d + 1 < best)) best = d + 1;
+    });
+    if (best == DistanceField::UNREACHABLE) return; // opened inside a pocket the target can't reach
+    if (f.distance[tile] != DistanceField::UNREACHABLE && f.distance[tile] <= best) return;
+
+    // decrease-only relaxation out of the new tile, touches just the tiles that got closer
+    f.distance[tile] = best;
+    queue.clear();
+    queue.push_back(tile);
+    for (std::size_t head = 0; head < queue.size(); head++) {
+        const int u = queue[head];
+        const int next = f.distance[u] + 1;
+        forEachNeighbour(grid, u, [&](int n, int) {
+            if (f.distance[n] != DistanceField::UNREACHABLE && f.distance[n] <= next) return;
+            f.distance[n] = next;
+            queue.push_back(n);
+        });
+    }
+}
+
+DistanceField& PathPlanner::insertField(DistanceField&& f)
+{
+    const int target = f.target;
+    auto existing = byTarget.find(target);
+    if (existing != byTarget.end()) {
+        fields.erase(existing->second);
+        byTarget.erase(existing);
+    }
+    fields.push_front(std::move(f));
+    byTarget[target] = fields.begin();
+    while (fields.size() > maxCachedFields) {
+        byTarget.erase(fields.back().target);
+        fields.pop_back();
+    }
+    return fields.front();
+}
+
+const DistanceField& PathPlanner::field(GridPoint target)
+{
+    if (!inside(target)) throw std::out_of_range("PathPlanner target off the grid");
+    sync();
+
+    const int t = grid.index(target.x, target.y);
+    auto it = byTarget.find(t);
+    if (it != byTarget.end()) {
+        stats.hits++;
+        fields.splice(fields.begin(), fields, it->second);
+        return fields.front();
+    }
+
+    FARM_PROFILE_SCOPE("PathPlanner::buildField");
+    DistanceField f;
+    f.target = t;
+    buildField(t, f.distance, queue);
+    stats.built++;
+    return insertField(std::move(f));
+}
+
+int PathPlanner::distance(GridPoint from, GridPoint to)
+{
+    if (!inside(from)) throw std::out_of_range("PathPlanner start off the grid");
+    return field(to).distance[grid.index(from.x, from.y)];
+}
+
+bool PathPlanner::nextStep(GridPoint from, GridPoint target, direction& out)
+{
+    if (!inside(from)) throw std::out_of_range("PathPlanner start off the grid");
+    const DistanceField& f = field(target);
+    const int d = f.distance[grid.index(from.x, from.y)];
+    if (d == DistanceField::UNREACHABLE || d == 0) return false;
+
+    // any neighbour one closer is on a shortest route
+    for (int k = 0; k < 4; k++) {
+        const int nx = from.x + DX[k];
+        const int ny = from.y + DY[k];
+        if (nx < 0 || ny < 0 || nx >= grid.getGridWidth() || ny >= grid.getGridHeight()) continue;
+        if (f.distance[grid.index(nx, ny)] == d - 1) {
+            out = DIRECTIONS[k];
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<direction> PathPlanner::route(GridPoint from, GridPoint target)
+{
+    std::vector<direction> moves;
+    if (!inside(from)) throw std::out_of_range("PathPlanner start off the grid");
+    const DistanceField& f = field(target);
+    int d = f.distance[grid.index(from.x, from.y)];
+    if (d == DistanceField::UNREACHABLE) return moves;
+
+    moves.reserve(static_cast<std::size_t>(d));
+    GridPoint at = from;
+    while (d > 0) {
+        for (int k = 0; k < 4; k++) {
+            const GridPoint n{ at.x + DX[k], at.y + DY[k] };
+            if (!inside(n) || f.distance[grid.index(n.x, n.y)] != d - 1) continue;
+            moves.push_back(DIRECTIONS[k]);
+            at = n;
+            break;
+        }
+        d--;
+    }
+    return moves;
+}
+
+void PathPlanner::prepare(const std::vector<GridPoint>& targets, WorkerPool& pool)
+{
+    FARM_PROFILE_SCOPE("PathPlanner::prepare");
+    sync();
+
+    std::vector<int> missing;
+    for (const GridPoint& p : targets) {
+        if (!inside(p)) throw std::out_of_range("PathPlanner target off the grid");
+        const int t = grid.index(p.x, p.y);
+        if (byTarget.count(t) || std::find(missing.begin(), missing.end(), t) != missing.end()) continue;
+        missing.push_back(t);
+    }
+    // no point building more than the cache keeps
+    if (missing.size() > maxCachedFields) missing.resize(maxCachedFields);
+    if (missing.empty()) return;
+
+    std::vector<DistanceField> built(missing.size());
+    const int chunks = std::min<int>(pool.getThreadCount(), static_cast<int>(missing.size()));
+    pool.run(chunks, [&](int chunk) {
+        std::vector<int> scratch;
+        for (std::size_t k = static_cast<std::size_t>(chunk); k < missing.size(); k += chunks) {
+            built[k].target = missing[k];
+            buildField(missing[k], built[k].distance, scratch);
+        }
+    });
+    stats.built += built.size();
+    for (DistanceField& f : built) insertField(std::move(f));
+}
+
+std::vector<int> PathPlanner::distanceMatrix(const std::vector<GridPoint>& points, WorkerPool& pool)
+{
+    FARM_PROFILE_SCOPE("PathPlanner::distanceMatrix");
+    sync();
+
+    const std::size_t n = points.size();
+    std::vector<int> tiles(n);
+    for (std::size_t i = 0; i < n; i++) {
+        if (!inside(points[i])) throw std::out_of_range("PathPlanner point off the grid");
+        tiles[i] = grid.index(points[i].x, points[i].y);
+    }
+
+    // rows of points that already have a field come straight out of the cache
+    std::vector<int> matrix(n * n, DistanceField::UNREACHABLE);
+    std::vector<std::size_t> missing;
+    for (std::size_t i = 0; i < n; i++) {
+        auto it = byTarget.find(tiles[i]);
+        if (it == byTarget.end()) {
+            missing.push_back(i);
+            continue;
+        }
+        stats.hits++;
+        for (std::size_t j = 0; j < n; j++) matrix[i * n + j] = it->second->distance[tiles[j]];
+    }
+    if (missing.empty()) return matrix;
+
+    // the rest get a BFS each into a per-chunk scratch field that's dropped afterwards
+    const int chunks = std::min<int>(pool.getThreadCount(), static_cast<int>(missing.size()));
+    pool.run(chunks, [&](int chunk) {
+        std::vector<int> distance;
+        std::vector<int> scratch;
+        for (std::size_t k = static_cast<std::size_t>(chunk); k < missing.size(); k += chunks) {
+            const std::size_t i = missing[k];
+            buildField(tiles[i], distance, scratch);
+            for (std::size_t j = 0; j < n; j++) matrix[i * n + j] = distance[tiles[j]];
+        }
+    });
+    stats.built += missing.size();
+    return matrix;
+}
+
+void PathPlanner::clearCache()
+{
+    fields.clear();
+    byTarget.clear();
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "Farmer.hpp"
+#include "Grid.hpp"
+
+class WorkerPool;
+
+// Shortest routes over a Grid's walkable tiles, 4-connected, one move per step like Farmer.
+//
+// Single queries run BFS or A* from scratch. Anything asked about the same target again goes
+// through a distance field (flow field): the move count from every tile to that target,
+// built once by a BFS out of the target and cached (LRU). Following a field costs O(1) per
+// step. Fields follow the grid's walkability edits: a tile opening up is patched into every
+// cached field in place, a tile closing drops only the fields that could reach it.
+struct GridPoint
+{
+    int x = 0;
+    int y = 0;
+};
+
+enum class PathSearch { Bfs, AStar };
+
+struct PathResult
+{
+    bool found = false;
+    std::vector<direction> moves; // empty when found and start == goal
+    int expanded = 0;             // tiles taken off the open list, for comparing searches
+};
+
+// moves from every tile to one target, UNREACHABLE for walls and tiles cut off from it
+struct DistanceField
+{
+    static constexpr int UNREACHABLE = -1;
+    int target = 0; // tile index
+    std::vector<int> distance;
+};
+
+struct PathPlannerStats
+{
+    std::uint64_t hits = 0;        // field() answered from the cache
+    std::uint64_t built = 0;       // fields built from scratch
+    std::uint64_t patched = 0;     // cached fields updated in place for tiles opening up
+    std::uint64_t invalidated = 0; // cached fields dropped for walls appearing (or a reset)
+};
+
+class PathPlanner
+{
+    public:
+    // keeps at most maxCachedFields fields, 4 bytes a tile each
+    explicit PathPlanner(const Grid& grid, std::size_t maxCachedFields = 64);
+
+    // from scratch, doesn't touch the cache. A start or goal on a wall or off the grid is
+    // never found.
+    PathResult findPath(GridPoint from, GridPoint to, PathSearch search = PathSearch::AStar) const;
+
+    // the cached field for target, built if missing. The reference is good until the next
+    // call on the planner.
+    const DistanceField& field(GridPoint target);
+
+    // moves from -> to, DistanceField::UNREACHABLE if there's no route (served from to's field)
+    int distance(GridPoint from, GridPoint to);
+    // first move of a shortest route from -> target, false if there's none or from is target
+    bool nextStep(GridPoint from, GridPoint target, direction& out);
+    // the whole route by following target's field, empty if unreachable
+    std::vector<direction> route(GridPoint from, GridPoint target);
+
+    // builds the fields of all these targets across the pool and caches as many as fit
+    void prepare(const std::vector<GridPoint>& targets, WorkerPool& pool);
+
+    // moves between every pair of points, row-major points.size() squared, UNREACHABLE where
+    // there's no route. One BFS per point spread over the pool, cached fields are reused and
+    // the rest aren't kept, so a thousand crops don't need a thousand fields in memory.
+    std::vector<int> distanceMatrix(const std::vector<GridPoint>& points, WorkerPool& pool);
+
+    const PathPlannerStats& getStats() const { return stats; }
+    std::size_t cachedFieldCount() const { return fields.size(); }
+    void clearCache();
+
+    private:
+    bool inside(GridPoint p) const
+    {
+        return p.x >= 0 && p.y >= 0 && p.x < grid.getGridWidth() && p.y < grid.getGridHeight();
+    }
+
+    // BFS out of target into distance (resized to the grid), queue is scratch
+    void buildField(int target, std::vector<int>& distance, std::vector<int>& queue) const;
+    // catches up with walkability edits made since the last call
+    void sync();
+    // relaxes distances outward from a tile that just became walkable
+    void patchOpened(DistanceField& f, int tile);
+    DistanceField& insertField(DistanceField&& f);
+
+    const Grid& grid;
+    std::size_t maxCachedFields;
+    std::uint64_t seenVersion;
+
+    // most recently used at the front
+    std::list<DistanceField> fields;
+    std::unordered_map<int, std::list<DistanceField>::iterator> byTarget;
+
+    std::vector<int> queue;   // BFS scratch
+    std::vector<int> changes; // walkability edits scratch
+    PathPlannerStats stats;
+};
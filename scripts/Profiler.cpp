@@ -0,0 +1,273 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+const char* profileCounterName(ProfileCounter counter)
+{
+    switch (counter) {
+    case ProfileCounter::TilesVisited: return "tiles visited";
+    case ProfileCounter::VerticesEmitted: return "vertices emitted";
+    case ProfileCounter::BytesUploaded: return "bytes uploaded";
+    case ProfileCounter::DrawCalls: return "draw calls";
+    default: return "?";
+    }
+}
+
+const char* profileStatName(ProfileStat stat)
+{
+    switch (stat) {
+    case ProfileStat::Frame: return "frame";
+    case ProfileStat::Tick: return "tick";
+    case ProfileStat::Gpu: return "gpu";
+    default: return "?";
+    }
+}
+
+RollingSamples::RollingSamples(std::size_t capacity) : samples(std::max<std::size_t>(1, capacity))
+{
+}
+
+void RollingSamples::add(double ms)
+{
+    samples[next] = ms;
+    next = (next + 1) % samples.size();
+    count = std::min(count + 1, samples.size());
+}
+
+double RollingSamples::percentile(double p) const
+{
+    if (count == 0) return 0.0;
+    // nearest rank, so p99 of a full window is the 3rd slowest of 240
+    scratch.assign(samples.begin(), samples.begin() + count);
+    const double rank = std::ceil(std::clamp(p, 0.0, 1.0) * count);
+    const std::size_t k = rank < 1.0 ? 0 : static_cast<std::size_t>(rank) - 1;
+    std::nth_element(scratch.begin(), scratch.begin() + k, scratch.end());
+    return scratch[k];
+}
+
+Profiler& Profiler::instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler() : started(std::chrono::steady_clock::now())
+{
+}
+
+double Profiler::now() const
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+}
+
+Profiler::ThreadBuffer& Profiler::localBuffer()
+{
+    // hands the buffer back when the thread exits
+    struct Lease
+    {
+        ThreadBuffer* buffer = nullptr;
+        ~Lease()
+        {
+            if (!buffer) return;
+            Profiler& p = Profiler::instance();
+            std::lock_guard<std::mutex> lock(p.buffersMutex);
+            buffer->inUse = false;
+        }
+    };
+    thread_local Lease mine;
+    if (!mine.buffer) {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        // an exited thread's buffer if there is one: its counters go on growing from where they
+        // are, so endFrame's deltas still add up, and its events stay in the trace
+        ThreadBuffer* free = nullptr;
+        int id = 1;
+        for (const auto& b : buffers) {
+            if (b->id >= FIRST_VIRTUAL_THREAD) continue;
+            if (!b->inUse && !free) free = b.get();
+            id = std::max(id, b->id + 1);
+        }
+        if (!free) {
+            buffers.push_back(std::make_unique<ThreadBuffer>());
+            free = buffers.back().get();
+            free->id = id;
+        }
+        std::lock_guard<std::mutex> bufferLock(free->mutex);
+        free->inUse = true;
+        free->name = "thread " + std::to_string(free->id);
+        mine.buffer = free;
+    }
+    return *mine.buffer;
+}
+
+Profiler::ThreadBuffer& Profiler::bufferFor(int thread)
+{
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (const auto& b : buffers)
+        if (b->id == thread) return *b;
+    buffers.push_back(std::make_unique<ThreadBuffer>());
+    buffers.back()->id = thread;
+    buffers.back()->name = "track " + std::to_string(thread);
+    return *buffers.back();
+}
+
+void Profiler::setThreadName(const char* name)
+{
+    ThreadBuffer& b = localBuffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    b.name = name;
+}
+
+void Profiler::nameVirtualThread(int thread, const char* name)
+{
+    if (thread < FIRST_VIRTUAL_THREAD)
+        throw std::invalid_argument("virtual thread ids start at FIRST_VIRTUAL_THREAD");
+    ThreadBuffer& b = bufferFor(thread);
+    std::lock_guard<std::mutex> lock(b.mutex);
+    b.name = name;
+}
+
+void Profiler::addSample(ProfileStat stat, double ms)
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    stats[static_cast<int>(stat)].add(ms);
+}
+
+double Profiler::percentile(ProfileStat stat, double p) const
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats[static_cast<int>(stat)].percentile(p);
+}
+
+std::size_t Profiler::sampleCount(ProfileStat stat) const
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats[static_cast<int>(stat)].size();
+}
+
+void Profiler::append(ThreadBuffer& buffer, const TraceEvent& e)
+{
+    // over the cap the capture just ends, what's already in stays consistent
+    if (capturedCount.fetch_add(1, std::memory_order_relaxed) >= maxCaptureEvents) {
+        capturedCount.fetch_sub(1, std::memory_order_relaxed);
+        capturing.store(false, std::memory_order_relaxed);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back(e);
+}
+
+void Profiler::record(const char* name, double start, double end)
+{
+    if (!capturing.load(std::memory_order_relaxed)) return;
+    ThreadBuffer& b = localBuffer();
+    append(b, TraceEvent{ name, start, end - start, b.id });
+}
+
+void Profiler::recordOn(int thread, const char* name, double start, double duration)
+{
+    if (!capturing.load(std::memory_order_relaxed)) return;
+    append(bufferFor(thread), TraceEvent{ name, start, duration, thread });
+}
+
+void Profiler::endFrame()
+{
+    const double t = now();
+    if (lastFrameEnd >= 0.0) addSample(ProfileStat::Frame, (t - lastFrameEnd) / 1000.0);
+    lastFrameEnd = t;
+
+    lastFrame.end = t;
+    lastFrame.values.fill(0);
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    // each thread's totals only grow, the frame gets what they grew by since the last one
+    for (const auto& b : buffers) {
+        for (std::size_t c = 0; c < lastFrame.values.size(); c++) {
+            const std::int64_t total = b->counters[c].load(std::memory_order_relaxed);
+            lastFrame.values[c] += total - b->reported[c];
+            b->reported[c] = total;
+        }
+    }
+    if (capturing.load(std::memory_order_relaxed)) capturedFrames.push_back(lastFrame);
+}
+
+void Profiler::startCapture()
+{
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (const auto& b : buffers) {
+            std::lock_guard<std::mutex> bufferLock(b->mutex);
+            b->events.clear();
+        }
+        capturedFrames.clear();
+    }
+    capturedCount.store(0, std::memory_order_relaxed);
+    capturing.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::stopCapture()
+{
+    capturing.store(false, std::memory_order_relaxed);
+}
+
+// event names are our own literals, but keep the JSON valid whatever they hold
+static void writeJsonString(std::FILE* f, const std::string& s)
+{
+    std::fputc('"', f);
+    for (char c : s) {
+        if (c == '"' || c == '\\') std::fputc('\\', f);
+        if (static_cast<unsigned char>(c) < 0x20) c = ' ';
+        std::fputc(c, f);
+    }
+    std::fputc('"', f);
+}
+
+std::size_t Profiler::writeChromeTrace(const std::string& path) const
+{
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) throw std::runtime_error("can't write trace file " + path);
+
+    std::size_t written = 0;
+    bool first = true;
+    auto separator = [&] {
+        std::fputs(first ? "\n" : ",\n", f);
+        first = false;
+    };
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", f);
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (const auto& b : buffers) {
+            std::lock_guard<std::mutex> bufferLock(b->mutex);
+            separator();
+            std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", b->id);
+            writeJsonString(f, b->name);
+            std::fputs("}}", f);
+            for (const TraceEvent& e : b->events) {
+                separator();
+                std::fputs("{\"name\":", f);
+                writeJsonString(f, e.name);
+                std::fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                             e.thread, e.start, e.duration);
+                written++;
+            }
+        }
+
+        // counters show up as their own graphs above the threads
+        for (const FrameCounters& fc : capturedFrames) {
+            for (std::size_t c = 0; c < fc.values.size(); c++) {
+                separator();
+                std::fputs("{\"name\":", f);
+                writeJsonString(f, profileCounterName(static_cast<ProfileCounter>(c)));
+                std::fprintf(f, ",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+                             fc.end, static_cast<long long>(fc.values[c]));
+                written++;
+            }
+        }
+    }
+    std::fputs("\n]}\n", f);
+
+    const bool failed = std::ferror(f) != 0;
+    if (std::fclose(f) != 0 || failed) throw std::runtime_error("error writing trace file " + path);
+    return written;
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scoped timers and per-frame counters for finding out where a frame goes.
+// Build with FARM_PROFILING=0 (cmake -DAUTOMATED_FARMER_PROFILING=OFF) and the FARM_PROFILE_*
+// macros compile to nothing. The Profiler itself stays so callers don't need #ifs, it just
+// never gets fed.
+#ifndef FARM_PROFILING
+#define FARM_PROFILING 1
+#endif
+
+// things counted per frame, summed over every thread
+enum class ProfileCounter
+{
+    TilesVisited,    // tiles a Grid::tick looked at
+    VerticesEmitted, // vertices the draw calls asked for
+    BytesUploaded,   // buffer + texture bytes sent to the GPU
+    DrawCalls,
+    Count,
+};
+
+// timings kept in a rolling window for the p50/p99 readout
+enum class ProfileStat
+{
+    Frame, // start of one frame to the start of the next
+    Tick,  // one simulation step
+    Gpu,   // GPU time of a frame, from timer queries
+    Count,
+};
+
+const char* profileCounterName(ProfileCounter counter);
+const char* profileStatName(ProfileStat stat);
+
+// the last `capacity` samples of something, in milliseconds
+class RollingSamples
+{
+    public:
+    explicit RollingSamples(std::size_t capacity = 240);
+
+    void add(double ms);
+    std::size_t size() const { return count; }
+    // p in [0, 1], 0 when there's nothing yet
+    double percentile(double p) const;
+
+    private:
+    std::vector<double> samples;
+    std::size_t next = 0;
+    std::size_t count = 0;
+    mutable std::vector<double> scratch;
+};
+
+// one finished scope, times in microseconds since the profiler started
+struct TraceEvent
+{
+    const char* name; // has to be a string literal, it's kept by pointer
+    double start;
+    double duration;
+    int thread;
+};
+
+// counter totals of one frame, stamped at the end of the frame
+struct FrameCounters
+{
+    double end = 0.0; // microseconds
+    std::array<std::int64_t, static_cast<int>(ProfileCounter::Count)> values{};
+};
+
+// Process-wide. Scopes can finish on any thread, counters can be bumped from any thread and
+// are summed over all of them at endFrame.
+// Trace events are only kept while a capture runs, and at most maxCaptureEvents of them
+// (one simulation step is an event, fast-forward makes a lot of those).
+class Profiler
+{
+    public:
+    static Profiler& instance();
+
+    // false in a FARM_PROFILING=0 build
+    static bool compiledIn() { return FARM_PROFILING != 0; }
+
+    // microseconds since the profiler started, the time base of every event
+    double now() const;
+
+    // names the calling thread in traces
+    void setThreadName(const char* name);
+
+    // adds to the calling thread's own totals: only that thread writes them, so it's a plain
+    // load and store on a line nobody else writes, however hot the caller (Grid::tick)
+    void count(ProfileCounter counter, std::int64_t n)
+    {
+        thread_local CounterTotals* mine = nullptr;
+        if (!mine) mine = &localBuffer().counters;
+        std::atomic<std::int64_t>& total = (*mine)[static_cast<int>(counter)];
+        total.store(total.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    void addSample(ProfileStat stat, double ms);
+
+    // called by ScopedTimer, start/end from now()
+    void record(const char* name, double start, double end);
+    // an event for a thread of our own making, e.g. the GPU track
+    void recordOn(int thread, const char* name, double start, double duration);
+
+    // call once per frame from the render thread: closes the frame's counters and time
+    void endFrame();
+    const FrameCounters& getLastFrameCounters() const { return lastFrame; }
+    // p50/p99 style readouts of a stat, thread safe
+    double percentile(ProfileStat stat, double p) const;
+    std::size_t sampleCount(ProfileStat stat) const;
+
+    // trace capture: start drops whatever the last capture held
+    void startCapture();
+    void stopCapture();
+    bool isCapturing() const { return capturing.load(std::memory_order_relaxed); }
+    std::size_t capturedEvents() const { return capturedCount.load(std::memory_order_relaxed); }
+    void setMaxCaptureEvents(std::size_t n) { maxCaptureEvents = n; }
+
+    // writes the last capture as Chrome trace-event JSON (chrome://tracing, Perfetto, speedscope).
+    // Returns the number of events written, throws std::runtime_error if the file can't be written.
+    std::size_t writeChromeTrace(const std::string& path) const;
+
+    // thread ids below this are handed to real threads, recordOn tracks go above
+    static const int FIRST_VIRTUAL_THREAD = 1000;
+    void nameVirtualThread(int thread, const char* name);
+
+    private:
+    Profiler();
+
+    using CounterTotals = std::array<std::atomic<std::int64_t>, static_cast<int>(ProfileCounter::Count)>;
+
+    struct ThreadBuffer
+    {
+        int id = 0;
+        bool inUse = false; // a live thread owns it (under buffersMutex)
+        std::string name;
+        std::mutex mutex;
+        std::vector<TraceEvent> events;
+        // running totals of the thread's count() calls, and how much of them endFrame has
+        // already handed out (under buffersMutex)
+        alignas(64) CounterTotals counters{};
+        std::array<std::int64_t, static_cast<int>(ProfileCounter::Count)> reported{};
+    };
+
+    ThreadBuffer& localBuffer();
+    ThreadBuffer& bufferFor(int thread);
+    void append(ThreadBuffer& buffer, const TraceEvent& e);
+
+    const std::chrono::steady_clock::time_point started;
+
+    FrameCounters lastFrame;
+    double lastFrameEnd = -1.0;
+
+    mutable std::mutex statsMutex;
+    std::array<RollingSamples, static_cast<int>(ProfileStat::Count)> stats;
+
+    std::atomic<bool> capturing{ false };
+    std::atomic<std::size_t> capturedCount{ 0 };
+    std::size_t maxCaptureEvents = 1 << 20;
+
+    // buffers live as long as the profiler, threads only keep a pointer to theirs. A thread's
+    // buffer goes to the next new thread after it exits, so there are only ever as many as
+    // threads alive at once.
+    mutable std::mutex buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::vector<FrameCounters> capturedFrames;
+};
+
+// times its own lifetime into the profiler, and into a rolling stat if given one
+class ScopedTimer
+{
+    public:
+    explicit ScopedTimer(const char* name, ProfileStat stat = ProfileStat::Count)
+        : name(name), stat(stat), start(Profiler::instance().now())
+    {
+    }
+    ~ScopedTimer()
+    {
+        Profiler& p = Profiler::instance();
+        const double end = p.now();
+        p.record(name, start, end);
+        if (stat != ProfileStat::Count) p.addSample(stat, (end - start) / 1000.0);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+    const char* name;
+    ProfileStat stat;
+    double start;
+};
+
+#define FARM_PROFILE_CONCAT_INNER(a, b) a##b
+#define FARM_PROFILE_CONCAT(a, b) FARM_PROFILE_CONCAT_INNER(a, b)
+
+#if FARM_PROFILING
+// times the rest of the enclosing block, `name` must be a string literal
+#define FARM_PROFILE_SCOPE(name) ScopedTimer FARM_PROFILE_CONCAT(profileScope_, __LINE__)(name)
+// same, and feeds the duration to a rolling ProfileStat
+#define FARM_PROFILE_SCOPE_STAT(name, stat) ScopedTimer FARM_PROFILE_CONCAT(profileScope_, __LINE__)(name, stat)
+#define FARM_PROFILE_COUNT(counter, n) Profiler::instance().count(counter, n)
+#else
+#define FARM_PROFILE_SCOPE(name) ((void)0)
+#define FARM_PROFILE_SCOPE_STAT(name, stat) ((void)0)
+#define FARM_PROFILE_COUNT(counter, n) ((void)0)
+#endif
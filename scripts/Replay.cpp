@@ -0,0 +1,603 @@
+#include "Replay.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::uint32_t REPLAY_FORMAT_VERSION = 2;
+constexpr char REPLAY_MAGIC[4] = { 'F', 'R', 'P', 'L' };
+constexpr int ACTION_BITS = 3;
+constexpr std::uint64_t ACTION_MASK = (1u << ACTION_BITS) - 1;
+
+void putVarint(std::vector<std::uint8_t>& out, std::uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+// zigzag so small negatives stay small
+void putSigned(std::vector<std::uint8_t>& out, std::int64_t v)
+{
+    putVarint(out, (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63));
+}
+
+// false on a truncated or over-long varint
+bool getVarint(const std::vector<std::uint8_t>& in, std::size_t& pos, std::uint64_t& out)
+{
+    out = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= in.size()) return false;
+        const std::uint8_t b = in[pos++];
+        out |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// reads the file format, every problem is a runtime_error
+struct Reader
+{
+    const std::vector<std::uint8_t>& in;
+    std::size_t pos = 0;
+
+    std::uint64_t varint()
+    {
+        std::uint64_t v;
+        if (!getVarint(in, pos, v)) fail("truncated");
+        return v;
+    }
+    std::int64_t signedVarint()
+    {
+        const std::uint64_t v = varint();
+        return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+    }
+    // a count or index below limit
+    int index(std::uint64_t limit)
+    {
+        const std::uint64_t v = varint();
+        if (v >= limit) fail("value out of range");
+        return static_cast<int>(v);
+    }
+    std::uint8_t byte()
+    {
+        if (pos >= in.size()) fail("truncated");
+        return in[pos++];
+    }
+    [[noreturn]] static void fail(const std::string& what)
+    {
+        throw std::runtime_error("bad replay file: " + what);
+    }
+};
+
+bool sameTile(const Tile& a, const Tile& b)
+{
+    return a.type == b.type && a.cropstate == b.cropstate && a.growthTimer == b.growthTimer
+        && a.replantCooldown == b.replantCooldown;
+}
+
+bool sameTiles(const std::vector<Tile>& a, const std::vector<Tile>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), sameTile);
+}
+
+// the newest version of a chunk at or before a checkpoint, there's always one from checkpoint 0
+const ReplayChunkVersion& versionAt(const Replay& replay, int chunk, int checkpoint)
+{
+    const std::vector<ReplayChunkVersion>& versions = replay.chunks[chunk];
+    auto it = std::upper_bound(versions.begin(), versions.end(), checkpoint,
+                               [](int c, const ReplayChunkVersion& v) { return c < v.checkpoint; });
+    return *(it - 1);
+}
+
+int chunkBegin(int chunk) { return chunk * REPLAY_CHUNK_TILES; }
+int chunkEnd(const Replay& replay, int chunk)
+{
+    return std::min(chunkBegin(chunk) + REPLAY_CHUNK_TILES, replay.width * replay.height);
+}
+
+std::uint8_t actionCode(CommandType type, direction dir)
+{
+    switch (type) {
+    case CommandType::Move:    return static_cast<std::uint8_t>(dir);
+    case CommandType::Plant:   return static_cast<std::uint8_t>(ReplayAction::Plant);
+    case CommandType::Harvest: return static_cast<std::uint8_t>(ReplayAction::Harvest);
+    case CommandType::Remove:  return static_cast<std::uint8_t>(ReplayAction::Remove);
+    case CommandType::Wait:    break;
+    }
+    throw std::invalid_argument("waits aren't logged");
+}
+
+} // namespace
+
+std::size_t Replay::storageBytes() const
+{
+    std::size_t bytes = sizeof(Replay) + walkable.size() + log.size();
+    for (const ReplayCheckpoint& cp : checkpoints)
+        bytes += sizeof(cp) + (cp.changedChunks.size() + cp.growingChunks.size()) * sizeof(int);
+    for (const std::vector<ReplayChunkVersion>& versions : chunks) {
+        bytes += sizeof(versions);
+        for (const ReplayChunkVersion& v : versions) bytes += sizeof(v) + v.tiles.size() * sizeof(Tile);
+    }
+    return bytes;
+}
+
+void writeReplay(const Replay& replay, std::ostream& out)
+{
+    std::vector<std::uint8_t> bytes(std::begin(REPLAY_MAGIC), std::end(REPLAY_MAGIC));
+    putVarint(bytes, REPLAY_FORMAT_VERSION);
+    putVarint(bytes, static_cast<std::uint64_t>(replay.width));
+    putVarint(bytes, static_cast<std::uint64_t>(replay.height));
+    putVarint(bytes, static_cast<std::uint64_t>(replay.interval));
+    putSigned(bytes, replay.startTick);
+    putSigned(bytes, replay.endTick);
+    for (int b = 0; b < 8; b++) bytes.push_back(static_cast<std::uint8_t>(replay.finalHash >> (b * 8)));
+    putVarint(bytes, static_cast<std::uint64_t>(replay.actionCount));
+
+    // walls as alternating run lengths, walkable first
+    std::uint8_t current = 1;
+    std::uint64_t run = 0;
+    for (std::uint8_t w : replay.walkable) {
+        if ((w != 0) != (current != 0)) {
+            putVarint(bytes, run);
+            current ^= 1;
+            run = 0;
+        }
+        run++;
+    }
+    putVarint(bytes, run);
+
+    putVarint(bytes, replay.log.size());
+    bytes.insert(bytes.end(), replay.log.begin(), replay.log.end());
+
+    putVarint(bytes, replay.checkpoints.size());
+    for (const ReplayCheckpoint& cp : replay.checkpoints) {
+        putSigned(bytes, cp.tick);
+        putVarint(bytes, static_cast<std::uint64_t>(cp.farmerX));
+        putVarint(bytes, static_cast<std::uint64_t>(cp.farmerY));
+        putVarint(bytes, static_cast<std::uint64_t>(cp.harvests));
+        putVarint(bytes, cp.logOffset);
+        putSigned(bytes, cp.logTick);
+        putVarint(bytes, cp.changedChunks.size());
+        for (int c : cp.changedChunks) putVarint(bytes, static_cast<std::uint64_t>(c));
+        putVarint(bytes, cp.growingChunks.size());
+        for (int c : cp.growingChunks) putVarint(bytes, static_cast<std::uint64_t>(c));
+    }
+
+    for (const std::vector<ReplayChunkVersion>& versions : replay.chunks) {
+        putVarint(bytes, versions.size());
+        for (const ReplayChunkVersion& v : versions) {
+            putVarint(bytes, static_cast<std::uint64_t>(v.checkpoint));
+            for (const Tile& t : v.tiles) {
+                bytes.push_back(static_cast<std::uint8_t>(t.type));
+                bytes.push_back(static_cast<std::uint8_t>(t.cropstate));
+                bytes.push_back(static_cast<std::uint8_t>(t.replantCooldown));
+                putSigned(bytes, t.growthTimer);
+            }
+        }
+    }
+
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    if (!out) throw std::runtime_error("failed writing replay");
+}
+
+Replay readReplay(std::istream& in)
+{
+    const std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    Reader r{ bytes };
+    for (char c : REPLAY_MAGIC)
+        if (r.byte() != static_cast<std::uint8_t>(c)) Reader::fail("not a replay");
+    if (r.varint() != REPLAY_FORMAT_VERSION) Reader::fail("unsupported version");
+
+    Replay replay;
+    replay.width = r.index(1u << 16);
+    replay.height = r.index(1u << 16);
+    if (replay.width == 0 || replay.height == 0 || static_cast<std::int64_t>(replay.width) * replay.height > (1 << 26))
+        Reader::fail("bad grid size");
+    replay.interval = r.index(static_cast<std::uint64_t>(std::numeric_limits<int>::max()));
+    replay.startTick = r.signedVarint();
+    replay.endTick = r.signedVarint();
+    if (replay.interval == 0 || replay.startTick < 0 || replay.endTick < replay.startTick)
+        Reader::fail("bad ticks");
+    for (int b = 0; b < 8; b++) replay.finalHash |= static_cast<std::uint64_t>(r.byte()) << (b * 8);
+    replay.actionCount = static_cast<std::int64_t>(r.varint());
+
+    const std::size_t tiles = static_cast<std::size_t>(replay.width) * replay.height;
+    replay.walkable.reserve(tiles);
+    for (std::uint8_t current = 1; replay.walkable.size() < tiles; current ^= 1) {
+        const std::uint64_t run = r.varint();
+        if (run > tiles - replay.walkable.size()) Reader::fail("walls overrun the grid");
+        replay.walkable.insert(replay.walkable.end(), static_cast<std::size_t>(run), current);
+    }
+
+    const std::uint64_t logSize = r.varint();
+    if (logSize > bytes.size() - r.pos) Reader::fail("truncated");
+    replay.log.assign(bytes.begin() + static_cast<std::ptrdiff_t>(r.pos),
+                      bytes.begin() + static_cast<std::ptrdiff_t>(r.pos + logSize));
+    r.pos += static_cast<std::size_t>(logSize);
+
+    const int chunkCount = replay.chunkCount();
+    // the recorder checkpoints at startTick and every interval ticks after it, and a seek only
+    // replays at most one interval on that promise. Spaced any other way, the file is damaged.
+    const int checkpointCount = r.index(bytes.size());
+    if (checkpointCount == 0) Reader::fail("no checkpoints");
+    if (checkpointCount - 1 != (replay.endTick - replay.startTick) / replay.interval)
+        Reader::fail("wrong number of checkpoints");
+    replay.checkpoints.resize(static_cast<std::size_t>(checkpointCount));
+    for (int k = 0; k < checkpointCount; k++) {
+        ReplayCheckpoint& cp = replay.checkpoints[k];
+        cp.tick = r.signedVarint();
+        if (cp.tick != replay.startTick + static_cast<std::int64_t>(k) * replay.interval)
+            Reader::fail("bad checkpoint tick");
+        cp.farmerX = r.index(static_cast<std::uint64_t>(replay.width));
+        cp.farmerY = r.index(static_cast<std::uint64_t>(replay.height));
+        cp.harvests = r.index(static_cast<std::uint64_t>(std::numeric_limits<int>::max()));
+        cp.logOffset = static_cast<std::size_t>(r.index(replay.log.size() + 1));
+        cp.logTick = r.signedVarint();
+        for (std::vector<int>* list : { &cp.changedChunks, &cp.growingChunks }) {
+            const int count = r.index(static_cast<std::uint64_t>(chunkCount) + 1);
+            list->resize(static_cast<std::size_t>(count));
+            for (int& c : *list) c = r.index(static_cast<std::uint64_t>(chunkCount));
+        }
+    }
+
+    replay.chunks.resize(static_cast<std::size_t>(chunkCount));
+    for (int c = 0; c < chunkCount; c++) {
+        const int count = r.index(static_cast<std::uint64_t>(checkpointCount) + 1);
+        std::vector<ReplayChunkVersion>& versions = replay.chunks[c];
+        versions.resize(static_cast<std::size_t>(count));
+        for (int v = 0; v < count; v++) {
+            versions[v].checkpoint = r.index(static_cast<std::uint64_t>(checkpointCount));
+            if ((v == 0 && versions[v].checkpoint != 0) || (v > 0 && versions[v].checkpoint <= versions[v - 1].checkpoint))
+                Reader::fail("bad chunk versions");
+            versions[v].tiles.resize(static_cast<std::size_t>(chunkEnd(replay, c) - chunkBegin(c)));
+            for (Tile& t : versions[v].tiles) {
+                const std::uint8_t type = r.byte();
+                const std::uint8_t state = r.byte();
+                const std::uint8_t cooldown = r.byte();
+                const std::int64_t timer = r.signedVarint();
+                if (type > 2 || state > 2 || timer < std::numeric_limits<int>::min() || timer > std::numeric_limits<int>::max())
+                    Reader::fail("bad tile");
+                t.type = static_cast<TileType>(type);
+                t.cropstate = static_cast<CropState>(state);
+                t.growthTimer = static_cast<int>(timer);
+                t.replantCooldown = cooldown;
+            }
+        }
+        if (versions.empty()) Reader::fail("chunk missing from checkpoint 0");
+    }
+    if (r.pos != bytes.size()) Reader::fail("trailing bytes");
+
+    // every action has to decode and land inside the run, in order
+    std::size_t pos = 0;
+    std::int64_t tick = replay.startTick - 1;
+    while (pos < replay.log.size()) {
+        std::uint64_t v;
+        if (!getVarint(replay.log, pos, v) || (v & ACTION_MASK) > static_cast<std::uint64_t>(ReplayAction::Remove)
+            || (v >> ACTION_BITS) >= static_cast<std::uint64_t>(replay.endTick - tick))
+            Reader::fail("bad action log");
+        tick += 1 + static_cast<std::int64_t>(v >> ACTION_BITS);
+    }
+    return replay;
+}
+
+void saveReplayFile(const Replay& replay, const std::string& path)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out) throw std::runtime_error("can't write replay file: " + path);
+    writeReplay(replay, out);
+}
+
+Replay loadReplayFile(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("can't open replay file: " + path);
+    return readReplay(in);
+}
+
+ReplayRecorder::ReplayRecorder(Grid& grid, Farmer& farmer, int interval)
+    : grid(grid), farmer(farmer), lastActionTick(grid.getTickCount() - 1)
+{
+    if (interval <= 0)
+        throw std::invalid_argument("replay checkpoint interval must be positive");
+
+    replay.width = grid.getGridWidth();
+    replay.height = grid.getGridHeight();
+    replay.interval = interval;
+    replay.startTick = grid.getTickCount();
+    const GridSpan<std::uint8_t> walkable = grid.walkability();
+    replay.walkable.assign(walkable.begin(), walkable.end());
+
+    // checkpoint 0 has everything
+    const int chunkCount = replay.chunkCount();
+    replay.chunks.resize(static_cast<std::size_t>(chunkCount));
+    dirtyFlags.assign(static_cast<std::size_t>(chunkCount), 1);
+    for (int c = 0; c < chunkCount; c++) dirty.push_back(c);
+    checkpoint();
+}
+
+void ReplayRecorder::markDirty(int tile)
+{
+    const int c = tile / REPLAY_CHUNK_TILES;
+    if (dirtyFlags[c]) return;
+    dirtyFlags[c] = 1;
+    dirty.push_back(c);
+}
+
+bool ReplayRecorder::act(CommandType type, direction dir)
+{
+    Command cmd;
+    cmd.type = type;
+    cmd.dir = dir;
+    const bool ok = applyAction(cmd, farmer);
+
+    if (type != CommandType::Wait) {
+        const std::int64_t now = grid.getTickCount();
+        putVarint(replay.log, (static_cast<std::uint64_t>(now - lastActionTick - 1) << ACTION_BITS) | actionCode(type, dir));
+        lastActionTick = now;
+        replay.actionCount++;
+        // moves only change the farmer, which every checkpoint has anyway
+        if (ok && type != CommandType::Move)
+            markDirty(grid.index(farmer.getX(), farmer.getY()));
+    }
+
+    grid.tick();
+    if ((grid.getTickCount() - replay.startTick) % replay.interval == 0)
+        checkpoint();
+    return ok;
+}
+
+void ReplayRecorder::wait(std::int64_t ticks)
+{
+    for (std::int64_t t = 0; t < ticks; t++) act(CommandType::Wait);
+}
+
+RunStats ReplayRecorder::run(const std::vector<Command>& commands)
+{
+    RunStats stats;
+    for (const Command& cmd : commands) {
+        for (int r = 0; r < cmd.count; r++) {
+            const bool ok = act(cmd.type, cmd.dir);
+            stats.ticks++;
+            if (cmd.type == CommandType::Wait) continue;
+            stats.actions++;
+            if (!ok) stats.failedActions++;
+            if (ok && cmd.type == CommandType::Harvest) stats.harvests++;
+        }
+    }
+    return stats;
+}
+
+void ReplayRecorder::checkpoint()
+{
+    ReplayCheckpoint cp;
+    cp.tick = grid.getTickCount();
+    cp.farmerX = farmer.getX();
+    cp.farmerY = farmer.getY();
+    cp.harvests = farmer.getHarvestCount();
+    cp.logOffset = replay.log.size();
+    cp.logTick = lastActionTick;
+    const int index = static_cast<int>(replay.checkpoints.size());
+
+    // crops growing and tiles cooling down at the last checkpoint moved on too, if only their timers
+    if (index > 0)
+        for (int c : replay.checkpoints.back().growingChunks) markDirty(chunkBegin(c));
+    std::sort(dirty.begin(), dirty.end());
+
+    const GridSpan<TileType> types = grid.types();
+    const GridSpan<CropState> states = grid.cropStates();
+    const GridSpan<int> timers = grid.growthTimers();
+    const GridSpan<std::uint8_t> cooldowns = grid.replantCooldowns();
+    for (int c : dirty) {
+        ReplayChunkVersion v;
+        v.checkpoint = index;
+        v.tiles.reserve(static_cast<std::size_t>(chunkEnd(replay, c) - chunkBegin(c)));
+        bool growing = false;
+        for (int i = chunkBegin(c); i < chunkEnd(replay, c); i++) {
+            Tile t;
+            t.type = types[i];
+            t.cropstate = states[i];
+            t.growthTimer = timers[i];
+            t.replantCooldown = cooldowns[i];
+            growing |= (t.type == TileType::CROP && t.cropstate == CropState::PLANTED) || t.replantCooldown > 0;
+            v.tiles.push_back(t);
+        }
+        if (growing) cp.growingChunks.push_back(c);
+
+        std::vector<ReplayChunkVersion>& versions = replay.chunks[c];
+        if (versions.empty() || !sameTiles(versions.back().tiles, v.tiles)) {
+            versions.push_back(std::move(v));
+            cp.changedChunks.push_back(c);
+        }
+        dirtyFlags[c] = 0;
+    }
+    dirty.clear();
+    replay.checkpoints.push_back(std::move(cp));
+}
+
+Replay ReplayRecorder::finish()
+{
+    replay.endTick = grid.getTickCount();
+    replay.finalHash = hashState(grid, farmer);
+    return std::move(replay);
+}
+
+ReplayPlayer::ReplayPlayer(const Replay& replay)
+    : replay(replay), grid(replay.width, replay.height, GrowthMode::Scheduled), farmer(grid)
+{
+    for (int i = 0; i < grid.tileCount(); i++)
+        if (!replay.walkable[i]) grid.setWalkable(i % replay.width, i / replay.width, false);
+    dirtyFlags.assign(static_cast<std::size_t>(replay.chunkCount()), 0);
+    restore(0);
+}
+
+void ReplayPlayer::markDirty(int chunk)
+{
+    if (dirtyFlags[chunk]) return;
+    dirtyFlags[chunk] = 1;
+    dirty.push_back(chunk);
+}
+
+void ReplayPlayer::restore(int checkpoint)
+{
+    const ReplayCheckpoint& cp = replay.checkpoints[checkpoint];
+
+    // what differs from the target: whatever moved since the last restore, plus every chunk
+    // with a version between that checkpoint and this one
+    if (restoredFrom < 0) {
+        for (int c = 0; c < replay.chunkCount(); c++) markDirty(c);
+    } else {
+        const int lo = std::min(restoredFrom, checkpoint);
+        const int hi = std::max(restoredFrom, checkpoint);
+        for (int k = lo + 1; k <= hi; k++)
+            for (int c : replay.checkpoints[k].changedChunks) markDirty(c);
+    }
+
+    // clock first, so setTile schedules crops against the restored tick
+    grid.setTickCount(cp.tick);
+    for (int c : dirty) {
+        const ReplayChunkVersion& v = versionAt(replay, c, checkpoint);
+        for (int i = chunkBegin(c), j = 0; i < chunkEnd(replay, c); i++, j++)
+            grid.setTile(i % replay.width, i / replay.width, v.tiles[j]);
+        dirtyFlags[c] = 0;
+    }
+    restoredChunks += static_cast<int>(dirty.size());
+    dirty.clear();
+
+    farmer.setPosition(cp.farmerX, cp.farmerY);
+    farmer.setHarvestCount(cp.harvests);
+    // these change with the first tick
+    for (int c : cp.growingChunks) markDirty(c);
+
+    logPos = cp.logOffset;
+    lastActionTick = cp.logTick;
+    readNextAction();
+    restoredFrom = checkpoint;
+}
+
+void ReplayPlayer::readNextAction()
+{
+    nextOffset = logPos;
+    hasNext = logPos < replay.log.size();
+    if (!hasNext) return;
+
+    std::uint64_t v;
+    if (!getVarint(replay.log, logPos, v) || (v & ACTION_MASK) > static_cast<std::uint64_t>(ReplayAction::Remove))
+        throw std::runtime_error("corrupt replay action log");
+    nextTick = lastActionTick + 1 + static_cast<std::int64_t>(v >> ACTION_BITS);
+    nextAction = static_cast<ReplayAction>(v & ACTION_MASK);
+}
+
+void ReplayPlayer::advance()
+{
+    if (hasNext && nextTick == grid.getTickCount()) {
+        switch (nextAction) {
+        case ReplayAction::Plant:   farmer.plant(); break;
+        case ReplayAction::Harvest: farmer.harvest(); break;
+        case ReplayAction::Remove:  farmer.remove(); break;
+        default: farmer.move(static_cast<direction>(nextAction)); break;
+        }
+        if (nextAction >= ReplayAction::Plant)
+            markDirty(grid.index(farmer.getX(), farmer.getY()) / REPLAY_CHUNK_TILES);
+        lastActionTick = nextTick;
+        readNextAction();
+    }
+    grid.tick();
+    replayedTicks++;
+}
+
+void ReplayPlayer::seek(std::int64_t tick)
+{
+    replayedTicks = 0;
+    restoredChunks = 0;
+    const std::int64_t target = std::max(replay.startTick, std::min(tick, replay.endTick));
+
+    const auto it = std::upper_bound(replay.checkpoints.begin(), replay.checkpoints.end(), target,
+                                     [](std::int64_t t, const ReplayCheckpoint& cp) { return t < cp.tick; });
+    const int checkpoint = static_cast<int>(it - replay.checkpoints.begin()) - 1;
+
+    const std::int64_t now = grid.getTickCount();
+    if (now > target || target - now > target - replay.checkpoints[checkpoint].tick)
+        restore(checkpoint);
+    while (grid.getTickCount() < target) advance();
+}
+
+bool ReplayPlayer::stepForward()
+{
+    if (getTick() >= replay.endTick) return false;
+    seek(getTick() + 1);
+    return true;
+}
+
+bool ReplayPlayer::stepBack()
+{
+    if (getTick() <= replay.startTick) return false;
+    seek(getTick() - 1);
+    return true;
+}
+
+bool ReplayPlayer::matchesCheckpoint(int checkpoint) const
+{
+    const ReplayCheckpoint& cp = replay.checkpoints[checkpoint];
+    if (farmer.getX() != cp.farmerX || farmer.getY() != cp.farmerY || farmer.getHarvestCount() != cp.harvests
+        || nextOffset != cp.logOffset || lastActionTick != cp.logTick)
+        return false;
+
+    // the chunks the recording saw change, and the ones the re-simulation touched
+    const Grid& view = grid;
+    auto same = [&](int c) {
+        const ReplayChunkVersion& v = versionAt(replay, c, checkpoint);
+        for (int i = chunkBegin(c), j = 0; i < chunkEnd(replay, c); i++, j++) {
+            if (!sameTile(view.getTileUnchecked(i % replay.width, i / replay.width), v.tiles[j]))
+                return false;
+        }
+        return true;
+    };
+    return std::all_of(cp.changedChunks.begin(), cp.changedChunks.end(), same)
+        && std::all_of(dirty.begin(), dirty.end(), same);
+}
+
+ReplayVerifyResult ReplayPlayer::verify(std::uint64_t expectedHash)
+{
+    ReplayVerifyResult result;
+    result.expectedHash = expectedHash;
+
+    restoredFrom = -1;
+    for (int c : dirty) dirtyFlags[c] = 0;
+    dirty.clear();
+    restoredChunks = 0;
+    replayedTicks = 0;
+    restore(0);
+
+    for (std::size_t k = 1; k < replay.checkpoints.size(); k++) {
+        const ReplayCheckpoint& cp = replay.checkpoints[k];
+        while (grid.getTickCount() < cp.tick) advance();
+        if (result.divergedAt >= 0)
+            continue;
+        if (!matchesCheckpoint(static_cast<int>(k))) {
+            result.divergedAt = cp.tick;
+            continue;
+        }
+        // the world is that checkpoint now, so later seeks and checks can start from it
+        for (int c : dirty) dirtyFlags[c] = 0;
+        dirty.clear();
+        for (int c : cp.growingChunks) markDirty(c);
+        restoredFrom = static_cast<int>(k);
+    }
+    while (grid.getTickCount() < replay.endTick) advance();
+
+    result.actualHash = hashState(grid, farmer);
+    result.ok = result.divergedAt < 0 && result.actualHash == expectedHash;
+    return result;
+}
+
+ReplayVerifyResult verifyReplay(const Replay& replay, std::uint64_t expectedHash)
+{
+    ReplayPlayer player(replay);
+    return player.verify(expectedHash);
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "Farmer.hpp"
+#include "Grid.hpp"
+#include "Simulation.hpp"
+
+// Deterministic replays of a run: the farmer's actions as a compact log plus checkpoints of
+// the world every `interval` ticks, so any tick can be rebuilt by restoring the checkpoint at
+// or before it and replaying at most one interval of actions.
+//
+// The log is one varint per action, (ticks skipped since the previous action << 3) | action,
+// so acting every tick costs a byte a tick and waiting costs nothing. Checkpoints are
+// copy-on-write over runs of REPLAY_CHUNK_TILES tiles: a checkpoint only keeps a new copy of
+// the chunks that could have changed in its interval (an action worked a tile there, or a
+// crop was still growing or a tile cooling down), every other chunk is shared with the checkpoints before it. So
+// storage follows what the farmer did, not grid size times ticks.
+//
+// Recording assumes nothing but the recorded actions and ticks touches the world.
+
+// flat tiles per checkpoint chunk, 3KB of Tile each
+constexpr int REPLAY_CHUNK_TILES = 256;
+
+// action codes in the log, the moves line up with the direction enum
+enum class ReplayAction : std::uint8_t { MoveLeft, MoveUp, MoveDown, MoveRight, Plant, Harvest, Remove };
+
+struct ReplayCheckpoint
+{
+    std::int64_t tick = 0;
+    int farmerX = 0;
+    int farmerY = 0;
+    int harvests = 0;
+    std::size_t logOffset = 0;      // first log byte of the actions at or after tick
+    std::int64_t logTick = 0;       // tick of the action just before logOffset, the next delta counts from it
+    std::vector<int> changedChunks; // chunks with a new version in this checkpoint
+    std::vector<int> growingChunks; // chunks with a PLANTED crop or a tile in its replant cooldown at tick
+};
+
+// one chunk's tiles as of a checkpoint
+struct ReplayChunkVersion
+{
+    int checkpoint = 0;
+    std::vector<Tile> tiles;
+};
+
+struct Replay
+{
+    int width = 0;
+    int height = 0;
+    int interval = 0;
+    std::int64_t startTick = 0;
+    std::int64_t endTick = 0;
+    std::uint64_t finalHash = 0; // hashState at endTick
+    std::int64_t actionCount = 0;
+    std::vector<std::uint8_t> walkable; // walls don't change during a run, kept once
+    std::vector<std::uint8_t> log;
+    std::vector<ReplayCheckpoint> checkpoints; // [0] is at startTick and has every chunk
+    std::vector<std::vector<ReplayChunkVersion>> chunks; // per chunk, versions in checkpoint order
+
+    int chunkCount() const { return (width * height + REPLAY_CHUNK_TILES - 1) / REPLAY_CHUNK_TILES; }
+    // roughly what it holds in memory
+    std::size_t storageBytes() const;
+};
+
+// binary replay files, readReplay throws std::runtime_error on anything malformed
+void writeReplay(const Replay& replay, std::ostream& out);
+Replay readReplay(std::istream& in);
+void saveReplayFile(const Replay& replay, const std::string& path);
+Replay loadReplayFile(const std::string& path);
+
+// Drives a run and records it, in place of CommandRunner. Checkpoint 0 is the world as it is
+// when the recorder is made.
+class ReplayRecorder
+{
+    public:
+    ReplayRecorder(Grid& grid, Farmer& farmer, int interval = 256);
+
+    // carries out one action (Wait does nothing) and ticks the grid, false if the action failed
+    bool act(CommandType type, direction dir = UP);
+    void wait(std::int64_t ticks);
+    // the whole stream, counts and all, same ticks and stats as runCommands
+    RunStats run(const std::vector<Command>& commands);
+
+    std::int64_t getTick() const { return grid.getTickCount(); }
+
+    // stamps the final state and hands the replay over, the recorder is done after this
+    Replay finish();
+
+    private:
+    void markDirty(int tile);
+    void checkpoint();
+
+    Grid& grid;
+    Farmer& farmer;
+    Replay replay;
+    std::int64_t lastActionTick;
+    std::vector<std::uint8_t> dirtyFlags;
+    std::vector<int> dirty;
+};
+
+struct ReplayVerifyResult
+{
+    bool ok = false;
+    // first checkpoint tick where the re-simulation didn't match what was recorded, -1 if none
+    std::int64_t divergedAt = -1;
+    std::uint64_t expectedHash = 0;
+    std::uint64_t actualHash = 0;
+};
+
+// Rebuilds any tick of a replay in its own Grid (Scheduled) and Farmer.
+class ReplayPlayer
+{
+    public:
+    // starts at the replay's first tick; the replay has to outlive the player
+    explicit ReplayPlayer(const Replay& replay);
+
+    // any tick in [startTick, endTick], clamped: restores the checkpoint at or before it (unless
+    // playing on from where we are is shorter) and replays the rest, at most one interval
+    void seek(std::int64_t tick);
+    // false at the ends
+    bool stepForward();
+    bool stepBack();
+
+    std::int64_t getTick() const { return grid.getTickCount(); }
+    const Grid& getGrid() const { return grid; }
+    const Farmer& getFarmer() const { return farmer; }
+
+    // work done by the last seek / step
+    std::int64_t lastReplayedTicks() const { return replayedTicks; }
+    int lastRestoredChunks() const { return restoredChunks; }
+
+    // re-simulates the whole run from checkpoint 0 without trusting the later checkpoints,
+    // checking each of them on the way and the final state against expectedHash. Leaves the
+    // player at the end.
+    ReplayVerifyResult verify(std::uint64_t expectedHash);
+    ReplayVerifyResult verify() { return verify(replay.finalHash); }
+
+    private:
+    void restore(int checkpoint);
+    void advance();
+    void readNextAction();
+    void markDirty(int chunk);
+    bool matchesCheckpoint(int checkpoint) const;
+
+    const Replay& replay;
+    Grid grid;
+    Farmer farmer;
+
+    int restoredFrom = -1; // checkpoint the world was last restored to
+    // chunks that may have moved away from that checkpoint since
+    std::vector<std::uint8_t> dirtyFlags;
+    std::vector<int> dirty;
+
+    // log cursor: the next action and the tick it runs on
+    std::size_t logPos = 0;
+    std::size_t nextOffset = 0; // where the next action starts, log size if there's none
+    std::int64_t lastActionTick = 0;
+    bool hasNext = false;
+    std::int64_t nextTick = 0;
+    ReplayAction nextAction = ReplayAction::MoveUp;
+
+    std::int64_t replayedTicks = 0;
+    int restoredChunks = 0;
+};
+
+// shorthand for ReplayPlayer(replay).verify(expectedHash)
+ReplayVerifyResult verifyReplay(const Replay& replay, std::uint64_t expectedHash);
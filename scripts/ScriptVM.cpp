@@ -0,0 +1,514 @@
+#include "ScriptVM.hpp"
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+std::int32_t readOperand(const std::uint8_t* at)
+{
+    return static_cast<std::int32_t>(static_cast<std::uint32_t>(at[0]) | static_cast<std::uint32_t>(at[1]) << 8
+                                     | static_cast<std::uint32_t>(at[2]) << 16 | static_cast<std::uint32_t>(at[3]) << 24);
+}
+
+std::string lower(std::string s)
+{
+    for (char& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+// Python's // and %, rounding toward negative infinity
+std::int64_t floorDiv(std::int64_t a, std::int64_t b)
+{
+    std::int64_t q = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0))) q--;
+    return q;
+}
+
+std::int64_t floorMod(std::int64_t a, std::int64_t b)
+{
+    std::int64_t r = a % b;
+    if (r != 0 && ((r < 0) != (b < 0))) r += b;
+    return r;
+}
+
+// a op b into r, false on int64 overflow (Python would go to a bigint, scripts never need one)
+bool checkedAdd(std::int64_t a, std::int64_t b, std::int64_t& r)
+{
+    if ((b > 0 && a > std::numeric_limits<std::int64_t>::max() - b)
+        || (b < 0 && a < std::numeric_limits<std::int64_t>::min() - b))
+        return false;
+    r = a + b;
+    return true;
+}
+
+bool checkedSub(std::int64_t a, std::int64_t b, std::int64_t& r)
+{
+    if ((b < 0 && a > std::numeric_limits<std::int64_t>::max() + b)
+        || (b > 0 && a < std::numeric_limits<std::int64_t>::min() + b))
+        return false;
+    r = a - b;
+    return true;
+}
+
+bool checkedMul(std::int64_t a, std::int64_t b, std::int64_t& r)
+{
+    if (a != 0 && b != 0) {
+        const std::int64_t hi = std::numeric_limits<std::int64_t>::max();
+        const std::int64_t lo = std::numeric_limits<std::int64_t>::min();
+        if (a > 0 ? (b > 0 ? a > hi / b : b < lo / a) : (b > 0 ? a < lo / b : a < hi / b))
+            return false;
+    }
+    r = a * b;
+    return true;
+}
+
+// the longest string a script can build with +, so a doubling loop can't eat the machine
+constexpr std::size_t MAX_STRING_BYTES = 64 * 1024;
+// strings built with + held at once. On reaching it the ones nothing refers to any more are
+// dropped, and if what's left is still over half of it the script is out of memory, so every
+// collection frees at least half and they cost O(1) per byte built
+constexpr std::size_t MAX_BUILT_STRING_BYTES = 16 * 1024 * 1024;
+
+} // namespace
+
+const char* cropKindName(CropKind kind)
+{
+    switch (kind) {
+    case CropKind::Wheat: return "wheat";
+    case CropKind::Corn: return "corn";
+    case CropKind::Tomato: return "tomato";
+    case CropKind::Carrot: return "carrot";
+    default: return "unknown";
+    }
+}
+
+CropKind cropKindFromName(const std::string& name)
+{
+    const std::string n = lower(name);
+    if (n == "wheat") return CropKind::Wheat;
+    if (n == "corn") return CropKind::Corn;
+    if (n == "tomato") return CropKind::Tomato;
+    if (n == "carrot") return CropKind::Carrot;
+    return CropKind::Unknown;
+}
+
+std::vector<CropKind> layoutCrops(const Layout& layout)
+{
+    std::vector<CropKind> crops(static_cast<std::size_t>(layout.width) * layout.height, CropKind::Unknown);
+    for (int y = 0; y < layout.height; y++) {
+        for (int x = 0; x < layout.width; x++) {
+            CropKind& k = crops[static_cast<std::size_t>(y) * layout.width + x];
+            switch (layout.rows[y][x]) {
+            case 'W': k = CropKind::Wheat; break;
+            case 'C': k = CropKind::Corn; break;
+            case 'T': k = CropKind::Tomato; break;
+            case 'R': k = CropKind::Carrot; break;
+            default: break;
+            }
+        }
+    }
+    return crops;
+}
+
+const char* scriptOutcomeName(ScriptOutcome outcome)
+{
+    switch (outcome) {
+    case ScriptOutcome::Won: return "won";
+    case ScriptOutcome::Incomplete: return "incomplete";
+    case ScriptOutcome::Failed: return "failed";
+    case ScriptOutcome::OutOfInstructions: return "out of instructions";
+    case ScriptOutcome::OutOfTicks: return "out of ticks";
+    case ScriptOutcome::Error: return "error";
+    case ScriptOutcome::CompileError: return "compile error";
+    }
+    return "?";
+}
+
+ScriptResult ScriptVM::run(const ScriptProgram& program, Grid& grid, Farmer& farmer, std::vector<CropKind>& crops,
+                           const ScriptObjective& objective, const std::vector<std::string>& allowed,
+                           const ScriptLimits& limits)
+{
+    if (crops.size() != static_cast<std::size_t>(grid.getGridWidth()) * grid.getGridHeight())
+        throw std::invalid_argument("ScriptVM::run: crops must have one entry per tile");
+
+    ScriptResult result;
+    const bool plantUnlocked = allowed.empty() || std::find(allowed.begin(), allowed.end(), "plant") != allowed.end();
+
+    stack.clear();
+    variables.assign(program.variables.size(), Value());
+    // strings built at runtime with +, indexed after the program's constants
+    std::vector<std::string> built;
+    std::size_t builtBytes = 0;
+    const std::int64_t constants = static_cast<std::int64_t>(program.strings.size());
+    auto str = [&](const Value& v) -> const std::string& {
+        return v.i < constants ? program.strings[v.i] : built[v.i - constants];
+    };
+    // keeps the built strings the stack, the variables or the two operands of a + still use,
+    // renumbered, and drops the rest
+    auto collectStrings = [&](Value& a, Value& b) {
+        std::vector<std::int64_t> renumber(built.size(), -1);
+        std::vector<std::string> live;
+        builtBytes = 0;
+        auto keep = [&](Value& v) {
+            if (v.kind != ValueKind::Str || v.i < constants) return;
+            std::int64_t& to = renumber[v.i - constants];
+            if (to < 0) {
+                to = constants + static_cast<std::int64_t>(live.size());
+                builtBytes += built[v.i - constants].size();
+                live.push_back(std::move(built[v.i - constants]));
+            }
+            v.i = to;
+        };
+        for (Value& v : stack) keep(v);
+        for (Value& v : variables) keep(v);
+        keep(a);
+        keep(b);
+        built = std::move(live);
+    };
+
+    const std::uint8_t* code = program.code.data();
+    std::size_t pc = 0;
+
+    auto fail = [&](const std::string& message) { throw ScriptError(message, program.lineAt(pc)); };
+    auto typeName = [](const Value& v) {
+        switch (v.kind) {
+        case ValueKind::None: return "NoneType";
+        case ValueKind::Int: return "int";
+        case ValueKind::Str: return "str";
+        default: return "undefined";
+        }
+    };
+    auto pop = [&]() {
+        Value v = stack.back();
+        stack.pop_back();
+        return v;
+    };
+    auto truthy = [&](const Value& v) {
+        if (v.kind == ValueKind::Int) return v.i != 0;
+        if (v.kind == ValueKind::Str) return !str(v).empty();
+        return false;
+    };
+    auto pushInt = [&](std::int64_t i) { stack.push_back({ ValueKind::Int, i }); };
+    auto bothInts = [&](const Value& a, const Value& b, const char* op) {
+        if (a.kind != ValueKind::Int || b.kind != ValueKind::Int)
+            fail(std::string("TypeError: unsupported operand type(s) for ") + op + ": '" + typeName(a) + "' and '"
+                 + typeName(b) + "'");
+    };
+    auto overflow = [&]() { fail("OverflowError: integer too large"); };
+
+    auto won = [&]() {
+        if (!objective.cropRequirements.empty()) {
+            for (const auto& req : objective.cropRequirements)
+                if (result.cropHarvests[static_cast<int>(req.first)] < req.second) return false;
+            return true;
+        }
+        return result.harvests >= objective.harvestsRequired;
+    };
+
+    // every command, failed or not, is one action and one tick, like CommandRunner. Returns
+    // false when the run is over.
+    auto finishAction = [&](bool ok) {
+        result.actions++;
+        if (!ok) result.failedActions++;
+        grid.tick();
+        result.ticks++;
+        if (ok && result.harvests > 0 && won()) {
+            result.outcome = ScriptOutcome::Won;
+            return false;
+        }
+        if (objective.tickLimit > 0 && result.ticks >= objective.tickLimit) {
+            result.outcome = ScriptOutcome::Failed;
+            return false;
+        }
+        if (result.ticks >= limits.maxTicks) {
+            result.outcome = ScriptOutcome::OutOfTicks;
+            return false;
+        }
+        return true;
+    };
+    auto tileIndex = [&]() { return static_cast<std::size_t>(farmer.getY()) * grid.getGridWidth() + farmer.getX(); };
+
+    try {
+        for (;;) {
+            if (result.instructions >= limits.maxInstructions) {
+                result.outcome = ScriptOutcome::OutOfInstructions;
+                break;
+            }
+            result.instructions++;
+
+            const ScriptOp op = static_cast<ScriptOp>(code[pc]);
+            const std::uint8_t* operands = code + pc + 1;
+            std::size_t next = pc + 1;
+
+            switch (op) {
+            case ScriptOp::PushInt:
+                pushInt(readOperand(operands));
+                next += 4;
+                break;
+            case ScriptOp::PushStr:
+                stack.push_back({ ValueKind::Str, readOperand(operands) });
+                next += 4;
+                break;
+            case ScriptOp::PushNone:
+                stack.push_back({ ValueKind::None, 0 });
+                break;
+            case ScriptOp::Load: {
+                const std::int32_t slot = readOperand(operands);
+                if (variables[slot].kind == ValueKind::Undefined)
+                    fail("NameError: name '" + program.variables[slot] + "' is not defined");
+                stack.push_back(variables[slot]);
+                next += 4;
+                break;
+            }
+            case ScriptOp::Store:
+                variables[readOperand(operands)] = pop();
+                next += 4;
+                break;
+            case ScriptOp::Pop:
+                stack.pop_back();
+                break;
+
+            case ScriptOp::Add: {
+                Value b = pop();
+                Value a = pop();
+                if (a.kind == ValueKind::Str && b.kind == ValueKind::Str) {
+                    const std::size_t bytes = str(a).size() + str(b).size();
+                    if (bytes > MAX_STRING_BYTES) fail("MemoryError: string too long");
+                    if (builtBytes + bytes > MAX_BUILT_STRING_BYTES) {
+                        collectStrings(a, b);
+                        if (builtBytes + bytes > MAX_BUILT_STRING_BYTES / 2) fail("MemoryError: out of string memory");
+                    }
+                    built.push_back(str(a) + str(b));
+                    builtBytes += bytes;
+                    stack.push_back({ ValueKind::Str, constants + static_cast<std::int64_t>(built.size()) - 1 });
+                    break;
+                }
+                bothInts(a, b, "+");
+                std::int64_t r;
+                if (!checkedAdd(a.i, b.i, r)) overflow();
+                pushInt(r);
+                break;
+            }
+            case ScriptOp::Sub: {
+                const Value b = pop();
+                const Value a = pop();
+                bothInts(a, b, "-");
+                std::int64_t r;
+                if (!checkedSub(a.i, b.i, r)) overflow();
+                pushInt(r);
+                break;
+            }
+            case ScriptOp::Mul: {
+                const Value b = pop();
+                const Value a = pop();
+                bothInts(a, b, "*");
+                std::int64_t r;
+                if (!checkedMul(a.i, b.i, r)) overflow();
+                pushInt(r);
+                break;
+            }
+            case ScriptOp::FloorDiv:
+            case ScriptOp::Mod: {
+                const Value b = pop();
+                const Value a = pop();
+                bothInts(a, b, op == ScriptOp::Mod ? "%" : "//");
+                if (b.i == 0)
+                    fail(op == ScriptOp::Mod ? "ZeroDivisionError: integer modulo by zero"
+                                             : "ZeroDivisionError: integer division by zero");
+                if (a.i == std::numeric_limits<std::int64_t>::min() && b.i == -1) {
+                    if (op == ScriptOp::Mod) pushInt(0);
+                    else overflow();
+                    break;
+                }
+                pushInt(op == ScriptOp::Mod ? floorMod(a.i, b.i) : floorDiv(a.i, b.i));
+                break;
+            }
+            case ScriptOp::Neg: {
+                const Value a = pop();
+                if (a.kind != ValueKind::Int)
+                    fail(std::string("TypeError: bad operand type for unary -: '") + typeName(a) + "'");
+                if (a.i == std::numeric_limits<std::int64_t>::min()) overflow();
+                pushInt(-a.i);
+                break;
+            }
+            case ScriptOp::Not:
+                pushInt(truthy(pop()) ? 0 : 1);
+                break;
+
+            case ScriptOp::Eq:
+            case ScriptOp::Ne: {
+                const Value b = pop();
+                const Value a = pop();
+                bool equal = a.kind == b.kind;
+                if (equal && a.kind == ValueKind::Int) equal = a.i == b.i;
+                if (equal && a.kind == ValueKind::Str) equal = str(a) == str(b);
+                pushInt((op == ScriptOp::Eq) == equal ? 1 : 0);
+                break;
+            }
+            case ScriptOp::Lt:
+            case ScriptOp::Le:
+            case ScriptOp::Gt:
+            case ScriptOp::Ge: {
+                const Value b = pop();
+                const Value a = pop();
+                int cmp;
+                if (a.kind == ValueKind::Int && b.kind == ValueKind::Int) {
+                    cmp = a.i < b.i ? -1 : a.i > b.i ? 1 : 0;
+                } else if (a.kind == ValueKind::Str && b.kind == ValueKind::Str) {
+                    cmp = str(a).compare(str(b));
+                } else {
+                    const char* name = op == ScriptOp::Lt ? "<" : op == ScriptOp::Le ? "<=" : op == ScriptOp::Gt ? ">" : ">=";
+                    fail(std::string("TypeError: '") + name + "' not supported between instances of '" + typeName(a)
+                         + "' and '" + typeName(b) + "'");
+                    cmp = 0;
+                }
+                const bool r = op == ScriptOp::Lt ? cmp < 0 : op == ScriptOp::Le ? cmp <= 0 : op == ScriptOp::Gt ? cmp > 0 : cmp >= 0;
+                pushInt(r ? 1 : 0);
+                break;
+            }
+
+            case ScriptOp::Jump:
+                next = static_cast<std::size_t>(readOperand(operands));
+                break;
+            case ScriptOp::JumpIfFalse:
+                next = truthy(pop()) ? next + 4 : static_cast<std::size_t>(readOperand(operands));
+                break;
+            case ScriptOp::JumpIfFalseOrPop:
+                if (!truthy(stack.back())) {
+                    next = static_cast<std::size_t>(readOperand(operands));
+                } else {
+                    stack.pop_back();
+                    next += 4;
+                }
+                break;
+            case ScriptOp::JumpIfTrueOrPop:
+                if (truthy(stack.back())) {
+                    next = static_cast<std::size_t>(readOperand(operands));
+                } else {
+                    stack.pop_back();
+                    next += 4;
+                }
+                break;
+
+            case ScriptOp::RangeInit: {
+                const std::int32_t base = readOperand(operands);
+                const Value step = pop();
+                const Value stop = pop();
+                const Value start = pop();
+                for (const Value* v : { &start, &stop, &step })
+                    if (v->kind != ValueKind::Int)
+                        fail(std::string("TypeError: '") + typeName(*v) + "' object cannot be interpreted as an integer");
+                if (step.i == 0) fail("ValueError: range() arg 3 must not be zero");
+                variables[base] = start;
+                variables[base + 1] = stop;
+                variables[base + 2] = step;
+                next += 4;
+                break;
+            }
+            case ScriptOp::RangeNext: {
+                const std::int32_t base = readOperand(operands);
+                Value& current = variables[base];
+                const std::int64_t stop = variables[base + 1].i;
+                const std::int64_t step = variables[base + 2].i;
+                if (step > 0 ? current.i < stop : current.i > stop) {
+                    variables[readOperand(operands + 4)] = current;
+                    // past the end of int64 is past stop too
+                    if (!checkedAdd(current.i, step, current.i)) current.i = stop;
+                    next += 12;
+                } else {
+                    next = static_cast<std::size_t>(readOperand(operands + 8));
+                }
+                break;
+            }
+
+            case ScriptOp::Move: {
+                const Value dir = pop();
+                if (dir.kind != ValueKind::Str)
+                    fail(std::string("AttributeError: '") + typeName(dir) + "' object has no attribute 'lower'");
+                const std::string d = lower(str(dir));
+                bool moved = false;
+                if (d == "up") moved = farmer.move(UP);
+                else if (d == "down") moved = farmer.move(DOWN);
+                else if (d == "left") moved = farmer.move(LEFT);
+                else if (d == "right") moved = farmer.move(RIGHT);
+                if (!finishAction(moved)) return result;
+                break;
+            }
+            case ScriptOp::Plant: {
+                const Value name = pop();
+                bool ok = false;
+                // main.py checks the lock before it looks at the argument
+                if (plantUnlocked) {
+                    if (name.kind != ValueKind::Str)
+                        fail(std::string("AttributeError: '") + typeName(name) + "' object has no attribute 'lower'");
+                    const CropKind kind = cropKindFromName(str(name));
+                    if (kind != CropKind::Unknown && farmer.plant()) {
+                        crops[tileIndex()] = kind;
+                        ok = true;
+                    }
+                }
+                if (!finishAction(ok)) return result;
+                break;
+            }
+            case ScriptOp::Harvest: {
+                const std::size_t tile = tileIndex();
+                const bool ok = farmer.harvest();
+                if (ok) {
+                    result.harvests++;
+                    result.cropHarvests[static_cast<int>(crops[tile])]++;
+                    crops[tile] = CropKind::Unknown;
+                }
+                if (!finishAction(ok)) return result;
+                break;
+            }
+            case ScriptOp::Remove: {
+                const std::size_t tile = tileIndex();
+                const bool ok = farmer.remove();
+                if (ok) crops[tile] = CropKind::Unknown;
+                if (!finishAction(ok)) return result;
+                break;
+            }
+            case ScriptOp::Print:
+                // the IDE console isn't part of grading, the arguments were evaluated for their errors
+                stack.resize(stack.size() - readOperand(operands));
+                next += 4;
+                break;
+            case ScriptOp::Halt:
+                result.outcome = ScriptOutcome::Incomplete;
+                return result;
+            }
+            pc = next;
+        }
+    } catch (const ScriptError& err) {
+        result.outcome = ScriptOutcome::Error;
+        result.error = err.what();
+        result.errorLine = err.getLine();
+    }
+    return result;
+}
+
+ScriptResult validateScript(const std::string& source, const ScriptLevel& level, const ScriptLimits& limits)
+{
+    ScriptProgram program;
+    try {
+        ScriptOptions options;
+        options.allowed = level.allowed;
+        program = compileScript(source, options);
+    } catch (const ScriptError& err) {
+        ScriptResult result;
+        result.outcome = ScriptOutcome::CompileError;
+        result.error = err.what();
+        result.errorLine = err.getLine();
+        return result;
+    }
+
+    Grid grid(level.layout.width, level.layout.height);
+    applyLayout(level.layout, grid);
+    Farmer farmer(grid, level.layout.startX, level.layout.startY);
+    std::vector<CropKind> crops = layoutCrops(level.layout);
+    // one VM per thread, so batch graders reuse its buffers across submissions
+    static thread_local ScriptVM vm;
+    return vm.run(program, grid, farmer, crops, level.objective, level.allowed, limits);
+}
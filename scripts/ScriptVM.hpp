@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FarmScript.hpp"
+#include "Farmer.hpp"
+#include "Grid.hpp"
+#include "Simulation.hpp"
+
+// Runs compiled farm scripts (FarmScript.hpp) directly against a Grid and Farmer, no Python
+// thread and no animation in between. Every command is one action plus one grid.tick(), the
+// same as a command stream in CommandRunner, so grading a submission costs microseconds
+// instead of however long its animation would take.
+
+// the crop types of level.py, Grid itself only knows planted/grown
+enum class CropKind : std::uint8_t { Unknown, Wheat, Corn, Tomato, Carrot };
+constexpr int CROP_KIND_COUNT = 5;
+
+const char* cropKindName(CropKind kind);
+// case-insensitive like plant() in main.py, Unknown for anything else
+CropKind cropKindFromName(const std::string& name);
+// per tile crop kinds of the layout's pre-placed crops ('W' 'C' 'T' 'R'), row-major
+std::vector<CropKind> layoutCrops(const Layout& layout);
+
+// Objective from objective.py: with crop requirements every listed crop has to reach its
+// count, otherwise any harvestsRequired crops win
+struct ScriptObjective
+{
+    int harvestsRequired = 1;
+    std::vector<std::pair<CropKind, int>> cropRequirements;
+    // stands in for time_limit, a script that hasn't won after this many ticks fails. 0 is none.
+    std::int64_t tickLimit = 0;
+};
+
+// cut-offs for scripts that never finish (while True: pass, or wandering forever)
+struct ScriptLimits
+{
+    std::int64_t maxInstructions = 10'000'000;
+    std::int64_t maxTicks = 100'000;
+};
+
+enum class ScriptOutcome
+{
+    Won,               // objective met, the run stops at the harvest that did it
+    Incomplete,        // the script ended without meeting the objective
+    Failed,            // tickLimit ran out first
+    OutOfInstructions, // hit ScriptLimits::maxInstructions
+    OutOfTicks,        // hit ScriptLimits::maxTicks
+    Error,             // runtime error (TypeError, NameError, ...), see error/errorLine
+    CompileError,      // only from validateScript
+};
+
+const char* scriptOutcomeName(ScriptOutcome outcome);
+
+struct ScriptResult
+{
+    ScriptOutcome outcome = ScriptOutcome::Incomplete;
+    std::int64_t instructions = 0;
+    std::int64_t ticks = 0;
+    std::int64_t actions = 0;
+    std::int64_t failedActions = 0; // blocked moves, locked/unknown/occupied plants, nothing to harvest/remove
+    std::int64_t harvests = 0;
+    std::int64_t cropHarvests[CROP_KIND_COUNT] = {};
+    std::string error;
+    int errorLine = 0;
+};
+
+// Reusable between runs, keeps its stack and variable storage so validating the next
+// submission doesn't allocate
+class ScriptVM
+{
+    public:
+    // crops is the kind of crop on each tile (row-major, layoutCrops() for a fresh level) and
+    // is updated as the script plants, harvests and removes. allowed is the level's command
+    // list, plant() is locked when "plant" isn't in it (empty allows everything).
+    ScriptResult run(const ScriptProgram& program, Grid& grid, Farmer& farmer, std::vector<CropKind>& crops,
+                     const ScriptObjective& objective, const std::vector<std::string>& allowed,
+                     const ScriptLimits& limits = ScriptLimits());
+
+    private:
+    enum class ValueKind : std::uint8_t { Undefined, None, Int, Str };
+    struct Value
+    {
+        ValueKind kind = ValueKind::Undefined;
+        std::int64_t i = 0; // the int, or the string constant index
+    };
+
+    std::vector<Value> stack;
+    std::vector<Value> variables;
+};
+
+// one level to grade against: the farm, the objective and the allowed list
+struct ScriptLevel
+{
+    Layout layout;
+    ScriptObjective objective;
+    std::vector<std::string> allowed;
+};
+
+// compile + run on a fresh copy of the level, compile errors come back as CompileError
+ScriptResult validateScript(const std::string& source, const ScriptLevel& level,
+                            const ScriptLimits& limits = ScriptLimits());
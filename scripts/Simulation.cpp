@@ -0,0 +1,250 @@
+#include "Simulation.hpp"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+static std::string trim(const std::string& s)
+{
+    const auto first = s.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) return "";
+    const auto last = s.find_last_not_of(" \t\r\n");
+    return s.substr(first, last - first + 1);
+}
+
+static std::ifstream openOrThrow(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error("could not open " + path);
+    return in;
+}
+
+Layout parseLayout(std::istream& in)
+{
+    Layout layout;
+    bool sawFarmer = false;
+    std::string line;
+    int lineNo = 0;
+
+    while (std::getline(in, line)) {
+        lineNo++;
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+
+        if (layout.width == 0) layout.width = static_cast<int>(line.size());
+        if (static_cast<int>(line.size()) != layout.width)
+            throw std::runtime_error("layout line " + std::to_string(lineNo) + ": rows must all be "
+                                     + std::to_string(layout.width) + " wide");
+
+        for (int x = 0; x < layout.width; x++) {
+            const char c = line[x];
+            if (std::string(".SPGWCTRFX").find(c) == std::string::npos)
+                throw std::runtime_error("layout line " + std::to_string(lineNo) + ": unknown tile '"
+                                         + std::string(1, c) + "'");
+            if (c == 'F') {
+                if (sawFarmer)
+                    throw std::runtime_error("layout line " + std::to_string(lineNo) + ": more than one 'F'");
+                sawFarmer = true;
+                layout.startX = x;
+                layout.startY = layout.height;
+            }
+        }
+        layout.rows.push_back(line);
+        layout.height++;
+    }
+
+    if (layout.height == 0)
+        throw std::runtime_error("layout is empty");
+    return layout;
+}
+
+Layout loadLayoutFile(const std::string& path)
+{
+    std::ifstream in = openOrThrow(path);
+    return parseLayout(in);
+}
+
+void applyLayout(const Layout& layout, Grid& grid)
+{
+    if (grid.getGridWidth() != layout.width || grid.getGridHeight() != layout.height)
+        throw std::invalid_argument("applyLayout: grid size does not match layout");
+
+    for (int y = 0; y < layout.height; y++) {
+        for (int x = 0; x < layout.width; x++) {
+            Tile t;
+            switch (layout.rows[y][x]) {
+            case 'S':
+                t.type = TileType::SOIL;
+                break;
+            case 'P':
+                t.type = TileType::CROP;
+                t.cropstate = CropState::PLANTED;
+                break;
+            case 'G': case 'W': case 'C': case 'T': case 'R':
+                // pre-placed crops start fully grown like they do in level.py
+                t.type = TileType::CROP;
+                t.cropstate = CropState::GROWN;
+                t.growthTimer = Tile::GROWTH_TIME;
+                break;
+            default:
+                break;
+            }
+            grid.setTile(x, y, t);
+            grid.setWalkable(x, y, layout.rows[y][x] != 'X');
+        }
+    }
+}
+
+static bool parseDirection(const std::string& word, direction& out)
+{
+    if (word == "up")    { out = UP;    return true; }
+    if (word == "down")  { out = DOWN;  return true; }
+    if (word == "left")  { out = LEFT;  return true; }
+    if (word == "right") { out = RIGHT; return true; }
+    return false;
+}
+
+std::vector<Command> parseCommands(std::istream& in)
+{
+    std::vector<Command> commands;
+    std::string line;
+    int lineNo = 0;
+
+    while (std::getline(in, line)) {
+        lineNo++;
+        const auto hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        line = trim(line);
+        if (line.empty()) continue;
+
+        std::istringstream words(line);
+        std::string verb;
+        words >> verb;
+
+        Command cmd;
+        const std::string where = "command line " + std::to_string(lineNo) + ": ";
+        if (verb == "move") {
+            std::string dir;
+            words >> dir;
+            if (!parseDirection(dir, cmd.dir))
+                throw std::runtime_error(where + "move needs up/down/left/right");
+            cmd.type = CommandType::Move;
+        } else if (verb == "plant") {
+            cmd.type = CommandType::Plant;
+        } else if (verb == "harvest") {
+            cmd.type = CommandType::Harvest;
+        } else if (verb == "remove") {
+            cmd.type = CommandType::Remove;
+        } else if (verb == "wait") {
+            cmd.type = CommandType::Wait;
+        } else {
+            throw std::runtime_error(where + "unknown command '" + verb + "'");
+        }
+
+        // optional repeat count, "move right 5" / "wait 20"
+        int count = 1;
+        if (words >> count) {
+            if (count < 0)
+                throw std::runtime_error(where + "count can't be negative");
+            // "move right 5x" / "wait 2 more" aren't a count
+            std::string rest;
+            if (words >> rest)
+                throw std::runtime_error(where + "unexpected '" + rest + "' after the count");
+        } else if (!words.eof()) {
+            throw std::runtime_error(where + "bad count");
+        }
+        cmd.count = count;
+        commands.push_back(cmd);
+    }
+    return commands;
+}
+
+std::vector<Command> loadCommandFile(const std::string& path)
+{
+    std::ifstream in = openOrThrow(path);
+    return parseCommands(in);
+}
+
+void CommandRunner::skipEmpty()
+{
+    // "wait 0" / "move left 0" take no ticks
+    while (commandIndex < commands->size() && repeatIndex >= (*commands)[commandIndex].count) {
+        commandIndex++;
+        repeatIndex = 0;
+    }
+}
+
+bool applyAction(const Command& cmd, Farmer& farmer)
+{
+    switch (cmd.type) {
+    case CommandType::Move:    return farmer.move(cmd.dir);
+    case CommandType::Plant:   return farmer.plant();
+    case CommandType::Harvest: return farmer.harvest();
+    case CommandType::Remove:  return farmer.remove();
+    case CommandType::Wait:    return true;
+    }
+    return true;
+}
+
+void CommandRunner::step(Grid& grid, Farmer& farmer)
+{
+    skipEmpty();
+    if (done()) return;
+
+    const Command& cmd = (*commands)[commandIndex];
+    const bool ok = applyAction(cmd, farmer);
+
+    if (cmd.type != CommandType::Wait) {
+        stats.actions++;
+        if (!ok) stats.failedActions++;
+        if (ok && cmd.type == CommandType::Harvest) stats.harvests++;
+    }
+
+    grid.tick();
+    stats.ticks++;
+
+    repeatIndex++;
+    skipEmpty();
+}
+
+RunStats runCommands(Grid& grid, Farmer& farmer, const std::vector<Command>& commands)
+{
+    CommandRunner runner(commands);
+    while (!runner.done())
+        runner.step(grid, farmer);
+    return runner.getStats();
+}
+
+std::uint64_t hashState(const Grid& grid, const Farmer& farmer)
+{
+    std::uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](std::uint64_t v) {
+        for (int b = 0; b < 8; b++) {
+            h ^= (v >> (b * 8)) & 0xff;
+            h *= 1099511628211ull;
+        }
+    };
+
+    mix(static_cast<std::uint64_t>(grid.getGridWidth()));
+    mix(static_cast<std::uint64_t>(grid.getGridHeight()));
+    const GridSpan<TileType> types = grid.types();
+    const GridSpan<CropState> states = grid.cropStates();
+    const GridSpan<int> timers = grid.growthTimers();
+    for (std::size_t i = 0; i < types.size(); i++) {
+        mix(static_cast<std::uint64_t>(types[i])
+            | (static_cast<std::uint64_t>(states[i]) << 8)
+            | (static_cast<std::uint64_t>(static_cast<std::uint32_t>(timers[i])) << 16));
+    }
+    // walls by index, so a farm without any hashes the same as before they existed
+    const GridSpan<std::uint8_t> walkable = grid.walkability();
+    for (std::size_t i = 0; i < walkable.size(); i++)
+        if (!walkable[i]) mix(i);
+    // the same for the few tiles still in a replant cooldown
+    const GridSpan<std::uint8_t> cooldowns = grid.replantCooldowns();
+    for (std::size_t i = 0; i < cooldowns.size(); i++)
+        if (cooldowns[i]) mix(i | (static_cast<std::uint64_t>(cooldowns[i]) << 32));
+    mix(static_cast<std::uint64_t>(farmer.getX()));
+    mix(static_cast<std::uint64_t>(farmer.getY()));
+    mix(static_cast<std::uint64_t>(farmer.getHarvestCount()));
+    return h;
+}
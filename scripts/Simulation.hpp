@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+#include "Grid.hpp"
+#include "Farmer.hpp"
+
+// Headless pieces for driving Grid + Farmer without a window: text layouts, scripted command
+// streams and a runner that steps them as fast as the CPU allows.
+
+// ASCII farm layout, same characters as the pygame levels plus a few for tile state:
+//   '.' empty   'S' soil   'P' planted crop   'G' grown crop
+//   'W' 'C' 'T' 'R' pre-placed (grown) crops   'F' farmer start (empty tile)
+//   'X' wall, an empty tile the farmer can't walk onto
+// blank lines and lines starting with '#' are skipped, rows must all be the same width
+struct Layout
+{
+    int width = 0;
+    int height = 0;
+    std::vector<std::string> rows;
+    int startX = 0;
+    int startY = 0;
+};
+
+Layout parseLayout(std::istream& in);
+Layout loadLayoutFile(const std::string& path);
+// writes the layout's tiles and walls into a grid of the same size
+void applyLayout(const Layout& layout, Grid& grid);
+
+// one farmer action from a command stream, each action takes one tick
+//   move up|down|left|right [n]   plant   harvest   remove   wait [n]
+enum class CommandType { Move, Plant, Harvest, Remove, Wait };
+
+struct Command
+{
+    CommandType type = CommandType::Wait;
+    direction dir = UP;
+    int count = 1;
+};
+
+// carries out one action on the farmer, without ticking. False if it failed (blocked move,
+// planting on a crop or a tile in its replant cooldown, harvesting nothing ripe, removing no
+// crop). Wait always succeeds.
+bool applyAction(const Command& cmd, Farmer& farmer);
+
+std::vector<Command> parseCommands(std::istream& in);
+std::vector<Command> loadCommandFile(const std::string& path);
+
+struct RunStats
+{
+    std::int64_t ticks = 0;
+    std::int64_t actions = 0;
+    std::int64_t failedActions = 0; // blocked moves, planting on a crop, harvesting nothing ripe, removing nothing
+    std::int64_t harvests = 0;
+};
+
+// plays a command stream one tick at a time, so a caller can interleave it with other work
+// (the commands have to outlive the runner)
+class CommandRunner
+{
+    public:
+    explicit CommandRunner(const std::vector<Command>& commands) : commands(&commands) { skipEmpty(); }
+
+    bool done() const { return commandIndex >= commands->size(); }
+
+    // runs one action (or one waited tick) and ticks the grid, does nothing once done()
+    void step(Grid& grid, Farmer& farmer);
+
+    const RunStats& getStats() const { return stats; }
+
+    private:
+    void skipEmpty();
+
+    const std::vector<Command>* commands;
+    std::size_t commandIndex = 0;
+    int repeatIndex = 0;
+    RunStats stats;
+};
+
+// plays the commands in order, ticking the grid once per action and once per waited tick
+RunStats runCommands(Grid& grid, Farmer& farmer, const std::vector<Command>& commands);
+
+// FNV-1a over every tile, the walls and the farmer, cheap way to compare two runs' final states
+std::uint64_t hashState(const Grid& grid, const Farmer& farmer);
@@ -0,0 +1,145 @@
+#include "SimulationThread.hpp"
+#include <algorithm>
+#include <chrono>
+#include "Profiler.hpp"
+
+// while fast-forwarding, stop and publish at least this often so the picture keeps moving
+static const double MAX_BATCH_SECONDS = 1.0 / 120.0;
+
+SimulationThread::SimulationThread(Grid& grid, Farmer& farmer, SnapshotExchange& snapshots, double ticksPerSecond)
+    : grid(grid), farmer(farmer), snapshots(snapshots), requestedRate(ticksPerSecond), clock(ticksPerSecond)
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+    stop();
+}
+
+void SimulationThread::start()
+{
+    if (thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = false;
+    }
+    grid.setChangeTracking(true);
+    prevFarmerX = farmer.getX();
+    prevFarmerY = farmer.getY();
+    publishOwed = true;
+    thread = std::thread([this] { run(); });
+}
+
+void SimulationThread::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (thread.joinable()) thread.join();
+}
+
+void SimulationThread::setTicksPerSecond(double ticksPerSecond)
+{
+    FixedStepClock check(ticksPerSecond); // throws on a bad rate before anything changes
+    requestedRate.store(ticksPerSecond);
+    wake.notify_all();
+}
+
+void SimulationThread::queueAction(const Command& cmd)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    actions.push_back(cmd);
+}
+
+void SimulationThread::run()
+{
+    Profiler::instance().setThreadName("simulation");
+    double last = steadySeconds();
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) break;
+        }
+
+        const double rate = requestedRate.load();
+        if (rate != clock.getTicksPerSecond()) clock.setTicksPerSecond(rate);
+
+        const double now = steadySeconds();
+        clock.advance(now - last);
+        last = now;
+
+        // run what's due, but hand a snapshot over every MAX_BATCH_SECONDS when far behind
+        const std::int64_t due = clock.ticksDue();
+        std::int64_t ran = 0;
+        while (ran < due) {
+            step();
+            ran++;
+            if ((ran & 63) == 0 && steadySeconds() - now > MAX_BATCH_SECONDS) break;
+        }
+        clock.consumeTicks(ran);
+        tickRate.add(ran, steadySeconds());
+
+        if (ran > 0) publishOwed = true;
+        if (publishOwed) publish();
+
+        // sleep until the next tick is due, a stop or a rate change wakes us early
+        double wait = clock.secondsUntilNextTick();
+        if (publishOwed) wait = std::min(wait, 0.001); // the reader had the slot, retry soon
+        if (wait > 0.0) {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait_for(lock, std::chrono::duration<double>(std::min(wait, 0.1)), [&] {
+                return stopping || requestedRate.load() != rate;
+            });
+        }
+    }
+}
+
+void SimulationThread::step()
+{
+    FARM_PROFILE_SCOPE_STAT("simulation step", ProfileStat::Tick);
+    prevFarmerX = farmer.getX();
+    prevFarmerY = farmer.getY();
+
+    Command cmd;
+    bool haveAction = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!actions.empty()) {
+            cmd = actions.front();
+            actions.pop_front();
+            haveAction = true;
+        }
+    }
+    if (haveAction) applyAction(cmd, farmer);
+
+    {
+        FARM_PROFILE_SCOPE("Grid::tick");
+        grid.tick();
+    }
+    tickCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SimulationThread::publish()
+{
+    FARM_PROFILE_SCOPE("publish snapshot");
+    SnapshotInfo info;
+    info.tick = tickCount.load(std::memory_order_relaxed);
+    info.farmerX = farmer.getX();
+    info.farmerY = farmer.getY();
+    info.prevFarmerX = prevFarmerX;
+    info.prevFarmerY = prevFarmerY;
+    info.harvests = farmer.getHarvestCount();
+    info.publishedAt = steadySeconds();
+    info.tickSeconds = clock.getTickSeconds();
+    info.targetTicksPerSecond = clock.getTicksPerSecond();
+    info.measuredTicksPerSecond = tickRate.getRate();
+
+    // the reader may be on the slot we want, then the changes keep piling up in the grid
+    // and go out with the next try
+    if (snapshots.publish(grid, grid.getChangedTiles(), grid.allTilesChanged(), info)) {
+        grid.clearChangedTiles();
+        publishOwed = false;
+    }
+}
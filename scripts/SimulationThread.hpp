@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "Farmer.hpp"
+#include "FixedStepClock.hpp"
+#include "Grid.hpp"
+#include "GridSnapshot.hpp"
+#include "Simulation.hpp"
+
+// Runs a grid and its farmer on their own thread at a fixed tick rate, independent of how
+// fast anything renders. Queued actions are played one per tick, same as CommandRunner.
+// After each batch of ticks the state goes out through the SnapshotExchange, the renderer
+// never touches the live grid.
+// The grid and farmer belong to this thread between start() and stop().
+class SimulationThread
+{
+    public:
+    SimulationThread(Grid& grid, Farmer& farmer, SnapshotExchange& snapshots, double ticksPerSecond = 4.0);
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void start();
+    void stop();
+
+    // thread safe
+    void setTicksPerSecond(double ticksPerSecond);
+    double getTicksPerSecond() const { return requestedRate.load(); }
+    void queueAction(const Command& cmd);
+    std::int64_t getTickCount() const { return tickCount.load(std::memory_order_relaxed); }
+
+    private:
+    void run();
+    void step();
+    void publish();
+
+    Grid& grid;
+    Farmer& farmer;
+    SnapshotExchange& snapshots;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::deque<Command> actions;
+
+    std::atomic<double> requestedRate;
+    std::atomic<std::int64_t> tickCount{0};
+
+    // simulation thread only
+    FixedStepClock clock;
+    RateCounter tickRate;
+    int prevFarmerX = 0;
+    int prevFarmerY = 0;
+    bool publishOwed = true;
+};
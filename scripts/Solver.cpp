@@ -0,0 +1,896 @@
+#include "Solver.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+#include "WorkerPool.hpp"
+
+namespace {
+
+// what the farmer does with a tick. Moves first and in the direction enum's order.
+enum Action : std::uint8_t { ActLeft, ActUp, ActDown, ActRight, ActPlant, ActHarvest, ActRemove, ActWait, ACTION_COUNT };
+
+const int DX[4] = { -1, 0, 0, 1 };
+const int DY[4] = { 0, -1, 1, 0 };
+
+// a tile in a search state is one byte: 0 no crop, otherwise the ticks until it's ripe + 1
+// (1 is ripe), with FIXED_CROP set while it's still the crop the level started with (its kind
+// is in SolverProblem::crops). An empty tile still in its replant cooldown is RECOVERING plus
+// the ticks until it can be planted. Counting down instead of storing the planting tick keeps
+// the state relative, so the same farm a tick later hashes the same.
+const std::uint8_t FIXED_CROP = 0x80;
+const std::uint8_t RECOVERING = 0x40;
+const std::uint8_t TICKS_MASK = 0x3f;
+
+bool hasCrop(std::uint8_t c) { return c != 0 && !(c & RECOVERING); }
+
+const int NO_BOUND = INT_MAX / 4;
+const std::uint16_t FAR = 0xffff;
+
+// at the front of every state, the tile bytes follow
+struct StateHeader
+{
+    std::int16_t pos;
+    std::int16_t flex;     // harvests of crops the farmer planted (of every crop without requirements)
+    std::int16_t fixed[4]; // harvests of the level's own crops per kind, capped at what's required
+};
+
+std::uint64_t splitMix(std::uint64_t& x)
+{
+    std::uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Lock-free, one entry per slot, always replaced. The key is stored xor'd with the data
+// (Hyatt's trick) so an entry torn by two threads writing it at once just misses.
+class TranspositionTable
+{
+    public:
+    explicit TranspositionTable(std::size_t entryCount) : entries(new Entry[entryCount]), mask(entryCount - 1)
+    {
+        for (std::size_t i = 0; i < entryCount; i++) {
+            entries[i].check.store(0, std::memory_order_relaxed);
+            entries[i].data.store(~0ull, std::memory_order_relaxed);
+        }
+    }
+
+    // true if the state was already reached by tick g, otherwise remembers it at g
+    bool seen(std::uint64_t key, std::uint64_t g)
+    {
+        Entry& e = entries[key & mask];
+        const std::uint64_t data = e.data.load(std::memory_order_relaxed);
+        const std::uint64_t check = e.check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && data <= g) return true;
+        e.data.store(g, std::memory_order_relaxed);
+        e.check.store(key ^ g, std::memory_order_relaxed);
+        return false;
+    }
+
+    private:
+    struct Entry
+    {
+        std::atomic<std::uint64_t> check;
+        std::atomic<std::uint64_t> data;
+    };
+    std::unique_ptr<Entry[]> entries;
+    std::size_t mask;
+};
+
+constexpr std::size_t TABLE_ENTRY_BYTES = 16;
+constexpr std::size_t MIN_TABLE_ENTRIES = 1024;
+
+class Search
+{
+    public:
+    Search(const SolverProblem& p) : problem(p)
+    {
+        tiles = p.width * p.height;
+        if (tiles <= 0 || tiles > INT16_MAX) throw std::invalid_argument("solver: bad grid size");
+        if (p.walkable.size() != static_cast<std::size_t>(tiles) || p.readyIn.size() != p.walkable.size()
+            || p.cooldowns.size() != p.walkable.size() || p.crops.size() != p.walkable.size())
+            throw std::invalid_argument("solver: problem arrays must have one entry per tile");
+        if (p.growTicks < 1 || p.growTicks + 1 > TICKS_MASK) throw std::invalid_argument("solver: growth time out of range");
+        if (p.replantCooldown < 0 || p.replantCooldown + 1 > TICKS_MASK
+            || std::any_of(p.cooldowns.begin(), p.cooldowns.end(), [](int c) { return c < 0 || c > TICKS_MASK; }))
+            throw std::invalid_argument("solver: replant cooldown out of range");
+        start = p.startY * p.width + p.startX;
+        if (p.startX < 0 || p.startX >= p.width || p.startY < 0 || p.startY >= p.height)
+            throw std::invalid_argument("solver: farmer starts off the grid");
+
+        byKinds = !p.objective.cropRequirements.empty();
+        if (byKinds) {
+            for (const auto& r : p.objective.cropRequirements) {
+                const int k = static_cast<int>(r.first) - 1;
+                if (k < 0 || k >= 4) throw std::invalid_argument("solver: crop requirement for an unknown crop");
+                required[k] += std::max(0, r.second);
+            }
+        } else {
+            // ScriptVM only checks for a win after a harvest, so it's always at least one
+            required[0] = std::max(1, p.objective.harvestsRequired);
+        }
+        for (int k = 0; k < 4; k++) {
+            totalRequired += required[k];
+            if (required[k] > INT16_MAX) throw std::invalid_argument("solver: too many harvests required");
+        }
+
+        stateBytes = (sizeof(StateHeader) + static_cast<std::size_t>(tiles) + 7) & ~static_cast<std::size_t>(7);
+        buildGraph();
+        buildKeys();
+    }
+
+    std::size_t stateSize() const { return stateBytes; }
+
+    void initial(std::uint8_t* s) const
+    {
+        std::memset(s, 0, stateBytes);
+        StateHeader& h = header(s);
+        h.pos = static_cast<std::int16_t>(start);
+        std::uint8_t* t = s + sizeof(StateHeader);
+        for (int i = 0; i < tiles; i++) {
+            if (problem.readyIn[i] < 0) {
+                // a cooldown under a crop doesn't matter, removing it starts a new one
+                if (problem.cooldowns[i] > 0) t[i] = static_cast<std::uint8_t>(RECOVERING | problem.cooldowns[i]);
+                continue;
+            }
+            const int left = std::min(std::max(problem.readyIn[i], 0), problem.growTicks);
+            t[i] = static_cast<std::uint8_t>(left + 1);
+            // without requirements every crop is as good as another, leaving them unmarked
+            // lets the table merge more states
+            if (byKinds) t[i] |= FIXED_CROP;
+        }
+    }
+
+    static StateHeader& header(std::uint8_t* s) { return *reinterpret_cast<StateHeader*>(s); }
+    static const StateHeader& header(const std::uint8_t* s) { return *reinterpret_cast<const StateHeader*>(s); }
+
+    // harvests still missing, 0 is a win
+    int need(const std::uint8_t* s) const
+    {
+        const StateHeader& h = header(s);
+        if (!byKinds) return std::max(0, required[0] - h.flex);
+        int missing = 0;
+        for (int k = 0; k < 4; k++) missing += std::max(0, required[k] - h.fixed[k]);
+        return std::max(0, missing - h.flex);
+    }
+
+    // whether harvesting a crop with this byte on tile i moves the counts
+    bool useful(const std::uint8_t* s, int i, std::uint8_t c) const
+    {
+        if (!(c & FIXED_CROP)) return true;
+        const int k = kindOf[static_cast<std::size_t>(i)];
+        return k >= 0 && header(s).fixed[k] < required[k];
+    }
+
+    // Admissible lower bound on the ticks left, NO_BOUND when the objective is out of reach.
+    // The larger of two:
+    //  - timing: each useful crop can't be harvested before it's ripe and the farmer is on
+    //    it, each crop still to plant can't be planted before the farmer reaches a free tile
+    //    and one plant a tick after that, and harvests take a tick each. The need earliest
+    //    finishing harvests, taken one a tick.
+    //  - ticks spent: every missing harvest and plant is a tick, and a farmer that stays on one
+    //    tile gets at most one harvest per growth cycle (harvest, sit out the cooldown, plant,
+    //    wait for it), so the rest have to be separated by moves
+    int bound(const std::uint8_t* s, std::vector<int>& times) const
+    {
+        const int n = need(s);
+        if (n == 0) return 0;
+        const StateHeader& h = header(s);
+        const std::uint8_t* t = s + sizeof(StateHeader);
+        const std::uint16_t* d = dist.data() + static_cast<std::size_t>(h.pos) * tiles;
+
+        times.clear();
+        int freeAt = NO_BOUND; // when the first plant can happen
+        int flexOnField = 0;
+        int fixedOnField[4] = {};
+        for (int i = 0; i < tiles; i++) {
+            if (d[i] == FAR) continue;
+            const std::uint8_t c = t[i];
+            if (!hasCrop(c)) {
+                // free, or once its cooldown is over
+                freeAt = std::min(freeAt, std::max(static_cast<int>(d[i]), c == 0 ? 0 : c & TICKS_MASK));
+                continue;
+            }
+            const int done = std::max(static_cast<int>(d[i]), (c & TICKS_MASK) - 1) + 1;
+            // removed on arrival at the earliest, then the cooldown
+            freeAt = std::min(freeAt, static_cast<int>(d[i]) + 1 + problem.replantCooldown);
+            if (!useful(s, i, c)) continue;
+            times.push_back(done);
+            if (c & FIXED_CROP) fixedOnField[kindOf[static_cast<std::size_t>(i)]]++;
+            else flexOnField++;
+        }
+
+        int onField = flexOnField;
+        for (int k = 0; k < 4; k++) onField += std::min(fixedOnField[k], std::max(0, required[k] - h.fixed[k]));
+        const int plants = std::max(0, n - onField);
+        if (plants > 0 && !problem.canPlant) return NO_BOUND;
+        for (int j = 0; j < plants && j < n; j++) times.push_back(freeAt + j + problem.growTicks + 1);
+        if (static_cast<int>(times.size()) < n) return NO_BOUND;
+
+        std::nth_element(times.begin(), times.begin() + (n - 1), times.end());
+        std::sort(times.begin(), times.begin() + (n - 1));
+        int timing = 0;
+        for (int j = 0; j < n; j++) timing = std::max(timing, times[static_cast<std::size_t>(j)] + n - 1 - j);
+
+        // S stays (S - 1 moves) with T ticks: n <= S + (T - 2S + 1) / cycle and T >= n + plants + S - 1,
+        // solved for the smallest T
+        int spent = n + plants;
+        const int cycle = problem.growTicks + 1 + problem.replantCooldown;
+        if (cycle > 2) {
+            const long long num = static_cast<long long>(n + plants - 1) * (cycle - 2) + static_cast<long long>(n) * cycle - 1;
+            spent = std::max(spent, static_cast<int>((num + cycle - 2) / (cycle - 1)));
+        }
+        return std::max(timing, spent);
+    }
+
+    std::uint64_t hash(const std::uint8_t* s) const
+    {
+        const StateHeader& h = header(s);
+        std::uint64_t key = posKeys[static_cast<std::size_t>(h.pos)];
+        const std::uint8_t* t = s + sizeof(StateHeader);
+        for (int i = 0; i < tiles; i++)
+            if (t[i]) key ^= tileKeys[static_cast<std::size_t>(i) * 256 + t[i]];
+        key ^= countKeys[0][static_cast<std::size_t>(h.flex)];
+        for (int k = 0; k < 4; k++) key ^= countKeys[k + 1][static_cast<std::size_t>(h.fixed[k])];
+        return key;
+    }
+
+    // Every state one tick on from s into out (stateSize() apart), the action taken into
+    // actions. Removing is only tried on a crop that isn't ripe (harvesting one is never
+    // worse), and waiting only when something is growing and there's nothing to plant or
+    // harvest underfoot: doing that instead is never worse either.
+    int expand(const std::uint8_t* s, std::uint8_t* out, std::uint8_t* actions) const
+    {
+        const StateHeader& h = header(s);
+        const std::uint8_t* t = s + sizeof(StateHeader);
+        const std::uint8_t here = t[h.pos];
+        int count = 0;
+        auto emit = [&](Action a) -> std::uint8_t* {
+            std::uint8_t* c = out + static_cast<std::size_t>(count) * stateBytes;
+            std::memcpy(c, s, stateBytes);
+            actions[count++] = a;
+            return c;
+        };
+
+        for (int a = 0; a < 4; a++) {
+            const int to = neighbours[static_cast<std::size_t>(h.pos) * 4 + a];
+            if (to < 0) continue;
+            header(emit(static_cast<Action>(a))).pos = static_cast<std::int16_t>(to);
+        }
+        const bool canHarvest = hasCrop(here) && (here & TICKS_MASK) == 1;
+        // +1 for the tick this action takes
+        const std::uint8_t cleared = static_cast<std::uint8_t>(RECOVERING | (problem.replantCooldown + 1));
+        const bool canPlantHere = here == 0 && problem.canPlant;
+        if (canPlantHere) {
+            std::uint8_t* c = emit(ActPlant);
+            c[sizeof(StateHeader) + h.pos] = static_cast<std::uint8_t>(problem.growTicks + 1);
+        }
+        if (canHarvest) {
+            std::uint8_t* c = emit(ActHarvest);
+            StateHeader& ch = header(c);
+            c[sizeof(StateHeader) + h.pos] = cleared;
+            if (here & FIXED_CROP) {
+                const int k = kindOf[static_cast<std::size_t>(h.pos)];
+                if (k >= 0 && ch.fixed[k] < required[k]) ch.fixed[k]++;
+            } else if (ch.flex < totalRequired) {
+                ch.flex++;
+            }
+        }
+        if (hasCrop(here) && !canHarvest) emit(ActRemove)[sizeof(StateHeader) + h.pos] = cleared;
+        if (!canHarvest && !canPlantHere) {
+            bool growing = false;
+            for (int i = 0; i < tiles && !growing; i++) growing = (t[i] & TICKS_MASK) > 1 || (t[i] & RECOVERING);
+            if (growing) emit(ActWait);
+        }
+
+        // then the tick
+        for (int j = 0; j < count; j++) {
+            std::uint8_t* c = out + static_cast<std::size_t>(j) * stateBytes + sizeof(StateHeader);
+            for (int i = 0; i < tiles; i++) {
+                if ((c[i] & TICKS_MASK) > 1) c[i]--;
+                else if (c[i] & RECOVERING) c[i] = 0;
+            }
+        }
+        return count;
+    }
+
+    int tileCount() const { return tiles; }
+    int startTile() const { return start; }
+    int kindAt(int i) const { return kindOf[static_cast<std::size_t>(i)]; }
+    bool usesKinds() const { return byKinds; }
+    int requiredOf(int k) const { return required[k]; }
+
+    private:
+    void buildGraph()
+    {
+        const int w = problem.width;
+        neighbours.assign(static_cast<std::size_t>(tiles) * 4, -1);
+        kindOf.assign(static_cast<std::size_t>(tiles), -1);
+        for (int i = 0; i < tiles; i++) {
+            const int k = static_cast<int>(problem.crops[static_cast<std::size_t>(i)]) - 1;
+            if (k >= 0 && k < 4) kindOf[static_cast<std::size_t>(i)] = k;
+            if (!problem.walkable[static_cast<std::size_t>(i)]) continue;
+            for (int a = 0; a < 4; a++) {
+                const int x = i % w + DX[a];
+                const int y = i / w + DY[a];
+                if (x < 0 || x >= w || y < 0 || y >= problem.height) continue;
+                if (!problem.walkable[static_cast<std::size_t>(y * w + x)]) continue;
+                neighbours[static_cast<std::size_t>(i) * 4 + a] = y * w + x;
+            }
+        }
+
+        // all pairs, a BFS from every tile
+        dist.assign(static_cast<std::size_t>(tiles) * tiles, FAR);
+        std::vector<int> queue(static_cast<std::size_t>(tiles));
+        for (int from = 0; from < tiles; from++) {
+            std::uint16_t* d = dist.data() + static_cast<std::size_t>(from) * tiles;
+            std::size_t head = 0, tail = 0;
+            d[from] = 0;
+            queue[tail++] = from;
+            while (head < tail) {
+                const int at = queue[head++];
+                for (int a = 0; a < 4; a++) {
+                    const int to = neighbours[static_cast<std::size_t>(at) * 4 + a];
+                    if (to < 0 || d[to] != FAR) continue;
+                    d[to] = static_cast<std::uint16_t>(d[at] + 1);
+                    queue[tail++] = to;
+                }
+            }
+        }
+    }
+
+    void buildKeys()
+    {
+        std::uint64_t seed = 0x5eedf4a3ull;
+        tileKeys.resize(static_cast<std::size_t>(tiles) * 256);
+        for (std::uint64_t& k : tileKeys) k = splitMix(seed);
+        posKeys.resize(static_cast<std::size_t>(tiles));
+        for (std::uint64_t& k : posKeys) k = splitMix(seed);
+        for (int c = 0; c < 5; c++) {
+            countKeys[c].resize(static_cast<std::size_t>(totalRequired) + 1);
+            for (std::uint64_t& k : countKeys[c]) k = splitMix(seed);
+        }
+    }
+
+    const SolverProblem& problem;
+    int tiles = 0;
+    int start = 0;
+    bool byKinds = false;
+    int required[4] = {}; // per kind, or required[0] the harvest count without requirements
+    int totalRequired = 0;
+    std::size_t stateBytes = 0;
+    std::vector<int> neighbours; // 4 per tile, -1 for an edge or wall
+    std::vector<int> kindOf;     // 0-3 from Wheat, -1 none or Unknown
+    std::vector<std::uint16_t> dist;
+    std::vector<std::uint64_t> tileKeys; // 256 per tile, by tile byte
+    std::vector<std::uint64_t> posKeys;
+    std::vector<std::uint64_t> countKeys[5]; // flex, then the 4 kinds, by count
+};
+
+// the best schedule so far, shared by the search threads
+struct Incumbent
+{
+    std::atomic<int> ticks{ NO_BOUND };
+    std::mutex mutex;
+    std::vector<std::uint8_t> actions;
+
+    void offer(const std::vector<std::uint8_t>& prefix, const std::vector<std::uint8_t>& path, std::uint8_t last)
+    {
+        const int length = static_cast<int>(prefix.size() + path.size()) + 1;
+        if (length >= ticks.load(std::memory_order_relaxed)) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (length >= ticks.load(std::memory_order_relaxed)) return;
+        actions = prefix;
+        actions.insert(actions.end(), path.begin(), path.end());
+        actions.push_back(last);
+        ticks.store(length, std::memory_order_relaxed);
+    }
+};
+
+// Breadth-first, keeping the width states with the lowest bound every tick (ties to the one
+// with fewer harvests missing, then by hash so every run keeps the same ones). Expansion is
+// split over the pool, picking the survivors is serial.
+void beamSearch(const Search& search, WorkerPool& pool, int width, int maxTicks, std::size_t seenCap,
+                Incumbent& incumbent)
+{
+    const std::size_t bytes = search.stateSize();
+    struct Candidate
+    {
+        int bound;
+        int need;
+        std::uint64_t key;
+        std::uint32_t parent;
+        std::uint8_t action;
+        std::uint8_t* state;
+    };
+    struct Chunk
+    {
+        std::vector<std::uint8_t> states;
+        std::vector<Candidate> candidates;
+        std::vector<int> times;
+    };
+
+    std::vector<std::uint8_t> layer(bytes);
+    search.initial(layer.data());
+    std::size_t layerCount = 1;
+    // parent index and action of every kept state, per tick, to walk the schedule back
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint8_t>>> trail;
+    std::unordered_set<std::uint64_t> seen;
+    seen.insert(search.hash(layer.data()));
+
+    const int chunkCount = pool.getThreadCount() * 4;
+    std::vector<Chunk> chunks(static_cast<std::size_t>(chunkCount));
+    std::vector<Candidate> all;
+    std::vector<std::uint8_t> next;
+
+    for (int depth = 0; depth < maxTicks && layerCount > 0 && depth + 1 < incumbent.ticks.load(); depth++) {
+        const std::size_t perChunk = (layerCount + chunkCount - 1) / chunkCount;
+        pool.run(chunkCount, [&](int c) {
+            Chunk& chunk = chunks[static_cast<std::size_t>(c)];
+            const std::size_t first = std::min(layerCount, perChunk * c);
+            const std::size_t last = std::min(layerCount, first + perChunk);
+            chunk.states.resize((last - first) * ACTION_COUNT * bytes);
+            chunk.candidates.clear();
+            std::uint8_t actions[ACTION_COUNT];
+            for (std::size_t i = first; i < last; i++) {
+                std::uint8_t* out = chunk.states.data() + (i - first) * ACTION_COUNT * bytes;
+                const int n = search.expand(layer.data() + i * bytes, out, actions);
+                for (int j = 0; j < n; j++) {
+                    std::uint8_t* child = out + static_cast<std::size_t>(j) * bytes;
+                    const int b = search.bound(child, chunk.times);
+                    if (b >= NO_BOUND) continue;
+                    chunk.candidates.push_back({ b, search.need(child), search.hash(child), static_cast<std::uint32_t>(i),
+                                                 actions[j], child });
+                }
+            }
+        });
+
+        all.clear();
+        for (const Chunk& chunk : chunks) all.insert(all.end(), chunk.candidates.begin(), chunk.candidates.end());
+        auto walkBack = [&](std::uint32_t parent, std::uint8_t action) {
+            std::vector<std::uint8_t> path(trail.size() + 1);
+            path.back() = action;
+            for (std::size_t d = trail.size(); d-- > 0;) {
+                path[d] = trail[d][parent].second;
+                parent = trail[d][parent].first;
+            }
+            return path;
+        };
+        for (const Candidate& c : all) {
+            if (c.need != 0) continue;
+            std::lock_guard<std::mutex> lock(incumbent.mutex);
+            incumbent.actions = walkBack(c.parent, c.action);
+            incumbent.ticks.store(depth + 1);
+            return;
+        }
+
+        std::sort(all.begin(), all.end(), [](const Candidate& a, const Candidate& b) {
+            if (a.bound != b.bound) return a.bound < b.bound;
+            if (a.need != b.need) return a.need < b.need;
+            if (a.key != b.key) return a.key < b.key;
+            if (a.parent != b.parent) return a.parent < b.parent;
+            return a.action < b.action;
+        });
+        if (seen.size() > seenCap) seen.clear();
+        next.resize(std::min(all.size(), static_cast<std::size_t>(width)) * bytes);
+        trail.emplace_back();
+        std::size_t kept = 0;
+        for (const Candidate& c : all) {
+            if (kept == static_cast<std::size_t>(width)) break;
+            if (!seen.insert(c.key).second) continue;
+            std::memcpy(next.data() + kept * bytes, c.state, bytes);
+            trail.back().push_back({ c.parent, c.action });
+            kept++;
+        }
+        layer.swap(next);
+        layerCount = kept;
+    }
+}
+
+// the parallel depth-first branch-and-bound, from the states a few ticks in
+class BranchAndBound
+{
+    public:
+    BranchAndBound(const Search& search, TranspositionTable& table, Incumbent& incumbent, std::int64_t maxNodes)
+        : search(search), table(table), incumbent(incumbent), maxNodes(maxNodes)
+    {
+    }
+
+    // returns the proven lower bound: the optimum when the search finished
+    int run(WorkerPool& pool, int rootBound)
+    {
+        const std::size_t bytes = search.stateSize();
+        struct Start
+        {
+            std::vector<std::uint8_t> state;
+            std::vector<std::uint8_t> path;
+            int bound;
+        };
+        std::vector<Start> frontier(1);
+        frontier[0].state.resize(bytes);
+        search.initial(frontier[0].state.data());
+        frontier[0].bound = rootBound;
+        table.seen(search.hash(frontier[0].state.data()), 0);
+
+        // breadth-first until there's enough to keep every thread busy and balanced
+        const std::size_t wanted = static_cast<std::size_t>(pool.getThreadCount()) * 16;
+        std::vector<std::uint8_t> children(ACTION_COUNT * bytes);
+        std::uint8_t actions[ACTION_COUNT];
+        std::vector<int> times;
+        for (int g = 0; frontier.size() < wanted && !frontier.empty() && g < 24; g++) {
+            std::vector<Start> next;
+            for (const Start& node : frontier) {
+                const int n = search.expand(node.state.data(), children.data(), actions);
+                nodes.fetch_add(1, std::memory_order_relaxed);
+                for (int j = 0; j < n; j++) {
+                    const std::uint8_t* child = children.data() + static_cast<std::size_t>(j) * bytes;
+                    if (search.need(child) == 0) {
+                        incumbent.offer({}, node.path, actions[j]);
+                        continue;
+                    }
+                    const int b = search.bound(child, times);
+                    if (g + 1 + b >= incumbent.ticks.load(std::memory_order_relaxed)) continue;
+                    if (table.seen(search.hash(child), static_cast<std::uint64_t>(g + 1))) {
+                        hits.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    Start s;
+                    s.state.assign(child, child + bytes);
+                    s.path = node.path;
+                    s.path.push_back(actions[j]);
+                    s.bound = g + 1 + b;
+                    next.push_back(std::move(s));
+                }
+            }
+            frontier.swap(next);
+        }
+
+        // most promising first, the pool hands them out in order
+        std::stable_sort(frontier.begin(), frontier.end(), [](const Start& a, const Start& b) { return a.bound < b.bound; });
+        std::vector<std::uint8_t> finished(frontier.size(), 0);
+        pool.run(static_cast<int>(frontier.size()), [&](int i) {
+            const Start& s = frontier[static_cast<std::size_t>(i)];
+            Worker w;
+            w.prefix = &s.path;
+            dive(w, s.state.data(), static_cast<int>(s.path.size()), 0);
+            nodes.fetch_add(w.nodes, std::memory_order_relaxed);
+            hits.fetch_add(w.hits, std::memory_order_relaxed);
+            if (!aborted.load(std::memory_order_relaxed)) finished[static_cast<std::size_t>(i)] = 1;
+        });
+
+        int proven = incumbent.ticks.load();
+        for (std::size_t i = 0; i < frontier.size(); i++)
+            if (!finished[i]) proven = std::min(proven, frontier[i].bound);
+        return std::max(rootBound, proven);
+    }
+
+    bool wasAborted() const { return aborted.load(); }
+    std::int64_t nodeCount() const { return nodes.load(); }
+    std::int64_t hitCount() const { return hits.load(); }
+
+    private:
+    static constexpr std::int64_t NODE_BATCH = 1024;
+
+    struct Worker
+    {
+        const std::vector<std::uint8_t>* prefix = nullptr;
+        std::vector<std::uint8_t> path;
+        std::vector<std::vector<std::uint8_t>> children; // per depth
+        std::vector<int> times;
+        std::int64_t nodes = 0;
+        std::int64_t hits = 0;
+    };
+
+    void dive(Worker& w, const std::uint8_t* s, int g, std::size_t depth)
+    {
+        if (aborted.load(std::memory_order_relaxed)) return;
+        // counted into the shared total a batch at a time
+        if (++w.nodes == NODE_BATCH) {
+            w.nodes = 0;
+            if (nodes.fetch_add(NODE_BATCH, std::memory_order_relaxed) + NODE_BATCH >= maxNodes) {
+                aborted.store(true);
+                return;
+            }
+        }
+
+        const std::size_t bytes = search.stateSize();
+        if (w.children.size() <= depth) w.children.emplace_back(ACTION_COUNT * (bytes + 8));
+        // the deeper calls can grow w.children, but not move what's in the buffers
+        std::uint8_t* buffer = w.children[depth].data();
+        std::uint8_t actions[ACTION_COUNT];
+        const int n = search.expand(s, buffer, actions);
+
+        // children by bound, ties in action order. An insertion as each comes in, there are
+        // at most ACTION_COUNT (std::sort on the array trips GCC 12's -Warray-bounds)
+        std::pair<int, int> order[ACTION_COUNT];
+        int kept = 0;
+        for (int j = 0; j < n; j++) {
+            const std::uint8_t* child = buffer + static_cast<std::size_t>(j) * bytes;
+            if (search.need(child) == 0) {
+                incumbent.offer(*w.prefix, w.path, actions[j]);
+                continue;
+            }
+            const int f = g + 1 + search.bound(child, w.times);
+            if (f >= incumbent.ticks.load(std::memory_order_relaxed)) continue;
+            int at = kept++;
+            for (; at > 0 && order[at - 1].first > f; at--) order[at] = order[at - 1];
+            order[at] = { f, j };
+        }
+
+        for (int o = 0; o < kept; o++) {
+            if (order[o].first >= incumbent.ticks.load(std::memory_order_relaxed)) break;
+            const std::uint8_t* child = buffer + static_cast<std::size_t>(order[o].second) * bytes;
+            if (table.seen(search.hash(child), static_cast<std::uint64_t>(g + 1))) {
+                w.hits++;
+                continue;
+            }
+            w.path.push_back(actions[order[o].second]);
+            dive(w, child, g + 1, depth + 1);
+            w.path.pop_back();
+            if (aborted.load(std::memory_order_relaxed)) return;
+        }
+    }
+
+    const Search& search;
+    TranspositionTable& table;
+    Incumbent& incumbent;
+    const std::int64_t maxNodes;
+    std::atomic<std::int64_t> nodes{ 0 };
+    std::atomic<std::int64_t> hits{ 0 };
+    std::atomic<bool> aborted{ false };
+};
+
+// turns the actions into commands, and hands the planted crops their kinds: replayed on the
+// problem, each harvest of a planted crop gets the first kind still short at the end
+void buildSchedule(const Search& search, const SolverProblem& problem, const std::vector<std::uint8_t>& actions,
+                   SolverResult& result)
+{
+    const int w = problem.width;
+    int pos = search.startTile();
+    std::vector<int> plantOn(static_cast<std::size_t>(search.tileCount()), -1); // plant index on each tile
+    std::vector<bool> original(static_cast<std::size_t>(search.tileCount()));
+    for (int i = 0; i < search.tileCount(); i++) original[static_cast<std::size_t>(i)] = problem.readyIn[static_cast<std::size_t>(i)] >= 0;
+    std::vector<int> harvestedPlants;
+    int fixedHarvests[4] = {};
+    int plants = 0;
+
+    result.schedule.clear();
+    for (std::uint8_t a : actions) {
+        Command cmd;
+        if (a < 4) {
+            cmd.type = CommandType::Move;
+            cmd.dir = static_cast<direction>(a);
+            pos += DY[a] * w + DX[a];
+        } else if (a == ActPlant) {
+            cmd.type = CommandType::Plant;
+            plantOn[static_cast<std::size_t>(pos)] = plants++;
+        } else if (a == ActHarvest) {
+            cmd.type = CommandType::Harvest;
+            if (original[static_cast<std::size_t>(pos)]) {
+                original[static_cast<std::size_t>(pos)] = false;
+                const int k = search.kindAt(pos);
+                if (k >= 0) fixedHarvests[k]++;
+            } else {
+                harvestedPlants.push_back(plantOn[static_cast<std::size_t>(pos)]);
+            }
+            plantOn[static_cast<std::size_t>(pos)] = -1;
+        } else if (a == ActRemove) {
+            cmd.type = CommandType::Remove;
+            original[static_cast<std::size_t>(pos)] = false;
+            plantOn[static_cast<std::size_t>(pos)] = -1;
+        } else {
+            cmd.type = CommandType::Wait;
+        }
+        result.schedule.push_back(cmd);
+    }
+
+    int shortBy[4] = {};
+    CropKind spare = CropKind::Wheat;
+    if (search.usesKinds()) {
+        for (int k = 3; k >= 0; k--) {
+            shortBy[k] = std::max(0, search.requiredOf(k) - fixedHarvests[k]);
+            if (search.requiredOf(k) > 0) spare = static_cast<CropKind>(k + 1);
+        }
+    }
+    result.plantKinds.assign(static_cast<std::size_t>(plants), spare);
+    for (int p : harvestedPlants) {
+        for (int k = 0; k < 4; k++) {
+            if (shortBy[k] == 0) continue;
+            shortBy[k]--;
+            result.plantKinds[static_cast<std::size_t>(p)] = static_cast<CropKind>(k + 1);
+            break;
+        }
+    }
+}
+
+const char* directionWord(direction d)
+{
+    switch (d) {
+    case LEFT: return "left";
+    case UP: return "up";
+    case DOWN: return "down";
+    case RIGHT: return "right";
+    }
+    return "?";
+}
+
+std::string lowerName(CropKind kind)
+{
+    std::string s = cropKindName(kind);
+    for (char& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+} // namespace
+
+SolverProblem makeSolverProblem(const Grid& grid, const Farmer& farmer, const std::vector<CropKind>& crops,
+                                const ScriptObjective& objective, const std::vector<std::string>& allowed)
+{
+    const int w = grid.getGridWidth();
+    const int h = grid.getGridHeight();
+    if (crops.size() != static_cast<std::size_t>(w) * h)
+        throw std::invalid_argument("makeSolverProblem: crops must have one entry per tile");
+
+    SolverProblem p;
+    p.width = w;
+    p.height = h;
+    p.startX = farmer.getX();
+    p.startY = farmer.getY();
+    p.crops = crops;
+    p.objective = objective;
+    p.canPlant = allowed.empty() || std::find(allowed.begin(), allowed.end(), "plant") != allowed.end();
+    p.walkable.assign(grid.walkability().begin(), grid.walkability().end());
+
+    // how long growing takes, and when each crop already there ripens: asked of the grid
+    // itself rather than worked out from its timers
+    {
+        Grid probe(1, 1, grid.getGrowthMode());
+        Farmer planter(probe);
+        planter.plant();
+        int ticks = 0;
+        while (probe.getTile(0, 0).cropstate != CropState::GROWN) {
+            if (++ticks > TICKS_MASK) throw std::runtime_error("makeSolverProblem: crops never ripen");
+            probe.tick();
+        }
+        p.growTicks = ticks;
+
+        // and how many plants fail after a harvest before one takes
+        planter.harvest();
+        int cooldown = 0;
+        for (probe.tick(); !planter.plant(); probe.tick()) {
+            if (++cooldown >= TICKS_MASK) throw std::runtime_error("makeSolverProblem: harvested tiles never take a crop again");
+        }
+        p.replantCooldown = cooldown;
+    }
+    p.readyIn.assign(static_cast<std::size_t>(w) * h, -1);
+    const GridSpan<std::uint8_t> cooldowns = grid.replantCooldowns();
+    p.cooldowns.assign(cooldowns.begin(), cooldowns.end());
+    Grid ahead = grid;
+    std::vector<int> growing;
+    const GridSpan<TileType> types = grid.types();
+    const GridSpan<CropState> states = grid.cropStates();
+    for (int i = 0; i < w * h; i++) {
+        if (types[static_cast<std::size_t>(i)] != TileType::CROP) continue;
+        if (states[static_cast<std::size_t>(i)] == CropState::GROWN) p.readyIn[static_cast<std::size_t>(i)] = 0;
+        else growing.push_back(i);
+    }
+    for (int t = 1; !growing.empty(); t++) {
+        if (t > p.growTicks) throw std::runtime_error("makeSolverProblem: a crop takes longer than a fresh one to ripen");
+        ahead.tick();
+        const GridSpan<CropState> now = ahead.cropStates();
+        growing.erase(std::remove_if(growing.begin(), growing.end(), [&](int i) {
+            if (now[static_cast<std::size_t>(i)] != CropState::GROWN) return false;
+            p.readyIn[static_cast<std::size_t>(i)] = t;
+            return true;
+        }), growing.end());
+    }
+    return p;
+}
+
+const char* solveStatusName(SolveStatus status)
+{
+    switch (status) {
+    case SolveStatus::Optimal: return "optimal";
+    case SolveStatus::BestFound: return "best found";
+    case SolveStatus::NoSolution: return "no solution";
+    }
+    return "?";
+}
+
+SolverResult solveLevel(const SolverProblem& problem, const SolverOptions& options)
+{
+    const Search search(problem);
+    SolverResult result;
+
+    // the beam's layer, its children and their bookkeeping, and the trail, per state kept
+    const std::size_t bytes = search.stateSize();
+    const std::size_t perBeamState = bytes * (1 + ACTION_COUNT) + ACTION_COUNT * 40 + 64;
+    const std::size_t beamBudget = options.memoryBytes / 2;
+    const std::size_t fitWidth = beamBudget / perBeamState;
+    result.beamWidth = static_cast<int>(std::min<std::size_t>(static_cast<std::size_t>(std::max(1, options.beamWidth)), fitWidth));
+    // whatever the frontier and the threads' stacks need is small next to the table
+    std::size_t tableEntries = 1;
+    while (tableEntries * 2 * TABLE_ENTRY_BYTES <= options.memoryBytes * 3 / 4) tableEntries *= 2;
+    if (result.beamWidth < 1 || tableEntries < MIN_TABLE_ENTRIES)
+        throw std::invalid_argument("solver: memory cap of " + std::to_string(options.memoryBytes)
+                                    + " bytes is too small for this level");
+    result.tableEntries = tableEntries;
+
+    WorkerPool pool(options.threads);
+    result.threads = pool.getThreadCount();
+
+    std::vector<std::uint8_t> root(bytes);
+    search.initial(root.data());
+    std::vector<int> times;
+    const int rootBound = search.bound(root.data(), times);
+    if (rootBound >= NO_BOUND) return result;
+    result.lowerBound = rootBound;
+
+    Incumbent incumbent;
+    incumbent.ticks.store(options.maxTicks + 1);
+    {
+        // the beam frees its memory before the table is made
+        const std::size_t seenCap = beamBudget / 2 / 48;
+        beamSearch(search, pool, result.beamWidth, options.maxTicks, seenCap, incumbent);
+    }
+    if (incumbent.ticks.load() <= options.maxTicks) result.beamTicks = incumbent.ticks.load();
+
+    int proven = rootBound;
+    bool complete = result.beamTicks == rootBound;
+    if (!complete) {
+        TranspositionTable table(tableEntries);
+        BranchAndBound bnb(search, table, incumbent, options.maxNodes);
+        proven = bnb.run(pool, rootBound);
+        complete = !bnb.wasAborted();
+        result.nodes = bnb.nodeCount();
+        result.tableHits = bnb.hitCount();
+    }
+
+    if (incumbent.ticks.load() > options.maxTicks) {
+        result.lowerBound = complete ? options.maxTicks + 1 : proven;
+        return result;
+    }
+    result.ticks = incumbent.ticks.load();
+    result.status = complete ? SolveStatus::Optimal : SolveStatus::BestFound;
+    result.lowerBound = complete ? result.ticks : std::min(proven, result.ticks);
+    buildSchedule(search, problem, incumbent.actions, result);
+    return result;
+}
+
+void writeScheduleCommands(std::ostream& out, const SolverResult& result)
+{
+    std::size_t plant = 0;
+    for (const Command& cmd : result.schedule) {
+        switch (cmd.type) {
+        case CommandType::Move: out << "move " << directionWord(cmd.dir) << "\n"; break;
+        case CommandType::Plant: out << "plant # " << lowerName(result.plantKinds[plant++]) << "\n"; break;
+        case CommandType::Harvest: out << "harvest\n"; break;
+        case CommandType::Remove: out << "remove\n"; break;
+        case CommandType::Wait: out << "wait\n"; break;
+        }
+    }
+}
+
+std::string scheduleScript(const SolverResult& result)
+{
+    std::ostringstream out;
+    std::size_t plant = 0;
+    for (const Command& cmd : result.schedule) {
+        switch (cmd.type) {
+        case CommandType::Move: out << "move(\"" << directionWord(cmd.dir) << "\")\n"; break;
+        case CommandType::Plant: out << "plant(\"" << lowerName(result.plantKinds[plant++]) << "\")\n"; break;
+        case CommandType::Harvest: out << "harvest()\n"; break;
+        case CommandType::Remove: out << "remove()\n"; break;
+        case CommandType::Wait: out << "harvest()  # nothing ripe here yet, this just waits a tick\n"; break;
+        }
+    }
+    return out.str();
+}
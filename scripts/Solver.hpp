@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "Farmer.hpp"
+#include "Grid.hpp"
+#include "ScriptVM.hpp"
+#include "Simulation.hpp"
+
+// Finds the fewest ticks a level's objective can be met in, and a schedule that does it,
+// for par times and difficulty ratings. Same rules as ScriptVM: every action (move, plant,
+// harvest, remove, or a wasted one to wait) is one tick, crops ripen Tile::GROWTH_TIME ticks
+// after they're planted, a tile can't be replanted for Tile::REPLANT_COOLDOWN ticks after a
+// harvest or remove, and the run ends on the harvest that meets the objective.
+//
+// The search:
+//  - a beam search (breadth-first, the best beamWidth states of every tick kept) finds a
+//    good schedule quickly, which becomes the bound to beat
+//  - a parallel depth-first branch-and-bound then proves it optimal or improves on it. The
+//    states a few ticks in are split across a WorkerPool, each thread runs its own DFS, and
+//    they share the incumbent and a lock-free transposition table keyed by a Zobrist hash of
+//    the farmer tile, the crops and how far along they are, and the harvest counts. A state
+//    seen before at the same tick or earlier is cut.
+//  - the lower bound is admissible (crops can't ripen faster than they do, every harvest and
+//    plant is a tick, and a farmer standing still gets at most one crop per growth cycle), so
+//    a search that runs to the end proves the schedule optimal. One that runs out of nodes
+//    returns the best schedule found and the bound it got to.
+// Planted crops have no kind while searching, one crop counts for any requirement; the
+// kinds are handed out afterwards so the schedule meets the crop requirements.
+
+// everything the solver needs to know about a level, taken from a Grid at its start
+struct SolverProblem
+{
+    int width = 0;
+    int height = 0;
+    int startX = 0;
+    int startY = 0;
+    std::vector<std::uint8_t> walkable; // row-major, 1 walkable
+    // per tile: -1 no crop, otherwise the ticks until the crop there can be harvested
+    std::vector<int> readyIn;
+    // per tile: the ticks before a tile without a crop can be planted (Tile::replantCooldown)
+    std::vector<int> cooldowns;
+    std::vector<CropKind> crops;        // kind of the crop on each tile, Unknown for none
+    int growTicks = Tile::GROWTH_TIME;  // from planting to harvestable
+    int replantCooldown = Tile::REPLANT_COOLDOWN; // ticks a tile can't be planted after a harvest or remove
+    ScriptObjective objective;          // tickLimit is ignored
+    bool canPlant = true;
+};
+
+// the level as it is in grid now (crops part grown and tiles cooling down keep their timers),
+// farmer on its tile. The growth time and replant cooldown are found by playing them out on
+// a scratch Grid. crops is layoutCrops() / PackedLevel::crops, allowed the level's command list.
+SolverProblem makeSolverProblem(const Grid& grid, const Farmer& farmer, const std::vector<CropKind>& crops,
+                                const ScriptObjective& objective, const std::vector<std::string>& allowed);
+
+struct SolverOptions
+{
+    int threads = 0;                           // 0 is one per hardware thread
+    std::size_t memoryBytes = 256u << 20;      // peak for the search's own tables and buffers
+    int beamWidth = 4096;                      // states kept per tick, cut further to fit memoryBytes
+    std::int64_t maxNodes = 5'000'000;         // branch-and-bound expansions before giving up on a proof
+    int maxTicks = 5000;                       // schedules longer than this aren't looked for
+};
+
+enum class SolveStatus
+{
+    Optimal,     // nothing shorter exists
+    BestFound,   // ran out of nodes, lowerBound <= the optimum <= ticks
+    NoSolution,  // the objective can't be met (not enough crops and no plant), or nothing within maxTicks
+};
+
+const char* solveStatusName(SolveStatus status);
+
+struct SolverResult
+{
+    SolveStatus status = SolveStatus::NoSolution;
+    int ticks = -1;                   // length of schedule
+    int lowerBound = 0;
+    std::vector<Command> schedule;    // one per tick, Wait where the farmer has nothing to do
+    std::vector<CropKind> plantKinds; // what each Plant in schedule plants, in order
+
+    int beamTicks = -1;               // what the beam search found on its own
+    int beamWidth = 0;                // after the memory cap
+    std::int64_t nodes = 0;           // expanded by branch-and-bound
+    std::int64_t tableHits = 0;       // states cut by the transposition table
+    std::size_t tableEntries = 0;
+    int threads = 1;
+};
+
+// throws std::invalid_argument when memoryBytes is too small to search in
+SolverResult solveLevel(const SolverProblem& problem, const SolverOptions& options = SolverOptions());
+
+// the schedule as a command stream (parseCommands), plants commented with their crop
+void writeScheduleCommands(std::ostream& out, const SolverResult& result);
+// the schedule as a straight-line farm script, a wait being a harvest() with nothing to harvest
+std::string scheduleScript(const SolverResult& result);
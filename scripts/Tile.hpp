@@ -1,6 +1,8 @@
 #pragma once
-enum class TileType { EMPTY, SOIL, CROP };
-enum  class CropState { EMPTY, PLANTED, GROWN }; //switched these to class to avoid empty conflicts 2/14/26
+#include <cstdint>
+// byte-sized so the per-field arrays in Grid stay small and cache friendly
+enum class TileType : std::uint8_t { EMPTY, SOIL, CROP };
+enum  class CropState : std::uint8_t { EMPTY, PLANTED, GROWN }; //switched these to class to avoid empty conflicts 2/14/26
 
 struct Tile 
 {
@@ -10,4 +12,11 @@ struct Tile
     // Tick since planted
     int growthTimer = 0;
     static constexpr int GROWTH_TIME = 15;
-};
\ No newline at end of file
+    // ticks left before the tile takes a crop again, counts down with every tick. A harvest or
+    // remove sets it to REPLANT_COOLDOWN + 1 so the tick it happens on doesn't count.
+    int replantCooldown = 0;
+    // the game's _HARVEST_COOLDOWN (pygame/tile.py: 3s against the 20s a crop grows, rounded up)
+    static constexpr int REPLANT_COOLDOWN = 3;
+    // what a Grid can hold
+    static constexpr int MAX_REPLANT_COOLDOWN = 255;
+};
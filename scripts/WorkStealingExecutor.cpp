@@ -0,0 +1,105 @@
+#include "WorkStealingExecutor.hpp"
+#include <algorithm>
+
+// which executor / worker the current thread belongs to, so submits from inside a task
+// go to that worker's own deque
+static thread_local const WorkStealingExecutor* currentExecutor = nullptr;
+static thread_local int currentWorker = -1;
+
+WorkStealingExecutor::WorkStealingExecutor(int threadCount)
+{
+    if (threadCount <= 0)
+        threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    for (int i = 0; i < threadCount; i++)
+        queues.push_back(std::make_unique<Queue>());
+    for (int i = 0; i < threadCount; i++)
+        workers.emplace_back([this, i] { workerLoop(i); });
+}
+
+WorkStealingExecutor::~WorkStealingExecutor()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread& t : workers)
+        t.join();
+}
+
+void WorkStealingExecutor::submit(Task task)
+{
+    const std::size_t target = currentExecutor == this
+        ? static_cast<std::size_t>(currentWorker)
+        : static_cast<std::size_t>(nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size());
+
+    unfinished.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+
+    queued.fetch_add(1, std::memory_order_release);
+    // take the sleep lock once so a worker that just checked `queued` can't miss this wake-up
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    workAvailable.notify_one();
+}
+
+void WorkStealingExecutor::wait()
+{
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    allDone.wait(lock, [this] { return unfinished.load(std::memory_order_acquire) == 0; });
+}
+
+bool WorkStealingExecutor::popLocal(int self, Task& out)
+{
+    Queue& q = *queues[self];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty()) return false;
+    out = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingExecutor::steal(int self, Task& out)
+{
+    // start at the next worker over so thieves don't all pile onto worker 0
+    const int n = static_cast<int>(queues.size());
+    for (int k = 1; k < n; k++) {
+        Queue& q = *queues[(self + k) % n];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) continue;
+        out = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        steals.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingExecutor::workerLoop(int self)
+{
+    currentExecutor = this;
+    currentWorker = self;
+
+    for (;;) {
+        Task task;
+        if (popLocal(self, task) || steal(self, task)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            if (unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        workAvailable.wait(lock, [this] {
+            return stopping || queued.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping && queued.load(std::memory_order_acquire) == 0) return;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Task executor for lots of small, independent jobs (many worlds at once).
+// Every worker owns a deque: it pushes and pops its own work at the back (newest first, still
+// warm in cache) and, when it runs dry, steals the oldest task from the front of someone else's.
+// Tasks may submit more tasks, which land on the submitting worker's own deque.
+// Unlike WorkerPool, which splits one big loop, jobs here can be uneven and keep arriving.
+class WorkStealingExecutor
+{
+    public:
+    using Task = std::function<void()>;
+
+    // 0 means one worker per hardware thread
+    explicit WorkStealingExecutor(int threadCount = 0);
+    ~WorkStealingExecutor();
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    int getThreadCount() const { return static_cast<int>(workers.size()); }
+
+    void submit(Task task);
+
+    // blocks until every submitted task, including ones submitted by tasks, has finished
+    void wait();
+
+    // how many tasks were taken from another worker's deque since construction
+    std::uint64_t getStealCount() const { return steals.load(std::memory_order_relaxed); }
+
+    private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(int self);
+    bool popLocal(int self, Task& out);
+    bool steal(int self, Task& out);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::atomic<std::int64_t> queued{ 0 };     // sitting in a deque
+    std::atomic<std::int64_t> unfinished{ 0 }; // submitted and not done yet
+    std::atomic<std::uint64_t> nextQueue{ 0 }; // round robin for submits from outside the pool
+    std::atomic<std::uint64_t> steals{ 0 };
+
+    std::mutex sleepMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    bool stopping = false;
+};
@@ -0,0 +1,80 @@
+#include "WorkerPool.hpp"
+#include <algorithm>
+
+WorkerPool::WorkerPool(int threadCount)
+{
+    if (threadCount <= 0)
+        threadCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    // the caller is one of the threads, so spawn one less
+    for (int i = 1; i < threadCount; i++)
+        workers.emplace_back([this] { workerLoop(); });
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers)
+        t.join();
+}
+
+void WorkerPool::run(int taskCount, const std::function<void(int)>& task)
+{
+    if (taskCount <= 0)
+        return;
+
+    // nothing to hand out, skip the wake-up round trip
+    if (workers.empty() || taskCount == 1) {
+        for (int i = 0; i < taskCount; i++) task(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &task;
+        jobTasks = taskCount;
+        nextTask.store(0, std::memory_order_relaxed);
+        busyWorkers = static_cast<int>(workers.size());
+        generation++;
+    }
+    wake.notify_all();
+
+    drain();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return busyWorkers == 0; });
+    job = nullptr;
+}
+
+void WorkerPool::drain()
+{
+    // tasks are handed out one at a time so uneven blocks still balance out
+    for (;;) {
+        const int i = nextTask.fetch_add(1, std::memory_order_relaxed);
+        if (i >= jobTasks) break;
+        (*job)(i);
+    }
+}
+
+void WorkerPool::workerLoop()
+{
+    std::uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        drain();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0)
+            finished.notify_one();
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads that stay alive between jobs, so a parallel tick doesn't pay for
+// spawning threads every time. The calling thread works on the job too.
+// run() is not re-entrant: one job at a time, and tasks must not call back into the same pool.
+class WorkerPool
+{
+    public:
+    // threadCount counts the calling thread, 0 means one per hardware thread
+    explicit WorkerPool(int threadCount = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int getThreadCount() const { return static_cast<int>(workers.size()) + 1; }
+
+    // calls task(i) for every i in [0, taskCount) across the pool, returns once all are done
+    void run(int taskCount, const std::function<void(int)>& task);
+
+    private:
+    void workerLoop();
+    void drain();
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    const std::function<void(int)>* job = nullptr;
+    int jobTasks = 0;
+    std::atomic<int> nextTask{ 0 };
+    int busyWorkers = 0;
+    std::uint64_t generation = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,141 @@
+#include "WorldBatch.hpp"
+#include <chrono>
+#include <exception>
+
+static std::int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::unique_ptr<World> WorldPool::acquire(int width, int height)
+{
+    std::unique_ptr<World> world;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) {
+            world = std::move(idle.back());
+            idle.pop_back();
+        } else {
+            created++;
+        }
+    }
+
+    if (world) {
+        world->grid.reset(width, height);
+        world->farmer.reset(0, 0);
+    } else {
+        world = std::make_unique<World>(width, height, mode);
+    }
+    return world;
+}
+
+void WorldPool::release(std::unique_ptr<World> world)
+{
+    if (!world) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    idle.push_back(std::move(world));
+}
+
+std::size_t WorldPool::idleCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return idle.size();
+}
+
+std::size_t WorldPool::createdCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return created;
+}
+
+int WorldBatch::add(std::shared_ptr<const Layout> layout,
+                    std::shared_ptr<const std::vector<Command>> commands,
+                    std::int64_t tickLimit)
+{
+    auto slot = std::make_unique<Slot>();
+    slot->layout = std::move(layout);
+    slot->commands = std::move(commands);
+    slot->tickLimit = tickLimit;
+    slots.push_back(std::move(slot));
+    return static_cast<int>(slots.size()) - 1;
+}
+
+void WorldBatch::clear()
+{
+    for (auto& slot : slots)
+        pool.release(std::move(slot->world));
+    slots.clear();
+}
+
+BatchReport WorldBatch::run(WorkStealingExecutor& executor, int sliceTicks, const CompletionFn& onDone)
+{
+    if (sliceTicks <= 0) sliceTicks = 1;
+    completion = onDone ? &onDone : nullptr;
+    const std::uint64_t stealsBefore = executor.getStealCount();
+    runStartNs = nowNs();
+
+    for (int id = 0; id < size(); id++) {
+        Slot& slot = *slots[id];
+        slot.result = WorldResult();
+        executor.submit([this, &executor, &slot, id, sliceTicks] {
+            // set up inside the task so building thousands of worlds is spread over the pool too
+            try {
+                const Layout& layout = *slot.layout;
+                if (!slot.world)
+                    slot.world = pool.acquire(layout.width, layout.height);
+                else
+                    slot.world->grid.reset(layout.width, layout.height);
+                applyLayout(layout, slot.world->grid);
+                slot.world->farmer.reset(layout.startX, layout.startY);
+                slot.runner = std::make_unique<CommandRunner>(*slot.commands);
+            } catch (const std::exception& e) {
+                slot.result.error = e.what();
+                slot.result.completedMs = (nowNs() - runStartNs) / 1e6;
+                if (completion) (*completion)(id, slot.result);
+                return;
+            }
+            runSlice(executor, slot, id, sliceTicks);
+        });
+    }
+    executor.wait();
+
+    BatchReport report;
+    report.worlds = size();
+    report.seconds = (nowNs() - runStartNs) / 1e9;
+    for (const auto& slot : slots)
+        report.worldTicks += slot->result.stats.ticks;
+    report.worldTicksPerSecond = report.seconds > 0.0 ? report.worldTicks / report.seconds : 0.0;
+    report.steals = executor.getStealCount() - stealsBefore;
+    completion = nullptr;
+    return report;
+}
+
+void WorldBatch::runSlice(WorkStealingExecutor& executor, Slot& slot, int id, int sliceTicks)
+{
+    World& world = *slot.world;
+    CommandRunner& runner = *slot.runner;
+
+    for (int i = 0; i < sliceTicks && !runner.done(); i++) {
+        if (slot.tickLimit > 0 && runner.getStats().ticks >= slot.tickLimit) break;
+        runner.step(world.grid, world.farmer);
+    }
+
+    const bool finished = runner.done();
+    const bool outOfTicks = slot.tickLimit > 0 && runner.getStats().ticks >= slot.tickLimit;
+    if (!finished && !outOfTicks) {
+        // not done yet: requeue on this worker, an idle one can steal it
+        executor.submit([this, &executor, &slot, id, sliceTicks] {
+            runSlice(executor, slot, id, sliceTicks);
+        });
+        return;
+    }
+
+    slot.result.stats = runner.getStats();
+    slot.result.finished = finished;
+    slot.result.hitTickLimit = !finished;
+    slot.result.finalHash = hashState(world.grid, world.farmer);
+    slot.result.completedMs = (nowNs() - runStartNs) / 1e6;
+    slot.runner.reset();
+    if (completion) (*completion)(id, slot.result);
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Grid.hpp"
+#include "Farmer.hpp"
+#include "Simulation.hpp"
+#include "WorkStealingExecutor.hpp"
+
+// One self-contained farm: a grid and the farmer working it.
+// Farmer keeps a Grid& so a World never moves, it lives behind a unique_ptr.
+struct World
+{
+    World(int width, int height, GrowthMode mode) : grid(width, height, mode), farmer(grid) {}
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    Grid grid;
+    Farmer farmer;
+};
+
+// Recycles worlds between runs so a batch of thousands doesn't reallocate every grid each time.
+// Thread safe.
+class WorldPool
+{
+    public:
+    explicit WorldPool(GrowthMode mode = GrowthMode::Scheduled) : mode(mode) {}
+
+    // a world reset to an empty grid of this size, reusing a released one when there is one
+    std::unique_ptr<World> acquire(int width, int height);
+    void release(std::unique_ptr<World> world);
+
+    std::size_t idleCount() const;
+    std::size_t createdCount() const;
+
+    private:
+    GrowthMode mode;
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<World>> idle;
+    std::size_t created = 0;
+};
+
+struct WorldResult
+{
+    RunStats stats;
+    std::uint64_t finalHash = 0;
+    bool finished = false;     // the whole command stream ran
+    bool hitTickLimit = false; // stopped early at the tick limit
+    double completedMs = 0.0;  // since the start of run()
+    std::string error;         // set if the world threw
+};
+
+struct BatchReport
+{
+    int worlds = 0;
+    std::int64_t worldTicks = 0;
+    double seconds = 0.0;
+    double worldTicksPerSecond = 0.0;
+    std::uint64_t steals = 0;
+};
+
+// N independent worlds, typically many player submissions replayed against the same level.
+// run() steps all of them on a work-stealing executor in slices of `sliceTicks`, so long runs
+// get split up and short ones finish (and report) early.
+class WorldBatch
+{
+    public:
+    explicit WorldBatch(WorldPool& pool) : pool(pool) {}
+    ~WorldBatch() { clear(); }
+
+    WorldBatch(const WorldBatch&) = delete;
+    WorldBatch& operator=(const WorldBatch&) = delete;
+
+    // queues a world on `layout` that will play `commands`, returns its id
+    // tickLimit <= 0 means no limit
+    int add(std::shared_ptr<const Layout> layout,
+            std::shared_ptr<const std::vector<Command>> commands,
+            std::int64_t tickLimit = 0);
+
+    // called from a worker thread as each world completes
+    using CompletionFn = std::function<void(int id, const WorldResult& result)>;
+
+    BatchReport run(WorkStealingExecutor& executor, int sliceTicks = 256, const CompletionFn& onDone = {});
+
+    const WorldResult& result(int id) const { return slots[id]->result; }
+    const World& world(int id) const { return *slots[id]->world; }
+    int size() const { return static_cast<int>(slots.size()); }
+
+    // hands every world back to the pool
+    void clear();
+
+    private:
+    struct Slot
+    {
+        std::shared_ptr<const Layout> layout;
+        std::shared_ptr<const std::vector<Command>> commands;
+        std::int64_t tickLimit = 0;
+        std::unique_ptr<World> world;
+        std::unique_ptr<CommandRunner> runner;
+        WorldResult result;
+    };
+
+    void runSlice(WorkStealingExecutor& executor, Slot& slot, int id, int sliceTicks);
+
+    WorldPool& pool;
+    std::vector<std::unique_ptr<Slot>> slots;
+
+    // per-run state shared with the tasks
+    std::int64_t runStartNs = 0;
+    const CompletionFn* completion = nullptr;
+};
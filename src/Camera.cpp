@@ -0,0 +1,51 @@
+#include "Camera.hpp"
+#include <algorithm>
+#include <cmath>
+
+// one tile filling four screens down to a million tiles across a screen
+static const float MIN_SCALE = 2e-6f;
+static const float MAX_SCALE = 8.0f;
+
+void Camera::fitGrid(int gridWidth, int gridHeight)
+{
+    const float gridSize = 1.4f; // same square the grid always sat in
+    scale = gridSize / static_cast<float>(std::max(1, std::max(gridWidth, gridHeight)));
+    centerX = gridWidth * 0.5f;
+    centerY = gridHeight * 0.5f;
+}
+
+void Camera::setViewport(int pixelWidth, int pixelHeight)
+{
+    viewportWidth = std::max(1, pixelWidth);
+    viewportHeight = std::max(1, pixelHeight);
+}
+
+void Camera::pan(float ndcDx, float ndcDy)
+{
+    centerX += ndcDx / scale;
+    centerY -= ndcDy / scale;
+}
+
+void Camera::zoomAt(float factor, float atNdcX, float atNdcY)
+{
+    const float wx = worldX(atNdcX);
+    const float wy = worldY(atNdcY);
+    scale = std::clamp(scale * factor, MIN_SCALE, MAX_SCALE);
+    // put the same world point back under the cursor
+    centerX = wx - atNdcX / scale;
+    centerY = wy + atNdcY / scale;
+}
+
+TileRect Camera::visibleTiles(int gridWidth, int gridHeight) const
+{
+    // the screen is NDC [-1, 1] on both axes
+    // clamp while still in float so a view panned far away can't overflow the int casts
+    const float w = static_cast<float>(gridWidth);
+    const float h = static_cast<float>(gridHeight);
+    TileRect r;
+    r.x0 = static_cast<int>(std::floor(std::clamp(worldX(-1.0f), 0.0f, w)));
+    r.x1 = static_cast<int>(std::ceil(std::clamp(worldX(1.0f), 0.0f, w)));
+    r.y0 = static_cast<int>(std::floor(std::clamp(worldY(1.0f), 0.0f, h)));
+    r.y1 = static_cast<int>(std::ceil(std::clamp(worldY(-1.0f), 0.0f, h)));
+    return r;
+}
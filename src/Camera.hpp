@@ -0,0 +1,46 @@
+#pragma once
+
+// visible part of the grid in whole tiles, [x0, x1) x [y0, y1), empty if x0 >= x1 or y0 >= y1
+struct TileRect
+{
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    bool empty() const { return x0 >= x1 || y0 >= y1; }
+};
+
+// 2D pan/zoom camera over the grid. World units are tiles, x right and y down, tile (x, y)
+// covers [x, x+1) x [y, y+1). No OpenGL in here.
+class Camera
+{
+    public:
+    // the old fixed layout: the whole grid centered in a 1.4 NDC square
+    void fitGrid(int gridWidth, int gridHeight);
+
+    // framebuffer size in pixels, only used to decide how big a tile is on screen
+    void setViewport(int pixelWidth, int pixelHeight);
+
+    // moves the view by a distance given in NDC, so pan speed doesn't depend on zoom
+    void pan(float ndcDx, float ndcDy);
+    // zooms by `factor` (>1 is in) keeping the world point under (ndcX, ndcY) where it is
+    void zoomAt(float factor, float ndcX, float ndcY);
+
+    float getCenterX() const { return centerX; }
+    float getCenterY() const { return centerY; }
+    // NDC units per tile
+    float getScale() const { return scale; }
+    float tilePixels() const { return scale * viewportHeight * 0.5f; }
+
+    float worldX(float ndcX) const { return centerX + ndcX / scale; }
+    float worldY(float ndcY) const { return centerY - ndcY / scale; }
+    float ndcX(float worldX) const { return (worldX - centerX) * scale; }
+    float ndcY(float worldY) const { return (centerY - worldY) * scale; }
+
+    // tiles of a gridWidth x gridHeight grid that touch the screen
+    TileRect visibleTiles(int gridWidth, int gridHeight) const;
+
+    private:
+    float centerX = 0.0f;
+    float centerY = 0.0f;
+    float scale = 1.0f;
+    int viewportWidth = 800;
+    int viewportHeight = 600;
+};
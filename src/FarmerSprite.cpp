@@ -0,0 +1,202 @@
+#include "FarmerSprite.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include "Profiler.hpp"
+#include "Shader.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+// atlas pages are this big unless the driver can't do it
+static const int ATLAS_PAGE_SIZE = 1024;
+// the instance ring starts with room for this many sprites and grows when a frame needs more
+static const std::size_t MIN_SPRITE_CAPACITY = 16384;
+
+// one instance per sprite, 6 vertices each from gl_VertexID. The quad turns around its center.
+static const char* SPRITE_VS = R"(
+    #version 330 core
+    layout(location = 0) in vec4 aRect;     // x, y, w, h in tiles
+    layout(location = 1) in vec4 aUv;       // u0, v0, u1, v1
+    layout(location = 2) in float aRotation;
+    layout(location = 3) in vec4 aTint;
+    uniform vec2 uCenter;
+    uniform float uScale;
+    out vec2 vUv;
+    out vec4 vTint;
+    const vec2 corners[6] = vec2[6](
+        vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+        vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+    void main() {
+        vec2 c = corners[gl_VertexID];
+        vec2 local = (c - 0.5) * aRect.zw;
+        float s = sin(aRotation);
+        float k = cos(aRotation);
+        // y points down in the world, so this turns clockwise on screen
+        vec2 world = aRect.xy + 0.5 * aRect.zw + vec2(local.x * k - local.y * s, local.x * s + local.y * k);
+        vUv = mix(aUv.xy, aUv.zw, c);
+        vTint = aTint;
+        gl_Position = vec4((world.x - uCenter.x) * uScale, (uCenter.y - world.y) * uScale, 0.0, 1.0);
+    }
+)";
+
+static const char* SPRITE_FS = R"(
+    #version 330 core
+    in vec2 vUv;
+    in vec4 vTint;
+    uniform sampler2D uAtlas;
+    out vec4 FragColor;
+    void main() {
+        vec4 c = texture(uAtlas, vUv) * vTint;
+        if (c.a == 0.0) discard;
+        FragColor = c;
+    }
+)";
+
+// the built-in sprites, with any <dir>/<name>.png there is swapped in
+static std::vector<SpriteImage> loadFarmSprites(const std::string& dir)
+{
+    std::vector<SpriteImage> images = builtinFarmSprites();
+    if (dir.empty()) return images;
+    for (SpriteImage& img : images) {
+        const std::string path = dir + "/" + img.name + ".png";
+        if (!std::ifstream(path).good()) continue;
+        int w = 0, h = 0, channels = 0;
+        stbi_uc* pixels = stbi_load(path.c_str(), &w, &h, &channels, 4);
+        if (!pixels) throw std::runtime_error("can't read sprite " + path + ": " + stbi_failure_reason());
+        img.width = w;
+        img.height = h;
+        img.rgba.assign(pixels, pixels + static_cast<std::size_t>(w) * h * 4);
+        stbi_image_free(pixels);
+    }
+    return images;
+}
+
+static int atlasPageSize()
+{
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    return std::min(ATLAS_PAGE_SIZE, (int)maxTextureSize);
+}
+
+FarmerSprite::FarmerSprite(const std::string& spriteDir)
+    : atlas(SpriteAtlas::build(loadFarmSprites(spriteDir), atlasPageSize())), batch(atlas), ids(findFarmSprites(atlas))
+{
+    program = makeProgram(SPRITE_VS, SPRITE_FS);
+    uCenter = glGetUniformLocation(program, "uCenter");
+    uScale = glGetUniformLocation(program, "uScale");
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "uAtlas"), 0);
+    glUseProgram(0);
+
+    // nearest filtering keeps the pixel art sharp, the padding around each sprite keeps
+    // neighbours from bleeding in at the edges
+    const int size = atlas.getPageSize();
+    pageTextures.resize(static_cast<std::size_t>(atlas.pageCount()));
+    glGenTextures((GLsizei)pageTextures.size(), pageTextures.data());
+    for (int p = 0; p < atlas.pageCount(); p++) {
+        glBindTexture(GL_TEXTURE_2D, pageTextures[static_cast<std::size_t>(p)]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, atlas.pagePixels(p).data());
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    for (GLuint loc = 0; loc < 4; loc++) {
+        glEnableVertexAttribArray(loc);
+        glVertexAttribDivisor(loc, 1);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+FarmerSprite::~FarmerSprite()
+{
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteTextures((GLsizei)pageTextures.size(), pageTextures.data());
+    glDeleteProgram(program);
+}
+
+void FarmerSprite::draw(const Grid& grid, const Camera& camera, float farmerX, float farmerY)
+{
+    FARM_PROFILE_SCOPE("FarmerSprite::draw");
+    lastDrawCalls = 0;
+    lastUploadBytes = 0;
+
+    batch.begin();
+    const TileRect view = camera.visibleTiles(grid.getGridWidth(), grid.getGridHeight());
+    if (!view.empty()) batchFarmSprites(grid, view, farmerX, farmerY, ids, batch);
+    batch.finish();
+    lastSprites = batch.size();
+    if (lastSprites == 0) return;
+
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    upload(batch.instances());
+
+    glUseProgram(program);
+    glUniform2f(uCenter, camera.getCenterX(), camera.getCenterY());
+    glUniform1f(uScale, camera.getScale());
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glActiveTexture(GL_TEXTURE0);
+
+    // one draw per run of sprites on the same page, the attributes moved to the run's start
+    for (const SpriteDrawRange& r : batch.ranges()) {
+        glBindTexture(GL_TEXTURE_2D, pageTextures[static_cast<std::size_t>(r.page)]);
+        pointAttributes(frameOffset + static_cast<std::size_t>(r.first) * sizeof(SpriteInstance));
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, r.count);
+        lastDrawCalls++;
+        FARM_PROFILE_COUNT(ProfileCounter::DrawCalls, 1);
+        FARM_PROFILE_COUNT(ProfileCounter::VerticesEmitted, 6 * static_cast<std::int64_t>(r.count));
+    }
+
+    glDisable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void FarmerSprite::upload(const std::vector<SpriteInstance>& instances)
+{
+    const std::size_t bytes = instances.size() * sizeof(SpriteInstance);
+    if (writeOffset + bytes > capacity) {
+        // wrapped or too small: orphan the buffer, the GPU keeps the old storage for as long
+        // as it's still drawing from it and we start over at the front of a fresh one
+        capacity = std::max({ capacity, bytes * 2, MIN_SPRITE_CAPACITY * sizeof(SpriteInstance) });
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)capacity, nullptr, GL_STREAM_DRAW);
+        writeOffset = 0;
+    }
+
+    // this range hasn't been drawn from since the last orphan, no need to wait for the GPU
+    void* dst = glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)writeOffset, (GLsizeiptr)bytes,
+                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (dst) {
+        std::memcpy(dst, instances.data(), bytes);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    } else {
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)writeOffset, (GLsizeiptr)bytes, instances.data());
+    }
+    frameOffset = writeOffset;
+    writeOffset += bytes;
+    lastUploadBytes = bytes;
+    FARM_PROFILE_COUNT(ProfileCounter::BytesUploaded, static_cast<std::int64_t>(bytes));
+}
+
+void FarmerSprite::pointAttributes(std::size_t byteOffset)
+{
+    const GLsizei stride = sizeof(SpriteInstance);
+    const char* base = reinterpret_cast<const char*>(byteOffset);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof(SpriteInstance, x));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof(SpriteInstance, u0));
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, base + offsetof(SpriteInstance, rotation));
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, base + offsetof(SpriteInstance, tint));
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "Camera.hpp"
+#include "Grid.hpp"
+#include "SpriteBatch.hpp"
+
+// below this many pixels per tile sprites are mush, the flat GridRenderer draws instead
+constexpr float SPRITE_MIN_TILE_PIXELS = 8.0f;
+
+// The textured farm: soil, crop, wall and farmer sprites packed into one atlas when it's
+// created, then every frame the visible tiles go through a SpriteBatch into one streaming
+// instance buffer and out in a draw call per atlas page (one, with the built-in sprites).
+//  - sprites come from <spriteDir>/<name>.png (stb_image) for the farmSpriteNames() found
+//    there, the built-in pixel art for the rest
+//  - the instance buffer is a ring written with unsynchronized maps, and orphaned when it
+//    wraps, so a frame never waits on the GPU still reading the last one
+// Needs a current GL context for its whole lifetime. Throws std::runtime_error for a sprite
+// file that's there but can't be read.
+class FarmerSprite
+{
+    public:
+    explicit FarmerSprite(const std::string& spriteDir = "");
+    ~FarmerSprite();
+
+    FarmerSprite(const FarmerSprite&) = delete;
+    FarmerSprite& operator=(const FarmerSprite&) = delete;
+
+    // the part of grid the camera sees plus the farmer, which can sit between tiles.
+    // Blends over whatever is in the framebuffer.
+    void draw(const Grid& grid, const Camera& camera, float farmerX, float farmerY);
+
+    static bool worthDrawing(const Camera& camera) { return camera.tilePixels() >= SPRITE_MIN_TILE_PIXELS; }
+
+    const SpriteAtlas& getAtlas() const { return atlas; }
+    // what the last draw() did
+    int getLastDrawCalls() const { return lastDrawCalls; }
+    std::size_t getLastSprites() const { return lastSprites; }
+    std::size_t getLastUploadBytes() const { return lastUploadBytes; }
+
+    private:
+    void upload(const std::vector<SpriteInstance>& instances);
+    void pointAttributes(std::size_t byteOffset);
+
+    SpriteAtlas atlas;
+    SpriteBatch batch;
+    FarmSpriteIds ids;
+
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    std::vector<GLuint> pageTextures;
+    GLint uCenter = -1, uScale = -1;
+
+    std::size_t capacity = 0;    // bytes in vbo
+    std::size_t writeOffset = 0; // where the next frame's instances go
+    std::size_t frameOffset = 0; // where this frame's went
+
+    int lastDrawCalls = 0;
+    std::size_t lastSprites = 0;
+    std::size_t lastUploadBytes = 0;
+};
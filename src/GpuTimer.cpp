@@ -0,0 +1,64 @@
+#include "GpuTimer.hpp"
+#include "Profiler.hpp"
+
+// GPU frames go on their own track in the trace. They're placed at the CPU time the frame
+// was submitted, the GPU runs them some time after that.
+static const int GPU_TRACK = Profiler::FIRST_VIRTUAL_THREAD;
+
+GpuFrameTimer::GpuFrameTimer()
+{
+    // timer queries are core since 3.3, which is what main asks for
+    if (!GLAD_GL_VERSION_3_3) return;
+    GLint bits = 0;
+    glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &bits);
+    if (bits == 0) return;
+
+    glGenQueries(QUERY_COUNT, queries);
+    available = true;
+    Profiler::instance().nameVirtualThread(GPU_TRACK, "GPU (placed at submit time)");
+}
+
+GpuFrameTimer::~GpuFrameTimer()
+{
+    if (available) glDeleteQueries(QUERY_COUNT, queries);
+}
+
+void GpuFrameTimer::beginFrame()
+{
+    if (!available || open) return;
+    collect();
+    // every query still in flight, skip timing this frame rather than wait
+    if (pending[next]) return;
+
+    glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+    issuedAt[next] = Profiler::instance().now();
+    open = true;
+}
+
+void GpuFrameTimer::endFrame()
+{
+    if (!open) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    pending[next] = true;
+    next = (next + 1) % QUERY_COUNT;
+    open = false;
+}
+
+void GpuFrameTimer::collect()
+{
+    // oldest first, results come back in submission order
+    for (int k = 0; k < QUERY_COUNT; k++) {
+        const int q = (next + k) % QUERY_COUNT;
+        if (!pending[q]) continue;
+        GLint ready = 0;
+        glGetQueryObjectiv(queries[q], GL_QUERY_RESULT_AVAILABLE, &ready);
+        if (!ready) break;
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries[q], GL_QUERY_RESULT, &ns);
+        pending[q] = false;
+        lastMs = ns / 1e6;
+        Profiler::instance().addSample(ProfileStat::Gpu, lastMs);
+        Profiler::instance().recordOn(GPU_TRACK, "gpu frame", issuedAt[q], ns / 1e3);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <glad/glad.h>
+
+// GPU time per frame from GL_TIME_ELAPSED queries, fed to the profiler as ProfileStat::Gpu
+// and as events on a "GPU" track in traces. Results are picked up a few frames late so
+// reading them never stalls the pipeline.
+// Needs a current GL context for its whole lifetime. On a context without timer queries
+// (or one that reports a 0-bit counter) it does nothing and isAvailable() says so.
+class GpuFrameTimer
+{
+    public:
+    GpuFrameTimer();
+    ~GpuFrameTimer();
+
+    GpuFrameTimer(const GpuFrameTimer&) = delete;
+    GpuFrameTimer& operator=(const GpuFrameTimer&) = delete;
+
+    bool isAvailable() const { return available; }
+
+    // around everything the frame draws, only one frame can be open at a time
+    void beginFrame();
+    void endFrame();
+
+    // newest GPU frame time that came back, in ms
+    double getLastMs() const { return lastMs; }
+
+    private:
+    // frames in flight before a query gets reused, drivers rarely run more than 3 ahead
+    static const int QUERY_COUNT = 4;
+
+    void collect();
+
+    bool available = false;
+    bool open = false;
+    GLuint queries[QUERY_COUNT] = {};
+    bool pending[QUERY_COUNT] = {};
+    double issuedAt[QUERY_COUNT] = {}; // profiler time the frame started on the CPU
+    int next = 0;
+    double lastMs = 0.0;
+};
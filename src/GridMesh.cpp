@@ -0,0 +1,213 @@
+#include "GridMesh.hpp"
+#include <algorithm>
+#include "Profiler.hpp"
+
+// Vertex format: x, y, r, g, b
+// writes straight into storage the caller already sized, 6 vertices per quad
+static float* writeQuad(float* p,
+                        float left, float top,
+                        float right, float bottom,
+                        float r, float g, float b)
+{
+    const float quad[6][2] = {
+        { left, top }, { right, top },    { right, bottom }, // first triangle
+        { left, top }, { right, bottom }, { left,  bottom }, // second triangle
+    };
+    for (const auto& v : quad) {
+        p[0] = v[0]; p[1] = v[1];
+        p[2] = r;    p[3] = g;    p[4] = b;
+        p += 5;
+    }
+    return p;
+}
+
+RGB colorForTile(const Tile& t)
+{
+    // Pick colors based on tile type/state (tweak freely)
+    switch (t.type) {
+    case TileType::EMPTY: return { 0.20f, 0.30f, 0.28f }; //if the type ie empty show dark green
+    case TileType::SOIL:  return { 0.35f, 0.25f, 0.15f }; //if it is soil, show brown
+    case TileType::CROP://if it is a crop to a switch statement to see how much the crop has grown
+        switch (t.cropstate) {
+        case CropState::EMPTY:   return { 0.20f, 0.45f, 0.20f };
+        case CropState::PLANTED: return { 0.20f, 0.60f, 0.25f };
+        case CropState::GROWN:   return { 0.35f, 0.80f, 0.35f };
+        }
+    }
+    return { 0.25f, 0.25f, 0.25f };
+}
+
+GridPlacement placeGrid(int width, int height)
+{
+    (void)height; // cells are square and sized off the width
+
+    //layout for the gird, set to be centered
+    const float gridSize = 1.4f;   //height and width for tiles can be adjusted -JK
+    const float gap = 0.0f;       //gap between the tiles, set to 0 for no gap - JK
+
+    GridPlacement place;
+    place.gap = gap;
+    place.cellSize = (gridSize - gap * (width - 1)) / width;
+    place.startX = -gridSize / 2.0f;
+    place.startY =  gridSize / 2.0f; //the player will start on the top left by default
+    return place;
+}
+
+void writeTileVertices(const GridPlacement& place, int x, int y, TileType type, CropState state, bool walkable,
+                       float* out)
+{
+    float left   = place.startX + x * (place.cellSize + place.gap);
+    float top    = place.startY - y * (place.cellSize + place.gap);
+    float right  = left + place.cellSize;
+    float bottom = top  - place.cellSize;
+
+    Tile t;
+    t.type = type;
+    t.cropstate = state;
+    RGB c = walkable ? colorForTile(t) : WALL_COLOR;
+
+    // Slight checker variation so you can see tiles easier even if same type
+    if ((x + y) % 2 == 0) { c.r += TILE_CHECKER_BOOST; c.g += TILE_CHECKER_BOOST; c.b += TILE_CHECKER_BOOST; }
+
+    // Tile fill
+    writeQuad(out, left, top, right, bottom, c.r, c.g, c.b);
+}
+
+void buildTileMesh(const Grid& grid, std::vector<float>& outTileVerts)
+{
+    FARM_PROFILE_SCOPE("buildTileMesh");
+    const int W = grid.getGridWidth();
+    const int H = grid.getGridHeight();
+    const GridPlacement place = placeGrid(W, H);
+
+    // size everything up front and write through raw pointers, push_back per float
+    // was most of the cost on big grids
+    outTileVerts.resize(static_cast<size_t>(W) * H * MESH_FLOATS_PER_TILE);
+    float* tileOut = outTileVerts.data();
+
+    for (int y = 0; y < H; y++) {
+        // walk the row straight out of the field arrays instead of a checked getTile per tile
+        const GridSpan<TileType> types = grid.typeRow(y);
+        const GridSpan<CropState> states = grid.cropStateRow(y);
+        const GridSpan<std::uint8_t> walkable = grid.walkabilityRow(y);
+
+        for (int x = 0; x < W; x++) {
+            writeTileVertices(place, x, y, types[x], states[x], walkable[x] != 0, tileOut);
+            tileOut += MESH_FLOATS_PER_TILE;
+        }
+    }
+}
+
+void buildBorderMesh(int width, int height, std::vector<float>& outBorderVerts)
+{
+    const GridPlacement place = placeGrid(width, height);
+
+    // border thickness in NDC units (thin rectangles)
+    const float borderT = tileBorderThickness(place.cellSize);
+    const RGB borderC = TILE_BORDER_COLOR;
+
+    outBorderVerts.resize(static_cast<size_t>(width) * height * MESH_FLOATS_PER_TILE_BORDER);
+    float* borderOut = outBorderVerts.data();
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float left   = place.startX + x * (place.cellSize + place.gap);
+            float top    = place.startY - y * (place.cellSize + place.gap);
+            float right  = left + place.cellSize;
+            float bottom = top  - place.cellSize;
+
+            // Borders (4 skinny quads)
+            // Top
+            borderOut = writeQuad(borderOut,
+                                  left, top, right, top - borderT,
+                                  borderC.r, borderC.g, borderC.b);
+
+            // Bottom
+            borderOut = writeQuad(borderOut,
+                                  left, bottom + borderT, right, bottom,
+                                  borderC.r, borderC.g, borderC.b);
+
+            // Left
+            borderOut = writeQuad(borderOut,
+                                  left, top, left + borderT, bottom,
+                                  borderC.r, borderC.g, borderC.b);
+
+            // Right
+            borderOut = writeQuad(borderOut,
+                                  right - borderT, top, right, bottom,
+                                  borderC.r, borderC.g, borderC.b);
+        }
+    }
+}
+
+void buildFarmerMesh(int width, int height, int farmerX, int farmerY, std::vector<float>& outFarmerVerts)
+{
+    const GridPlacement place = placeGrid(width, height);
+
+    // Farmer marker (small quad inside its tile)
+    farmerX = std::clamp(farmerX, 0, width - 1);
+    farmerY = std::clamp(farmerY, 0, height - 1);
+
+    float fLeft   = place.startX + farmerX * (place.cellSize + place.gap);
+    float fTop    = place.startY - farmerY * (place.cellSize + place.gap);
+    float fRight  = fLeft + place.cellSize;
+    float fBottom = fTop  - place.cellSize;
+
+    const float inset = farmerInset(place.cellSize);
+    fLeft += inset; fRight -= inset;
+    fTop  -= inset; fBottom += inset;
+
+    outFarmerVerts.resize(MESH_FLOATS_PER_QUAD);
+    writeQuad(outFarmerVerts.data(), fLeft, fTop, fRight, fBottom, FARMER_COLOR.r, FARMER_COLOR.g, FARMER_COLOR.b);
+}
+
+void buildTileCodes(const Grid& grid, std::vector<std::uint8_t>& outCodes)
+{
+    FARM_PROFILE_SCOPE("buildTileCodes");
+    const int W = grid.getGridWidth();
+    const int H = grid.getGridHeight();
+    const int chunksX = chunksAcross(W);
+
+    outCodes.assign(static_cast<std::size_t>(chunksX) * chunksAcross(H) * TILE_CHUNK_TILES, 0);
+    for (int y = 0; y < H; y++) {
+        const GridSpan<TileType> types = grid.typeRow(y);
+        const GridSpan<CropState> states = grid.cropStateRow(y);
+        const GridSpan<std::uint8_t> walkable = grid.walkabilityRow(y);
+        // a row of a chunk is contiguous, write it TILE_CHUNK tiles at a time
+        for (int x0 = 0; x0 < W; x0 += TILE_CHUNK) {
+            std::uint8_t* out = outCodes.data() + chunkedTileOffset(x0, y, chunksX);
+            const int x1 = std::min(W, x0 + TILE_CHUNK);
+            for (int x = x0; x < x1; x++)
+                *out++ = packTileCode(types[x], states[x], walkable[x] != 0);
+        }
+    }
+}
+
+void buildTilePalette(float outRgb[TILE_CODE_COUNT * 3])
+{
+    for (int code = 0; code < TILE_CODE_COUNT; code++) {
+        Tile t;
+        t.type = static_cast<TileType>(code & 3);
+        t.cropstate = static_cast<CropState>(code >> 2);
+        const RGB c = (code & 3) == TILE_CODE_WALL ? WALL_COLOR : colorForTile(t);
+        outRgb[code * 3 + 0] = c.r;
+        outRgb[code * 3 + 1] = c.g;
+        outRgb[code * 3 + 2] = c.b;
+    }
+}
+
+void buildMeshesFromGrid(
+    const Grid& grid,
+    int farmerX, int farmerY,
+    std::vector<float>& outTileVerts,
+    std::vector<float>& outBorderVerts,
+    std::vector<float>& outFarmerVerts)
+{
+    FARM_PROFILE_SCOPE("buildMeshesFromGrid");
+    const int W = grid.getGridWidth();
+    const int H = grid.getGridHeight();
+
+    buildTileMesh(grid, outTileVerts);
+    buildBorderMesh(W, H, outBorderVerts);
+    buildFarmerMesh(W, H, farmerX, farmerY, outFarmerVerts);
+}
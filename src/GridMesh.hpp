@@ -0,0 +1,87 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Grid.hpp"
+
+// CPU side of the grid renderer, no OpenGL in here so it can be benchmarked headless
+
+//we will symbolize what kind of crop is being grown through colors for now
+struct RGB { float r, g, b; };
+
+RGB colorForTile(const Tile& t);
+
+// Vertex format: x, y, r, g, b
+constexpr int MESH_FLOATS_PER_VERTEX = 5;
+constexpr int MESH_FLOATS_PER_QUAD = 6 * MESH_FLOATS_PER_VERTEX;
+// every tile owns one quad in the tile mesh, at index(x, y) * MESH_FLOATS_PER_QUAD
+constexpr int MESH_FLOATS_PER_TILE = MESH_FLOATS_PER_QUAD;
+// and four skinny quads in the border mesh
+constexpr int MESH_FLOATS_PER_TILE_BORDER = 4 * MESH_FLOATS_PER_QUAD;
+
+// the rest of the look, shared with the instanced shaders so both paths draw the same thing
+constexpr float TILE_CHECKER_BOOST = 0.02f;           // added to every other tile
+constexpr float TILE_BORDER_THICKNESS = 0.01f;        // NDC units, inside each tile edge
+constexpr RGB TILE_BORDER_COLOR{ 0.05f, 0.05f, 0.05f };
+constexpr float FARMER_INSET = 0.06f;                 // NDC units from the tile edge
+constexpr RGB FARMER_COLOR{ 0.35f, 0.75f, 0.40f };
+constexpr RGB WALL_COLOR{ 0.50f, 0.50f, 0.52f };       // unwalkable tiles, whatever is on them
+
+// capped to a share of the tile so small tiles don't turn solid border color
+inline float tileBorderThickness(float cellSize) { return std::min(TILE_BORDER_THICKNESS, cellSize * 0.1f); }
+inline float farmerInset(float cellSize) { return std::min(FARMER_INSET, cellSize * 0.25f); }
+
+// where the grid sits in NDC
+struct GridPlacement
+{
+    float cellSize;
+    float gap;
+    float startX;
+    float startY;
+};
+
+GridPlacement placeGrid(int width, int height);
+
+// fills one tile's quad (MESH_FLOATS_PER_TILE floats) with its current color
+void writeTileVertices(const GridPlacement& place, int x, int y, TileType type, CropState state, bool walkable,
+                       float* out);
+
+// whole-grid pieces: tile fills depend on tile state, borders only on the grid size
+void buildTileMesh(const Grid& grid, std::vector<float>& outTileVerts);
+void buildBorderMesh(int width, int height, std::vector<float>& outBorderVerts);
+void buildFarmerMesh(int width, int height, int farmerX, int farmerY, std::vector<float>& outFarmerVerts);
+
+// instanced path: one byte per tile, type in bits 0-1, crop state in bits 2-3. A wall is
+// type 3, which no TileType uses. The shader turns the code into a color and works the quad
+// out from the instance id.
+constexpr int TILE_CODE_COUNT = 16;
+constexpr std::uint8_t TILE_CODE_WALL = 3;
+inline std::uint8_t packTileCode(TileType type, CropState state, bool walkable)
+{
+    if (!walkable) return TILE_CODE_WALL;
+    return static_cast<std::uint8_t>(static_cast<int>(type) | (static_cast<int>(state) << 2));
+}
+
+// The codes are stored in TILE_CHUNK x TILE_CHUNK chunks so the renderer can cull whole chunks:
+// chunks in row-major order, each one's tiles contiguous and row-major inside it.
+// Chunks on the right and bottom edge are padded out to full size.
+constexpr int TILE_CHUNK = 64;
+constexpr int TILE_CHUNK_TILES = TILE_CHUNK * TILE_CHUNK;
+inline int chunksAcross(int tiles) { return (tiles + TILE_CHUNK - 1) / TILE_CHUNK; }
+inline int chunkedTileOffset(int x, int y, int chunksX)
+{
+    const int chunk = (y / TILE_CHUNK) * chunksX + x / TILE_CHUNK;
+    return chunk * TILE_CHUNK_TILES + (y % TILE_CHUNK) * TILE_CHUNK + x % TILE_CHUNK;
+}
+void buildTileCodes(const Grid& grid, std::vector<std::uint8_t>& outCodes);
+// colorForTile for every code, for the shader's palette
+void buildTilePalette(float outRgb[TILE_CODE_COUNT * 3]);
+
+// all three at once, the original per-frame path
+void buildMeshesFromGrid(
+    const Grid& grid,
+    int farmerX, int farmerY,
+    std::vector<float>& outTileVerts,
+    std::vector<float>& outBorderVerts,
+    std::vector<float>& outFarmerVerts);
@@ -0,0 +1,577 @@
+#include "GridRenderer.hpp"
+#include <algorithm>
+#include <cmath>
+#include "GridMesh.hpp"
+#include "Profiler.hpp"
+#include "Shader.hpp"
+
+// a run of changed tiles can swallow a gap this small, one bigger upload beats two calls
+static const int MERGE_GAP_VERTEX_TILES = 8;
+static const int MERGE_GAP_CODE_TILES = 64;
+
+// below this many pixels per tile the borders and checker can't be seen anyway,
+// draw one texel per tile instead of quads
+static const float LOW_DETAIL_TILE_PIXELS = 3.0f;
+
+// plain position + color, used by Vertices mode. The mesh is built for the old fixed
+// layout (placeGrid), uScale/uOffset move it to where the camera wants it.
+static const char* VERTEX_VS = R"(
+    #version 330 core
+    layout(location = 0) in vec2 aPos;
+    layout(location = 1) in vec3 aColor;
+    uniform float uScale;
+    uniform vec2 uOffset;
+    out vec3 vColor;
+    void main() {
+        vColor = aColor;
+        gl_Position = vec4(aPos * uScale + uOffset, 0.0, 1.0);
+    }
+)";
+
+static const char* VERTEX_FS = R"(
+    #version 330 core
+    in vec3 vColor;
+    out vec4 FragColor;
+    void main() {
+        FragColor = vec4(vColor, 1.0);
+    }
+)";
+
+// Instanced mode: one instance per tile, 6 vertices each with no vertex buffer at all.
+// A draw covers a run of whole chunks starting at uFirstChunk, the tile comes from
+// gl_InstanceID and the corner from gl_VertexID. Padding tiles past the grid edge collapse
+// to a point off screen.
+static const char* INSTANCED_VS = R"(
+    #version 330 core
+    layout(location = 0) in uint aTile;
+    uniform int uChunk;
+    uniform ivec2 uGridSize;
+    uniform int uChunksX;
+    uniform int uFirstChunk;
+    uniform vec2 uCenter;
+    uniform float uScale;
+    flat out uint vTile;
+    flat out ivec2 vCell;
+    out vec2 vLocal; // NDC units from the cell's top left corner
+    out vec2 vWorld;
+    const vec2 corners[6] = vec2[6](
+        vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+        vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+    void main() {
+        int chunkTiles = uChunk * uChunk;
+        int chunk = uFirstChunk + gl_InstanceID / chunkTiles;
+        int inChunk = gl_InstanceID % chunkTiles;
+        ivec2 cell = ivec2((chunk % uChunksX) * uChunk + inChunk % uChunk,
+                           (chunk / uChunksX) * uChunk + inChunk / uChunk);
+        vTile = aTile;
+        vCell = cell;
+        if (cell.x >= uGridSize.x || cell.y >= uGridSize.y) {
+            vLocal = vec2(0.0);
+            vWorld = vec2(0.0);
+            gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+            return;
+        }
+        vec2 c = corners[gl_VertexID];
+        vLocal = c * uScale;
+        vec2 world = vec2(cell) + c;
+        vWorld = world;
+        gl_Position = vec4((world.x - uCenter.x) * uScale, (uCenter.y - world.y) * uScale, 0.0, 1.0);
+    }
+)";
+
+// colorForTile, the checker, the four border strips and the farmer marker, in the same
+// order the Vertices mode draws them so the two look identical
+static const char* INSTANCED_FS = R"(
+    #version 330 core
+    flat in uint vTile;
+    flat in ivec2 vCell;
+    in vec2 vLocal;
+    in vec2 vWorld;
+    uniform vec3 uPalette[16];
+    uniform float uChecker;
+    uniform float uScale;
+    uniform float uBorder;
+    uniform vec3 uBorderColor;
+    uniform vec2 uFarmer; // top left of the farmer's (possibly in between) tile
+    uniform float uInset;
+    uniform vec3 uFarmerColor;
+    out vec4 FragColor;
+    void main() {
+        vec3 c;
+        float inset = uInset / uScale; // in tiles
+        if (all(greaterThanEqual(vWorld, uFarmer + vec2(inset)))
+            && all(lessThanEqual(vWorld, uFarmer + vec2(1.0 - inset)))) {
+            c = uFarmerColor;
+        } else if (any(lessThan(vLocal, vec2(uBorder)))
+                   || any(greaterThan(vLocal, vec2(uScale - uBorder)))) {
+            c = uBorderColor;
+        } else {
+            c = uPalette[vTile & 15u];
+            if (((vCell.x + vCell.y) & 1) == 0) c += vec3(uChecker);
+        }
+        FragColor = vec4(c, 1.0);
+    }
+)";
+
+// low detail: one quad over the visible part of the grid, each pixel looks its tile up
+// in the code texture. Tiles are too small here for borders or the checker.
+static const char* LOW_DETAIL_VS = R"(
+    #version 330 core
+    uniform vec2 uRectMin;
+    uniform vec2 uRectMax;
+    uniform vec2 uCenter;
+    uniform float uScale;
+    out vec2 vWorld;
+    const vec2 corners[6] = vec2[6](
+        vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+        vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+    void main() {
+        vec2 world = mix(uRectMin, uRectMax, corners[gl_VertexID]);
+        vWorld = world;
+        gl_Position = vec4((world.x - uCenter.x) * uScale, (uCenter.y - world.y) * uScale, 0.0, 1.0);
+    }
+)";
+
+static const char* LOW_DETAIL_FS = R"(
+    #version 330 core
+    in vec2 vWorld;
+    uniform usampler2D uCodes;
+    uniform int uChunk;
+    uniform ivec2 uGridSize;
+    uniform int uChunksX;
+    uniform int uCodesWidth;
+    uniform vec3 uPalette[16];
+    uniform vec2 uFarmer;
+    uniform vec3 uFarmerColor;
+    out vec4 FragColor;
+    void main() {
+        ivec2 cell = clamp(ivec2(floor(vWorld)), ivec2(0), uGridSize - 1);
+        if (cell == ivec2(floor(uFarmer + 0.5))) {
+            FragColor = vec4(uFarmerColor, 1.0);
+            return;
+        }
+        ivec2 chunk = cell / uChunk;
+        ivec2 inChunk = cell - chunk * uChunk;
+        int offset = (chunk.y * uChunksX + chunk.x) * uChunk * uChunk + inChunk.y * uChunk + inChunk.x;
+        uint code = texelFetch(uCodes, ivec2(offset % uCodesWidth, offset / uCodesWidth), 0).r;
+        FragColor = vec4(uPalette[code & 15u], 1.0);
+    }
+)";
+
+GridRenderer::GridRenderer(Grid& grid, GridRenderMode mode) : grid(grid), mode(mode)
+{
+    vertexProgram = makeProgram(VERTEX_VS, VERTEX_FS);
+    createVertexBuffer(tiles);
+    createVertexBuffer(borders);
+    createVertexBuffer(farmer);
+    vScale = glGetUniformLocation(vertexProgram, "uScale");
+    vOffset = glGetUniformLocation(vertexProgram, "uOffset");
+
+    instancedProgram = makeProgram(INSTANCED_VS, INSTANCED_FS);
+    createInstanceBuffer();
+
+    lowDetailProgram = makeProgram(LOW_DETAIL_VS, LOW_DETAIL_FS);
+    // the low detail quad has no attributes, core profile still wants a VAO bound
+    glGenVertexArrays(1, &lowDetailVao);
+    glGenTextures(1, &lowDetailTexture);
+    glBindTexture(GL_TEXTURE_2D, lowDetailTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+    // everything that doesn't change with the grid or the camera goes in once
+    float palette[TILE_CODE_COUNT * 3];
+    buildTilePalette(palette);
+
+    glUseProgram(instancedProgram);
+    glUniform3fv(glGetUniformLocation(instancedProgram, "uPalette"), TILE_CODE_COUNT, palette);
+    glUniform1i(glGetUniformLocation(instancedProgram, "uChunk"), TILE_CHUNK);
+    glUniform1f(glGetUniformLocation(instancedProgram, "uChecker"), TILE_CHECKER_BOOST);
+    glUniform3f(glGetUniformLocation(instancedProgram, "uBorderColor"),
+                TILE_BORDER_COLOR.r, TILE_BORDER_COLOR.g, TILE_BORDER_COLOR.b);
+    glUniform3f(glGetUniformLocation(instancedProgram, "uFarmerColor"),
+                FARMER_COLOR.r, FARMER_COLOR.g, FARMER_COLOR.b);
+    iGridSize = glGetUniformLocation(instancedProgram, "uGridSize");
+    iChunksX = glGetUniformLocation(instancedProgram, "uChunksX");
+    iFirstChunk = glGetUniformLocation(instancedProgram, "uFirstChunk");
+    iCenter = glGetUniformLocation(instancedProgram, "uCenter");
+    iScale = glGetUniformLocation(instancedProgram, "uScale");
+    iBorder = glGetUniformLocation(instancedProgram, "uBorder");
+    iInset = glGetUniformLocation(instancedProgram, "uInset");
+    iFarmer = glGetUniformLocation(instancedProgram, "uFarmer");
+
+    glUseProgram(lowDetailProgram);
+    glUniform3fv(glGetUniformLocation(lowDetailProgram, "uPalette"), TILE_CODE_COUNT, palette);
+    glUniform1i(glGetUniformLocation(lowDetailProgram, "uChunk"), TILE_CHUNK);
+    glUniform1i(glGetUniformLocation(lowDetailProgram, "uCodes"), 0);
+    glUniform3f(glGetUniformLocation(lowDetailProgram, "uFarmerColor"),
+                FARMER_COLOR.r, FARMER_COLOR.g, FARMER_COLOR.b);
+    lRectMin = glGetUniformLocation(lowDetailProgram, "uRectMin");
+    lRectMax = glGetUniformLocation(lowDetailProgram, "uRectMax");
+    lCenter = glGetUniformLocation(lowDetailProgram, "uCenter");
+    lScale = glGetUniformLocation(lowDetailProgram, "uScale");
+    lGridSize = glGetUniformLocation(lowDetailProgram, "uGridSize");
+    lChunksX = glGetUniformLocation(lowDetailProgram, "uChunksX");
+    lCodesWidth = glGetUniformLocation(lowDetailProgram, "uCodesWidth");
+    lFarmer = glGetUniformLocation(lowDetailProgram, "uFarmer");
+    glUseProgram(0);
+
+    grid.setChangeTracking(true);
+}
+
+GridRenderer::~GridRenderer()
+{
+    grid.setChangeTracking(false);
+    destroyBuffer(tiles);
+    destroyBuffer(borders);
+    destroyBuffer(farmer);
+    destroyBuffer(tileCodes);
+    glDeleteVertexArrays(1, &lowDetailVao);
+    glDeleteTextures(1, &lowDetailTexture);
+    glDeleteProgram(vertexProgram);
+    glDeleteProgram(instancedProgram);
+    glDeleteProgram(lowDetailProgram);
+}
+
+void GridRenderer::createVertexBuffer(Buffer& b)
+{
+    glGenVertexArrays(1, &b.vao);
+    glGenBuffers(1, &b.vbo);
+
+    glBindVertexArray(b.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, b.vbo);
+
+    // Vertex format: x, y, r, g, b
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, MESH_FLOATS_PER_VERTEX * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, MESH_FLOATS_PER_VERTEX * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    glBindVertexArray(0);
+}
+
+void GridRenderer::createInstanceBuffer()
+{
+    glGenVertexArrays(1, &tileCodes.vao);
+    glGenBuffers(1, &tileCodes.vbo);
+
+    glBindVertexArray(tileCodes.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, tileCodes.vbo);
+
+    // one tile code per instance, read as an integer. The offset gets moved per chunk run.
+    glVertexAttribIPointer(0, 1, GL_UNSIGNED_BYTE, 1, (void*)0);
+    glVertexAttribDivisor(0, 1);
+    glEnableVertexAttribArray(0);
+
+    glBindVertexArray(0);
+}
+
+void GridRenderer::destroyBuffer(Buffer& b)
+{
+    glDeleteBuffers(1, &b.vbo);
+    glDeleteVertexArrays(1, &b.vao);
+    b = Buffer();
+}
+
+void GridRenderer::setMode(GridRenderMode newMode)
+{
+    if (newMode == mode) return;
+    mode = newMode;
+
+    // the other mode's buffers went stale while it was off, start it over and drop the old copies
+    width = height = 0;
+    tileVerts = std::vector<float>();
+    codes = std::vector<std::uint8_t>();
+}
+
+void GridRenderer::update(float fx, float fy)
+{
+    FARM_PROFILE_SCOPE("GridRenderer::update");
+    lastUploadedTiles = 0;
+    lastUploadCalls = 0;
+    lastUploadBytes = 0;
+
+    const bool resized = grid.getGridWidth() != width || grid.getGridHeight() != height;
+    if (resized || grid.allTilesChanged()) {
+        rebuildAll();
+    } else if (!grid.getChangedTiles().empty()) {
+        uploadChangedTiles();
+    }
+    grid.clearChangedTiles();
+
+    farmerX = std::clamp(fx, 0.0f, (float)(width - 1));
+    farmerY = std::clamp(fy, 0.0f, (float)(height - 1));
+
+    // the vertex path only draws the farmer on whole tiles
+    const int tileX = (int)std::lround(farmerX);
+    const int tileY = (int)std::lround(farmerY);
+    const bool moved = tileX != meshFarmerX || tileY != meshFarmerY;
+    if (mode == GridRenderMode::Vertices && (moved || farmer.vertexCount == 0)) {
+        meshFarmerX = tileX;
+        meshFarmerY = tileY;
+        buildFarmerMesh(width, height, tileX, tileY, scratch);
+        glBindBuffer(GL_ARRAY_BUFFER, farmer.vbo);
+        glBufferData(GL_ARRAY_BUFFER, scratch.size() * sizeof(float), scratch.data(), GL_DYNAMIC_DRAW);
+        farmer.vertexCount = (GLsizei)(scratch.size() / MESH_FLOATS_PER_VERTEX);
+        lastUploadBytes += scratch.size() * sizeof(float);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    FARM_PROFILE_COUNT(ProfileCounter::BytesUploaded, static_cast<std::int64_t>(lastUploadBytes));
+}
+
+void GridRenderer::rebuildAll()
+{
+    FARM_PROFILE_SCOPE("GridRenderer::rebuildAll");
+    const bool resized = grid.getGridWidth() != width || grid.getGridHeight() != height;
+    width = grid.getGridWidth();
+    height = grid.getGridHeight();
+    lastUploadedTiles = grid.tileCount();
+    lastUploadCalls = 1;
+
+    if (mode == GridRenderMode::Instanced) {
+        chunksX = chunksAcross(width);
+        chunksY = chunksAcross(height);
+        buildTileCodes(grid, codes);
+        glBindBuffer(GL_ARRAY_BUFFER, tileCodes.vbo);
+        glBufferData(GL_ARRAY_BUFFER, codes.size(), codes.data(), GL_DYNAMIC_DRAW);
+        lastUploadBytes += codes.size();
+
+        // a chunk per row to start with, rows twice as wide until they fit under the limit
+        const int codeCount = static_cast<int>(codes.size());
+        auto rowsFor = [codeCount](int rowWidth) { return (codeCount + rowWidth - 1) / rowWidth; };
+        lowDetailWidth = std::min(TILE_CHUNK_TILES, static_cast<int>(maxTextureSize));
+        while (rowsFor(lowDetailWidth) > maxTextureSize && lowDetailWidth <= maxTextureSize / 2)
+            lowDetailWidth *= 2;
+        lowDetailAvailable = rowsFor(lowDetailWidth) <= maxTextureSize;
+        if (lowDetailAvailable) {
+            glBindTexture(GL_TEXTURE_2D, lowDetailTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, lowDetailWidth, rowsFor(lowDetailWidth), 0,
+                         GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+            uploadLowDetail(0, codeCount - 1);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            lastUploadCalls++;
+        }
+        return;
+    }
+
+    buildTileMesh(grid, tileVerts);
+    glBindBuffer(GL_ARRAY_BUFFER, tiles.vbo);
+    glBufferData(GL_ARRAY_BUFFER, tileVerts.size() * sizeof(float), tileVerts.data(), GL_DYNAMIC_DRAW);
+    tiles.vertexCount = (GLsizei)(tileVerts.size() / MESH_FLOATS_PER_VERTEX);
+    lastUploadBytes += tileVerts.size() * sizeof(float);
+
+    if (resized) {
+        buildBorderMesh(width, height, scratch);
+        glBindBuffer(GL_ARRAY_BUFFER, borders.vbo);
+        glBufferData(GL_ARRAY_BUFFER, scratch.size() * sizeof(float), scratch.data(), GL_STATIC_DRAW);
+        borders.vertexCount = (GLsizei)(scratch.size() / MESH_FLOATS_PER_VERTEX);
+        lastUploadBytes += scratch.size() * sizeof(float);
+        // make sure the farmer quad gets placed for the new size too
+        farmer.vertexCount = 0;
+    }
+}
+
+void GridRenderer::uploadChangedTiles()
+{
+    FARM_PROFILE_SCOPE("GridRenderer::uploadChangedTiles");
+    const GridSpan<TileType> types = grid.types();
+    const GridSpan<CropState> states = grid.cropStates();
+    const GridSpan<std::uint8_t> walkable = grid.walkability();
+    const std::vector<int>& changed = grid.getChangedTiles();
+
+    // sortedChanges ends up holding offsets into whichever buffer this mode uses
+    int mergeGap;
+    if (mode == GridRenderMode::Instanced) {
+        sortedChanges.resize(changed.size());
+        for (std::size_t k = 0; k < changed.size(); k++) {
+            const int i = changed[k];
+            const int offset = chunkedTileOffset(i % width, i / width, chunksX);
+            codes[offset] = packTileCode(types[i], states[i], walkable[i] != 0);
+            sortedChanges[k] = offset;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, tileCodes.vbo);
+        if (lowDetailAvailable) glBindTexture(GL_TEXTURE_2D, lowDetailTexture);
+        mergeGap = MERGE_GAP_CODE_TILES;
+    } else {
+        const GridPlacement place = placeGrid(width, height);
+        for (int i : changed) {
+            writeTileVertices(place, i % width, i / width, types[i], states[i], walkable[i] != 0,
+                              tileVerts.data() + static_cast<std::size_t>(i) * MESH_FLOATS_PER_TILE);
+        }
+        sortedChanges = changed;
+        glBindBuffer(GL_ARRAY_BUFFER, tiles.vbo);
+        mergeGap = MERGE_GAP_VERTEX_TILES;
+    }
+    std::sort(sortedChanges.begin(), sortedChanges.end());
+
+    // coalesce into runs, one upload each
+    std::size_t k = 0;
+    while (k < sortedChanges.size()) {
+        const int first = sortedChanges[k];
+        int last = first;
+        while (k + 1 < sortedChanges.size() && sortedChanges[k + 1] - last <= mergeGap)
+            last = sortedChanges[++k];
+        uploadRange(first, last);
+        k++;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GridRenderer::uploadRange(int first, int last)
+{
+    const std::size_t tileCount = static_cast<std::size_t>(last - first + 1);
+    if (mode == GridRenderMode::Instanced) {
+        glBufferSubData(GL_ARRAY_BUFFER, first, tileCount, codes.data() + first);
+        lastUploadBytes += tileCount;
+        if (lowDetailAvailable) uploadLowDetail(first, last);
+    } else {
+        const std::size_t offset = static_cast<std::size_t>(first) * MESH_FLOATS_PER_TILE;
+        const std::size_t count = tileCount * MESH_FLOATS_PER_TILE;
+        glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(float), count * sizeof(float), tileVerts.data() + offset);
+        lastUploadBytes += count * sizeof(float);
+    }
+    lastUploadedTiles += static_cast<int>(tileCount);
+    lastUploadCalls++;
+}
+
+void GridRenderer::uploadLowDetail(int first, int last)
+{
+    // the tail of first's row, then whole rows in one go, then the head of last's row
+    while (first <= last) {
+        const int x = first % lowDetailWidth;
+        const int remaining = last - first + 1;
+        const int rows = x == 0 ? std::max(1, remaining / lowDetailWidth) : 1;
+        const int texels = rows > 1 ? lowDetailWidth : std::min(lowDetailWidth - x, remaining);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, first / lowDetailWidth, texels, rows, GL_RED_INTEGER,
+                        GL_UNSIGNED_BYTE, codes.data() + first);
+        first += texels * rows;
+        lastUploadBytes += static_cast<std::size_t>(texels) * rows;
+    }
+}
+
+void GridRenderer::draw(const Camera& camera)
+{
+    FARM_PROFILE_SCOPE("GridRenderer::draw");
+    lastDrawCalls = 0;
+    lastDrawnTiles = 0;
+    lastLowDetail = false;
+    if (width == 0) return;
+
+    if (mode == GridRenderMode::Vertices) {
+        drawVertices(camera);
+        return;
+    }
+
+    const TileRect view = camera.visibleTiles(width, height);
+    if (view.empty()) return;
+
+    if (lowDetailAvailable && camera.tilePixels() < LOW_DETAIL_TILE_PIXELS)
+        drawLowDetail(camera, view);
+    else
+        drawChunks(camera, view);
+}
+
+void GridRenderer::drawVertices(const Camera& camera)
+{
+    // the meshes sit where placeGrid put them, map that onto the camera's view
+    const GridPlacement place = placeGrid(width, height);
+    const float step = place.cellSize + place.gap;
+    const float s = camera.getScale();
+    const float k = s / step;
+
+    glUseProgram(vertexProgram);
+    glUniform1f(vScale, k);
+    glUniform2f(vOffset, -place.startX * k - camera.getCenterX() * s,
+                         -place.startY * k + camera.getCenterY() * s);
+
+    //draw tiles, then borders (skinny quads) on top, then the farmer marker
+    for (const Buffer* b : { &tiles, &borders, &farmer }) {
+        if (b->vertexCount == 0) continue;
+        glBindVertexArray(b->vao);
+        glDrawArrays(GL_TRIANGLES, 0, b->vertexCount);
+        lastDrawCalls++;
+        FARM_PROFILE_COUNT(ProfileCounter::DrawCalls, 1);
+        FARM_PROFILE_COUNT(ProfileCounter::VerticesEmitted, b->vertexCount);
+    }
+    glBindVertexArray(0);
+    lastDrawnTiles = static_cast<std::int64_t>(width) * height;
+}
+
+void GridRenderer::drawChunks(const Camera& camera, const TileRect& view)
+{
+    const float s = camera.getScale();
+    glUseProgram(instancedProgram);
+    glUniform2i(iGridSize, width, height);
+    glUniform1i(iChunksX, chunksX);
+    glUniform2f(iCenter, camera.getCenterX(), camera.getCenterY());
+    glUniform1f(iScale, s);
+    glUniform1f(iBorder, tileBorderThickness(s));
+    glUniform1f(iInset, farmerInset(s));
+    glUniform2f(iFarmer, farmerX, farmerY);
+
+    glBindVertexArray(tileCodes.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, tileCodes.vbo);
+
+    const int cx0 = view.x0 / TILE_CHUNK;
+    const int cx1 = (view.x1 - 1) / TILE_CHUNK;
+    const int cy0 = view.y0 / TILE_CHUNK;
+    const int cy1 = (view.y1 - 1) / TILE_CHUNK;
+
+    // each visible chunk row is one contiguous run, rows that touch (the view spans the whole
+    // grid width) merge so the whole grid in view is still a single draw
+    int runFirst = -1, runLast = -1;
+    for (int cy = cy0; cy <= cy1; cy++) {
+        const int first = cy * chunksX + cx0;
+        const int last = cy * chunksX + cx1;
+        if (runFirst >= 0 && first == runLast + 1) {
+            runLast = last;
+            continue;
+        }
+        if (runFirst >= 0) drawChunkRun(runFirst, runLast);
+        runFirst = first;
+        runLast = last;
+    }
+    if (runFirst >= 0) drawChunkRun(runFirst, runLast);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GridRenderer::drawChunkRun(int firstChunk, int lastChunk)
+{
+    const std::size_t offset = static_cast<std::size_t>(firstChunk) * TILE_CHUNK_TILES;
+    const GLsizei instances = (GLsizei)((lastChunk - firstChunk + 1) * TILE_CHUNK_TILES);
+    glVertexAttribIPointer(0, 1, GL_UNSIGNED_BYTE, 1, (void*)offset);
+    glUniform1i(iFirstChunk, firstChunk);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, instances);
+    lastDrawCalls++;
+    lastDrawnTiles += instances;
+    FARM_PROFILE_COUNT(ProfileCounter::DrawCalls, 1);
+    FARM_PROFILE_COUNT(ProfileCounter::VerticesEmitted, 6 * static_cast<std::int64_t>(instances));
+}
+
+void GridRenderer::drawLowDetail(const Camera& camera, const TileRect& view)
+{
+    glUseProgram(lowDetailProgram);
+    glUniform2f(lRectMin, (float)view.x0, (float)view.y0);
+    glUniform2f(lRectMax, (float)view.x1, (float)view.y1);
+    glUniform2f(lCenter, camera.getCenterX(), camera.getCenterY());
+    glUniform1f(lScale, camera.getScale());
+    glUniform2i(lGridSize, width, height);
+    glUniform1i(lChunksX, chunksX);
+    glUniform1i(lCodesWidth, lowDetailWidth);
+    glUniform2f(lFarmer, farmerX, farmerY);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, lowDetailTexture);
+    glBindVertexArray(lowDetailVao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    lastDrawCalls = 1;
+    lastLowDetail = true;
+    FARM_PROFILE_COUNT(ProfileCounter::DrawCalls, 1);
+    FARM_PROFILE_COUNT(ProfileCounter::VerticesEmitted, 6);
+}
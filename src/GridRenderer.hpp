@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include "Camera.hpp"
+#include "Grid.hpp"
+
+enum class GridRenderMode
+{
+    // instanced draws of the visible chunks: the GPU gets a byte per tile and the shaders
+    // work out position, color, checker, borders and the farmer marker themselves.
+    // Zoomed far out it switches to one texel per tile on a single quad instead.
+    Instanced,
+    // CPU-built triangles (30 floats per tile fill, 120 per tile border) for the whole grid,
+    // three draws, no culling. The reference the instanced path should look like.
+    Vertices,
+};
+
+// Keeps the grid on the GPU between frames instead of rebuilding and re-uploading
+// everything every frame.
+//  - only the tiles the Grid reports as changed get rewritten, with neighbouring changed
+//    tiles merged into one upload
+//  - Instanced mode keeps the tile codes in TILE_CHUNK x TILE_CHUNK chunks (see GridMesh.hpp),
+//    both as an instance buffer and as the low-detail texture (the same bytes wrapped into rows),
+//    and only draws the chunks the camera can see
+//  - Vertices mode: borders only depend on the grid size, uploaded once (again on resize),
+//    the farmer quad is re-uploaded only when the farmer moves
+// Needs a current GL context for its whole lifetime. Turns on change tracking on the grid.
+class GridRenderer
+{
+    public:
+    explicit GridRenderer(Grid& grid, GridRenderMode mode = GridRenderMode::Instanced);
+    ~GridRenderer();
+
+    GridRenderer(const GridRenderer&) = delete;
+    GridRenderer& operator=(const GridRenderer&) = delete;
+
+    void setMode(GridRenderMode mode);
+    GridRenderMode getMode() const { return mode; }
+
+    // pushes whatever changed since the last update to the GPU. The farmer can sit between
+    // tiles while it's interpolated from one to the next.
+    void update(float farmerX, float farmerY);
+    // binds its own shader programs
+    void draw(const Camera& camera);
+
+    // what the last update() sent, for checking the partial path actually kicks in
+    int getLastUploadedTiles() const { return lastUploadedTiles; }
+    int getLastUploadCalls() const { return lastUploadCalls; }
+    std::size_t getLastUploadBytes() const { return lastUploadBytes; }
+    // what the last draw() did
+    int getLastDrawCalls() const { return lastDrawCalls; }
+    std::int64_t getLastDrawnTiles() const { return lastDrawnTiles; }
+    bool wasLastDrawLowDetail() const { return lastLowDetail; }
+
+    private:
+    struct Buffer
+    {
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        GLsizei vertexCount = 0;
+    };
+
+    static void createVertexBuffer(Buffer& b);
+    void createInstanceBuffer();
+    static void destroyBuffer(Buffer& b);
+
+    void rebuildAll();
+    void uploadChangedTiles();
+    void uploadRange(int first, int last);
+    void uploadLowDetail(int first, int last);
+
+    void drawVertices(const Camera& camera);
+    void drawChunks(const Camera& camera, const TileRect& view);
+    void drawChunkRun(int firstChunk, int lastChunk);
+    void drawLowDetail(const Camera& camera, const TileRect& view);
+
+    Grid& grid;
+    GridRenderMode mode;
+    int width = 0;
+    int height = 0;
+    float farmerX = -1.0f;
+    float farmerY = -1.0f;
+
+    // Vertices mode
+    GLuint vertexProgram = 0;
+    Buffer tiles;
+    Buffer borders;
+    Buffer farmer;
+    std::vector<float> tileVerts; // CPU copy of the tile buffer, patched in place then uploaded by range
+    std::vector<float> scratch;
+    GLint vScale = -1, vOffset = -1;
+    int meshFarmerX = -1; // tile the farmer quad was last built on
+    int meshFarmerY = -1;
+
+    // Instanced mode
+    GLuint instancedProgram = 0;
+    Buffer tileCodes;
+    std::vector<std::uint8_t> codes; // same idea, a byte per tile in chunk order
+    int chunksX = 0;
+    int chunksY = 0;
+    GLint iGridSize = -1, iChunksX = -1, iFirstChunk = -1, iCenter = -1, iScale = -1;
+    GLint iBorder = -1, iInset = -1, iFarmer = -1;
+
+    // low detail: the same codes as an integer texture, in order and wrapped every
+    // lowDetailWidth texels. That's a chunk per row, or wider rows on grids that would
+    // otherwise run past GL_MAX_TEXTURE_SIZE rows.
+    GLuint lowDetailProgram = 0;
+    GLuint lowDetailVao = 0;
+    GLuint lowDetailTexture = 0;
+    GLint maxTextureSize = 0;
+    int lowDetailWidth = 0;
+    bool lowDetailAvailable = false; // false past GL_MAX_TEXTURE_SIZE squared tiles
+    GLint lRectMin = -1, lRectMax = -1, lCenter = -1, lScale = -1, lGridSize = -1, lChunksX = -1, lFarmer = -1;
+    GLint lCodesWidth = -1;
+
+    std::vector<int> sortedChanges;
+
+    int lastUploadedTiles = 0;
+    int lastUploadCalls = 0;
+    std::size_t lastUploadBytes = 0;
+    int lastDrawCalls = 0;
+    std::int64_t lastDrawnTiles = 0;
+    bool lastLowDetail = false;
+};
@@ -0,0 +1,166 @@
+#include "HudOverlay.hpp"
+#include <algorithm>
+#include <cctype>
+#include "Shader.hpp"
+
+// font pixels are this many screen pixels, cells are 3x5 with a pixel of spacing
+static const float HUD_PIXEL = 2.0f;
+static const int GLYPH_WIDTH = 3;
+static const int GLYPH_HEIGHT = 5;
+static const int GLYPH_ADVANCE = GLYPH_WIDTH + 1;
+static const int LINE_ADVANCE = GLYPH_HEIGHT + 2;
+static const int PANEL_PADDING = 3;
+static const int PANEL_MARGIN = 4;
+
+// Vertex format: x, y in pixels from the top left, r, g, b, a
+static const int HUD_FLOATS_PER_VERTEX = 6;
+
+static const char* HUD_VS = R"(
+    #version 330 core
+    layout(location = 0) in vec2 aPos;
+    layout(location = 1) in vec4 aColor;
+    uniform vec2 uScreen;
+    out vec4 vColor;
+    void main() {
+        vColor = aColor;
+        gl_Position = vec4(aPos.x / uScreen.x * 2.0 - 1.0, 1.0 - aPos.y / uScreen.y * 2.0, 0.0, 1.0);
+    }
+)";
+
+static const char* HUD_FS = R"(
+    #version 330 core
+    in vec4 vColor;
+    out vec4 FragColor;
+    void main() {
+        FragColor = vColor;
+    }
+)";
+
+struct Glyph
+{
+    char c;
+    const char* rows; // 5 rows of 3, top row first, '1' is lit
+};
+
+static const Glyph FONT[] = {
+    { '0', "111101101101111" }, { '1', "010110010010111" }, { '2', "111001111100111" },
+    { '3', "111001111001111" }, { '4', "101101111001001" }, { '5', "111100111001111" },
+    { '6', "111100111101111" }, { '7', "111001001001001" }, { '8', "111101111101111" },
+    { '9', "111101111001111" },
+    { 'A', "010101111101101" }, { 'B', "110101110101110" }, { 'C', "011100100100011" },
+    { 'D', "110101101101110" }, { 'E', "111100110100111" }, { 'F', "111100110100100" },
+    { 'G', "011100101101011" }, { 'H', "101101111101101" }, { 'I', "111010010010111" },
+    { 'J', "001001001101010" }, { 'K', "101101110101101" }, { 'L', "100100100100111" },
+    { 'M', "101111111101101" }, { 'N', "110101101101101" }, { 'O', "010101101101010" },
+    { 'P', "110101110100100" }, { 'Q', "010101101110011" }, { 'R', "110101110101101" },
+    { 'S', "011100010001110" }, { 'T', "111010010010010" }, { 'U', "101101101101111" },
+    { 'V', "101101101101010" }, { 'W', "101101111111101" }, { 'X', "101101010101101" },
+    { 'Y', "101101010010010" }, { 'Z', "111001010100111" },
+    { '.', "000000000000010" }, { ',', "000000000010100" }, { ':', "000010000010000" },
+    { '/', "001001010100100" }, { '%', "101001010100101" }, { '-', "000000111000000" },
+    { '+', "000010111010000" }, { '=', "000111000111000" }, { '_', "000000000000111" },
+    { '(', "001010010010001" }, { ')', "100010010010100" },
+};
+
+static const char* glyphRows(char c)
+{
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    for (const Glyph& g : FONT)
+        if (g.c == c) return g.rows;
+    return nullptr;
+}
+
+static void pushRect(std::vector<float>& out, float x0, float y0, float x1, float y1,
+                     float r, float g, float b, float a)
+{
+    const float corners[6][2] = { { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y0 }, { x1, y1 }, { x0, y1 } };
+    for (const auto& c : corners) {
+        out.insert(out.end(), { c[0], c[1], r, g, b, a });
+    }
+}
+
+HudOverlay::HudOverlay()
+{
+    program = makeProgram(HUD_VS, HUD_FS);
+    uScreen = glGetUniformLocation(program, "uScreen");
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, HUD_FLOATS_PER_VERTEX * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, HUD_FLOATS_PER_VERTEX * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+HudOverlay::~HudOverlay()
+{
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteProgram(program);
+}
+
+void HudOverlay::setText(const std::vector<std::string>& newLines)
+{
+    if (newLines == lines) return;
+    lines = newLines;
+    rebuild();
+}
+
+void HudOverlay::rebuild()
+{
+    verts.clear();
+    std::size_t columns = 0;
+    for (const std::string& line : lines) columns = std::max(columns, line.size());
+    if (columns == 0) {
+        vertexCount = 0;
+        return;
+    }
+
+    // the panel, then a quad per lit font pixel on top of it
+    const float px = HUD_PIXEL;
+    const float left = PANEL_MARGIN * px;
+    const float top = PANEL_MARGIN * px;
+    const float panelW = (columns * GLYPH_ADVANCE - 1 + 2 * PANEL_PADDING) * px;
+    const float panelH = (lines.size() * LINE_ADVANCE - 2 + 2 * PANEL_PADDING) * px;
+    pushRect(verts, left, top, left + panelW, top + panelH, 0.0f, 0.0f, 0.0f, 0.6f);
+
+    for (std::size_t row = 0; row < lines.size(); row++) {
+        const float lineTop = top + (PANEL_PADDING + row * LINE_ADVANCE) * px;
+        for (std::size_t col = 0; col < lines[row].size(); col++) {
+            const char* glyph = glyphRows(lines[row][col]);
+            if (!glyph) continue;
+            const float glyphLeft = left + (PANEL_PADDING + col * GLYPH_ADVANCE) * px;
+            for (int gy = 0; gy < GLYPH_HEIGHT; gy++) {
+                for (int gx = 0; gx < GLYPH_WIDTH; gx++) {
+                    if (glyph[gy * GLYPH_WIDTH + gx] != '1') continue;
+                    const float x = glyphLeft + gx * px;
+                    const float y = lineTop + gy * px;
+                    pushRect(verts, x, y, x + px, y + px, 0.95f, 0.95f, 0.85f, 1.0f);
+                }
+            }
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(float), verts.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    vertexCount = (GLsizei)(verts.size() / HUD_FLOATS_PER_VERTEX);
+}
+
+void HudOverlay::draw(int framebufferWidth, int framebufferHeight)
+{
+    if (vertexCount == 0) return;
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glUseProgram(program);
+    glUniform2f(uScreen, (float)std::max(1, framebufferWidth), (float)std::max(1, framebufferHeight));
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+    glBindVertexArray(0);
+    glDisable(GL_BLEND);
+}
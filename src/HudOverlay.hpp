@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+// A few lines of text on a dark panel in the top left corner, for the profiler readout.
+// Uses a built-in 3x5 pixel font so it needs nothing but GL: digits, A-Z and a little
+// punctuation, lowercase comes out as uppercase and anything else as a space.
+// Needs a current GL context for its whole lifetime.
+class HudOverlay
+{
+    public:
+    HudOverlay();
+    ~HudOverlay();
+
+    HudOverlay(const HudOverlay&) = delete;
+    HudOverlay& operator=(const HudOverlay&) = delete;
+
+    // the quads only get rebuilt and re-uploaded when the text actually changes
+    void setText(const std::vector<std::string>& lines);
+    // blends over whatever is in the framebuffer
+    void draw(int framebufferWidth, int framebufferHeight);
+
+    private:
+    void rebuild();
+
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLsizei vertexCount = 0;
+    GLint uScreen = -1;
+    std::vector<std::string> lines;
+    std::vector<float> verts;
+};
@@ -0,0 +1,45 @@
+#include "Shader.hpp"
+#include <iostream>
+
+//this function takes the source code and shader type, compiles and returns the shader
+//GLuint is the final linked shader program ID 
+GLuint compileShader(GLenum type, const char* src)
+{
+    GLuint s = glCreateShader(type);
+    glShaderSource(s, 1, &src, nullptr);
+    glCompileShader(s);
+
+    GLint ok = 0;
+    glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
+    //if there is an error throw error msg
+    if (!ok) {
+        char log[1024];
+        glGetShaderInfoLog(s, sizeof(log), nullptr, log);
+        std::cerr << "Shader compile error:\n" << log << "\n";
+    }
+    return s;
+}
+//this function links all the shader together to display things
+GLuint makeProgram(const char* vsSrc, const char* fsSrc)
+{
+    GLuint vs = compileShader(GL_VERTEX_SHADER, vsSrc);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fsSrc);
+
+    GLuint p = glCreateProgram();
+    glAttachShader(p, vs);
+    glAttachShader(p, fs);
+    glLinkProgram(p);
+
+    GLint ok = 0;
+    glGetProgramiv(p, GL_LINK_STATUS, &ok);
+    //throws error msg
+    if (!ok) {
+        char log[1024];
+        glGetProgramInfoLog(p, sizeof(log), nullptr, log);
+        std::cerr << "Program link error:\n" << log << "\n";
+    }
+
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    return p;
+}
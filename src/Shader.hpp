@@ -0,0 +1,8 @@
+#pragma once
+#include <glad/glad.h>
+
+//this function takes the source code and shader type, compiles and returns the shader
+GLuint compileShader(GLenum type, const char* src);
+
+//this function links a vertex and fragment shader together into a program
+GLuint makeProgram(const char* vsSrc, const char* fsSrc);
@@ -0,0 +1,239 @@
+#include "SpriteBatch.hpp"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+SpriteAtlas SpriteAtlas::build(const std::vector<SpriteImage>& images, int pageSize, int padding)
+{
+    if (pageSize <= 0 || padding < 0) throw std::invalid_argument("atlas page size must be positive");
+    SpriteAtlas atlas;
+    atlas.pageSize = pageSize;
+    atlas.regions.resize(images.size());
+
+    for (std::size_t i = 0; i < images.size(); i++) {
+        const SpriteImage& img = images[i];
+        if (img.width <= 0 || img.height <= 0
+            || img.rgba.size() != static_cast<std::size_t>(img.width) * img.height * 4)
+            throw std::invalid_argument("sprite " + img.name + " has a bad size");
+        if (img.width + 2 * padding > pageSize || img.height + 2 * padding > pageSize)
+            throw std::invalid_argument("sprite " + img.name + " doesn't fit on a " + std::to_string(pageSize) + " page");
+        if (!atlas.ids.emplace(img.name, static_cast<int>(i)).second)
+            throw std::invalid_argument("two sprites called " + img.name);
+    }
+
+    // tallest first keeps the shelves tight, ties broken by width then input order so
+    // the same images always pack the same way
+    std::vector<std::size_t> order(images.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        if (images[a].height != images[b].height) return images[a].height > images[b].height;
+        return images[a].width > images[b].width;
+    });
+
+    int shelfX = 0, shelfY = 0, shelfHeight = 0;
+    const std::size_t texels = static_cast<std::size_t>(pageSize) * pageSize;
+    for (std::size_t i : order) {
+        const SpriteImage& img = images[i];
+        const int w = img.width + 2 * padding;
+        const int h = img.height + 2 * padding;
+        if (shelfX + w > pageSize) {
+            shelfY += shelfHeight;
+            shelfX = 0;
+            shelfHeight = 0;
+        }
+        if (atlas.pages.empty() || shelfY + h > pageSize) {
+            atlas.pages.emplace_back(texels * 4, 0);
+            shelfX = shelfY = shelfHeight = 0;
+        }
+
+        AtlasRegion& r = atlas.regions[i];
+        r.page = static_cast<int>(atlas.pages.size()) - 1;
+        r.x = shelfX + padding;
+        r.y = shelfY + padding;
+        r.width = img.width;
+        r.height = img.height;
+        r.u0 = static_cast<float>(r.x) / pageSize;
+        r.v0 = static_cast<float>(r.y) / pageSize;
+        r.u1 = static_cast<float>(r.x + r.width) / pageSize;
+        r.v1 = static_cast<float>(r.y + r.height) / pageSize;
+
+        // the image plus its padding, each padding texel a copy of the nearest edge texel
+        std::uint8_t* page = atlas.pages.back().data();
+        for (int py = -padding; py < img.height + padding; py++) {
+            const int sy = std::clamp(py, 0, img.height - 1);
+            std::uint8_t* row = page + (static_cast<std::size_t>(r.y + py) * pageSize + r.x) * 4;
+            const std::uint8_t* src = img.rgba.data() + static_cast<std::size_t>(sy) * img.width * 4;
+            std::memcpy(row, src, static_cast<std::size_t>(img.width) * 4);
+            for (int px = 1; px <= padding; px++) {
+                std::memcpy(row - px * 4, src, 4);
+                std::memcpy(row + (img.width - 1 + px) * 4, src + (img.width - 1) * 4, 4);
+            }
+        }
+
+        shelfX += w;
+        shelfHeight = std::max(shelfHeight, h);
+    }
+    return atlas;
+}
+
+int SpriteAtlas::find(const std::string& name) const
+{
+    auto it = ids.find(name);
+    return it == ids.end() ? -1 : it->second;
+}
+
+void SpriteBatch::begin()
+{
+    pending.clear();
+    keys.clear();
+    drawRanges.clear();
+    inOrder = true;
+}
+
+void SpriteBatch::add(int sprite, float x, float y, float w, float h, int layer, float rotation, std::uint32_t tint)
+{
+    if (sprite < 0 || sprite >= atlas->spriteCount()) throw std::out_of_range("no sprite " + std::to_string(sprite));
+    if (layer < 0 || layer >= SPRITE_LAYERS) throw std::out_of_range("no sprite layer " + std::to_string(layer));
+    const AtlasRegion& r = atlas->region(sprite);
+    const std::uint16_t key = static_cast<std::uint16_t>(layer * atlas->pageCount() + r.page);
+    if (!keys.empty() && key < keys.back()) inOrder = false;
+    keys.push_back(key);
+    pending.push_back({ x, y, w, h, r.u0, r.v0, r.u1, r.v1, rotation, tint });
+}
+
+void SpriteBatch::finish()
+{
+    drawRanges.clear();
+    if (pending.empty()) return;
+    const int pageCount = atlas->pageCount();
+
+    if (!inOrder) {
+        // counting sort on the key, stable so sprites on one layer and page keep their order
+        bucketStart.assign(static_cast<std::size_t>(SPRITE_LAYERS * pageCount) + 1, 0);
+        for (std::uint16_t k : keys) bucketStart[k + 1]++;
+        for (std::size_t b = 1; b < bucketStart.size(); b++) bucketStart[b] += bucketStart[b - 1];
+        sorted.resize(pending.size());
+        for (std::size_t i = 0; i < pending.size(); i++) sorted[static_cast<std::size_t>(bucketStart[keys[i]]++)] = pending[i];
+        // bucketStart[k] now ends bucket k, which is where bucket k + 1 starts
+        int first = 0;
+        for (int k = 0; k < SPRITE_LAYERS * pageCount; k++) {
+            const int end = bucketStart[static_cast<std::size_t>(k)];
+            if (end == first) continue;
+            const int page = k % pageCount;
+            if (!drawRanges.empty() && drawRanges.back().page == page) drawRanges.back().count += end - first;
+            else drawRanges.push_back({ page, first, end - first });
+            first = end;
+        }
+        return;
+    }
+
+    // added in order already: only cut where the page changes
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        const int page = keys[i] % pageCount;
+        if (!drawRanges.empty() && drawRanges.back().page == page) drawRanges.back().count++;
+        else drawRanges.push_back({ page, static_cast<int>(i), 1 });
+    }
+}
+
+// 8x8 pixel art, a character per pixel from this palette, '.' is transparent
+namespace {
+
+struct PaletteColor
+{
+    char c;
+    std::uint8_t r, g, b;
+};
+
+const PaletteColor PALETTE[] = {
+    { 'g', 86, 158, 74 },  { 'G', 62, 128, 58 },   // grass
+    { 's', 128, 88, 52 },  { 'S', 98, 64, 38 },    // soil
+    { 'w', 128, 128, 132 }, { 'W', 92, 92, 98 },   // stone wall
+    { 'l', 108, 196, 80 }, { 'L', 54, 140, 52 },   // leaves
+    { 'r', 214, 58, 48 },  { 'y', 230, 196, 92 },  // fruit, straw hat
+    { 'k', 238, 196, 160 }, { 'b', 64, 96, 178 },  // skin, overalls
+    { 'd', 40, 34, 30 },
+};
+
+struct BuiltinSprite
+{
+    const char* name;
+    const char* rows; // 8 rows of 8, top row first
+};
+
+const BuiltinSprite BUILTIN_SPRITES[] = {
+    { "grass",   "gggggGgg" "gGgggggg" "ggggggGg" "gggGgggg" "gggggggg" "Gggggggg" "gggggGgg" "ggGggggg" },
+    { "soil",    "ssssssss" "SSSSSSSS" "ssssssss" "ssssssss" "SSSSSSSS" "ssssssss" "ssssssss" "SSSSSSSS" },
+    { "wall",    "wwwWwwww" "wwwWwwww" "WWWWWWWW" "wWwwwwWw" "wWwwwwWw" "WWWWWWWW" "wwwWwwww" "wwwWwwww" },
+    { "planted", "........" "........" "........" "...ll..." "..lLl..." "...L...." "...L...." "........" },
+    { "grown",   "...rr..." "..rrrr.." ".lrrrrl." "lLlrrlLl" ".lLLLLl." "..lLLl.." "...LL..." "...LL..." },
+    { "farmer",  "..yyyy.." ".yyyyyy." "..kkkk.." "..kdkd.." "..bbbb.." ".kbbbbk." "..bbbb.." "..d..d.." },
+};
+
+} // namespace
+
+const std::vector<std::string>& farmSpriteNames()
+{
+    static const std::vector<std::string> names = { "grass", "soil", "wall", "planted", "grown", "farmer" };
+    return names;
+}
+
+std::vector<SpriteImage> builtinFarmSprites()
+{
+    std::vector<SpriteImage> out;
+    for (const BuiltinSprite& s : BUILTIN_SPRITES) {
+        SpriteImage img;
+        img.name = s.name;
+        img.width = 8;
+        img.height = 8;
+        img.rgba.assign(8 * 8 * 4, 0);
+        for (int i = 0; i < 64; i++) {
+            for (const PaletteColor& p : PALETTE) {
+                if (p.c != s.rows[i]) continue;
+                img.rgba[i * 4 + 0] = p.r;
+                img.rgba[i * 4 + 1] = p.g;
+                img.rgba[i * 4 + 2] = p.b;
+                img.rgba[i * 4 + 3] = 255;
+            }
+        }
+        out.push_back(std::move(img));
+    }
+    return out;
+}
+
+FarmSpriteIds findFarmSprites(const SpriteAtlas& atlas)
+{
+    FarmSpriteIds ids;
+    int* slots[] = { &ids.grass, &ids.soil, &ids.wall, &ids.planted, &ids.grown, &ids.farmer };
+    const std::vector<std::string>& names = farmSpriteNames();
+    for (std::size_t i = 0; i < names.size(); i++) {
+        *slots[i] = atlas.find(names[i]);
+        if (*slots[i] < 0) throw std::invalid_argument("sprite atlas has no " + names[i] + " sprite");
+    }
+    return ids;
+}
+
+void batchFarmSprites(const Grid& grid, const TileRect& view, float farmerX, float farmerY,
+                      const FarmSpriteIds& ids, SpriteBatch& batch)
+{
+    // row by row, ground and crop interleaved: the batch sorts them into layers
+    for (int y = view.y0; y < view.y1; y++) {
+        const GridSpan<TileType> types = grid.typeRow(y);
+        const GridSpan<CropState> states = grid.cropStateRow(y);
+        for (int x = view.x0; x < view.x1; x++) {
+            const TileType type = types[static_cast<std::size_t>(x)];
+            const float fx = static_cast<float>(x);
+            const float fy = static_cast<float>(y);
+            if (!grid.isWalkable(x, y)) {
+                batch.add(ids.wall, fx, fy, 1.0f, 1.0f, 0);
+                continue;
+            }
+            batch.add(type == TileType::EMPTY ? ids.grass : ids.soil, fx, fy, 1.0f, 1.0f, 0);
+            if (type != TileType::CROP) continue;
+            const CropState state = states[static_cast<std::size_t>(x)];
+            if (state == CropState::PLANTED) batch.add(ids.planted, fx, fy, 1.0f, 1.0f, 1);
+            else if (state == CropState::GROWN) batch.add(ids.grown, fx, fy, 1.0f, 1.0f, 1);
+        }
+    }
+    batch.add(ids.farmer, farmerX, farmerY, 1.0f, 1.0f, 2);
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Camera.hpp"
+#include "Grid.hpp"
+
+// CPU side of the sprite renderer (FarmerSprite), no OpenGL in here so it can be benchmarked
+// headless: packing images into atlas pages and collecting a frame's sprites into one
+// instance array, sorted so each run of sprites on the same page is a single draw.
+
+// RGBA8, rows top to bottom
+struct SpriteImage
+{
+    std::string name;
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint8_t> rgba;
+};
+
+// where a sprite landed. UVs are for the page texture, v grows downwards like the rows.
+struct AtlasRegion
+{
+    int page = 0;
+    int x = 0, y = 0, width = 0, height = 0;
+    float u0 = 0.0f, v0 = 0.0f, u1 = 0.0f, v1 = 0.0f;
+};
+
+// Images packed onto as few square pages as fit, shelf by shelf, tallest first. Each image
+// gets `padding` pixels around it filled with copies of its edge pixels, so linear filtering
+// and mipmapping don't pull in the neighbours.
+class SpriteAtlas
+{
+    public:
+    // throws std::invalid_argument for an image bigger than a page, a bad size or a
+    // duplicate name
+    static SpriteAtlas build(const std::vector<SpriteImage>& images, int pageSize, int padding = 1);
+
+    // sprite id for a name, -1 if there's none
+    int find(const std::string& name) const;
+    int spriteCount() const { return static_cast<int>(regions.size()); }
+    const AtlasRegion& region(int sprite) const { return regions[static_cast<std::size_t>(sprite)]; }
+
+    int pageCount() const { return static_cast<int>(pages.size()); }
+    int getPageSize() const { return pageSize; }
+    // pageSize * pageSize RGBA8 texels, transparent where nothing is packed
+    const std::vector<std::uint8_t>& pagePixels(int page) const { return pages[static_cast<std::size_t>(page)]; }
+
+    private:
+    int pageSize = 0;
+    std::vector<AtlasRegion> regions; // by sprite id, the images' order
+    std::unordered_map<std::string, int> ids;
+    std::vector<std::vector<std::uint8_t>> pages;
+};
+
+// One sprite as the GPU reads it, an instance each. World units are tiles like the Camera's,
+// (x, y) is the top left corner before rotation, which goes around the center.
+struct SpriteInstance
+{
+    float x, y, w, h;
+    float u0, v0, u1, v1;
+    float rotation;       // radians, clockwise on screen
+    std::uint32_t tint;   // RGBA8, r in the low byte, multiplies the texel
+};
+static_assert(sizeof(SpriteInstance) == 40, "sprite instance layout is shared with the shader");
+
+constexpr std::uint32_t SPRITE_WHITE = 0xffffffffu;
+// layers draw in order, 0 first. Within a layer sprites keep the order they were added in
+// as long as they're on the same page.
+constexpr int SPRITE_LAYERS = 16;
+
+// a run of instances that draws with one page bound
+struct SpriteDrawRange
+{
+    int page;
+    int first;
+    int count;
+};
+
+// Collects a frame's sprites, then orders them by layer and page with a counting sort
+// (O(n), no comparisons) and cuts the result into draw ranges. With everything on one page
+// that's a single range however many layers there are.
+class SpriteBatch
+{
+    public:
+    explicit SpriteBatch(const SpriteAtlas& atlas) : atlas(&atlas) {}
+
+    void begin();
+    // throws std::out_of_range for a sprite id or layer that doesn't exist
+    void add(int sprite, float x, float y, float w, float h, int layer,
+             float rotation = 0.0f, std::uint32_t tint = SPRITE_WHITE);
+    void finish();
+
+    // valid after finish()
+    const std::vector<SpriteInstance>& instances() const { return inOrder ? pending : sorted; }
+    const std::vector<SpriteDrawRange>& ranges() const { return drawRanges; }
+    std::size_t size() const { return pending.size(); }
+
+    private:
+    const SpriteAtlas* atlas;
+    std::vector<SpriteInstance> pending;
+    std::vector<std::uint16_t> keys;   // layer * pageCount + page per pending sprite
+    std::vector<int> bucketStart;
+    std::vector<SpriteInstance> sorted;
+    std::vector<SpriteDrawRange> drawRanges;
+    bool inOrder = true;               // keys never went down, nothing to sort
+};
+
+// the farm's own sprites by tile look, ids into one atlas
+struct FarmSpriteIds
+{
+    int grass = -1;
+    int soil = -1;
+    int wall = -1;
+    int planted = -1;
+    int grown = -1;
+    int farmer = -1;
+};
+
+// names the farm looks for in an atlas: "grass", "soil", "wall", "planted", "grown", "farmer"
+const std::vector<std::string>& farmSpriteNames();
+// 8x8 pixel-art stand-ins for all of them, used for any that don't come from a file
+std::vector<SpriteImage> builtinFarmSprites();
+// throws std::invalid_argument if the atlas is missing one of farmSpriteNames()
+FarmSpriteIds findFarmSprites(const SpriteAtlas& atlas);
+
+// the tiles in `view` (ground on layer 0, crops on layer 1) and the farmer on layer 2,
+// which may sit between tiles while it's interpolated
+void batchFarmSprites(const Grid& grid, const TileRect& view, float farmerX, float farmerY,
+                      const FarmSpriteIds& ids, SpriteBatch& batch);
@@ -0,0 +1,130 @@
+// Replays many command streams against one level at once on a work-stealing pool.
+//
+// usage: farm_batch --layout FILE | --size WxH  [--copies N] [--threads T] [--slice TICKS]
+//                   [--tick-limit N] [--runs R] [--quiet] commands.txt [more.txt ...]
+//
+//   every commands file becomes --copies worlds (default 1), all on the same layout
+//   --runs repeats the whole batch, later runs reuse the pooled worlds
+//   per-world lines: id, source file, ticks, harvests, failed actions, completion time, hash
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Simulation.hpp"
+#include "WorkStealingExecutor.hpp"
+#include "WorldBatch.hpp"
+
+int main(int argc, char** argv)
+{
+    std::string layoutPath;
+    int width = 3, height = 3;
+    int copies = 1;
+    int threads = 0;
+    int slice = 256;
+    long long tickLimit = 0;
+    int runs = 1;
+    bool quiet = false;
+    std::vector<std::string> commandPaths;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << arg << " needs a value\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--layout") layoutPath = next();
+        else if (arg == "--copies") copies = std::max(1, std::atoi(next().c_str()));
+        else if (arg == "--threads") threads = std::max(0, std::atoi(next().c_str()));
+        else if (arg == "--slice") slice = std::max(1, std::atoi(next().c_str()));
+        else if (arg == "--tick-limit") tickLimit = std::atoll(next().c_str());
+        else if (arg == "--runs") runs = std::max(1, std::atoi(next().c_str()));
+        else if (arg == "--quiet") quiet = true;
+        else if (arg == "--size") {
+            const std::string v = next();
+            if (std::sscanf(v.c_str(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                std::cerr << "--size wants WxH, e.g. 20x20\n";
+                return 2;
+            }
+        }
+        else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "unknown option " << arg << "\n";
+            return 2;
+        }
+        else commandPaths.push_back(arg);
+    }
+
+    if (commandPaths.empty()) {
+        std::cerr << "no command files given\n";
+        return 2;
+    }
+
+    try {
+        auto layout = std::make_shared<Layout>();
+        if (!layoutPath.empty()) {
+            *layout = loadLayoutFile(layoutPath);
+        } else {
+            layout->width = width;
+            layout->height = height;
+            layout->rows.assign(height, std::string(width, '.'));
+        }
+
+        std::vector<std::shared_ptr<const std::vector<Command>>> streams;
+        for (const std::string& path : commandPaths)
+            streams.push_back(std::make_shared<const std::vector<Command>>(loadCommandFile(path)));
+
+        WorkStealingExecutor executor(threads);
+        WorldPool pool;
+        std::mutex printMutex;
+
+        for (int run = 0; run < runs; run++) {
+            WorldBatch batch(pool);
+            std::vector<std::size_t> source;
+            for (std::size_t s = 0; s < streams.size(); s++) {
+                for (int c = 0; c < copies; c++) {
+                    batch.add(layout, streams[s], tickLimit);
+                    source.push_back(s);
+                }
+            }
+
+            WorldBatch::CompletionFn onDone;
+            if (!quiet) {
+                onDone = [&](int id, const WorldResult& r) {
+                    std::lock_guard<std::mutex> lock(printMutex);
+                    std::cout << "world " << id << "  " << commandPaths[source[id]];
+                    if (!r.error.empty()) {
+                        std::cout << "  error: " << r.error << "\n";
+                        return;
+                    }
+                    std::cout << "  ticks " << r.stats.ticks
+                              << "  harvests " << r.stats.harvests
+                              << "  failed " << r.stats.failedActions
+                              << (r.hitTickLimit ? "  (tick limit)" : "")
+                              << "  done at " << r.completedMs << " ms"
+                              << "  hash " << std::hex << r.finalHash << std::dec << "\n";
+                };
+            }
+
+            const BatchReport report = batch.run(executor, slice, onDone);
+            std::cout << "run " << run + 1 << ": " << report.worlds << " worlds on "
+                      << executor.getThreadCount() << " threads, "
+                      << report.worldTicks << " world-ticks in " << report.seconds * 1e3 << " ms, "
+                      << report.worldTicksPerSecond << " world-ticks/sec, "
+                      << report.steals << " steals, "
+                      << pool.createdCount() << " worlds allocated so far\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,217 @@
+// Headless batch runner: no window, no OpenGL, ticks as fast as the CPU allows.
+//
+// usage: farm_headless [--layout FILE | --pack FILE --level N | --size WxH]
+//                      [--commands FILE|-] [--ticks N]
+//                      [--repeat K] [--mode scheduled|scan] [--kernel scalar|sse2|avx2] [--dump]
+//                      [--record FILE [--checkpoint-interval N]] [--verify-index]
+//
+//   --layout    ASCII farm layout (see Simulation.hpp), default is a 3x3 empty farm
+//   --pack      compiled level pack (pygame/level_pack.py), --level picks a level by number
+//   --commands  command stream, one "move up 3" / "plant" / "harvest" / "wait 10" per line
+//   --ticks     extra ticks to run after the commands
+//   --repeat    play the command stream K times back to back (for throughput runs)
+//   --mode      growth engine, scheduled (default) or scan
+//   --kernel    scan mode's growth step, the widest the CPU has by default
+//   --dump      print the final farm as a layout
+//   --record    save the run as a replay (see Replay.hpp, play it back with farm_replay),
+//               with a checkpoint every N ticks (default 256)
+//   --verify-index  keep the crop index on and check it and the tile counts against a full
+//               scan after every tick (slow, for chasing index bugs)
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Grid.hpp"
+#include "Farmer.hpp"
+#include "LevelPack.hpp"
+#include "Replay.hpp"
+#include "Simulation.hpp"
+
+static char layoutChar(const Tile& t, bool farmerHere, bool walkable)
+{
+    if (farmerHere) return 'F';
+    if (!walkable) return 'X';
+    switch (t.type) {
+    case TileType::SOIL: return 'S';
+    case TileType::CROP:
+        if (t.cropstate == CropState::GROWN) return 'G';
+        if (t.cropstate == CropState::PLANTED) return 'P';
+        return 'S';
+    default: return '.';
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string layoutPath;
+    std::string commandPath;
+    std::string packPath;
+    int levelNumber = -1;
+    int width = 3, height = 3;
+    long long extraTicks = 0;
+    int repeat = 1;
+    GrowthMode mode = GrowthMode::Scheduled;
+    bool dump = false;
+    std::string recordPath;
+    int checkpointInterval = 256;
+    bool verifyIndex = false;
+    GrowthKernel kernel = bestGrowthKernel();
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << arg << " needs a value\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--layout") layoutPath = next();
+        else if (arg == "--pack") packPath = next();
+        else if (arg == "--level") levelNumber = std::atoi(next().c_str());
+        else if (arg == "--commands") commandPath = next();
+        else if (arg == "--ticks") extraTicks = std::atoll(next().c_str());
+        else if (arg == "--repeat") repeat = std::max(1, std::atoi(next().c_str()));
+        else if (arg == "--dump") dump = true;
+        else if (arg == "--verify-index") verifyIndex = true;
+        else if (arg == "--record") recordPath = next();
+        else if (arg == "--checkpoint-interval") checkpointInterval = std::max(1, std::atoi(next().c_str()));
+        else if (arg == "--size") {
+            const std::string v = next();
+            if (std::sscanf(v.c_str(), "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                std::cerr << "--size wants WxH, e.g. 1000x1000\n";
+                return 2;
+            }
+        }
+        else if (arg == "--mode") {
+            const std::string v = next();
+            if (v == "scan") mode = GrowthMode::Scan;
+            else if (v == "scheduled") mode = GrowthMode::Scheduled;
+            else {
+                std::cerr << "--mode is scan or scheduled\n";
+                return 2;
+            }
+        }
+        else if (arg == "--kernel") {
+            const std::string v = next();
+            if (v == "scalar") kernel = GrowthKernel::Scalar;
+            else if (v == "sse2") kernel = GrowthKernel::Sse2;
+            else if (v == "avx2") kernel = GrowthKernel::Avx2;
+            else {
+                std::cerr << "--kernel is scalar, sse2 or avx2\n";
+                return 2;
+            }
+        }
+        else {
+            std::cerr << "unknown option " << arg << "\n";
+            return 2;
+        }
+    }
+
+    if (packPath.empty() != (levelNumber < 0) || (!packPath.empty() && !layoutPath.empty())) {
+        std::cerr << "--pack and --level go together, and not with --layout\n";
+        return 2;
+    }
+
+    try {
+        Layout layout;
+        if (!layoutPath.empty()) {
+            layout = loadLayoutFile(layoutPath);
+            width = layout.width;
+            height = layout.height;
+        }
+
+        std::vector<Command> commands;
+        if (commandPath == "-") commands = parseCommands(std::cin);
+        else if (!commandPath.empty()) commands = loadCommandFile(commandPath);
+
+        Grid grid(width, height, mode);
+        grid.setGrowthKernel(kernel);
+        if (!layoutPath.empty()) applyLayout(layout, grid);
+        Farmer farmer(grid, layout.startX, layout.startY);
+        if (!packPath.empty()) {
+            const LevelPack pack = LevelPack::open(packPath);
+            const int index = pack.indexOfNumber(levelNumber);
+            if (index < 0) {
+                std::cerr << packPath << " has no level " << levelNumber << "\n";
+                return 1;
+            }
+            pack.loadLevel(index, grid, farmer);
+            width = grid.getGridWidth();
+            height = grid.getGridHeight();
+        }
+
+        if (verifyIndex) {
+            grid.setCropIndexing(true);
+            grid.setIndexVerification(true);
+        }
+
+        RunStats stats;
+        auto start = std::chrono::steady_clock::now();
+        std::unique_ptr<ReplayRecorder> recorder;
+        if (!recordPath.empty()) recorder = std::make_unique<ReplayRecorder>(grid, farmer, checkpointInterval);
+        for (int r = 0; r < repeat; r++) {
+            RunStats pass = recorder ? recorder->run(commands) : runCommands(grid, farmer, commands);
+            stats.ticks += pass.ticks;
+            stats.actions += pass.actions;
+            stats.failedActions += pass.failedActions;
+            stats.harvests += pass.harvests;
+        }
+        if (recorder) recorder->wait(extraTicks);
+        else for (long long t = 0; t < extraTicks; t++) grid.tick();
+        stats.ticks += extraTicks;
+        auto end = std::chrono::steady_clock::now();
+
+        if (recorder) {
+            const Replay replay = recorder->finish();
+            saveReplayFile(replay, recordPath);
+            std::cout << "replay:          " << recordPath << " (" << replay.actionCount << " actions, "
+                      << replay.checkpoints.size() << " checkpoints)\n";
+        }
+
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << "grid:            " << width << "x" << height
+                  << (mode == GrowthMode::Scan ? std::string(" (scan, ") + growthKernelName(kernel) + ")"
+                                               : std::string(" (scheduled)"))
+                  << "\n";
+        std::cout << "ticks:           " << stats.ticks << "\n";
+        std::cout << "actions:         " << stats.actions << " (" << stats.failedActions << " failed)\n";
+        std::cout << "harvests:        " << stats.harvests << "\n";
+        std::cout << "elapsed:         " << seconds * 1e3 << " ms\n";
+        std::cout << "ticks/sec:       " << (seconds > 0.0 ? stats.ticks / seconds : 0.0) << "\n";
+        std::cout << "farmer:          " << farmer.getX() << "," << farmer.getY() << "\n";
+        std::cout << "soil:            " << grid.countTiles(TileType::SOIL) << "\n";
+        std::cout << "crops planted:   " << grid.countTiles(TileType::CROP, CropState::PLANTED) << "\n";
+        std::cout << "crops grown:     " << grid.countTiles(TileType::CROP, CropState::GROWN) << "\n";
+        if (verifyIndex) {
+            int nx = 0, ny = 0;
+            std::cout << "nearest grown:   ";
+            if (grid.nearestCrop(CropState::GROWN, farmer.getX(), farmer.getY(), nx, ny))
+                std::cout << nx << "," << ny << "\n";
+            else
+                std::cout << "none\n";
+        }
+        std::cout << "state hash:      " << std::hex << hashState(grid, farmer) << std::dec << "\n";
+
+        if (dump) {
+            const Grid& view = grid;
+            for (int y = 0; y < height; y++) {
+                std::string row;
+                for (int x = 0; x < width; x++)
+                    row += layoutChar(view.getTile(x, y), farmer.getX() == x && farmer.getY() == y, view.isWalkable(x, y));
+                std::cout << row << "\n";
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
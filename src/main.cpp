@@ -1,8 +1,24 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <memory>
+#include <cmath>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include "Grid.hpp"
 #include "Farmer.hpp"
+#include "LevelPack.hpp"
+#include "FixedStepClock.hpp"
+#include "GridSnapshot.hpp"
+#include "SimulationThread.hpp"
+#include "Camera.hpp"
+#include "GridRenderer.hpp"
+#include "FarmerSprite.hpp"
+#include "Profiler.hpp"
+#include "GpuTimer.hpp"
+#include "HudOverlay.hpp"
 
 // IMPORTANT: glad must be included before glfw
 //gives you access to openGL functions.
@@ -22,177 +38,76 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     glViewport(0, 0, width, height);
 }
 
-//this function takes the source code and shader type, compiles and returns the shader
-//GLuint is the final linked shader program ID 
-static GLuint compileShader(GLenum type, const char* src)
+// scroll wheel notches since the last frame, the main loop turns them into zoom
+static double scrollPending = 0.0;
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
-    GLuint s = glCreateShader(type);
-    glShaderSource(s, 1, &src, nullptr);
-    glCompileShader(s);
-
-    GLint ok = 0;
-    glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
-    //if there is an error throw error msg
-    if (!ok) {
-        char log[1024];
-        glGetShaderInfoLog(s, sizeof(log), nullptr, log);
-        std::cerr << "Shader compile error:\n" << log << "\n";
-    }
-    return s;
-}
-//this function links all the shader together to display things
-static GLuint makeProgram(const char* vsSrc, const char* fsSrc)
-{
-    GLuint vs = compileShader(GL_VERTEX_SHADER, vsSrc);
-    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fsSrc);
-
-    GLuint p = glCreateProgram();
-    glAttachShader(p, vs);
-    glAttachShader(p, fs);
-    glLinkProgram(p);
-
-    GLint ok = 0;
-    glGetProgramiv(p, GL_LINK_STATUS, &ok);
-    //throws error msg
-    if (!ok) {
-        char log[1024];
-        glGetProgramInfoLog(p, sizeof(log), nullptr, log);
-        std::cerr << "Program link error:\n" << log << "\n";
-    }
-
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-    return p;
+    (void)window; (void)xoffset;
+    scrollPending += yoffset;
 }
 
-// Vertex format: x, y, r, g, b
-static void pushTri(std::vector<float>& v,
-                    float x0, float y0,
-                    float x1, float y1,
-                    float x2, float y2,
-                    float r, float g, float b)
-{
-    v.insert(v.end(), { x0, y0, r, g, b });
-    v.insert(v.end(), { x1, y1, r, g, b });
-    v.insert(v.end(), { x2, y2, r, g, b });
-}
+// where T writes the trace to, in the working directory
+static const char* TRACE_FILE = "farm_trace.json";
 
-static void pushQuad(std::vector<float>& v,
-                     float left, float top,
-                     float right, float bottom,
-                     float r, float g, float b)
+// the profiler readout: rolling p50/p99 of frame, tick and GPU time plus last frame's counters
+static std::vector<std::string> profilerHudLines(const GpuFrameTimer& gpuTimer, bool tracing)
 {
-    // two triangles
-    pushTri(v, left,  top,    right, top,    right, bottom, r, g, b);
-    pushTri(v, left,  top,    right, bottom, left,  bottom, r, g, b);
-}
-
-//we will symbolize what kind of crop is being grown through colors for now
-struct RGB { float r, g, b; };
-
-static RGB colorForTile(const Tile& t)
-{
-    // Pick colors based on tile type/state (tweak freely)
-    switch (t.type) {
-    case TileType::EMPTY: return { 0.20f, 0.30f, 0.28f }; //if the type ie empty show dark green
-    case TileType::SOIL:  return { 0.35f, 0.25f, 0.15f }; //if it is soil, show brown
-    case TileType::CROP://if it is a crop to a switch statement to see how much the crop has grown
-        switch (t.cropstate) {
-        case CropState::EMPTY:   return { 0.20f, 0.45f, 0.20f };
-        case CropState::PLANTED: return { 0.20f, 0.60f, 0.25f };
-        case CropState::GROWN:   return { 0.35f, 0.80f, 0.35f };
-        }
+    const Profiler& p = Profiler::instance();
+    std::vector<std::string> lines;
+    char line[128];
+
+    auto stat = [&](const char* label, ProfileStat which) {
+        std::snprintf(line, sizeof(line), "%-5s P50 %7.3f MS  P99 %7.3f MS", label,
+                      p.percentile(which, 0.50), p.percentile(which, 0.99));
+        lines.push_back(line);
+    };
+    stat("FRAME", ProfileStat::Frame);
+    stat("TICK", ProfileStat::Tick);
+    if (gpuTimer.isAvailable())
+        stat("GPU", ProfileStat::Gpu);
+    else
+        lines.push_back("GPU   NO TIMER QUERIES");
+
+    if (Profiler::compiledIn()) {
+        const FrameCounters& c = p.getLastFrameCounters();
+        std::snprintf(line, sizeof(line), "TILES %lld  VERTS %lld  UPLOAD %lld B  DRAWS %lld",
+                      (long long)c.values[(int)ProfileCounter::TilesVisited],
+                      (long long)c.values[(int)ProfileCounter::VerticesEmitted],
+                      (long long)c.values[(int)ProfileCounter::BytesUploaded],
+                      (long long)c.values[(int)ProfileCounter::DrawCalls]);
+        lines.push_back(line);
+        if (tracing && p.isCapturing())
+            std::snprintf(line, sizeof(line), "TRACE: RECORDING %zu EVENTS, T TO SAVE", p.capturedEvents());
+        else if (tracing)
+            std::snprintf(line, sizeof(line), "TRACE: FULL AT %zu EVENTS, T TO SAVE", p.capturedEvents());
+        else
+            std::snprintf(line, sizeof(line), "TRACE: T TO RECORD");
+        lines.push_back(line);
+    } else {
+        lines.push_back("SCOPES AND COUNTERS COMPILED OUT");
     }
-    return { 0.25f, 0.25f, 0.25f };
+    return lines;
 }
 
-static void buildMeshesFromGrid(
-    const Grid& grid,
-    int farmerX, int farmerY,
-    std::vector<float>& outTileVerts,
-    std::vector<float>& outBorderVerts,
-    std::vector<float>& outFarmerVerts)
+int main(int argc, char** argv)
 {
-    outTileVerts.clear();
-    outBorderVerts.clear();
-    outFarmerVerts.clear();
-
-    const int W = grid.getGridWidth();
-    const int H = grid.getGridHeight();
-
-    //layout for the gird, set to be centered
-    const float gridSize = 1.4f;   //height and width for tiles can be adjusted -JK
-    const float gap = 0.0f;       //gap between the tiles, set to 0 for no gap - JK
-    const float cellSize = (gridSize - gap * (W - 1)) / W;
-
-    const float startX = -gridSize / 2.0f;
-    const float startY =  gridSize / 2.0f; //the player will start on the top left by default
-
-    // border thickness in NDC units (thin rectangles)
-    const float borderT = 0.01f;
-    const RGB borderC{ 0.05f, 0.05f, 0.05f };
-
-    outTileVerts.reserve(W * H * 6 * 5);
-    outBorderVerts.reserve(W * H * 4 * 6 * 5); // 4 skinny quads per tile
-
-    for (int y = 0; y < H; y++) {
-        for (int x = 0; x < W; x++) {
-
-            float left   = startX + x * (cellSize + gap);
-            float top    = startY - y * (cellSize + gap);
-            float right  = left + cellSize;
-            float bottom = top  - cellSize;
-
-            const Tile& t = grid.getTile(x, y);
-            RGB c = colorForTile(t);
-
-            // Slight checker variation so you can see tiles easier even if same type
-            if ((x + y) % 2 == 0) { c.r += 0.02f; c.g += 0.02f; c.b += 0.02f; }
-
-            // Tile fill
-            pushQuad(outTileVerts, left, top, right, bottom, c.r, c.g, c.b);
-
-            // Borders (4 skinny quads)
-            // Top
-            pushQuad(outBorderVerts,
-                     left, top, right, top - borderT,
-                     borderC.r, borderC.g, borderC.b);
-
-            // Bottom
-            pushQuad(outBorderVerts,
-                     left, bottom + borderT, right, bottom,
-                     borderC.r, borderC.g, borderC.b);
-
-            // Left
-            pushQuad(outBorderVerts,
-                     left, top, left + borderT, bottom,
-                     borderC.r, borderC.g, borderC.b);
-
-            // Right
-            pushQuad(outBorderVerts,
-                     right - borderT, top, right, bottom,
-                     borderC.r, borderC.g, borderC.b);
+    // --pack FILE picks the compiled levels (pygame/level_pack.py), levels.pack next to the
+    // working directory by default; --level N starts on level number N. --sprites DIR swaps
+    // in <DIR>/soil.png, farmer.png etc. for the built-in sprites
+    std::string packPath = "levels.pack";
+    std::string spriteDir;
+    int startLevel = -1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--pack" && i + 1 < argc) packPath = argv[++i];
+        else if (arg == "--level" && i + 1 < argc) startLevel = std::atoi(argv[++i]);
+        else if (arg == "--sprites" && i + 1 < argc) spriteDir = argv[++i];
+        else {
+            std::cerr << "usage: " << argv[0] << " [--pack FILE] [--level N] [--sprites DIR]\n";
+            return 1;
         }
     }
 
-    // Farmer marker (small quad inside its tile)
-    farmerX = std::clamp(farmerX, 0, W - 1);
-    farmerY = std::clamp(farmerY, 0, H - 1);
-
-    float fLeft   = startX + farmerX * (cellSize + gap);
-    float fTop    = startY - farmerY * (cellSize + gap);
-    float fRight  = fLeft + cellSize;
-    float fBottom = fTop  - cellSize;
-
-    const float inset = 0.06f;
-    fLeft += inset; fRight -= inset;
-    fTop  -= inset; fBottom += inset;
-
-    pushQuad(outFarmerVerts, fLeft, fTop, fRight, fBottom, 0.35f, 0.75f, 0.40f);
-}
-
-int main()
-{
     //start GLFW library which must be called before using any GLFW functions.
     if (!glfwInit())
     {
@@ -236,45 +151,7 @@ int main()
     glViewport(0, 0, 800, 600);
     //register a callback function that GLFW calls every time the window is resized.
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-//creating shader program
-    const char* vsSrc = R"(
-        #version 330 core
-        layout(location = 0) in vec2 aPos;
-        layout(location = 1) in vec3 aColor;
-        out vec3 vColor;
-        void main() {
-            vColor = aColor;
-            gl_Position = vec4(aPos, 0.0, 1.0);
-        }
-    )";
-
-    const char* fsSrc = R"(
-        #version 330 core
-        in vec3 vColor;
-        out vec4 FragColor;
-        void main() {
-            FragColor = vec4(vColor, 1.0);
-        }
-    )";
-
-    GLuint program = makeProgram(vsSrc, fsSrc);
-
-    //creating one viewport
-    GLuint vao = 0, vbo = 0;
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
-    // Set up attributes once
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindVertexArray(0);
+    glfwSetScrollCallback(window, scroll_callback);
 
 //creating our 3x3 grid
     Grid grid(3, 3);
@@ -287,67 +164,276 @@ int main()
     // Use Farmer default constructor
     Farmer farmer(grid);
 
-    bool wPrev = false, aPrev = false, sPrev = false, dPrev = false;
-    std::vector<float> tileVerts;
-    std::vector<float> borderVerts;
-    std::vector<float> farmerVerts;
+    // with a level pack around the 3x3 grid gives way to its levels, [ and ] switch between them.
+    // Levels are copied straight out of the mapped file so switching doesn't parse anything
+    std::unique_ptr<LevelPack> pack;
+    int levelIndex = 0;
+    if (std::ifstream(packPath).good()) {
+        try {
+            pack = std::make_unique<LevelPack>(LevelPack::open(packPath, LevelPackCheck::Index));
+        } catch (const std::exception& err) {
+            std::cerr << err.what() << "\n";
+            return 1;
+        }
+        if (startLevel >= 0) levelIndex = pack->indexOfNumber(startLevel);
+        if (levelIndex < 0 || pack->levelCount() == 0) {
+            std::cerr << packPath << " has no level " << startLevel << "\n";
+            return 1;
+        }
+        pack->loadLevel(levelIndex, grid, farmer);
+    } else if (startLevel >= 0) {
+        std::cerr << "--level needs a level pack, " << packPath << " isn't there\n";
+        return 1;
+    }
+
+    // the simulation ticks on its own thread at a fixed rate, whatever the frame rate is.
+    // From here on only it touches grid and farmer, the window draws a copy (display)
+    // that it keeps up to date from the snapshots the simulation publishes.
+    SnapshotExchange snapshots;
+    SimulationThread sim(grid, farmer, snapshots, 4.0);
+    Grid display(grid.getGridWidth(), grid.getGridHeight(), GrowthMode::Scan);
+    SnapshotInfo shown;
+    std::vector<int> snapshotChanges;
+    sim.start();
+
+    // the grid stays on the GPU, only tiles that changed get re-uploaded each frame.
+    // Instanced by default, a byte per tile and one draw call for the whole thing
+    auto renderer = std::make_unique<GridRenderer>(display, GridRenderMode::Instanced);
+
+    // V switches to the textured farm, everything on screen batched into a draw per atlas page.
+    // Zoomed out past SPRITE_MIN_TILE_PIXELS the flat renderer takes over again
+    std::unique_ptr<FarmerSprite> sprites;
+    try {
+        sprites = std::make_unique<FarmerSprite>(spriteDir);
+    } catch (const std::exception& err) {
+        std::cerr << err.what() << ", drawing without sprites\n";
+    }
+    bool showSprites = false;
+
+    // H hides the profiler readout, T starts a trace capture and stops it again into TRACE_FILE
+    Profiler::instance().setThreadName("render");
+    auto gpuTimer = std::make_unique<GpuFrameTimer>();
+    auto hud = std::make_unique<HudOverlay>();
+    bool showHud = true;
+    double lastHud = -1.0;
+
+    // pan with the arrow keys, zoom with the scroll wheel around the cursor, F fits the grid back in
+    Camera camera;
+    camera.fitGrid(display.getGridWidth(), display.getGridHeight());
+    double lastFrame = glfwGetTime();
+
+    // measured rates, shown in the title bar
+    RateCounter frameRate;
+    double lastTitle = 0.0;
+
+    bool wPrev = false, aPrev = false, sPrev = false, dPrev = false, mPrev = false;
+    bool ePrev = false, qPrev = false, fasterPrev = false, slowerPrev = false;
+    bool hPrev = false, tPrev = false, vPrev = false, prevLevelPrev = false, nextLevelPrev = false;
+    bool tracing = false;
+    bool refitCamera = false;
 
 //while the window is open
     while (!glfwWindowShouldClose(window))
     {
-        //if input key for the window is pressed, we close the window.
-        if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-            glfwSetWindowShouldClose(window, true);
-
-        //movement system using WASD inputs
-        bool w = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
-        bool a = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
-        bool s = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
-        bool d = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+        {
+            FARM_PROFILE_SCOPE("input");
+            //if input key for the window is pressed, we close the window.
+            if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+                glfwSetWindowShouldClose(window, true);
+
+            //movement system using WASD inputs
+            bool w = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+            bool a = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+            bool s = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+            bool d = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+
+            //actions go to the simulation, which plays one per tick
+            Command cmd;
+            cmd.type = CommandType::Move;
+            if (w && !wPrev) { cmd.dir = UP;    sim.queueAction(cmd); }
+            if (s && !sPrev) { cmd.dir = DOWN;  sim.queueAction(cmd); }
+            if (a && !aPrev) { cmd.dir = LEFT;  sim.queueAction(cmd); }
+            if (d && !dPrev) { cmd.dir = RIGHT; sim.queueAction(cmd); }
+
+            wPrev = w; aPrev = a; sPrev = s; dPrev = d;
+
+            //E plants, Q harvests
+            bool e = glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS;
+            bool q = glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS;
+            if (e && !ePrev) { cmd.type = CommandType::Plant;   sim.queueAction(cmd); }
+            if (q && !qPrev) { cmd.type = CommandType::Harvest; sim.queueAction(cmd); }
+            ePrev = e; qPrev = q;
+
+            //= and - double or halve the tick rate, for fast-forward
+            bool faster = glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS;
+            bool slower = glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS;
+            if (faster && !fasterPrev) sim.setTicksPerSecond(std::min(sim.getTicksPerSecond() * 2.0, 1048576.0));
+            if (slower && !slowerPrev) sim.setTicksPerSecond(std::max(sim.getTicksPerSecond() * 0.5, 0.25));
+            fasterPrev = faster; slowerPrev = slower;
+
+            //M flips between the instanced and the old per-vertex renderer, they should look the same
+            bool m = glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS;
+            if (m && !mPrev) {
+                renderer->setMode(renderer->getMode() == GridRenderMode::Instanced
+                                      ? GridRenderMode::Vertices : GridRenderMode::Instanced);
+            }
+            mPrev = m;
+
+            bool v = glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS;
+            if (v && !vPrev && sprites) showSprites = !showSprites;
+            vPrev = v;
+
+            bool h = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+            if (h && !hPrev) showHud = !showHud;
+            hPrev = h;
+
+            bool t = glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
+            if (t && !tPrev) {
+                Profiler& profiler = Profiler::instance();
+                if (!tracing) {
+                    profiler.startCapture();
+                    tracing = true;
+                } else {
+                    // the capture may have stopped by itself at the event cap, save it all the same
+                    tracing = false;
+                    profiler.stopCapture();
+                    try {
+                        std::size_t events = profiler.writeChromeTrace(TRACE_FILE);
+                        std::cout << "wrote " << events << " trace events to " << TRACE_FILE << "\n";
+                    } catch (const std::exception& err) {
+                        std::cerr << err.what() << "\n";
+                    }
+                }
+            }
+            tPrev = t;
+
+            bool prevLevel = glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS;
+            bool nextLevel = glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS;
+            int step = (nextLevel && !nextLevelPrev) - (prevLevel && !prevLevelPrev);
+            if (pack && step != 0) {
+                // the simulation owns grid and farmer while it runs, so it stops for the swap.
+                // The next snapshot has the new size and the display and renderer follow it
+                levelIndex = (levelIndex + step + pack->levelCount()) % pack->levelCount();
+                sim.stop();
+                pack->loadLevel(levelIndex, grid, farmer);
+                sim.start();
+                refitCamera = true;
+            }
+            prevLevelPrev = prevLevel; nextLevelPrev = nextLevel;
+        }
 
-        if (w && !wPrev) farmer.move(UP);
-        if (s && !sPrev) farmer.move(DOWN);
-        if (a && !aPrev) farmer.move(LEFT);
-        if (d && !dPrev) farmer.move(RIGHT);
+        //camera controls
+        double now = glfwGetTime();
+        float dt = (float)(now - lastFrame);
+        lastFrame = now;
+
+        int fbWidth = 0, fbHeight = 0;
+        glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+        camera.setViewport(fbWidth, fbHeight);
+
+        const float panSpeed = 1.5f * dt; // NDC per second
+        if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)  camera.pan(-panSpeed, 0.0f);
+        if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) camera.pan( panSpeed, 0.0f);
+        if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)    camera.pan(0.0f,  panSpeed);
+        if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)  camera.pan(0.0f, -panSpeed);
+        if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS)
+            camera.fitGrid(display.getGridWidth(), display.getGridHeight());
+
+        if (scrollPending != 0.0) {
+            // cursor position in window coordinates, convert to NDC (y flips)
+            double cx = 0.0, cy = 0.0;
+            int winWidth = 1, winHeight = 1;
+            glfwGetCursorPos(window, &cx, &cy);
+            glfwGetWindowSize(window, &winWidth, &winHeight);
+            float ndcX = (float)(cx / std::max(1, winWidth)) * 2.0f - 1.0f;
+            float ndcY = 1.0f - (float)(cy / std::max(1, winHeight)) * 2.0f;
+            camera.zoomAt(std::pow(1.15f, (float)scrollPending), ndcX, ndcY);
+            scrollPending = 0.0;
+        }
 
-        wPrev = w; aPrev = a; sPrev = s; dPrev = d;
+        gpuTimer->beginFrame();
 
         //sets the background color to be teal
         glClearColor(0.1f, 0.2f, 0.25f, 1.0f);
         //fill framebuffer with the color you set with clearcolor 
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(program);
-
-        buildMeshesFromGrid(grid, farmer.getX(), farmer.getY(), tileVerts, borderVerts, farmerVerts);
-        
-        glBindVertexArray(vao);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-
-        //draw tiles
-        glBufferData(GL_ARRAY_BUFFER, tileVerts.size() * sizeof(float), tileVerts.data(), GL_DYNAMIC_DRAW);
-        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(tileVerts.size() / 5));
-
-        //draw borders (skinny quads)
-        glBufferData(GL_ARRAY_BUFFER, borderVerts.size() * sizeof(float), borderVerts.data(), GL_DYNAMIC_DRAW);
-        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(borderVerts.size() / 5));
-
-        //draw farmer marker
-        glBufferData(GL_ARRAY_BUFFER, farmerVerts.size() * sizeof(float), farmerVerts.data(), GL_DYNAMIC_DRAW);
-        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(farmerVerts.size() / 5));
+        //pick up the newest finished simulation state, if there is one
+        {
+            FARM_PROFILE_SCOPE("apply snapshot");
+            bool allChanged = false;
+            if (const GridSnapshot* snap = snapshots.acquire(snapshotChanges, allChanged)) {
+                applySnapshot(*snap, snapshotChanges, allChanged, display);
+                shown = snap->info;
+                snapshots.release();
+                if (refitCamera && pack && display.getGridWidth() == pack->level(levelIndex).width
+                    && display.getGridHeight() == pack->level(levelIndex).height) {
+                    camera.fitGrid(display.getGridWidth(), display.getGridHeight());
+                    refitCamera = false;
+                }
+            }
+        }
 
-        glBindVertexArray(0);
+        //slide the farmer from where it was to where it is over the length of a tick
+        float alpha = 1.0f;
+        if (shown.tickSeconds > 0.0)
+            alpha = (float)std::clamp((steadySeconds() - shown.publishedAt) / shown.tickSeconds, 0.0, 1.0);
+        float farmerX = shown.prevFarmerX + (shown.farmerX - shown.prevFarmerX) * alpha;
+        float farmerY = shown.prevFarmerY + (shown.farmerY - shown.prevFarmerY) * alpha;
+
+        // the flat renderer keeps up with the changes either way, switching back costs nothing
+        renderer->update(farmerX, farmerY);
+        if (showSprites && FarmerSprite::worthDrawing(camera))
+            sprites->draw(display, camera, farmerX, farmerY);
+        else
+            renderer->draw(camera);
+
+        if (showHud) {
+            FARM_PROFILE_SCOPE("hud");
+            // a few refreshes a second, numbers changing every frame can't be read
+            if (now - lastHud > 0.25) {
+                lastHud = now;
+                hud->setText(profilerHudLines(*gpuTimer, tracing));
+            }
+            hud->draw(fbWidth, fbHeight);
+        }
+        gpuTimer->endFrame();
+
+        frameRate.add(1, now);
+        if (now - lastTitle > 0.5) {
+            lastTitle = now;
+            std::string levelTitle;
+            if (pack) {
+                const PackedLevel level = pack->level(levelIndex);
+                levelTitle = " | level " + std::to_string(level.number) + " " + std::string(level.name);
+            }
+            char title[256];
+            std::snprintf(title, sizeof(title),
+                          "Automated-Farmer%s | tick %lld | sim %.1f ticks/s (target %g) | %.0f fps | harvests %d",
+                          levelTitle.c_str(), (long long)shown.tick, shown.measuredTicksPerSecond, sim.getTicksPerSecond(),
+                          frameRate.getRate(), shown.harvests);
+            glfwSetWindowTitle(window, title);
+        }
 
         //every frame, swap front and back buffer
-        glfwSwapBuffers(window);
+        {
+            FARM_PROFILE_SCOPE("swap buffers");
+            glfwSwapBuffers(window);
+        }
         //process all pending event from operating system like close requestkeyboard input
-        glfwPollEvents();
+        {
+            FARM_PROFILE_SCOPE("poll events");
+            glfwPollEvents();
+        }
+        Profiler::instance().endFrame();
     }
 
-    //cleaning up
-    glDeleteBuffers(1, &vbo);
-    glDeleteVertexArrays(1, &vao);
-    glDeleteProgram(program);
+    //cleaning up, the renderer's buffers have to go while the context is still alive
+    sim.stop();
+    renderer.reset();
+    sprites.reset();
+    hud.reset();
+    gpuTimer.reset();
 
     //close all GLFW windows and free resources allocated by GLFW
     glfwTerminate();
@@ -0,0 +1,116 @@
+// Replay viewer / checker for runs saved with farm_headless --record.
+//
+// usage: farm_replay FILE [--seek TICK] [--back N] [--dump] [--verify [HASH]]
+//
+//   --seek    show the farm at this tick (default the end of the run)
+//   --back    then step back N ticks
+//   --dump    print the farm at that tick as a layout
+//   --verify  re-simulate the whole run and check it against HASH (hex, e.g. a leaderboard
+//             submission's state hash), or against the hash recorded in the file.
+//             Exit code 1 if it doesn't match.
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "Replay.hpp"
+#include "Simulation.hpp"
+
+static char layoutChar(const Tile& t, bool farmerHere, bool walkable)
+{
+    if (farmerHere) return 'F';
+    if (!walkable) return 'X';
+    switch (t.type) {
+    case TileType::SOIL: return 'S';
+    case TileType::CROP:
+        if (t.cropstate == CropState::GROWN) return 'G';
+        if (t.cropstate == CropState::PLANTED) return 'P';
+        return 'S';
+    default: return '.';
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string path;
+    long long seekTick = -1;
+    long long back = 0;
+    bool dump = false;
+    bool verify = false;
+    std::string expectedHash;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << arg << " needs a value\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--seek") seekTick = std::atoll(next().c_str());
+        else if (arg == "--back") back = std::atoll(next().c_str());
+        else if (arg == "--dump") dump = true;
+        else if (arg == "--verify") {
+            verify = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') expectedHash = argv[++i];
+        }
+        else if (path.empty() && arg[0] != '-') path = arg;
+        else {
+            std::cerr << "unknown option " << arg << "\n";
+            return 2;
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "usage: farm_replay FILE [--seek TICK] [--back N] [--dump] [--verify [HASH]]\n";
+        return 2;
+    }
+
+    try {
+        const Replay replay = loadReplayFile(path);
+        std::cout << "grid:            " << replay.width << "x" << replay.height << "\n";
+        std::cout << "ticks:           " << replay.startTick << " - " << replay.endTick << "\n";
+        std::cout << "actions:         " << replay.actionCount << " (" << replay.log.size() << " byte log)\n";
+        std::cout << "checkpoints:     " << replay.checkpoints.size() << ", every " << replay.interval << " ticks\n";
+        std::cout << "recorded hash:   " << std::hex << replay.finalHash << std::dec << "\n";
+
+        ReplayPlayer player(replay);
+        auto start = std::chrono::steady_clock::now();
+        player.seek(seekTick < 0 ? replay.endTick : seekTick);
+        for (long long b = 0; b < back && player.stepBack(); b++) {}
+        auto end = std::chrono::steady_clock::now();
+
+        const Farmer& farmer = player.getFarmer();
+        const Grid& grid = player.getGrid();
+        std::cout << "tick:            " << player.getTick() << " (seek took "
+                  << std::chrono::duration<double, std::milli>(end - start).count() << " ms)\n";
+        std::cout << "farmer:          " << farmer.getX() << "," << farmer.getY() << "\n";
+        std::cout << "harvests:        " << farmer.getHarvestCount() << "\n";
+        std::cout << "state hash:      " << std::hex << hashState(grid, farmer) << std::dec << "\n";
+
+        if (dump) {
+            for (int y = 0; y < grid.getGridHeight(); y++) {
+                std::string row;
+                for (int x = 0; x < grid.getGridWidth(); x++)
+                    row += layoutChar(grid.getTile(x, y), farmer.getX() == x && farmer.getY() == y, grid.isWalkable(x, y));
+                std::cout << row << "\n";
+            }
+        }
+
+        if (verify) {
+            const std::uint64_t expected = expectedHash.empty() ? replay.finalHash : std::stoull(expectedHash, nullptr, 16);
+            const ReplayVerifyResult result = player.verify(expected);
+            std::cout << "verify:          " << (result.ok ? "ok" : "MISMATCH") << ", final hash " << std::hex
+                      << result.actualHash << " expected " << result.expectedHash << std::dec << "\n";
+            if (result.divergedAt >= 0)
+                std::cout << "diverged by:     tick " << result.divergedAt << "\n";
+            if (!result.ok) return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+// Headless grader for player farm scripts: compiles the script to bytecode and runs it on
+// the level straight away, no animation, then reports whether it met the objective.
+//
+// usage: farm_script --script FILE|- [--layout FILE] [--harvests N] [--crops wheat=2,corn=1]
+//                    [--tick-limit N] [--allow move,plant,harvest,for,...]
+//                    [--max-instructions N] [--max-ticks N] [--repeat K] [--disasm]
+//
+//   --layout     ASCII farm layout (see Simulation.hpp), default is a 3x3 empty farm
+//   --harvests   harvests needed to win when there are no crop requirements (default 1)
+//   --crops      per crop requirements, replaces --harvests like crop_requirements in objective.py
+//   --tick-limit a run that hasn't won after this many ticks fails (the level's time limit)
+//   --allow      the level's allowed commands, plant() and if/for/while are gated on it
+//   --repeat     grade K times and report the average, for timing
+//   --disasm     print the compiled bytecode
+//
+// exit code 0 if the script won, 1 if it didn't, 2 for bad arguments or files
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "FarmScript.hpp"
+#include "ScriptVM.hpp"
+#include "Simulation.hpp"
+
+static std::vector<std::string> splitCommas(const std::string& s)
+{
+    std::vector<std::string> out;
+    std::stringstream in(s);
+    std::string item;
+    while (std::getline(in, item, ','))
+        if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+int main(int argc, char** argv)
+{
+    std::string layoutPath;
+    std::string scriptPath;
+    ScriptLevel level;
+    ScriptLimits limits;
+    int repeat = 1;
+    bool disasm = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << arg << " needs a value\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--layout") layoutPath = next();
+        else if (arg == "--script") scriptPath = next();
+        else if (arg == "--harvests") level.objective.harvestsRequired = std::atoi(next().c_str());
+        else if (arg == "--tick-limit") level.objective.tickLimit = std::atoll(next().c_str());
+        else if (arg == "--max-instructions") limits.maxInstructions = std::atoll(next().c_str());
+        else if (arg == "--max-ticks") limits.maxTicks = std::atoll(next().c_str());
+        else if (arg == "--allow") level.allowed = splitCommas(next());
+        else if (arg == "--repeat") repeat = std::max(1, std::atoi(next().c_str()));
+        else if (arg == "--disasm") disasm = true;
+        else if (arg == "--crops") {
+            for (const std::string& item : splitCommas(next())) {
+                const auto eq = item.find('=');
+                const CropKind kind = cropKindFromName(item.substr(0, eq));
+                if (eq == std::string::npos || kind == CropKind::Unknown) {
+                    std::cerr << "--crops wants name=count pairs, e.g. wheat=2,corn=1\n";
+                    return 2;
+                }
+                level.objective.cropRequirements.push_back({ kind, std::atoi(item.c_str() + eq + 1) });
+            }
+        }
+        else {
+            std::cerr << "unknown option " << arg << "\n";
+            return 2;
+        }
+    }
+    if (scriptPath.empty()) {
+        std::cerr << "--script is required\n";
+        return 2;
+    }
+
+    std::string source;
+    try {
+        if (!layoutPath.empty()) {
+            level.layout = loadLayoutFile(layoutPath);
+        } else {
+            std::istringstream empty("...\n...\n...\n");
+            level.layout = parseLayout(empty);
+        }
+
+        std::stringstream buffer;
+        if (scriptPath == "-") {
+            buffer << std::cin.rdbuf();
+        } else {
+            std::ifstream in(scriptPath);
+            if (!in) throw std::runtime_error("could not open " + scriptPath);
+            buffer << in.rdbuf();
+        }
+        source = buffer.str();
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 2;
+    }
+
+    if (disasm) {
+        try {
+            ScriptOptions options;
+            options.allowed = level.allowed;
+            const ScriptProgram program = compileScript(source, options);
+            std::cout << program.disassemble();
+            std::cout << program.code.size() << " bytes of bytecode, " << program.variables.size() << " variable slots\n";
+        } catch (const ScriptError& e) {
+            std::cerr << "compile error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    ScriptResult result;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; r++) result = validateScript(source, level, limits);
+    auto end = std::chrono::steady_clock::now();
+    const double micros = std::chrono::duration<double, std::micro>(end - start).count() / repeat;
+
+    std::cout << "outcome:         " << scriptOutcomeName(result.outcome) << "\n";
+    if (!result.error.empty()) std::cout << "error:           " << result.error << "\n";
+    std::cout << "instructions:    " << result.instructions << "\n";
+    std::cout << "ticks:           " << result.ticks << "\n";
+    std::cout << "actions:         " << result.actions << " (" << result.failedActions << " failed)\n";
+    std::cout << "harvests:        " << result.harvests;
+    for (int k = 1; k < CROP_KIND_COUNT; k++)
+        if (result.cropHarvests[k] > 0)
+            std::cout << " " << cropKindName(static_cast<CropKind>(k)) << "=" << result.cropHarvests[k];
+    std::cout << "\n";
+    std::cout << "time per run:    " << micros << " us\n";
+    return result.outcome == ScriptOutcome::Won ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+// Par solver: the fewest ticks each level's objective can be met in, and a schedule that does
+// it (see Solver.hpp). Every schedule is checked by running it as a farm script through
+// ScriptVM before it's reported.
+//
+// usage: farm_solve [--pack FILE [--level N] | --layout FILE [--harvests N] [--crops wheat=2,...]
+//                   [--allow move,plant,...]]
+//                   [--threads N] [--memory-mb N] [--beam-width N] [--max-nodes N] [--max-ticks N]
+//                   [--out DIR] [--print]
+//
+//   --pack       compiled level pack (pygame/level_pack.py), every level in it unless --level
+//                picks one by number. Default is levels.pack when there's one here.
+//   --layout     one ASCII farm layout instead (see Simulation.hpp), with its objective from
+//                --harvests / --crops and its allowed list from --allow, like farm_script
+//   --threads    search threads, 0 (default) is one per hardware thread
+//   --memory-mb  cap on the search's memory per level (default 256)
+//   --beam-width states the beam search keeps per tick (default 4096)
+//   --max-nodes  branch-and-bound expansions per level before settling for the best found
+//                (default 5000000)
+//   --max-ticks  longest schedule looked for (default 5000)
+//   --out        write level_N.txt (command stream for farm_headless) and level_N.py (farm
+//                script for farm_script) per level into DIR, which has to exist
+//   --print      print each schedule as a command stream
+//
+// exit code 0 if every level was solved and its schedule checked out, 1 if not, 2 for bad
+// arguments or files
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Farmer.hpp"
+#include "FarmScript.hpp"
+#include "Grid.hpp"
+#include "LevelPack.hpp"
+#include "ScriptVM.hpp"
+#include "Simulation.hpp"
+#include "Solver.hpp"
+
+static std::vector<std::string> splitCommas(const std::string& s)
+{
+    std::vector<std::string> out;
+    std::stringstream in(s);
+    std::string item;
+    while (std::getline(in, item, ','))
+        if (!item.empty()) out.push_back(item);
+    return out;
+}
+
+// one level to solve, loaded into a fresh grid and farmer by load()
+struct SolveJob
+{
+    int number = 0;
+    std::string name;
+    ScriptObjective objective;
+    std::vector<std::string> allowed;
+    std::function<void(Grid&, Farmer&, std::vector<CropKind>&)> load;
+};
+
+// the schedule run as a farm script on a fresh copy of the level: it has to win, on its last tick
+static bool checkSchedule(const SolveJob& job, const SolverResult& result, std::string& why)
+{
+    Grid grid(1, 1);
+    Farmer farmer(grid);
+    std::vector<CropKind> crops;
+    job.load(grid, farmer, crops);
+
+    ScriptOptions options;
+    options.allowed = job.allowed;
+    ScriptProgram program;
+    try {
+        program = compileScript(scheduleScript(result), options);
+    } catch (const ScriptError& e) {
+        why = std::string("schedule doesn't compile: ") + e.what();
+        return false;
+    }
+    ScriptObjective objective = job.objective;
+    objective.tickLimit = 0;
+    ScriptVM vm;
+    const ScriptResult run = vm.run(program, grid, farmer, crops, objective, job.allowed);
+    if (run.outcome != ScriptOutcome::Won || run.ticks != result.ticks) {
+        why = std::string("schedule ") + scriptOutcomeName(run.outcome) + " after " + std::to_string(run.ticks)
+              + " ticks, expected a win after " + std::to_string(result.ticks);
+        return false;
+    }
+    return true;
+}
+
+// the crop's layout letter, lower case: carrot is 'R' there, 'c' is corn
+static char cropLetter(CropKind kind)
+{
+    switch (kind) {
+    case CropKind::Wheat: return 'w';
+    case CropKind::Corn: return 'c';
+    case CropKind::Tomato: return 't';
+    case CropKind::Carrot: return 'r';
+    default: return '?';
+    }
+}
+
+static std::string objectiveText(const ScriptObjective& o)
+{
+    if (o.cropRequirements.empty()) return std::to_string(o.harvestsRequired) + " any";
+    std::string s;
+    for (const auto& r : o.cropRequirements) {
+        if (!s.empty()) s += " ";
+        s += std::to_string(r.second) + cropLetter(r.first);
+    }
+    return s;
+}
+
+int main(int argc, char** argv)
+{
+    std::string packPath;
+    std::string layoutPath;
+    std::string outDir;
+    int levelNumber = -1;
+    bool print = false;
+    ScriptLevel custom;
+    SolverOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << arg << " needs a value\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--pack") packPath = next();
+        else if (arg == "--level") levelNumber = std::atoi(next().c_str());
+        else if (arg == "--layout") layoutPath = next();
+        else if (arg == "--harvests") custom.objective.harvestsRequired = std::atoi(next().c_str());
+        else if (arg == "--allow") custom.allowed = splitCommas(next());
+        else if (arg == "--threads") options.threads = std::atoi(next().c_str());
+        else if (arg == "--memory-mb") options.memoryBytes = static_cast<std::size_t>(std::atof(next().c_str()) * (1 << 20));
+        else if (arg == "--beam-width") options.beamWidth = std::atoi(next().c_str());
+        else if (arg == "--max-nodes") options.maxNodes = std::atoll(next().c_str());
+        else if (arg == "--max-ticks") options.maxTicks = std::atoi(next().c_str());
+        else if (arg == "--out") outDir = next();
+        else if (arg == "--print") print = true;
+        else if (arg == "--crops") {
+            for (const std::string& item : splitCommas(next())) {
+                const auto eq = item.find('=');
+                const CropKind kind = cropKindFromName(item.substr(0, eq));
+                if (eq == std::string::npos || kind == CropKind::Unknown) {
+                    std::cerr << "--crops wants name=count pairs, e.g. wheat=2,corn=1\n";
+                    return 2;
+                }
+                custom.objective.cropRequirements.push_back({ kind, std::atoi(item.c_str() + eq + 1) });
+            }
+        }
+        else {
+            std::cerr << "unknown option " << arg << "\n";
+            return 2;
+        }
+    }
+    if (!packPath.empty() && !layoutPath.empty()) {
+        std::cerr << "--pack and --layout don't go together\n";
+        return 2;
+    }
+    if (packPath.empty() && layoutPath.empty()) {
+        if (!std::ifstream("levels.pack").good()) {
+            std::cerr << "no levels.pack here, give --pack FILE or --layout FILE\n";
+            return 2;
+        }
+        packPath = "levels.pack";
+    }
+    if (options.threads < 0 || options.maxTicks < 1 || options.maxNodes < 0) {
+        std::cerr << "--threads, --max-ticks and --max-nodes can't be negative\n";
+        return 2;
+    }
+
+    std::unique_ptr<LevelPack> pack;
+    std::vector<SolveJob> jobs;
+    try {
+        if (!packPath.empty()) {
+            pack = std::make_unique<LevelPack>(LevelPack::open(packPath));
+            for (int index = 0; index < pack->levelCount(); index++) {
+                const PackedLevel level = pack->level(index);
+                if (levelNumber >= 0 && level.number != levelNumber) continue;
+                SolveJob job;
+                job.number = level.number;
+                job.name = std::string(level.name);
+                job.objective = level.objective();
+                job.allowed = level.allowedCommands();
+                const LevelPack* from = pack.get();
+                job.load = [from, index](Grid& grid, Farmer& farmer, std::vector<CropKind>& crops) {
+                    from->loadLevel(index, grid, farmer);
+                    const PackedLevel level = from->level(index);
+                    crops.assign(level.crops, level.crops + static_cast<std::size_t>(level.width) * level.height);
+                };
+                jobs.push_back(std::move(job));
+            }
+            if (jobs.empty()) {
+                std::cerr << packPath << " has no level " << levelNumber << "\n";
+                return 2;
+            }
+        } else {
+            custom.layout = loadLayoutFile(layoutPath);
+            SolveJob job;
+            job.name = layoutPath;
+            job.objective = custom.objective;
+            job.allowed = custom.allowed;
+            const Layout layout = custom.layout;
+            job.load = [layout](Grid& grid, Farmer& farmer, std::vector<CropKind>& crops) {
+                grid.reset(layout.width, layout.height);
+                applyLayout(layout, grid);
+                farmer.reset(layout.startX, layout.startY);
+                crops = layoutCrops(layout);
+            };
+            jobs.push_back(std::move(job));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 2;
+    }
+
+    std::printf("%-5s %-24s %6s %-12s %-11s %6s %6s %6s %11s %8s\n", "level", "name", "size", "objective", "status",
+                "ticks", "bound", "beam", "nodes", "ms");
+    bool allGood = true;
+    for (const SolveJob& job : jobs) {
+        Grid grid(1, 1);
+        Farmer farmer(grid);
+        std::vector<CropKind> crops;
+        job.load(grid, farmer, crops);
+
+        SolverResult result;
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            result = solveLevel(makeSolverProblem(grid, farmer, crops, job.objective, job.allowed), options);
+        } catch (const std::exception& e) {
+            std::cerr << "level " << job.number << ": " << e.what() << "\n";
+            return 2;
+        }
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        const std::string size = std::to_string(grid.getGridWidth()) + "x" + std::to_string(grid.getGridHeight());
+        std::printf("%-5d %-24.24s %6s %-12s %-11s %6d %6d %6d %11lld %8.1f\n", job.number, job.name.c_str(),
+                    size.c_str(), objectiveText(job.objective).c_str(), solveStatusName(result.status), result.ticks,
+                    result.lowerBound, result.beamTicks, static_cast<long long>(result.nodes), ms);
+
+        if (result.status == SolveStatus::NoSolution) {
+            allGood = false;
+            continue;
+        }
+        std::string why;
+        if (!checkSchedule(job, result, why)) {
+            std::cerr << "level " << job.number << ": " << why << "\n";
+            allGood = false;
+            continue;
+        }
+
+        if (print) writeScheduleCommands(std::cout, result);
+        if (!outDir.empty()) {
+            const std::string base = outDir + "/level_" + std::to_string(job.number);
+            std::ostringstream header;
+            header << "# level " << job.number << " " << job.name << ": " << result.ticks << " ticks, "
+                   << solveStatusName(result.status);
+            if (result.status != SolveStatus::Optimal) header << " (at least " << result.lowerBound << ")";
+            header << "\n";
+            std::ofstream commands(base + ".txt");
+            std::ofstream script(base + ".py");
+            if (!commands || !script) {
+                std::cerr << "can't write " << base << ".txt/.py\n";
+                return 2;
+            }
+            commands << header.str();
+            writeScheduleCommands(commands, result);
+            script << header.str() << scheduleScript(result);
+        }
+    }
+    return allGood ? 0 : 1;
+}